@@ -3,6 +3,7 @@
 #pragma once
 
 #include <gap/core/ranges.hpp>
+#include <iterator>
 #include <numeric>
 
 namespace gap::bench
@@ -13,14 +14,21 @@ namespace gap::bench
     template< sample S >
     using sample_type = typename S::value_type;
 
-    constexpr double sum(sample auto s) { return gap::ranges::accumulate(s, 0); }
+    constexpr double sum(sample auto s) {
+        auto add = [](double acc, auto val) { return acc + double(val); };
+        return gap::ranges::accumulate(s, 0.0, add);
+    }
 
-    constexpr double mean(sample auto s) { return sum(s) / ssize(s); }
+    constexpr double mean(sample auto s) { return sum(s) / double(std::ssize(s)); }
 
+    // The mean squared deviation from the mean, that is the variance despite
+    // the name, take the square root for the deviation itself.
     constexpr double standard_deviation(sample auto s) {
         double avg     = mean(s);
-        auto deviation = [avg](double acc, auto val) { return acc + (avg - val) * (avg - val); };
-        return gap::ranges::accumulate(s, 0.0, deviation) / ssize(s);
+        auto deviation = [avg](double acc, auto val) {
+            return acc + (avg - double(val)) * (avg - double(val));
+        };
+        return gap::ranges::accumulate(s, 0.0, deviation) / double(std::ssize(s));
     }
 
 } // namespace gap::bench
@@ -0,0 +1,203 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/scheduled_resumption.hpp>
+
+    #include <atomic>
+    #include <cassert>
+    #include <cstddef>
+    #include <type_traits>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        struct noop_barrier_completion
+        {
+            void operator()() const noexcept {}
+        };
+
+    } // namespace detail
+
+    template< typename completion_t >
+    struct async_barrier_wait_operation_base;
+
+    template< typename completion_t, scheduler scheduler_t >
+    struct async_barrier_wait_operation;
+
+    // A reusable barrier for a fixed number of participating coroutines.
+    //
+    // Each phase completes once every participant has arrived. The last
+    // participant to arrive runs the completion function, on its own thread
+    // and before any waiter is resumed, and then releases the waiters so
+    // that they can continue into the next phase:
+    //
+    //     async_barrier barrier{ workers, [&]() noexcept { ++phase; } };
+    //
+    //     // every worker
+    //     summarize(function);
+    //     co_await barrier.arrive_and_wait(pool);
+    //     resolve(call_sites);
+    //
+    // Arriving is lock-free: a waiter pushes itself onto an intrusive list
+    // and decrements the number of outstanding participants.
+    template< typename completion_t = detail::noop_barrier_completion >
+    struct async_barrier
+    {
+        static_assert(
+            std::is_nothrow_invocable_v< completion_t& >,
+            "the barrier completion function must be noexcept"
+        );
+
+        explicit async_barrier(std::size_t participants, completion_t completion = {}) noexcept(
+            std::is_nothrow_move_constructible_v< completion_t >
+        )
+            : m_expected(participants)
+            , m_remaining(participants)
+            , m_completion(std::move(completion))
+        {
+            assert(participants > 0);
+        }
+
+        async_barrier(const async_barrier &) = delete;
+        async_barrier &operator=(const async_barrier &) = delete;
+
+        ~async_barrier() {
+            assert(m_waiters.load(std::memory_order_relaxed) == nullptr);
+        }
+
+        // Arrives at the barrier and waits for the current phase to
+        // complete. Waiters are resumed inline on the thread of the last
+        // participant to arrive.
+        [[nodiscard]] async_barrier_wait_operation< completion_t, detail::inline_scheduler >
+        arrive_and_wait() noexcept {
+            return { *this, detail::inline_scheduler_instance };
+        }
+
+        // Like arrive_and_wait(), but the waiter is resumed through
+        // 'co_await scheduler.schedule()', so that a phase completion fans
+        // the waiters back out instead of running them all on one thread.
+        template< scheduler scheduler_t >
+        [[nodiscard]] async_barrier_wait_operation< completion_t, scheduler_t >
+        arrive_and_wait(scheduler_t &scheduler) noexcept {
+            return { *this, scheduler };
+        }
+
+        // Arrives at the barrier for the current phase and removes the
+        // caller from the participants of the following phases.
+        void arrive_and_drop() noexcept {
+            m_expected.fetch_sub(1, std::memory_order_relaxed);
+            arrive(nullptr);
+        }
+
+      private:
+        friend struct async_barrier_wait_operation_base< completion_t >;
+
+        using waiter = async_barrier_wait_operation_base< completion_t >;
+
+        // Returns true if this arrival completed the phase.
+        bool arrive(waiter *arriving) noexcept {
+            if (arriving) {
+                // Must be visible to the last participant before it takes the
+                // list, hence push first and count down second.
+                auto *head = m_waiters.load(std::memory_order_relaxed);
+                do {
+                    arriving->m_next = head;
+                } while (!m_waiters.compare_exchange_weak(
+                    head, arriving, std::memory_order_release, std::memory_order_relaxed
+                ));
+            }
+
+            auto remaining = m_remaining.fetch_sub(1, std::memory_order_acq_rel);
+            assert(remaining > 0);
+            if (remaining != 1) {
+                return false;
+            }
+
+            complete_phase(arriving);
+            return true;
+        }
+
+        void complete_phase(waiter *last) noexcept {
+            auto *waiters = m_waiters.exchange(nullptr, std::memory_order_acquire);
+
+            m_completion();
+
+            // Rearm before resuming anyone, as the resumed participants may
+            // arrive at the next phase straight away.
+            m_remaining.store(m_expected.load(std::memory_order_relaxed), std::memory_order_release);
+
+            // The barrier may be destroyed by a resumed waiter, so only the
+            // detached list is touched from here on.
+            while (waiters) {
+                auto *next = waiters->m_next;
+                if (waiters != last) {
+                    waiters->resume();
+                }
+                waiters = next;
+            }
+        }
+
+        std::atomic< std::size_t > m_expected;
+        alignas(64) std::atomic< std::size_t > m_remaining;
+        std::atomic< waiter* > m_waiters = nullptr;
+        [[no_unique_address]] completion_t m_completion;
+    };
+
+    template< typename completion_t >
+    struct async_barrier_wait_operation_base
+    {
+        explicit async_barrier_wait_operation_base(async_barrier< completion_t > &barrier) noexcept
+            : m_barrier(barrier)
+        {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+            m_awaiting_coroutine = awaiting_coroutine;
+            // Once the arrival is counted, another thread may complete the
+            // phase and resume us, so nothing may touch 'this' afterwards.
+            // The last participant continues without suspending.
+            return !m_barrier.arrive(this);
+        }
+
+      protected:
+        friend struct async_barrier< completion_t >;
+
+        ~async_barrier_wait_operation_base() = default;
+
+        virtual void resume() noexcept = 0;
+
+        async_barrier< completion_t > &m_barrier;
+        async_barrier_wait_operation_base *m_next = nullptr;
+        gap::coroutine_handle<> m_awaiting_coroutine;
+    };
+
+    template< typename completion_t, scheduler scheduler_t >
+    struct async_barrier_wait_operation final : async_barrier_wait_operation_base< completion_t >
+    {
+        using base = async_barrier_wait_operation_base< completion_t >;
+
+        async_barrier_wait_operation(
+            async_barrier< completion_t > &barrier, scheduler_t &scheduler
+        ) noexcept
+            : base(barrier)
+            , m_resumption(scheduler)
+        {}
+
+        void await_resume() { m_resumption.await_resume(); }
+
+      private:
+        void resume() noexcept override { m_resumption.resume(this->m_awaiting_coroutine); }
+
+        detail::scheduled_resumption< scheduler_t > m_resumption;
+    };
+
+} // namespace gap::coro
+
+#endif
@@ -0,0 +1,75 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/io_service.hpp>
+    #include <gap/coro/task.hpp>
+
+    #include <cstddef>
+    #include <cstdint>
+    #include <filesystem>
+    #include <span>
+
+namespace gap::coro
+{
+    enum class file_mode : std::uint8_t
+    {
+        read,
+        // Creates the file, or truncates an existing one.
+        write,
+        // Creates the file if it does not exist.
+        read_write
+    };
+
+    // A file read and written at explicit offsets without blocking the
+    // awaiting thread:
+    //
+    //     auto file = async_file::open(path);
+    //     std::vector< std::byte > header(64);
+    //     co_await file.read_at(0, header);
+    //
+    // Any number of reads and writes may be in flight at once, the file has
+    // no position. Operations go through an io_service, see there for how
+    // they are batched and where the awaiting coroutine resumes. Failures
+    // are thrown as std::system_error.
+    struct async_file
+    {
+        static async_file open(
+            const std::filesystem::path &path,
+            file_mode mode = file_mode::read,
+            io_service &service = io_service::global()
+        );
+
+        async_file(async_file &&other) noexcept;
+        async_file &operator=(async_file &&other) noexcept;
+
+        ~async_file();
+
+        // Reads up to 'buffer.size()' bytes at 'offset' and returns how many
+        // were read, fewer than asked only at the end of the file or for
+        // reads of a gigabyte or more.
+        task< std::size_t > read_at(std::uint64_t offset, std::span< std::byte > buffer);
+
+        // Writes up to 'buffer.size()' bytes at 'offset' and returns how
+        // many were written.
+        task< std::size_t > write_at(std::uint64_t offset, std::span< const std::byte > buffer);
+
+        std::uint64_t size() const;
+
+        int native_handle() const noexcept { return m_fd; }
+
+      private:
+        async_file(int fd, io_service &service) noexcept
+            : m_fd(fd)
+            , m_service(&service)
+        {}
+
+        int m_fd;
+        io_service *m_service;
+    };
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,414 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/async_generator.hpp from the
+// cppcoro project. The original file is licenced under the MIT license and the
+// original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/frame_allocator.hpp>
+
+    #include <atomic>
+    #include <cassert>
+    #include <cstddef>
+    #include <exception>
+    #include <iterator>
+    #include <memory>
+    #include <type_traits>
+    #include <utility>
+
+namespace gap::coro
+{
+    template< typename T >
+    struct async_generator;
+
+    namespace detail
+    {
+        template< typename T >
+        struct async_generator_iterator;
+        struct async_generator_yield_operation;
+        struct async_generator_advance_operation;
+
+        // The producer and the consumer may run on different threads, e.g.
+        // when the producer awaits a thread pool between two yields. Which
+        // side suspends first is resolved with a CAS on 'm_state':
+        //
+        //   value_not_ready_consumer_active    - the producer was resumed to
+        //                                        compute the next value.
+        //   value_not_ready_consumer_suspended - the consumer is waiting for
+        //                                        the producer to yield.
+        //   value_ready_producer_suspended     - the producer is suspended
+        //                                        at initial_suspend, a
+        //                                        co_yield or final_suspend.
+        //
+        // The consumer only ever resumes a suspended producer and vice versa.
+        // Whenever one side finds the other one still active it leaves the
+        // next step to it, so a synchronous producer and consumer ping-pong
+        // without growing the stack.
+        struct async_generator_promise_base : promise_allocator
+        {
+            enum class state {
+                value_not_ready_consumer_active,
+                value_not_ready_consumer_suspended,
+                value_ready_producer_suspended
+            };
+
+            async_generator_promise_base() noexcept = default;
+
+            async_generator_promise_base(const async_generator_promise_base&) = delete;
+            async_generator_promise_base& operator=(const async_generator_promise_base&) = delete;
+
+            gap::suspend_always initial_suspend() const noexcept { return {}; }
+
+            async_generator_yield_operation final_suspend() noexcept;
+
+            void unhandled_exception() noexcept { m_exception = std::current_exception(); }
+
+            void return_void() noexcept {}
+
+            // The producer has run to completion.
+            bool finished() const noexcept { return m_current_value == nullptr; }
+
+            void rethrow_if_unhandled_exception() {
+                if (m_exception) {
+                    std::rethrow_exception(std::move(m_exception));
+                }
+            }
+
+          protected:
+            async_generator_yield_operation internal_yield_value() noexcept;
+
+            void *m_current_value = nullptr;
+
+          private:
+            friend struct async_generator_yield_operation;
+            friend struct async_generator_advance_operation;
+
+            std::atomic< state > m_state = state::value_ready_producer_suspended;
+            std::exception_ptr m_exception;
+            gap::coroutine_handle<> m_consumer_coroutine;
+        };
+
+        struct async_generator_yield_operation final
+        {
+            using state = async_generator_promise_base::state;
+
+            explicit async_generator_yield_operation(async_generator_promise_base &promise) noexcept
+                : m_promise(promise)
+            {}
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(gap::coroutine_handle<>) noexcept {
+                // The value is published by the release below.
+                auto old_state = state::value_not_ready_consumer_active;
+                if (m_promise.m_state.compare_exchange_strong(
+                        old_state, state::value_ready_producer_suspended,
+                        std::memory_order_release, std::memory_order_acquire))
+                {
+                    // The consumer has not suspended yet, it will find the
+                    // value when it tries to.
+                    return;
+                }
+
+                assert(old_state == state::value_not_ready_consumer_suspended);
+
+                // The consumer is waiting for us. It may resume, or even
+                // destroy, the producer before resume() returns, so neither
+                // the promise nor this object may be touched afterwards.
+                auto consumer = m_promise.m_consumer_coroutine;
+                m_promise.m_state.store(state::value_ready_producer_suspended, std::memory_order_release);
+                consumer.resume();
+            }
+
+            void await_resume() noexcept {}
+
+          private:
+            async_generator_promise_base &m_promise;
+        };
+
+        inline async_generator_yield_operation async_generator_promise_base::final_suspend() noexcept {
+            m_current_value = nullptr;
+            return internal_yield_value();
+        }
+
+        inline async_generator_yield_operation async_generator_promise_base::internal_yield_value() noexcept {
+            return async_generator_yield_operation{ *this };
+        }
+
+        template< typename T >
+        struct async_generator_promise final : async_generator_promise_base
+        {
+            using value_type     = std::remove_reference_t< T >;
+            using reference_type = std::conditional_t< std::is_reference_v< T >, T, T& >;
+            using pointer_type   = value_type*;
+
+            async_generator_promise() noexcept = default;
+
+            async_generator< T > get_return_object() noexcept;
+
+            async_generator_yield_operation yield_value(value_type &value) noexcept {
+                m_current_value = static_cast< void* >(std::addressof(value));
+                return internal_yield_value();
+            }
+
+            async_generator_yield_operation yield_value(value_type &&value) noexcept {
+                return yield_value(value);
+            }
+
+            reference_type value() const noexcept {
+                return static_cast< reference_type >(*static_cast< pointer_type >(m_current_value));
+            }
+        };
+
+        struct async_generator_advance_operation
+        {
+            using state = async_generator_promise_base::state;
+
+          protected:
+            async_generator_advance_operation(std::nullptr_t) noexcept
+                : m_promise(nullptr)
+                , m_initial_state(state::value_ready_producer_suspended)
+            {}
+
+            // Resumes the producer right away, so that a producer that yields
+            // synchronously never makes the consumer suspend.
+            async_generator_advance_operation(
+                async_generator_promise_base &promise, gap::coroutine_handle<> producer
+            ) noexcept
+                : m_promise(std::addressof(promise))
+            {
+                auto initial_state = promise.m_state.load(std::memory_order_acquire);
+                assert(initial_state == state::value_ready_producer_suspended);
+
+                promise.m_state.store(state::value_not_ready_consumer_active, std::memory_order_relaxed);
+                producer.resume();
+
+                m_initial_state = promise.m_state.load(std::memory_order_acquire);
+            }
+
+          public:
+            bool await_ready() const noexcept {
+                return m_initial_state == state::value_ready_producer_suspended;
+            }
+
+            bool await_suspend(gap::coroutine_handle<> consumer) noexcept {
+                m_promise->m_consumer_coroutine = consumer;
+
+                // Races with the producer yielding on another thread. If the
+                // CAS fails the value became ready and we carry on instead.
+                auto old_state = state::value_not_ready_consumer_active;
+                return m_promise->m_state.compare_exchange_strong(
+                    old_state, state::value_not_ready_consumer_suspended,
+                    std::memory_order_release, std::memory_order_acquire
+                );
+            }
+
+          protected:
+            async_generator_promise_base *m_promise;
+
+          private:
+            state m_initial_state;
+        };
+
+        template< typename T >
+        struct async_generator_increment_operation final : async_generator_advance_operation
+        {
+            explicit async_generator_increment_operation(async_generator_iterator< T > &iterator) noexcept
+                : async_generator_advance_operation(
+                    iterator.m_coroutine.promise(), iterator.m_coroutine
+                )
+                , m_iterator(iterator)
+            {}
+
+            async_generator_iterator< T >& await_resume();
+
+          private:
+            async_generator_iterator< T > &m_iterator;
+        };
+
+        template< typename T >
+        struct async_generator_iterator final
+        {
+            using promise_type     = async_generator_promise< T >;
+            using handle_type      = gap::coroutine_handle< promise_type >;
+
+            using iterator_category = std::input_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = typename promise_type::value_type;
+            using reference         = typename promise_type::reference_type;
+            using pointer           = typename promise_type::pointer_type;
+
+            async_generator_iterator(std::nullptr_t) noexcept
+                : m_coroutine(nullptr)
+            {}
+
+            explicit async_generator_iterator(handle_type coroutine) noexcept
+                : m_coroutine(coroutine)
+            {}
+
+            // Awaiting the result advances the iterator, it compares equal to
+            // end() once the producer ran to completion.
+            //
+            //     for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it)
+            [[nodiscard]] async_generator_increment_operation< T > operator++() noexcept {
+                return async_generator_increment_operation< T >{ *this };
+            }
+
+            reference operator*() const noexcept { return m_coroutine.promise().value(); }
+
+            pointer operator->() const noexcept { return std::addressof(operator*()); }
+
+            bool operator==(const async_generator_iterator &other) const noexcept {
+                return m_coroutine == other.m_coroutine;
+            }
+
+            bool operator!=(const async_generator_iterator &other) const noexcept {
+                return !(*this == other);
+            }
+
+          private:
+            friend struct async_generator_increment_operation< T >;
+
+            handle_type m_coroutine;
+        };
+
+        template< typename T >
+        async_generator_iterator< T >& async_generator_increment_operation< T >::await_resume() {
+            if (m_promise->finished()) {
+                // Update the iterator first so that it compares equal to end()
+                // even if the exception is caught.
+                m_iterator = async_generator_iterator< T >{ nullptr };
+                m_promise->rethrow_if_unhandled_exception();
+            }
+
+            return m_iterator;
+        }
+
+        template< typename T >
+        struct async_generator_begin_operation final : async_generator_advance_operation
+        {
+            using promise_type = async_generator_promise< T >;
+            using handle_type  = gap::coroutine_handle< promise_type >;
+
+            async_generator_begin_operation(std::nullptr_t) noexcept
+                : async_generator_advance_operation(nullptr)
+            {}
+
+            explicit async_generator_begin_operation(handle_type producer) noexcept
+                : async_generator_advance_operation(producer.promise(), producer)
+            {}
+
+            bool await_ready() const noexcept {
+                return m_promise == nullptr || async_generator_advance_operation::await_ready();
+            }
+
+            async_generator_iterator< T > await_resume() {
+                if (m_promise == nullptr) {
+                    // Called begin() on the empty generator.
+                    return async_generator_iterator< T >{ nullptr };
+                }
+
+                if (m_promise->finished()) {
+                    // Completed without yielding any values.
+                    m_promise->rethrow_if_unhandled_exception();
+                    return async_generator_iterator< T >{ nullptr };
+                }
+
+                return async_generator_iterator< T >{
+                    handle_type::from_promise(*static_cast< promise_type* >(m_promise))
+                };
+            }
+        };
+
+    } // namespace detail
+
+    // A generator whose producer may 'co_await' between values, e.g. to wait
+    // for I/O or to hop onto a thread pool. Values are consumed by awaiting
+    // the iterator operations:
+    //
+    //     for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) {
+    //         use(*it);
+    //     }
+    //
+    // Each value is handed to the consumer without any buffering, the
+    // producer is only resumed once the consumer asks for the next one.
+    template< typename T >
+    struct [[nodiscard]] async_generator
+    {
+        using promise_type = detail::async_generator_promise< T >;
+        using iterator     = detail::async_generator_iterator< T >;
+
+        async_generator() noexcept
+            : m_coroutine(nullptr)
+        {}
+
+        explicit async_generator(promise_type &promise) noexcept
+            : m_coroutine(gap::coroutine_handle< promise_type >::from_promise(promise))
+        {}
+
+        async_generator(async_generator &&other) noexcept
+            : m_coroutine(std::exchange(other.m_coroutine, nullptr))
+        {}
+
+        async_generator(const async_generator &other) = delete;
+        async_generator& operator=(const async_generator &other) = delete;
+
+        // The producer is always suspended when the consumer is not awaiting
+        // one of the iterator operations, so it can be destroyed right away.
+        ~async_generator() {
+            if (m_coroutine) {
+                m_coroutine.destroy();
+            }
+        }
+
+        async_generator& operator=(async_generator &&other) noexcept {
+            async_generator temp(std::move(other));
+            swap(temp);
+            return *this;
+        }
+
+        auto begin() noexcept {
+            if (!m_coroutine) {
+                return detail::async_generator_begin_operation< T >{ nullptr };
+            }
+
+            return detail::async_generator_begin_operation< T >{ m_coroutine };
+        }
+
+        auto end() noexcept { return iterator{ nullptr }; }
+
+        void swap(async_generator &other) noexcept {
+            using std::swap;
+            swap(m_coroutine, other.m_coroutine);
+        }
+
+      private:
+        gap::coroutine_handle< promise_type > m_coroutine;
+    };
+
+    template< typename T >
+    void swap(async_generator< T > &a, async_generator< T > &b) noexcept {
+        a.swap(b);
+    }
+
+    namespace detail
+    {
+        template< typename T >
+        async_generator< T > async_generator_promise< T >::get_return_object() noexcept {
+            return async_generator< T >{ *this };
+        }
+
+    } // namespace detail
+
+} // namespace gap::coro
+
+#endif
@@ -0,0 +1,57 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/async_latch.hpp from the cppcoro
+// project. The original file is licenced under the MIT license and the
+// original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/async_manual_reset_event.hpp>
+
+    #include <atomic>
+    #include <cstddef>
+
+namespace gap::coro
+{
+    // A single-use countdown. Coroutines awaiting the latch are resumed,
+    // inline on the thread that performs the final count_down(), once the
+    // count reaches zero. Counting down is a single atomic decrement.
+    struct async_latch
+    {
+        // Constructs the latch with 'initial_count'. A latch constructed
+        // with a count of zero or less is already ready.
+        explicit async_latch(std::ptrdiff_t initial_count) noexcept
+            : m_count(initial_count)
+            , m_event(initial_count <= 0)
+        {}
+
+        async_latch(const async_latch &) = delete;
+        async_latch &operator=(const async_latch &) = delete;
+
+        bool is_ready() const noexcept { return m_event.is_set(); }
+
+        // Decrements the count by 'n', resuming the awaiting coroutines once
+        // it reaches zero.
+        void count_down(std::ptrdiff_t n = 1) noexcept {
+            if (m_count.fetch_sub(n, std::memory_order_acq_rel) <= n) {
+                m_event.set();
+            }
+        }
+
+        auto operator co_await() const noexcept { return m_event.operator co_await(); }
+
+      private:
+        std::atomic< std::ptrdiff_t > m_count;
+        async_manual_reset_event m_event;
+    };
+
+} // namespace gap::coro
+
+#endif
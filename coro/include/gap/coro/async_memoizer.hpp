@@ -0,0 +1,225 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/shared_task.hpp>
+
+    #include <cstddef>
+    #include <cstdint>
+    #include <functional>
+    #include <memory>
+    #include <mutex>
+    #include <type_traits>
+    #include <unordered_map>
+    #include <utility>
+
+namespace gap::coro
+{
+    struct memoizer_statistics {
+        // Calls that found a completed result.
+        std::uint64_t hits = 0;
+        // Calls that started a new computation.
+        std::uint64_t misses = 0;
+        // Calls that joined a computation still in flight.
+        std::uint64_t joins = 0;
+        // Completed entries dropped, by the capacity or evict_completed().
+        std::uint64_t evictions = 0;
+    };
+
+    //
+    // Asynchronous counterpart of gap::memoizer, safe to call from many
+    // threads at once. Each key maps to the shared_task computing its result:
+    //
+    //     auto summaries = async_memoize< function_id >(
+    //         [&](const function_id &id) -> task< summary > {
+    //             co_return co_await summarize(id);
+    //         }
+    //     );
+    //
+    //     summary s = co_await summaries(id);
+    //
+    // The first caller of a key starts the computation, every caller of the
+    // same key that comes while it runs awaits the same shared_task, and later
+    // callers get the stored result. Computations are not run under any lock.
+    //
+    // Keys are spread over independently locked shards. With a capacity set,
+    // a shard that grows past its share of it drops completed entries, in no
+    // particular order, until it is down to half of it. Computations in
+    // flight are never dropped. A computation that throws is forgotten, so
+    // that the next caller of the key retries it, while its current awaiters
+    // all see the exception.
+    //
+    // The memoizer must outlive the computations it starts. Awaiting the
+    // returned shared_task yields a reference into it, which is only safe to
+    // keep while the caller holds on to the shared_task as well, since the
+    // entry may be evicted at any time.
+    //
+    template< typename key_t, typename function_t, typename hash_t = std::hash< key_t > >
+    struct async_memoizer
+    {
+        using key_type      = key_t;
+        using function_type = function_t;
+        using result_type   = std::remove_reference_t<
+            await_result_t< std::invoke_result_t< function_t&, const key_t& > >
+        >;
+        using task_type = shared_task< result_type >;
+
+        static constexpr std::size_t default_shards = 16;
+
+        // A capacity of 0 keeps every completed entry.
+        explicit async_memoizer(
+            function_type fn, std::size_t capacity = 0, std::size_t shards = default_shards
+        )
+            : m_fn(std::move(fn))
+            , m_shard_count(shards ? shards : 1)
+            , m_shards(std::make_unique< shard[] >(m_shard_count))
+            , m_shard_capacity(capacity ? (capacity + m_shard_count - 1) / m_shard_count : 0)
+        {}
+
+        async_memoizer(const async_memoizer &) = delete;
+        async_memoizer &operator=(const async_memoizer &) = delete;
+
+        // The task computing the result for 'key', shared with every other
+        // caller of the same key.
+        task_type operator()(const key_type &key) {
+            auto &s = shard_of(key);
+            std::lock_guard lock(s.m_mutex);
+
+            if (auto it = s.m_entries.find(key); it != s.m_entries.end()) {
+                if (it->second.m_task.is_ready()) {
+                    ++s.m_stats.hits;
+                } else {
+                    ++s.m_stats.joins;
+                }
+                return it->second.m_task;
+            }
+
+            ++s.m_stats.misses;
+            if (m_shard_capacity && s.m_entries.size() >= m_shard_capacity) {
+                evict_completed(s, m_shard_capacity / 2);
+            }
+
+            auto id   = s.m_next_id++;
+            auto task = compute(key, id);
+            s.m_entries.emplace(key, entry{ task, id });
+            return task;
+        }
+
+        bool cached(const key_type &key) const {
+            auto &s = shard_of(key);
+            std::lock_guard lock(s.m_mutex);
+            return s.m_entries.contains(key);
+        }
+
+        // Number of entries, computations in flight included.
+        std::size_t size() const {
+            std::size_t size = 0;
+            for (std::size_t i = 0; i < m_shard_count; ++i) {
+                std::lock_guard lock(m_shards[i].m_mutex);
+                size += m_shards[i].m_entries.size();
+            }
+            return size;
+        }
+
+        // Forgets the entry of 'key', the next call recomputes it. Awaiters
+        // of a computation in flight are not affected.
+        bool evict(const key_type &key) {
+            auto &s = shard_of(key);
+            std::lock_guard lock(s.m_mutex);
+            return s.m_entries.erase(key) != 0;
+        }
+
+        // Forgets every completed entry and returns how many there were.
+        std::size_t evict_completed() {
+            std::size_t evicted = 0;
+            for (std::size_t i = 0; i < m_shard_count; ++i) {
+                std::lock_guard lock(m_shards[i].m_mutex);
+                evicted += evict_completed(m_shards[i], 0);
+            }
+            return evicted;
+        }
+
+        memoizer_statistics statistics() const {
+            memoizer_statistics stats;
+            for (std::size_t i = 0; i < m_shard_count; ++i) {
+                std::lock_guard lock(m_shards[i].m_mutex);
+                const auto &shard_stats = m_shards[i].m_stats;
+                stats.hits      += shard_stats.hits;
+                stats.misses    += shard_stats.misses;
+                stats.joins     += shard_stats.joins;
+                stats.evictions += shard_stats.evictions;
+            }
+            return stats;
+        }
+
+      private:
+        struct entry {
+            task_type m_task;
+            // Tells the entry apart from a later one of the same key.
+            std::uint64_t m_id;
+        };
+
+        struct alignas(64) shard {
+            mutable std::mutex m_mutex;
+            std::unordered_map< key_type, entry, hash_t > m_entries;
+            std::uint64_t m_next_id = 0;
+            memoizer_statistics m_stats;
+        };
+
+        shard &shard_of(const key_type &key) const {
+            return m_shards[hash_t{}(key) % m_shard_count];
+        }
+
+        static std::size_t evict_completed(shard &s, std::size_t keep) {
+            std::size_t evicted = 0;
+            for (auto it = s.m_entries.begin(); it != s.m_entries.end() && s.m_entries.size() > keep;) {
+                if (it->second.m_task.is_ready()) {
+                    it = s.m_entries.erase(it);
+                    ++evicted;
+                } else {
+                    ++it;
+                }
+            }
+            s.m_stats.evictions += evicted;
+            return evicted;
+        }
+
+        task_type compute(key_type key, std::uint64_t id) {
+            try {
+                co_return co_await std::invoke(m_fn, std::as_const(key));
+            } catch (...) {
+                forget(key, id);
+                throw;
+            }
+        }
+
+        void forget(const key_type &key, std::uint64_t id) {
+            auto &s = shard_of(key);
+            std::lock_guard lock(s.m_mutex);
+            if (auto it = s.m_entries.find(key); it != s.m_entries.end() && it->second.m_id == id) {
+                s.m_entries.erase(it);
+            }
+        }
+
+        function_type m_fn;
+        std::size_t m_shard_count;
+        std::unique_ptr< shard[] > m_shards;
+        std::size_t m_shard_capacity;
+    };
+
+    template< typename key_t, typename function_t >
+    auto async_memoize(
+        function_t &&fn, std::size_t capacity = 0,
+        std::size_t shards = async_memoizer< key_t, std::decay_t< function_t > >::default_shards
+    ) {
+        return async_memoizer< key_t, std::decay_t< function_t > >(
+            std::forward< function_t >(fn), capacity, shards
+        );
+    }
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,161 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/async_mutex.hpp from the cppcoro
+// project. The original file is licenced under the MIT license and the
+// original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/coroutine.hpp>
+
+    #include <atomic>
+    #include <cstdint>
+    #include <mutex> // for std::adopt_lock_t
+
+namespace gap::coro
+{
+    struct async_mutex_lock;
+    struct async_mutex_lock_operation;
+    struct async_mutex_scoped_lock_operation;
+
+    // A mutex that can be locked asynchronously using 'co_await'.
+    //
+    // Ownership of the mutex is not tied to any particular thread. This allows
+    // the coroutine owning the lock to transition from one thread to another
+    // while holding a lock.
+    //
+    // Waiters are resumed in FIFO order. Unlocking the mutex while there are
+    // waiters hands ownership directly to the oldest one and resumes it inside
+    // the call to unlock(), so suspended waiters never block an OS thread.
+    struct async_mutex
+    {
+        // Construct to a mutex that is not currently locked.
+        async_mutex() noexcept;
+
+        // Destroys the mutex. The mutex must not be locked and there must be
+        // no outstanding lock operations.
+        ~async_mutex();
+
+        async_mutex(const async_mutex&) = delete;
+        async_mutex& operator=(const async_mutex&) = delete;
+
+        // Attempt to acquire a lock on the mutex without blocking.
+        //
+        // Returns true if the lock was acquired, false if the mutex was
+        // already locked. The caller is responsible for calling unlock().
+        bool try_lock() noexcept;
+
+        // Acquire a lock on the mutex asynchronously.
+        //
+        // The caller is responsible for calling unlock() once done with it.
+        async_mutex_lock_operation lock_async() noexcept;
+
+        // Acquire a lock on the mutex asynchronously, returning an object that
+        // will call unlock() automatically when it goes out of scope.
+        //
+        //     auto lock = co_await mutex.scoped_lock_async();
+        async_mutex_scoped_lock_operation scoped_lock_async() noexcept;
+
+        // Unlock the mutex. Must only be called by the current lock-holder.
+        //
+        // If there are lock operations waiting to acquire the mutex then the
+        // next one is resumed inside this call.
+        void unlock();
+
+      private:
+        friend struct async_mutex_lock_operation;
+
+        static constexpr std::uintptr_t not_locked = 1;
+
+        // assume == reinterpret_cast< std::uintptr_t >(static_cast< void* >(nullptr))
+        static constexpr std::uintptr_t locked_no_waiters = 0;
+
+        // This field provides synchronisation for the mutex.
+        //
+        // It can have three kinds of values:
+        // - not_locked
+        // - locked_no_waiters
+        // - a pointer to the head of a singly linked list of recently
+        //   queued async_mutex_lock_operation objects. This list is
+        //   in most-recently-queued order as new items are pushed onto
+        //   the front of the list.
+        std::atomic< std::uintptr_t > m_state;
+
+        // Linked list of async lock operations that are waiting to acquire
+        // the mutex. These operations will acquire the lock in the order
+        // they appear in this list. Waiters in this list will acquire the
+        // mutex before waiters added to the m_state list.
+        async_mutex_lock_operation *m_waiters;
+    };
+
+    // An object that holds onto a mutex lock for its lifetime and ensures
+    // that the mutex is unlocked when it is destructed.
+    //
+    // It is equivalent to a std::lock_guard object but requires that the
+    // result of co_await async_mutex::lock_async() is passed to the
+    // constructor rather than passing the async_mutex object itself.
+    struct async_mutex_lock
+    {
+        explicit async_mutex_lock(async_mutex &mutex, std::adopt_lock_t) noexcept
+            : m_mutex(&mutex)
+        {}
+
+        async_mutex_lock(async_mutex_lock &&other) noexcept
+            : m_mutex(other.m_mutex)
+        {
+            other.m_mutex = nullptr;
+        }
+
+        async_mutex_lock(const async_mutex_lock &other) = delete;
+        async_mutex_lock& operator=(const async_mutex_lock &other) = delete;
+
+        // Releases the lock.
+        ~async_mutex_lock() {
+            if (m_mutex != nullptr) {
+                m_mutex->unlock();
+            }
+        }
+
+      private:
+        async_mutex *m_mutex;
+    };
+
+    struct async_mutex_lock_operation
+    {
+        explicit async_mutex_lock_operation(async_mutex &mutex) noexcept
+            : m_mutex(mutex)
+        {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(gap::coroutine_handle<> awaiter) noexcept;
+        void await_resume() const noexcept {}
+
+      protected:
+        friend struct async_mutex;
+
+        async_mutex &m_mutex;
+
+      private:
+        async_mutex_lock_operation *m_next;
+        gap::coroutine_handle<> m_awaiter;
+    };
+
+    struct async_mutex_scoped_lock_operation : async_mutex_lock_operation
+    {
+        using async_mutex_lock_operation::async_mutex_lock_operation;
+
+        [[nodiscard]] async_mutex_lock await_resume() const noexcept {
+            return async_mutex_lock{ m_mutex, std::adopt_lock };
+        }
+    };
+
+} // namespace gap::coro
+
+#endif
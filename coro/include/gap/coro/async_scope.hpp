@@ -0,0 +1,147 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/frame_allocator.hpp>
+
+    #include <atomic>
+    #include <cassert>
+    #include <cstddef>
+    #include <exception>
+    #include <type_traits>
+    #include <utility>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        // An eagerly started coroutine that nobody awaits. Its frame is
+        // freed as soon as it runs to completion.
+        struct detached_task
+        {
+            struct promise_type : promise_allocator
+            {
+                detached_task get_return_object() const noexcept { return {}; }
+
+                gap::suspend_never initial_suspend() const noexcept { return {}; }
+                gap::suspend_never final_suspend() const noexcept { return {}; }
+
+                void return_void() const noexcept {}
+
+                // Exceptions are caught by the coroutine body.
+                void unhandled_exception() const noexcept { std::terminate(); }
+            };
+        };
+
+    } // namespace detail
+
+    //
+    // Owns fire-and-forget work without holding on to it. spawn() starts an
+    // awaitable in a detached coroutine and join() completes once all of the
+    // spawned work did:
+    //
+    //     async_scope scope;
+    //     for (auto &function : functions) {
+    //         scope.spawn(analyze(function));
+    //     }
+    //     co_await scope.join();
+    //
+    // Outstanding work is tracked by a single atomic counter, each finished
+    // coroutine frees its frame right away, so memory is proportional to the
+    // work still running rather than to everything spawned. The first
+    // exception thrown by spawned work is rethrown by join(), the rest are
+    // dropped.
+    //
+    // join() is awaited once. Spawned work may spawn more work until join()
+    // completes, and the scope has to be joined before it is destroyed.
+    //
+    struct async_scope
+    {
+        async_scope() noexcept = default;
+
+        async_scope(const async_scope &) = delete;
+        async_scope &operator=(const async_scope &) = delete;
+
+        ~async_scope() {
+            assert(m_count.load(std::memory_order_relaxed) == 0 && "async_scope was not joined");
+        }
+
+        // Starts 'work' inline on the calling thread, until its first
+        // suspension. Its result is discarded.
+        template< awaitable awaitable_t >
+        void spawn(awaitable_t &&work) {
+            on_work_started();
+            [](async_scope *scope, std::decay_t< awaitable_t > spawned) -> detail::detached_task {
+                try {
+                    co_await std::move(spawned);
+                } catch (...) {
+                    scope->on_failure(std::current_exception());
+                }
+                scope->on_work_finished();
+            }(this, std::forward< awaitable_t >(work));
+        }
+
+        // Number of spawned coroutines that did not finish yet.
+        std::size_t outstanding() const noexcept {
+            auto count = m_count.load(std::memory_order_acquire);
+            return m_joined.load(std::memory_order_relaxed) ? count : count - 1;
+        }
+
+        [[nodiscard]] auto join() noexcept {
+            struct awaiter
+            {
+                async_scope *m_scope;
+
+                bool await_ready() const noexcept { return false; }
+
+                // Drops the count held by the scope, the last coroutine to
+                // finish resumes the joiner.
+                bool await_suspend(gap::coroutine_handle<> continuation) noexcept {
+                    m_scope->m_joined.store(true, std::memory_order_relaxed);
+                    m_scope->m_continuation = continuation;
+                    return m_scope->m_count.fetch_sub(1, std::memory_order_acq_rel) > 1;
+                }
+
+                void await_resume() const {
+                    if (m_scope->m_exception) {
+                        std::rethrow_exception(std::exchange(m_scope->m_exception, nullptr));
+                    }
+                }
+            };
+
+            return awaiter{ this };
+        }
+
+      private:
+        void on_work_started() noexcept {
+            assert(m_count.load(std::memory_order_relaxed) != 0 && "spawn() after join() completed");
+            m_count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void on_work_finished() noexcept {
+            if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                m_continuation.resume();
+            }
+        }
+
+        void on_failure(std::exception_ptr exception) noexcept {
+            if (!m_failed.exchange(true, std::memory_order_relaxed)) {
+                m_exception = std::move(exception);
+            }
+        }
+
+        // Spawned coroutines plus one held by the scope until it is joined.
+        std::atomic< std::size_t > m_count = 1;
+        std::atomic< bool > m_joined = false;
+        std::atomic< bool > m_failed = false;
+        std::exception_ptr m_exception;
+        gap::coroutine_handle<> m_continuation;
+    };
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
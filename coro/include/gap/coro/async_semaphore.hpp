@@ -0,0 +1,98 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/coroutine.hpp>
+
+    #include <atomic>
+    #include <cstdint>
+    #include <mutex>
+
+namespace gap::coro
+{
+    struct async_semaphore_acquire_operation;
+
+    // A counting semaphore whose acquire operation can be awaited.
+    //
+    // 'm_count' holds the number of available permits when it is positive
+    // and minus the number of coroutines that are waiting, or about to
+    // wait, when it is negative. Acquiring or releasing a permit while the
+    // opposite side is idle is a single atomic operation. Only when a
+    // release meets a waiter does it take the mutex that guards the FIFO of
+    // suspended waiters.
+    //
+    // The waiter is resumed inside the call to release(). A release() made
+    // by a waiter that is being resumed that way leaves its waiters to the
+    // outer call, which resumes them one after the other, so that a chain
+    // of waiters releasing in turn does not grow the stack.
+    struct async_semaphore
+    {
+        explicit async_semaphore(std::int64_t initial_count = 0) noexcept;
+
+        // There must be no outstanding acquire operations.
+        ~async_semaphore();
+
+        async_semaphore(const async_semaphore&) = delete;
+        async_semaphore& operator=(const async_semaphore&) = delete;
+
+        // Take a permit if one is available without suspending.
+        bool try_acquire() noexcept;
+
+        // Awaits until a permit is available and takes it.
+        //
+        //     co_await semaphore.acquire();
+        //     ...
+        //     semaphore.release();
+        [[nodiscard]] async_semaphore_acquire_operation acquire() noexcept;
+
+        // Returns 'count' permits, resuming up to 'count' waiters.
+        void release(std::int64_t count = 1);
+
+        // Approximate number of available permits, negative if there are
+        // waiters. Only for diagnostics.
+        std::int64_t available() const noexcept {
+            return m_count.load(std::memory_order_relaxed);
+        }
+
+      private:
+        friend struct async_semaphore_acquire_operation;
+
+        bool enqueue_waiter(async_semaphore_acquire_operation *operation) noexcept;
+
+        std::atomic< std::int64_t > m_count;
+
+        std::mutex m_mutex;
+
+        // FIFO of suspended waiters, guarded by 'm_mutex'.
+        async_semaphore_acquire_operation *m_waiters_head = nullptr;
+        async_semaphore_acquire_operation *m_waiters_tail = nullptr;
+
+        // Permits handed over by release() to waiters that have already
+        // claimed their place in 'm_count' but have not queued themselves
+        // yet. Guarded by 'm_mutex'.
+        std::int64_t m_pending_handoffs = 0;
+    };
+
+    struct async_semaphore_acquire_operation
+    {
+        explicit async_semaphore_acquire_operation(async_semaphore &semaphore) noexcept
+            : m_semaphore(semaphore)
+        {}
+
+        bool await_ready() const noexcept { return m_semaphore.try_acquire(); }
+        bool await_suspend(gap::coroutine_handle<> awaiter) noexcept;
+        void await_resume() const noexcept {}
+
+      private:
+        friend struct async_semaphore;
+
+        async_semaphore &m_semaphore;
+        async_semaphore_acquire_operation *m_next = nullptr;
+        gap::coroutine_handle<> m_awaiter;
+    };
+
+} // namespace gap::coro
+
+#endif
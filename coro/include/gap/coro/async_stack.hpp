@@ -0,0 +1,195 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include "gap/coro/awaitable_traits.hpp"
+    #include "gap/coro/coroutine.hpp"
+    #include "gap/core/source_location.hpp"
+
+    #include <atomic>
+    #include <chrono>
+    #include <cstddef>
+    #include <cstdint>
+    #include <iosfwd>
+    #include <utility>
+    #include <vector>
+
+    // Async stack tracking is opt-in, configure with GAP_ENABLE_ASYNC_STACKS
+    // or define GAP_CORO_ASYNC_STACKS=1 consistently for every translation
+    // unit. When it is off tasks carry no extra state and no hooks run.
+    #ifndef GAP_CORO_ASYNC_STACKS
+        #define GAP_CORO_ASYNC_STACKS 0
+    #endif
+
+namespace gap::coro
+{
+    inline constexpr bool async_stacks_enabled = GAP_CORO_ASYNC_STACKS;
+
+    enum class task_state : std::uint8_t { created, running, suspended, completed };
+
+    // A task as seen in a captured async stack.
+    struct async_stack_frame
+    {
+        // The coroutine function the task runs, not where it was called or
+        // awaited from.
+        gap::source_location location;
+        task_state state;
+
+        // Suspend points the task went through and the time it spent running
+        // between them, so far.
+        std::size_t suspends;
+        std::chrono::nanoseconds running_time;
+    };
+
+    // A chain of tasks, the innermost one first, each awaited by the next.
+    using async_stack = std::vector< async_stack_frame >;
+
+    // Totals of all tasks running the same coroutine function.
+    struct task_profile
+    {
+        gap::source_location location;
+        std::size_t tasks;
+        std::size_t suspends;
+        std::chrono::nanoseconds running_time;
+    };
+
+    // The async stacks of all live tasks, one per task that no other live
+    // task awaits. Empty unless async stacks are enabled.
+    std::vector< async_stack > capture_async_stacks();
+
+    void dump_async_stacks(std::ostream &os);
+
+    // The coroutine functions whose tasks, both finished and live, spent
+    // the most time running, the hottest first.
+    std::vector< task_profile > hottest_tasks(std::size_t count = 10);
+
+    void dump_hottest_tasks(std::ostream &os, std::size_t count = 10);
+
+    // Forgets the totals of finished tasks.
+    void reset_task_profiles();
+
+    namespace detail
+    {
+        // Bookkeeping of a tracked task. Frames register themselves for
+        // the lifetime of the coroutine, their counters are updated by
+        // whichever thread runs the task and read by the dump functions.
+        struct async_frame
+        {
+            using clock = std::chrono::steady_clock;
+
+            explicit async_frame(gap::source_location location) noexcept;
+            ~async_frame();
+
+            async_frame(const async_frame &) = delete;
+            async_frame &operator=(const async_frame &) = delete;
+
+            void on_resume() noexcept {
+                m_resumed_at = clock::now();
+                m_state.store(task_state::running, std::memory_order_relaxed);
+            }
+
+            void on_suspend() noexcept {
+                account();
+                m_suspends.fetch_add(1, std::memory_order_relaxed);
+                m_state.store(task_state::suspended, std::memory_order_relaxed);
+            }
+
+            void on_complete() noexcept {
+                account();
+                m_state.store(task_state::completed, std::memory_order_relaxed);
+            }
+
+            // Called when the task is awaited, by the task it is awaited from
+            // if that one is tracked.
+            void set_parent(async_frame *parent) noexcept {
+                m_parent.store(parent, std::memory_order_relaxed);
+            }
+
+            // The tracked task that is suspending on this thread right now,
+            // while it starts or resumes the task it awaits.
+            static async_frame *&awaiting() noexcept {
+                static thread_local async_frame *frame = nullptr;
+                return frame;
+            }
+
+            async_stack_frame snapshot() const noexcept;
+
+            gap::source_location m_location;
+            std::atomic< async_frame* > m_parent = nullptr;
+            std::atomic< task_state > m_state    = task_state::created;
+            std::atomic< std::size_t > m_suspends = 0;
+            std::atomic< std::int64_t > m_running_ns = 0;
+
+            // Only touched by the thread running the task.
+            clock::time_point m_resumed_at{};
+
+            // Links of the registry of live frames, guarded by its mutex.
+            async_frame *m_prev = nullptr;
+            async_frame *m_next = nullptr;
+
+          private:
+            void account() noexcept {
+                auto elapsed = std::chrono::duration_cast< std::chrono::nanoseconds >(
+                    clock::now() - m_resumed_at
+                );
+                m_running_ns.fetch_add(elapsed.count(), std::memory_order_relaxed);
+            }
+        };
+
+        struct tracked_initial_suspend
+        {
+            async_frame &m_frame;
+
+            constexpr bool await_ready() const noexcept { return false; }
+            void await_suspend(gap::coroutine_handle<>) const noexcept {}
+            void await_resume() const noexcept { m_frame.on_resume(); }
+        };
+
+        // Wraps every awaiter a tracked task awaits on, to count the suspend
+        // and stop the clock while the task is suspended.
+        template< typename awaiter_t >
+        struct tracked_awaiter
+        {
+            awaiter_t m_awaiter;
+            async_frame &m_frame;
+            bool m_suspended = false;
+
+            decltype(auto) await_ready() { return m_awaiter.await_ready(); }
+
+            template< typename promise_t >
+            decltype(auto) await_suspend(gap::coroutine_handle< promise_t > coroutine) {
+                m_suspended = true;
+                m_frame.on_suspend();
+
+                // The task may run elsewhere as soon as it is handed over,
+                // after this only the thread-local slot is touched.
+                struct awaiting_scope
+                {
+                    async_frame *m_outer;
+                    ~awaiting_scope() { async_frame::awaiting() = m_outer; }
+                } scope{ std::exchange(async_frame::awaiting(), &m_frame) };
+
+                return m_awaiter.await_suspend(coroutine);
+            }
+
+            decltype(auto) await_resume() {
+                if (m_suspended) {
+                    m_frame.on_resume();
+                }
+                return m_awaiter.await_resume();
+            }
+        };
+
+        template< awaitable awaitable_t >
+        auto make_tracked_awaiter(awaitable_t &&awaitable, async_frame &frame) {
+            return tracked_awaiter< awaiter_type_t< awaitable_t > >{
+                get_awaiter(static_cast< awaitable_t&& >(awaitable)), frame
+            };
+        }
+
+    } // namespace detail
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
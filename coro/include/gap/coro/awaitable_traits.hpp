@@ -46,6 +46,13 @@ namespace gap::coro
     template< typename T >
     concept awaitable = awaiter< T > || has_member_co_await< T > || has_free_co_await< T >;
 
+    // Something that can resume a coroutine elsewhere, e.g. on one of its
+    // threads, through 'co_await s.schedule()'.
+    template< typename T >
+    concept scheduler = requires(T &s) {
+        { s.schedule() } -> awaiter;
+    };
+
     template< typename T >
     requires has_member_co_await< T >
     decltype(auto) get_awaiter(T &&t) noexcept(noexcept(static_cast< T&& >(t).operator co_await())) {
@@ -0,0 +1,308 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include "gap/coro/coroutine.hpp"
+    #include "gap/coro/frame_allocator.hpp"
+
+    #include <cstddef>
+    #include <exception>
+    #include <memory>
+    #include <iterator>
+    #include <span>
+    #include <type_traits>
+    #include <utility>
+
+namespace gap
+{
+    template< typename T, std::size_t batch_size = 256 >
+    struct batched_generator;
+
+    namespace detail
+    {
+        // The producer either 'co_yield's single elements, which are
+        // collected into an internal buffer of 'batch_size' elements and
+        // only suspend the coroutine once it is full, or 'co_yield's whole
+        // spans, which are handed to the consumer as they are and must stay
+        // valid until the coroutine is resumed.
+        template< typename T, std::size_t batch_size >
+        struct batched_generator_promise : coro::promise_allocator {
+            static_assert(batch_size > 0);
+
+            using value_type = std::remove_cvref_t< T >;
+            using batch_type = std::span< const value_type >;
+            using coroutine_handle = gap::coroutine_handle< batched_generator_promise >;
+
+            batched_generator_promise()
+                : m_buffer(std::allocator< value_type >{}.allocate(batch_size))
+            {}
+
+            ~batched_generator_promise() {
+                clear();
+                std::allocator< value_type >{}.deallocate(m_buffer, batch_size);
+            }
+
+            batched_generator_promise(const batched_generator_promise &) = delete;
+            batched_generator_promise &operator=(const batched_generator_promise &) = delete;
+
+            batched_generator< T, batch_size > get_return_object() noexcept;
+
+            constexpr gap::suspend_always initial_suspend() const noexcept { return {}; }
+            constexpr gap::suspend_always final_suspend() const noexcept { return {}; }
+
+            struct append_awaiter {
+                bool m_full;
+
+                bool await_ready() const noexcept { return !m_full; }
+                void await_suspend(gap::coroutine_handle<>) const noexcept {}
+                void await_resume() const noexcept {}
+            };
+
+            append_awaiter yield_value(const value_type &value) {
+                std::construct_at(m_buffer + m_size, value);
+                return { ++m_size == batch_size };
+            }
+
+            append_awaiter yield_value(value_type &&value) {
+                std::construct_at(m_buffer + m_size, std::move(value));
+                return { ++m_size == batch_size };
+            }
+
+            gap::suspend_always yield_value(batch_type batch) noexcept {
+                m_pending = batch;
+                return {};
+            }
+
+            gap::suspend_always yield_value(std::span< value_type > batch) noexcept {
+                return yield_value(batch_type(batch));
+            }
+
+            void unhandled_exception() { m_exception = std::current_exception(); }
+
+            void return_void() noexcept {}
+
+            // Don't allow any use of 'co_await' inside the generator coroutine.
+            template< typename U >
+            gap::suspend_never await_transform(U &&value) = delete;
+
+            // The next non-empty batch, resuming the producer only when
+            // nothing is left to hand out. An empty batch marks the end.
+            batch_type next_batch() {
+                if (m_buffer_taken) {
+                    clear();
+                    m_buffer_taken = false;
+                }
+
+                if (!m_pending.empty()) {
+                    return std::exchange(m_pending, batch_type{});
+                }
+
+                auto coroutine = coroutine_handle::from_promise(*this);
+                while (!coroutine.done()) {
+                    coroutine.resume();
+
+                    // Buffered elements go first, a span yielded after them
+                    // is handed out on the next call.
+                    if (m_size != 0) {
+                        m_buffer_taken = true;
+                        return { m_buffer, m_size };
+                    }
+
+                    if (!m_pending.empty()) {
+                        return std::exchange(m_pending, batch_type{});
+                    }
+                }
+
+                if (m_exception) {
+                    std::rethrow_exception(std::exchange(m_exception, nullptr));
+                }
+
+                return {};
+            }
+
+          private:
+            void clear() noexcept {
+                std::destroy_n(m_buffer, std::exchange(m_size, 0));
+            }
+
+            // Raw storage, so that elements need not be default constructible.
+            value_type *m_buffer;
+            std::size_t m_size = 0;
+            bool m_buffer_taken = false;
+            batch_type m_pending;
+            std::exception_ptr m_exception;
+        };
+
+        struct batched_generator_sentinel {};
+
+        // Iterates over the elements of the batches, resuming the producer
+        // only when a batch runs out.
+        template< typename promise_t >
+        struct batched_generator_iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = typename promise_t::value_type;
+            using reference         = const value_type&;
+            using pointer           = const value_type*;
+
+            batched_generator_iterator() noexcept = default;
+
+            explicit batched_generator_iterator(promise_t *promise)
+                : m_promise(promise)
+            {
+                load(m_promise->next_batch());
+            }
+
+            friend bool operator==(const batched_generator_iterator &it, batched_generator_sentinel) noexcept {
+                return it.m_current == it.m_end;
+            }
+
+            batched_generator_iterator &operator++() {
+                if (++m_current == m_end) [[unlikely]] {
+                    load(m_promise->next_batch());
+                }
+                return *this;
+            }
+
+            void operator++(int) { (void) operator++(); }
+
+            reference operator*() const noexcept { return *m_current; }
+            pointer operator->() const noexcept { return m_current; }
+
+          private:
+            void load(typename promise_t::batch_type batch) noexcept {
+                m_current = batch.data();
+                m_end     = batch.data() + batch.size();
+            }
+
+            promise_t *m_promise = nullptr;
+            pointer m_current    = nullptr;
+            pointer m_end        = nullptr;
+        };
+
+        // Iterates over the batches themselves.
+        template< typename promise_t >
+        struct batch_iterator {
+            using iterator_category = std::input_iterator_tag;
+            using difference_type   = std::ptrdiff_t;
+            using value_type        = typename promise_t::batch_type;
+            using reference         = value_type;
+
+            batch_iterator() noexcept = default;
+
+            explicit batch_iterator(promise_t *promise)
+                : m_promise(promise)
+                , m_batch(promise->next_batch())
+            {}
+
+            friend bool operator==(const batch_iterator &it, batched_generator_sentinel) noexcept {
+                return it.m_batch.empty();
+            }
+
+            batch_iterator &operator++() {
+                m_batch = m_promise->next_batch();
+                return *this;
+            }
+
+            void operator++(int) { (void) operator++(); }
+
+            reference operator*() const noexcept { return m_batch; }
+
+          private:
+            promise_t *m_promise = nullptr;
+            value_type m_batch;
+        };
+
+    } // namespace detail
+
+    // A generator whose consumers see a flat range of elements while the
+    // producer hands them out in batches, so that the coroutine is resumed
+    // once per batch rather than once per element. Tight loops can go over
+    // whole batches through 'batches()', as contiguous spans:
+    //
+    //     batched_generator< std::uint64_t > addresses() {
+    //         for (auto ea : ...) co_yield ea;
+    //     }
+    //
+    //     auto gen = addresses();
+    //     for (std::span< const std::uint64_t > batch : gen.batches())
+    //         for (auto ea : batch) ...
+    //
+    // Like 'generator' this is a single-pass range, iterate it either by
+    // element or by batch, but not both.
+    template< typename T, std::size_t batch_size >
+    struct [[nodiscard]] batched_generator {
+        using promise_type     = detail::batched_generator_promise< T, batch_size >;
+        using coroutine_handle = typename promise_type::coroutine_handle;
+
+        using iterator   = detail::batched_generator_iterator< promise_type >;
+        using value_type = typename promise_type::value_type;
+
+        struct batch_range {
+            detail::batch_iterator< promise_type > begin() {
+                using batch_iterator = detail::batch_iterator< promise_type >;
+                return m_promise ? batch_iterator{ m_promise } : batch_iterator{};
+            }
+            detail::batched_generator_sentinel end() noexcept { return {}; }
+
+            promise_type *m_promise;
+        };
+
+        batched_generator() noexcept = default;
+
+        batched_generator(batched_generator &&other) noexcept
+            : m_coroutine(std::exchange(other.m_coroutine, nullptr))
+        {}
+
+        batched_generator(const batched_generator &other) = delete;
+
+        ~batched_generator() {
+            if (m_coroutine) {
+                m_coroutine.destroy();
+            }
+        }
+
+        batched_generator &operator=(batched_generator other) noexcept {
+            swap(other);
+            return *this;
+        }
+
+        iterator begin() {
+            return m_coroutine ? iterator{ &m_coroutine.promise() } : iterator{};
+        }
+
+        detail::batched_generator_sentinel end() noexcept { return {}; }
+
+        batch_range batches() & noexcept {
+            return { m_coroutine ? &m_coroutine.promise() : nullptr };
+        }
+
+        // The range would outlive the generator in 'for (... : gen().batches())'.
+        batch_range batches() && = delete;
+
+        void swap(batched_generator &other) noexcept { std::swap(m_coroutine, other.m_coroutine); }
+
+      private:
+        friend promise_type;
+
+        explicit batched_generator(coroutine_handle coroutine) noexcept
+            : m_coroutine(coroutine)
+        {}
+
+        coroutine_handle m_coroutine = nullptr;
+    };
+
+    namespace detail
+    {
+        template< typename T, std::size_t batch_size >
+        batched_generator< T, batch_size >
+        batched_generator_promise< T, batch_size >::get_return_object() noexcept {
+            return batched_generator< T, batch_size >{ coroutine_handle::from_promise(*this) };
+        }
+    } // namespace detail
+
+} // namespace gap
+
+#endif // GAP_ENABLE_COROUTINES
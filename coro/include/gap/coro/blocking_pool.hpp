@@ -0,0 +1,199 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/scheduler_ref.hpp>
+
+    #include <chrono>
+    #include <condition_variable>
+    #include <cstddef>
+    #include <cstdint>
+    #include <exception>
+    #include <functional>
+    #include <memory>
+    #include <mutex>
+    #include <optional>
+    #include <type_traits>
+    #include <utility>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        struct blocking_work
+        {
+            using execute_fn = void (*)(blocking_work *work) noexcept;
+
+            explicit blocking_work(execute_fn execute) noexcept : m_execute(execute) {}
+
+            execute_fn m_execute;
+            blocking_work *m_next = nullptr;
+        };
+
+    } // namespace detail
+
+    // Threads for calls that block, such as file reads, external solvers or
+    // LLVM passes that take locks, so that they don't stall the workers of a
+    // compute pool:
+    //
+    //     co_await pool.schedule();
+    //     auto bytes = co_await run_blocking([&] { return read_file(path); });
+    //     // back on 'pool'
+    //
+    // The pool is elastic. A thread is started whenever work is queued and
+    // no idle thread is there to take it, up to 'max_threads', and threads
+    // that stay idle for 'idle_timeout' exit. Calls made beyond 'max_threads'
+    // wait in FIFO order.
+    //
+    // The awaiting coroutine is resumed on the scheduler it was running on,
+    // found through scheduler_ref::current(), or on one passed explicitly.
+    // Awaited from a thread that belongs to no scheduler, it resumes on the
+    // blocking thread.
+    struct blocking_pool
+    {
+        static constexpr std::uint32_t default_max_threads = 256;
+        static constexpr std::chrono::milliseconds default_idle_timeout = std::chrono::seconds(10);
+
+        template< typename function_t >
+        struct run_operation : private detail::blocking_work
+        {
+            using result_t = std::invoke_result_t< function_t& >;
+
+            run_operation(blocking_pool &pool, function_t function, scheduler_ref resume_on)
+                : detail::blocking_work(&execute)
+                , m_pool(pool)
+                , m_function(std::move(function))
+                , m_resume_on(resume_on)
+            {}
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(gap::coroutine_handle<> awaiting_coroutine) {
+                m_awaiting_coroutine = awaiting_coroutine;
+                if (!m_resume_on) {
+                    m_resume_on = scheduler_ref::current();
+                }
+                m_pool.submit(this);
+            }
+
+            result_t await_resume() {
+                if (m_exception) {
+                    std::rethrow_exception(m_exception);
+                }
+
+                if constexpr (std::is_reference_v< result_t >) {
+                    return static_cast< result_t >(**m_result);
+                } else if constexpr (!std::is_void_v< result_t >) {
+                    return std::move(*m_result);
+                }
+            }
+
+          private:
+            using stored_t = std::conditional_t<
+                std::is_reference_v< result_t >,
+                std::add_pointer_t< result_t >,
+                result_t
+            >;
+
+            static void execute(detail::blocking_work *work) noexcept {
+                auto &self = *static_cast< run_operation* >(work);
+                try {
+                    if constexpr (std::is_reference_v< result_t >) {
+                        self.m_result = std::addressof(std::invoke(self.m_function));
+                    } else if constexpr (std::is_void_v< result_t >) {
+                        std::invoke(self.m_function);
+                    } else {
+                        self.m_result.emplace(std::invoke(self.m_function));
+                    }
+                } catch (...) {
+                    self.m_exception = std::current_exception();
+                }
+
+                // The operation may be gone as soon as the coroutine resumes.
+                auto resume_on = self.m_resume_on;
+                resume_on.resume(self.m_awaiting_coroutine);
+            }
+
+            struct empty {};
+
+            blocking_pool &m_pool;
+            function_t m_function;
+            scheduler_ref m_resume_on;
+            gap::coroutine_handle<> m_awaiting_coroutine = nullptr;
+            std::conditional_t< std::is_void_v< result_t >, empty, std::optional< stored_t > > m_result;
+            std::exception_ptr m_exception;
+        };
+
+        explicit blocking_pool(
+            std::uint32_t max_threads = default_max_threads,
+            std::chrono::milliseconds idle_timeout = default_idle_timeout
+        );
+
+        // Waits for all queued calls to finish.
+        ~blocking_pool();
+
+        blocking_pool(const blocking_pool &) = delete;
+        blocking_pool &operator=(const blocking_pool &) = delete;
+
+        // The pool behind run_blocking().
+        static blocking_pool &global();
+
+        // Calls 'function' on a blocking thread and resumes with its result.
+        template< typename function_t >
+        [[nodiscard]] run_operation< std::decay_t< function_t > > run(
+            function_t &&function, scheduler_ref resume_on = {}
+        ) {
+            return { *this, std::forward< function_t >(function), resume_on };
+        }
+
+        std::uint32_t max_threads() const noexcept { return m_max_threads; }
+
+        // Threads currently alive, busy or idle.
+        std::uint32_t thread_count() const;
+        std::uint32_t idle_thread_count() const;
+
+      private:
+        void submit(detail::blocking_work *work);
+
+        void run_worker_thread() noexcept;
+
+        const std::uint32_t m_max_threads;
+        const std::chrono::milliseconds m_idle_timeout;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_work_available;
+        std::condition_variable m_threads_exited;
+
+        // FIFO of calls waiting for a thread.
+        detail::blocking_work *m_head = nullptr;
+        detail::blocking_work *m_tail = nullptr;
+        std::size_t m_queued = 0;
+
+        std::uint32_t m_thread_count = 0;
+        std::uint32_t m_idle_thread_count = 0;
+        bool m_stop_requested = false;
+    };
+
+    // Calls 'function' on the global blocking pool and resumes the awaiting
+    // coroutine back on its scheduler.
+    template< typename function_t >
+    [[nodiscard]] auto run_blocking(function_t &&function) {
+        return blocking_pool::global().run(std::forward< function_t >(function));
+    }
+
+    // Calls 'function' on the global blocking pool and resumes the awaiting
+    // coroutine on 'scheduler'.
+    template< scheduler scheduler_t, typename function_t >
+    [[nodiscard]] auto run_blocking(scheduler_t &scheduler, function_t &&function) {
+        return blocking_pool::global().run(
+            std::forward< function_t >(function), scheduler_ref(scheduler)
+        );
+    }
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,85 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/core/on_scope_exit.hpp>
+    #include <gap/coro/async_semaphore.hpp>
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <cassert>
+    #include <cstddef>
+    #include <memory>
+    #include <ranges>
+    #include <type_traits>
+    #include <vector>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        // Results returned by rvalue reference refer into the awaited object,
+        // which the wrapping task does not outlive, so store them by value.
+        template< typename result_t >
+        using bounded_result_t = std::conditional_t<
+            std::is_rvalue_reference_v< result_t >, std::remove_cvref_t< result_t >, result_t
+        >;
+
+        template< awaitable awaitable_t, typename result_t = await_result_t< awaitable_t&& > >
+        requires (not std::is_void_v< result_t >)
+        task< bounded_result_t< result_t > > make_bounded_task(
+            std::shared_ptr< async_semaphore > semaphore, awaitable_t awaitable
+        ) {
+            co_await semaphore->acquire();
+            auto release = on_scope_exit([&semaphore]() noexcept { semaphore->release(); });
+            co_return co_await static_cast< awaitable_t&& >(awaitable);
+        }
+
+        template< awaitable awaitable_t, typename result_t = await_result_t< awaitable_t&& > >
+        requires std::is_void_v< result_t >
+        task<> make_bounded_task(std::shared_ptr< async_semaphore > semaphore, awaitable_t awaitable) {
+            co_await semaphore->acquire();
+            auto release = on_scope_exit([&semaphore]() noexcept { semaphore->release(); });
+            co_await static_cast< awaitable_t&& >(awaitable);
+        }
+
+    } // namespace detail
+
+    // Like when_all_ready_vec(), but at most 'max_in_flight' of the awaitables
+    // are started at any time. The remaining ones wait on a shared semaphore
+    // without having been started, so their state is only materialised once
+    // a slot frees up. Useful to cap peak memory when fanning out to a large
+    // number of tasks.
+    //
+    // Awaiting the result yields a std::vector of when_all_task, in the same
+    // order as the input range.
+    template< std::ranges::input_range range_t >
+    requires awaitable< std::ranges::range_value_t< range_t > >
+    auto bounded_when_all(range_t awaitables, std::size_t max_in_flight) {
+        assert(max_in_flight > 0);
+
+        using awaitable_t = std::ranges::range_value_t< range_t >;
+        using result_t    = detail::bounded_result_t< await_result_t< awaitable_t&& > >;
+
+        auto semaphore = std::make_shared< async_semaphore >(
+            static_cast< std::int64_t >(max_in_flight)
+        );
+
+        std::vector< task< result_t > > tasks;
+        if constexpr (std::ranges::sized_range< range_t >) {
+            tasks.reserve(std::ranges::size(awaitables));
+        }
+
+        for (auto &&awaitable : awaitables) {
+            tasks.push_back(detail::make_bounded_task(semaphore, std::move(awaitable)));
+        }
+
+        return when_all_ready_vec(std::move(tasks));
+    }
+
+} // namespace gap::coro
+
+#endif
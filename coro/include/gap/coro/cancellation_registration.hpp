@@ -0,0 +1,74 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/cancellation_registration.hpp
+// from the cppcoro project. The original file is licenced under the MIT
+// license and the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/cancellation_token.hpp>
+
+    #include <atomic>
+    #include <concepts>
+    #include <functional>
+    #include <utility>
+
+namespace gap::coro
+{
+    // Registers a callback to be invoked when cancellation is requested on
+    // the token, for as long as the registration object lives.
+    //
+    // If cancellation was already requested the callback runs inside the
+    // constructor, otherwise it runs on the thread that calls
+    // request_cancellation(). Destroying the registration guarantees that
+    // the callback is not running anymore, unless it is destroyed from inside
+    // the callback itself.
+    //
+    // An exception thrown by a callback that runs inside the constructor is
+    // thrown from the constructor. Inside request_cancellation() it calls
+    // std::terminate(), callbacks must not throw there.
+    struct cancellation_registration
+    {
+        template< typename callback_t >
+        requires std::constructible_from< std::function< void() >, callback_t&& >
+        cancellation_registration(cancellation_token token, callback_t &&callback)
+            : m_callback(std::forward< callback_t >(callback))
+        {
+            register_callback(std::move(token));
+        }
+
+        cancellation_registration(const cancellation_registration &other) = delete;
+        cancellation_registration& operator=(const cancellation_registration &other) = delete;
+
+        // Deregisters the callback, blocking while it is being executed by
+        // another thread.
+        ~cancellation_registration();
+
+      private:
+        friend struct detail::cancellation_state;
+
+        void register_callback(cancellation_token &&token);
+
+        detail::cancellation_state *m_state = nullptr;
+        std::function< void() > m_callback;
+
+        // The slot of the registration table holding this registration, or
+        // nullptr if the callback was never registered.
+        std::atomic< cancellation_registration* > *m_slot = nullptr;
+        std::atomic< bool > m_callback_completed = false;
+
+        // Set while the callback runs, the callback may destroy the
+        // registration it was registered with.
+        bool *m_destroyed_in_callback = nullptr;
+    };
+
+} // namespace gap::coro
+
+#endif
@@ -0,0 +1,68 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/cancellation_source.hpp from
+// the cppcoro project. The original file is licenced under the MIT license and
+// the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/cancellation_token.hpp>
+
+namespace gap::coro
+{
+    // The requesting side of cooperative cancellation. Hand out tokens with
+    // token() and call request_cancellation() to notify every operation that
+    // observes one of them.
+    struct cancellation_source
+    {
+        // Construct to a new cancellation source.
+        cancellation_source();
+
+        // Create a new reference to the same underlying cancellation source
+        // as 'other'.
+        cancellation_source(const cancellation_source &other) noexcept;
+        cancellation_source(cancellation_source &&other) noexcept;
+
+        ~cancellation_source();
+
+        cancellation_source& operator=(const cancellation_source &other) noexcept;
+        cancellation_source& operator=(cancellation_source &&other) noexcept;
+
+        // Query if this cancellation source can be cancelled.
+        //
+        // A cancellation source object will not be cancellable if it has
+        // previously been moved into another cancellation_source instance.
+        bool can_be_cancelled() const noexcept { return m_state != nullptr; }
+
+        // Obtain a cancellation token that can be used to query if
+        // cancellation has been requested on this source.
+        cancellation_token token() const noexcept;
+
+        // Request cancellation of operations that were passed an associated
+        // cancellation token.
+        //
+        // Any cancellation callback registered via a cancellation_registration
+        // object will be called inside this function by the first thread to
+        // call this method. A callback that throws terminates the program.
+        //
+        // This operation is a no-op if can_be_cancelled() returns false.
+        void request_cancellation();
+
+        // Query if some thread has called 'request_cancellation()' on this
+        // cancellation_source.
+        bool is_cancellation_requested() const noexcept;
+
+      private:
+        detail::cancellation_state *m_state;
+    };
+
+} // namespace gap::coro
+
+#endif
@@ -0,0 +1,75 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/cancellation_token.hpp from
+// the cppcoro project. The original file is licenced under the MIT license and
+// the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <utility>
+
+namespace gap::coro
+{
+    struct cancellation_source;
+    struct cancellation_registration;
+
+    namespace detail
+    {
+        struct cancellation_state;
+    } // namespace detail
+
+    // A token observed by cancellable operations. Tokens are cheap to copy,
+    // all copies refer to the state of the cancellation_source they were
+    // obtained from.
+    struct cancellation_token
+    {
+        // Construct to a token that can never have cancellation requested.
+        cancellation_token() noexcept;
+
+        cancellation_token(const cancellation_token &other) noexcept;
+        cancellation_token(cancellation_token &&other) noexcept;
+
+        ~cancellation_token();
+
+        cancellation_token& operator=(const cancellation_token &other) noexcept;
+        cancellation_token& operator=(cancellation_token &&other) noexcept;
+
+        void swap(cancellation_token &other) noexcept {
+            std::swap(m_state, other.m_state);
+        }
+
+        // Query whether it is possible that this operation will be cancelled
+        // or not.
+        //
+        // Cancellable operations may be able to take a more efficient path if
+        // they know they won't be cancelled.
+        bool can_be_cancelled() const noexcept;
+
+        // Query whether some thread has requested cancellation.
+        bool is_cancellation_requested() const noexcept;
+
+        // Throws gap::coro::operation_cancelled if cancellation has been
+        // requested.
+        void throw_if_cancellation_requested() const;
+
+      private:
+        friend struct cancellation_source;
+        friend struct cancellation_registration;
+
+        explicit cancellation_token(detail::cancellation_state *state) noexcept;
+
+        detail::cancellation_state *m_state;
+    };
+
+    inline void swap(cancellation_token &a, cancellation_token &b) noexcept { a.swap(b); }
+
+} // namespace gap::coro
+
+#endif
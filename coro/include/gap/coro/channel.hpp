@@ -0,0 +1,505 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/coroutine.hpp>
+
+    #include <atomic>
+    #include <cassert>
+    #include <cstddef>
+    #include <cstdint>
+    #include <exception>
+    #include <memory>
+    #include <mutex>
+    #include <new>
+    #include <optional>
+    #include <stdexcept>
+    #include <thread>
+    #include <type_traits>
+    #include <utility>
+
+namespace gap::coro
+{
+    // Exception thrown when sending to a channel that has been closed.
+    struct channel_closed : std::exception {
+        channel_closed() noexcept : std::exception() {}
+
+        const char* what() const noexcept override { return "channel closed"; }
+    };
+
+    template< typename T >
+    requires std::is_nothrow_move_constructible_v< T >
+    struct channel;
+
+    template< typename T >
+    struct channel_send_operation;
+
+    template< typename T >
+    struct channel_receive_operation;
+
+    namespace detail
+    {
+        struct channel_waiter
+        {
+            channel_waiter *m_next = nullptr;
+            gap::coroutine_handle<> m_awaiter;
+        };
+
+        struct channel_waiter_list
+        {
+            bool empty() const noexcept { return m_head == nullptr; }
+
+            channel_waiter *front() const noexcept { return m_head; }
+
+            void push_back(channel_waiter *waiter) noexcept {
+                waiter->m_next = nullptr;
+                if (m_tail != nullptr) {
+                    m_tail->m_next = waiter;
+                } else {
+                    m_head = waiter;
+                }
+                m_tail = waiter;
+            }
+
+            channel_waiter *pop_front() noexcept {
+                auto *waiter = m_head;
+                m_head = waiter->m_next;
+                if (m_head == nullptr) {
+                    m_tail = nullptr;
+                }
+                return waiter;
+            }
+
+            bool contains(const channel_waiter *waiter) const noexcept {
+                for (auto *it = m_head; it != nullptr; it = it->m_next) {
+                    if (it == waiter) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Resumes every waiter but 'skip'. The list must not be touched
+            // afterwards, the waiters live in the resumed coroutine frames.
+            void resume_all(const channel_waiter *skip = nullptr) noexcept {
+                auto *waiter = m_head;
+                while (waiter != nullptr) {
+                    auto *next = waiter->m_next;
+                    if (waiter != skip) {
+                        waiter->m_awaiter.resume();
+                    }
+                    waiter = next;
+                }
+            }
+
+          private:
+            channel_waiter *m_head = nullptr;
+            channel_waiter *m_tail = nullptr;
+        };
+
+    } // namespace detail
+
+    // A bounded multi-producer multi-consumer channel.
+    //
+    // Values are stored in a fixed-capacity ring buffer whose cells carry a
+    // sequence number, so that senders and receivers claim cells with a
+    // single CAS on the enqueue or dequeue position. As long as the channel
+    // is neither full nor empty, send and receive complete synchronously
+    // without taking a lock.
+    //
+    // A sender that finds the channel full, or a receiver that finds it
+    // empty, takes the mutex and queues itself. The opposite side checks for
+    // queued waiters after each fast path operation and serves them in FIFO
+    // order, moving values between the buffer and the suspended operations.
+    // Waiters are resumed on the thread that served them.
+    //
+    //     co_await ch.send(value);
+    //     while (auto value = co_await ch.receive()) { ... }
+    //
+    // Once the channel is closed sending throws channel_closed, receivers
+    // still drain the buffered values and then receive std::nullopt. The
+    // closed flag lives in the same atomic as the enqueue position, so that
+    // no sender can slip a value in after close() has told the receivers
+    // that the channel is drained.
+    template< typename T >
+    requires std::is_nothrow_move_constructible_v< T >
+    struct channel
+    {
+        using value_type = T;
+
+        explicit channel(std::size_t capacity)
+            : m_capacity(capacity)
+        {
+            if (capacity == 0) {
+                throw std::invalid_argument("channel capacity must be positive");
+            }
+
+            m_cells = std::make_unique< cell[] >(capacity);
+            for (std::size_t i = 0; i < capacity; ++i) {
+                m_cells[i].m_sequence.store(2 * i, std::memory_order_relaxed);
+            }
+        }
+
+        // There must be no outstanding send or receive operations.
+        ~channel() {
+            assert(m_senders.empty() && m_receivers.empty());
+
+            std::optional< T > value;
+            while (try_pop(value)) {
+                value.reset();
+            }
+        }
+
+        channel(const channel&) = delete;
+        channel& operator=(const channel&) = delete;
+
+        std::size_t capacity() const noexcept { return m_capacity; }
+
+        // Awaits until the value is stored in the channel, throws
+        // channel_closed if the channel is or gets closed first.
+        [[nodiscard]] channel_send_operation< T > send(T value) noexcept;
+
+        // Awaits the next value, or std::nullopt once the channel is closed
+        // and all buffered values have been received.
+        [[nodiscard]] channel_receive_operation< T > receive() noexcept;
+
+        // Stores the value without suspending. Returns false, leaving
+        // 'value' untouched, if the channel is full or closed.
+        bool try_send(T &&value) { return push_and_notify(value); }
+
+        // Takes a value without suspending, if one is buffered.
+        std::optional< T > try_receive() {
+            std::optional< T > value;
+            pop_and_notify(value);
+            return value;
+        }
+
+        // Resumes all suspended senders with channel_closed and all
+        // suspended receivers with std::nullopt.
+        void close() {
+            detail::channel_waiter_list ready;
+            {
+                std::lock_guard lock(m_mutex);
+                if (is_closed()) {
+                    return;
+                }
+
+                auto state = m_enqueue_state.fetch_or(closed_bit, std::memory_order_acq_rel);
+                wait_for_pushes(state >> 1);
+
+                serve_waiters(ready);
+
+                while (!m_receivers.empty()) {
+                    ready.push_back(m_receivers.pop_front());
+                }
+                m_receivers_waiting.store(0, std::memory_order_relaxed);
+
+                while (!m_senders.empty()) {
+                    auto *sender = static_cast< channel_send_operation< T >* >(m_senders.pop_front());
+                    sender->m_closed = true;
+                    ready.push_back(sender);
+                }
+                m_senders_waiting.store(0, std::memory_order_relaxed);
+            }
+
+            ready.resume_all();
+        }
+
+        bool is_closed() const noexcept {
+            return m_enqueue_state.load(std::memory_order_acquire) & closed_bit;
+        }
+
+      private:
+        friend struct channel_send_operation< T >;
+        friend struct channel_receive_operation< T >;
+
+        struct cell
+        {
+            std::atomic< std::size_t > m_sequence;
+            alignas(T) unsigned char m_storage[sizeof(T)];
+        };
+
+        // Low bit of 'm_enqueue_state', the enqueue position is kept above
+        // it.
+        static constexpr std::size_t closed_bit = 1;
+
+        // A cell is free for the sender claiming position 'pos' when its
+        // sequence equals '2 * pos', and holds a value for the receiver
+        // claiming 'pos' when its sequence equals '2 * pos + 1'. Doubling
+        // the positions keeps a full cell apart from a free one even with a
+        // capacity of one.
+        bool try_push(T &value) noexcept {
+            auto state = m_enqueue_state.load(std::memory_order_relaxed);
+            for (;;) {
+                if (state & closed_bit) {
+                    return false;
+                }
+
+                auto pos  = state >> 1;
+                auto &c   = m_cells[pos % m_capacity];
+                auto seq  = c.m_sequence.load(std::memory_order_acquire);
+                auto diff = static_cast< std::intptr_t >(seq - 2 * pos);
+                if (diff == 0) {
+                    if (m_enqueue_state.compare_exchange_weak(
+                            state, state + 2, std::memory_order_relaxed))
+                    {
+                        ::new (static_cast< void* >(c.m_storage)) T(std::move(value));
+                        c.m_sequence.store(2 * pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false; // full
+                } else {
+                    state = m_enqueue_state.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Waits until the senders that claimed a position below 'end' have
+        // stored their value. They hold no lock and only move the value
+        // into the cell, so this is short.
+        void wait_for_pushes(std::size_t end) const noexcept {
+            for (auto pos = m_dequeue_pos.load(std::memory_order_acquire); pos < end; ++pos) {
+                auto &c = m_cells[pos % m_capacity];
+                while (c.m_sequence.load(std::memory_order_acquire) == 2 * pos) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        bool try_pop(std::optional< T > &value) noexcept {
+            auto pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                auto &c   = m_cells[pos % m_capacity];
+                auto seq  = c.m_sequence.load(std::memory_order_acquire);
+                auto diff = static_cast< std::intptr_t >(seq - (2 * pos + 1));
+                if (diff == 0) {
+                    if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        auto *stored = std::launder(reinterpret_cast< T* >(c.m_storage));
+                        value.emplace(std::move(*stored));
+                        stored->~T();
+                        c.m_sequence.store(2 * (pos + m_capacity), std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false; // empty
+                } else {
+                    pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // The fence pairs with the one in enqueue_and_serve(): either we see
+        // the waiter count, or the waiter sees our value or free cell.
+        bool push_and_notify(T &value) {
+            if (!try_push(value)) {
+                return false;
+            }
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_receivers_waiting.load(std::memory_order_relaxed) > 0) {
+                notify();
+            }
+            return true;
+        }
+
+        bool pop_and_notify(std::optional< T > &value) {
+            if (!try_pop(value)) {
+                return false;
+            }
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (m_senders_waiting.load(std::memory_order_relaxed) > 0) {
+                notify();
+            }
+            return true;
+        }
+
+        void notify() {
+            detail::channel_waiter_list ready;
+            {
+                std::lock_guard lock(m_mutex);
+                serve_waiters(ready);
+            }
+            ready.resume_all();
+        }
+
+        // Moves values out of the buffer into queued receivers and from
+        // queued senders into the buffer for as long as either side makes
+        // progress. Requires 'm_mutex' to be held.
+        void serve_waiters(detail::channel_waiter_list &ready) noexcept {
+            for (bool progress = true; progress;) {
+                progress = false;
+
+                while (!m_receivers.empty()) {
+                    auto *receiver = static_cast< channel_receive_operation< T >* >(m_receivers.front());
+                    if (!try_pop(receiver->m_value)) {
+                        break;
+                    }
+
+                    ready.push_back(m_receivers.pop_front());
+                    m_receivers_waiting.fetch_sub(1, std::memory_order_relaxed);
+                    progress = true;
+                }
+
+                while (!m_senders.empty()) {
+                    auto *sender = static_cast< channel_send_operation< T >* >(m_senders.front());
+                    if (!try_push(sender->m_value)) {
+                        break;
+                    }
+
+                    ready.push_back(m_senders.pop_front());
+                    m_senders_waiting.fetch_sub(1, std::memory_order_relaxed);
+                    progress = true;
+                }
+            }
+        }
+
+        // Queues the operation behind earlier waiters of the same kind and
+        // serves as many waiters as possible. Returns true if the operation
+        // stays queued, in which case it must not be touched anymore. The
+        // operation is not queued if the channel is already closed.
+        bool enqueue_and_serve(
+            detail::channel_waiter *operation,
+            detail::channel_waiter_list &waiters,
+            std::atomic< std::size_t > &waiting,
+            bool &closed
+        ) noexcept {
+            detail::channel_waiter_list ready;
+            bool served = false;
+            {
+                std::lock_guard lock(m_mutex);
+                if (is_closed()) {
+                    closed = true;
+                    return false;
+                }
+
+                waiters.push_back(operation);
+                waiting.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                serve_waiters(ready);
+                served = ready.contains(operation);
+            }
+
+            ready.resume_all(operation);
+            return !served;
+        }
+
+        const std::size_t m_capacity;
+        std::unique_ptr< cell[] > m_cells;
+
+        // The enqueue position shifted left by one, or'ed with closed_bit
+        // once the channel is closed.
+        alignas(64) std::atomic< std::size_t > m_enqueue_state = 0;
+        alignas(64) std::atomic< std::size_t > m_dequeue_pos = 0;
+
+        // Number of queued waiters, so that the fast paths can tell whether
+        // somebody needs to be woken up without taking the mutex.
+        alignas(64) std::atomic< std::size_t > m_senders_waiting = 0;
+        std::atomic< std::size_t > m_receivers_waiting = 0;
+
+        std::mutex m_mutex;
+
+        // FIFOs of suspended operations, guarded by 'm_mutex'.
+        detail::channel_waiter_list m_senders;
+        detail::channel_waiter_list m_receivers;
+    };
+
+    template< typename T >
+    struct channel_send_operation : detail::channel_waiter
+    {
+        channel_send_operation(channel< T > &ch, T &&value) noexcept
+            : m_channel(ch)
+            , m_value(std::move(value))
+        {}
+
+        // Senders that are already queued go first.
+        bool await_ready() {
+            if (m_channel.is_closed()) {
+                m_closed = true;
+                return true;
+            }
+
+            return m_channel.m_senders_waiting.load(std::memory_order_relaxed) == 0
+                && m_channel.push_and_notify(m_value);
+        }
+
+        bool await_suspend(gap::coroutine_handle<> awaiter) noexcept {
+            m_awaiter = awaiter;
+            return m_channel.enqueue_and_serve(
+                this, m_channel.m_senders, m_channel.m_senders_waiting, m_closed
+            );
+        }
+
+        void await_resume() const {
+            if (m_closed) {
+                throw channel_closed();
+            }
+        }
+
+      private:
+        friend struct channel< T >;
+
+        channel< T > &m_channel;
+        T m_value;
+        bool m_closed = false;
+    };
+
+    template< typename T >
+    struct channel_receive_operation : detail::channel_waiter
+    {
+        explicit channel_receive_operation(channel< T > &ch) noexcept
+            : m_channel(ch)
+        {}
+
+        // Receivers that are already queued go first.
+        bool await_ready() {
+            return m_channel.m_receivers_waiting.load(std::memory_order_relaxed) == 0
+                && m_channel.pop_and_notify(m_value);
+        }
+
+        bool await_suspend(gap::coroutine_handle<> awaiter) noexcept {
+            m_awaiter = awaiter;
+
+            bool closed = false;
+            if (m_channel.enqueue_and_serve(
+                    this, m_channel.m_receivers, m_channel.m_receivers_waiting, closed))
+            {
+                return true;
+            }
+
+            if (closed) {
+                // Values sent while the channel was being closed are still
+                // delivered.
+                m_channel.try_pop(m_value);
+            }
+            return false;
+        }
+
+        std::optional< T > await_resume() noexcept { return std::move(m_value); }
+
+      private:
+        friend struct channel< T >;
+
+        channel< T > &m_channel;
+        std::optional< T > m_value;
+    };
+
+    template< typename T >
+    requires std::is_nothrow_move_constructible_v< T >
+    channel_send_operation< T > channel< T >::send(T value) noexcept {
+        return channel_send_operation< T >{ *this, std::move(value) };
+    }
+
+    template< typename T >
+    requires std::is_nothrow_move_constructible_v< T >
+    channel_receive_operation< T > channel< T >::receive() noexcept {
+        return channel_receive_operation< T >{ *this };
+    }
+
+} // namespace gap::coro
+
+#endif
@@ -0,0 +1,58 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <cstddef>
+    #include <cstdint>
+    #include <iosfwd>
+    #include <vector>
+
+namespace gap::coro
+{
+    enum class coroutine_kind : std::uint8_t { task, shared_task };
+
+    enum class coroutine_event : std::uint8_t { create, resume, suspend, destroy };
+
+    // One lifecycle event as recorded by trace_hooks.
+    struct trace_record
+    {
+        // Nanoseconds on the steady clock.
+        std::int64_t time;
+        const void *coroutine;
+        // Small sequential number of the recording thread, starting at 1.
+        std::uint32_t thread;
+        coroutine_event event;
+        coroutine_kind kind;
+    };
+
+    // Events each thread keeps, older ones are overwritten.
+    inline constexpr std::size_t trace_ring_capacity = 8192;
+
+    // The default lifecycle hooks. Every thread records into a ring buffer
+    // of its own without locking, the buffers are read while threads keep
+    // recording and recycled when threads exit.
+    struct trace_hooks
+    {
+        static void on_create(const void *coroutine, coroutine_kind kind) noexcept;
+        static void on_resume(const void *coroutine, coroutine_kind kind) noexcept;
+        static void on_suspend(const void *coroutine, coroutine_kind kind) noexcept;
+        static void on_destroy(const void *coroutine, coroutine_kind kind) noexcept;
+    };
+
+    // The recorded events still held by the ring buffers, ordered by time.
+    std::vector< trace_record > collect_coroutine_trace();
+
+    // Writes the recorded events as Chrome trace-event JSON, to be loaded
+    // in chrome://tracing or Perfetto. Each coroutine is an async span from
+    // creation to destruction and each stretch it ran is a slice on the
+    // thread that ran it.
+    void dump_chrome_trace(std::ostream &os);
+
+    // Forgets the events recorded so far.
+    void clear_coroutine_trace();
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,256 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <algorithm>
+    #include <bit>
+    #include <cstddef>
+    #include <memory>
+    #include <new>
+    #include <type_traits>
+
+    #if defined(__SANITIZE_ADDRESS__)
+        #define GAP_CORO_FRAME_RECYCLING 0
+    #elif defined(__has_feature)
+        #if __has_feature(address_sanitizer)
+            #define GAP_CORO_FRAME_RECYCLING 0
+        #endif
+    #endif
+
+    #ifndef GAP_CORO_FRAME_RECYCLING
+        #define GAP_CORO_FRAME_RECYCLING 1
+    #endif
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        // Per-thread cache of coroutine frames bucketed into power-of-two
+        // size classes. Frames are returned to the cache of the thread that
+        // destroys them, so a frame created on one thread and destroyed on
+        // another simply migrates between caches. Each bucket is bounded so
+        // that a burst of frames does not pin memory forever.
+        //
+        // Recycling is disabled under address sanitizer, which would
+        // otherwise miss use-after-free of recycled frames.
+        struct frame_recycler
+        {
+            static constexpr std::size_t min_block_size  = 64;
+            static constexpr std::size_t size_classes    = 8; // 64 B .. 8 KiB
+            static constexpr std::size_t max_cached_size = min_block_size << (size_classes - 1);
+            static constexpr std::size_t max_cached_per_class = 256;
+
+            static void *allocate(std::size_t size) {
+                if constexpr (GAP_CORO_FRAME_RECYCLING) {
+                    if (size <= max_cached_size) {
+                        auto &cache = thread_cache();
+                        auto index  = size_class(size);
+                        if (auto *block = cache.m_free[index]) {
+                            cache.m_free[index] = block->m_next;
+                            --cache.m_count[index];
+                            return block;
+                        }
+
+                        return ::operator new(class_size(index));
+                    }
+                }
+
+                return ::operator new(size);
+            }
+
+            static void deallocate(void *ptr, std::size_t size) noexcept {
+                if constexpr (GAP_CORO_FRAME_RECYCLING) {
+                    if (size <= max_cached_size) {
+                        auto index  = size_class(size);
+                        auto &cache = thread_cache();
+                        if (cache.m_alive && cache.m_count[index] < max_cached_per_class) {
+                            cache.m_free[index] = ::new (ptr) free_block{ cache.m_free[index] };
+                            ++cache.m_count[index];
+                            return;
+                        }
+
+                        ::operator delete(ptr, class_size(index));
+                        return;
+                    }
+                }
+
+                ::operator delete(ptr, size);
+            }
+
+          private:
+            struct free_block
+            {
+                free_block *m_next;
+            };
+
+            // Trivially destructible so that it stays usable while other
+            // thread-local objects (which may own coroutines) are destroyed.
+            struct cache_state
+            {
+                free_block *m_free[size_classes];
+                std::size_t m_count[size_classes];
+                bool m_alive;
+            };
+
+            struct cache_cleanup
+            {
+                ~cache_cleanup() {
+                    auto &cache   = state();
+                    cache.m_alive = false;
+                    for (std::size_t index = 0; index < size_classes; ++index) {
+                        while (auto *block = cache.m_free[index]) {
+                            cache.m_free[index] = block->m_next;
+                            ::operator delete(block, class_size(index));
+                        }
+                        cache.m_count[index] = 0;
+                    }
+                }
+            };
+
+            static std::size_t size_class(std::size_t size) noexcept {
+                return static_cast< std::size_t >(
+                    std::bit_width((std::max(size, min_block_size) - 1) / min_block_size)
+                );
+            }
+
+            static constexpr std::size_t class_size(std::size_t index) noexcept {
+                return min_block_size << index;
+            }
+
+            static cache_state &state() noexcept {
+                static thread_local cache_state cache{ {}, {}, true };
+                return cache;
+            }
+
+            static cache_state &thread_cache() noexcept {
+                static thread_local cache_cleanup cleanup;
+                (void) cleanup;
+                return state();
+            }
+        };
+
+        using deallocate_frame_fn = void (*)(void *frame, std::size_t size) noexcept;
+
+        // Every frame is followed by a pointer to the function that knows
+        // how to release it, optionally followed by the allocator that was
+        // passed to the coroutine.
+        constexpr std::size_t align_up(std::size_t size, std::size_t alignment) noexcept {
+            return (size + alignment - 1) & ~(alignment - 1);
+        }
+
+        constexpr std::size_t deallocate_fn_offset(std::size_t frame_size) noexcept {
+            return align_up(frame_size, alignof(deallocate_frame_fn));
+        }
+
+        inline deallocate_frame_fn &deallocate_fn_slot(void *frame, std::size_t size) noexcept {
+            auto *bytes = static_cast< std::byte* >(frame) + deallocate_fn_offset(size);
+            return *std::launder(reinterpret_cast< deallocate_frame_fn* >(bytes));
+        }
+
+        struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) aligned_block
+        {
+            std::byte m_data[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+        };
+
+        template< typename allocator_t >
+        using frame_block_allocator
+            = typename std::allocator_traits< allocator_t >::template rebind_alloc< aligned_block >;
+
+        template< typename allocator_t >
+        struct allocator_frame_layout
+        {
+            using block_allocator = frame_block_allocator< allocator_t >;
+
+            static constexpr std::size_t allocator_offset(std::size_t frame_size) noexcept {
+                return align_up(
+                    deallocate_fn_offset(frame_size) + sizeof(deallocate_frame_fn),
+                    alignof(block_allocator)
+                );
+            }
+
+            static constexpr std::size_t block_count(std::size_t frame_size) noexcept {
+                auto bytes = allocator_offset(frame_size) + sizeof(block_allocator);
+                return align_up(bytes, sizeof(aligned_block)) / sizeof(aligned_block);
+            }
+
+            static block_allocator *stored_allocator(void *frame, std::size_t size) noexcept {
+                auto *bytes = static_cast< std::byte* >(frame) + allocator_offset(size);
+                return std::launder(reinterpret_cast< block_allocator* >(bytes));
+            }
+
+            static void *allocate(std::size_t size, const allocator_t &allocator) {
+                block_allocator blocks(allocator);
+                auto *frame = static_cast< void* >(
+                    std::allocator_traits< block_allocator >::allocate(blocks, block_count(size))
+                );
+                ::new (static_cast< std::byte* >(frame) + allocator_offset(size))
+                    block_allocator(std::move(blocks));
+                deallocate_fn_slot(frame, size) = &deallocate;
+                return frame;
+            }
+
+            static void deallocate(void *frame, std::size_t size) noexcept {
+                auto *stored = stored_allocator(frame, size);
+                block_allocator blocks(std::move(*stored));
+                stored->~block_allocator();
+                std::allocator_traits< block_allocator >::deallocate(
+                    blocks, static_cast< aligned_block* >(frame), block_count(size)
+                );
+            }
+        };
+
+        inline void deallocate_recycled_frame(void *frame, std::size_t size) noexcept {
+            frame_recycler::deallocate(
+                frame, deallocate_fn_offset(size) + sizeof(deallocate_frame_fn)
+            );
+        }
+
+    } // namespace detail
+
+    // Base class for promise types that controls where coroutine frames live.
+    //
+    // By default frames are recycled through a per-thread cache. A coroutine
+    // that takes 'std::allocator_arg_t, const allocator_t&' as its leading
+    // parameters (after the implicit object parameter for member functions)
+    // has its frame allocated by a copy of that allocator instead:
+    //
+    //     task< int > compute(std::allocator_arg_t, arena_allocator alloc, int x);
+    //     co_await compute(std::allocator_arg, arena, 42);
+    struct promise_allocator
+    {
+        static void *operator new(std::size_t size) {
+            auto *frame = detail::frame_recycler::allocate(
+                detail::deallocate_fn_offset(size) + sizeof(detail::deallocate_frame_fn)
+            );
+            detail::deallocate_fn_slot(frame, size) = &detail::deallocate_recycled_frame;
+            return frame;
+        }
+
+        template< typename allocator_t, typename... args_t >
+        static void *operator new(
+            std::size_t size, std::allocator_arg_t, const allocator_t &allocator, const args_t&...
+        ) {
+            return detail::allocator_frame_layout< allocator_t >::allocate(size, allocator);
+        }
+
+        template< typename this_t, typename allocator_t, typename... args_t >
+        static void *operator new(
+            std::size_t size,
+            const this_t&,
+            std::allocator_arg_t,
+            const allocator_t &allocator,
+            const args_t&...
+        ) {
+            return detail::allocator_frame_layout< allocator_t >::allocate(size, allocator);
+        }
+
+        static void operator delete(void *frame, std::size_t size) noexcept {
+            detail::deallocate_fn_slot(frame, size)(frame, size);
+        }
+    };
+
+} // namespace gap::coro
+
+#endif
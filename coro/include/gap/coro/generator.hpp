@@ -14,6 +14,7 @@
 #ifdef GAP_ENABLE_COROUTINES
 
     #include "gap/coro/coroutine.hpp"
+    #include "gap/coro/frame_allocator.hpp"
     #include "gap/core/ranges.hpp"
 
     #include <concepts>
@@ -34,7 +35,7 @@ namespace gap
     namespace detail
     {
         template< typename T >
-        struct generator_promise_type {
+        struct generator_promise_type : coro::promise_allocator {
             using value_type     = std::remove_reference_t< T >;
             using reference_type = std::conditional_t< std::is_reference_v< T >, T, T& >;
             using pointer_type   = value_type*;
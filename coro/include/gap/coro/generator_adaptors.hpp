@@ -0,0 +1,326 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include "gap/coro/generator.hpp"
+
+    #include <cassert>
+    #include <cstddef>
+    #include <functional>
+    #include <iterator>
+    #include <type_traits>
+    #include <utility>
+    #include <vector>
+
+//
+// Lazy adaptors over generators that do not introduce coroutines of their
+// own. Every stage wraps the iterator of the stage before it, so a pipeline
+// such as
+//
+//     auto rows = lines() | coro::filter(non_empty) | coro::transform(parse)
+//               | coro::take_while(valid) | coro::enumerate | coro::chunk(64);
+//
+// resumes the 'lines' coroutine once per element and allocates no further
+// frames. Like generators the adapted ranges are single-pass. A pipeline
+// built on an lvalue refers to it, one built on an rvalue owns it.
+//
+namespace gap::coro
+{
+    namespace detail
+    {
+        template< typename range_t >
+        concept adaptable_range = requires(std::remove_reference_t< range_t > &range) {
+            range.begin();
+            range.end();
+        };
+
+        template< typename range_t >
+        using base_iterator_t = decltype(std::declval< std::remove_reference_t< range_t >& >().begin());
+
+        template< typename range_t >
+        using base_sentinel_t = decltype(std::declval< std::remove_reference_t< range_t >& >().end());
+
+        // Stores the adapted range, by reference if it was an lvalue.
+        template< typename range_t, typename fn_t >
+        struct adaptor_view_base
+        {
+            template< typename base_arg_t, typename fn_arg_t >
+            adaptor_view_base(base_arg_t &&base, fn_arg_t &&fn)
+                : m_base(std::forward< base_arg_t >(base))
+                , m_fn(std::forward< fn_arg_t >(fn))
+            {}
+
+            base_sentinel_t< range_t > end() { return m_base.end(); }
+
+            range_t m_base;
+            fn_t m_fn;
+        };
+
+        template< typename range_t, typename fn_t >
+        struct transform_view : adaptor_view_base< range_t, fn_t >
+        {
+            using adaptor_view_base< range_t, fn_t >::adaptor_view_base;
+
+            struct iterator
+            {
+                using base_iterator     = base_iterator_t< range_t >;
+                using iterator_category = std::input_iterator_tag;
+                using difference_type   = std::ptrdiff_t;
+                using reference = std::invoke_result_t< fn_t&, std::iter_reference_t< base_iterator > >;
+                using value_type = std::remove_cvref_t< reference >;
+
+                friend bool operator==(const iterator &it, const base_sentinel_t< range_t > &end) {
+                    return it.m_it == end;
+                }
+
+                iterator &operator++() {
+                    ++m_it;
+                    return *this;
+                }
+
+                void operator++(int) { ++*this; }
+
+                reference operator*() const { return std::invoke(m_view->m_fn, *m_it); }
+
+                transform_view *m_view = nullptr;
+                base_iterator m_it;
+            };
+
+            iterator begin() { return { this, this->m_base.begin() }; }
+        };
+
+        template< typename range_t, typename fn_t >
+        struct filter_view : adaptor_view_base< range_t, fn_t >
+        {
+            using adaptor_view_base< range_t, fn_t >::adaptor_view_base;
+
+            struct iterator
+            {
+                using base_iterator     = base_iterator_t< range_t >;
+                using iterator_category = std::input_iterator_tag;
+                using difference_type   = std::ptrdiff_t;
+                using reference         = std::iter_reference_t< base_iterator >;
+                using value_type        = std::iter_value_t< base_iterator >;
+
+                friend bool operator==(const iterator &it, const base_sentinel_t< range_t > &end) {
+                    return it.m_it == end;
+                }
+
+                iterator &operator++() {
+                    ++m_it;
+                    skip();
+                    return *this;
+                }
+
+                void operator++(int) { ++*this; }
+
+                reference operator*() const { return *m_it; }
+
+                void skip() {
+                    auto end = m_view->m_base.end();
+                    while (m_it != end && !std::invoke(m_view->m_fn, *m_it)) {
+                        ++m_it;
+                    }
+                }
+
+                filter_view *m_view = nullptr;
+                base_iterator m_it;
+            };
+
+            iterator begin() {
+                iterator it{ this, this->m_base.begin() };
+                it.skip();
+                return it;
+            }
+        };
+
+        template< typename range_t, typename fn_t >
+        struct take_while_view : adaptor_view_base< range_t, fn_t >
+        {
+            using adaptor_view_base< range_t, fn_t >::adaptor_view_base;
+
+            struct iterator
+            {
+                using base_iterator     = base_iterator_t< range_t >;
+                using iterator_category = std::input_iterator_tag;
+                using difference_type   = std::ptrdiff_t;
+                using reference         = std::iter_reference_t< base_iterator >;
+                using value_type        = std::iter_value_t< base_iterator >;
+
+                friend bool operator==(const iterator &it, const base_sentinel_t< range_t > &end) {
+                    return it.m_done || it.m_it == end;
+                }
+
+                iterator &operator++() {
+                    ++m_it;
+                    check();
+                    return *this;
+                }
+
+                void operator++(int) { ++*this; }
+
+                reference operator*() const { return *m_it; }
+
+                // Stops for good at the first element that fails, without
+                // pulling any further elements from the source.
+                void check() {
+                    m_done = m_it == m_view->m_base.end() || !std::invoke(m_view->m_fn, *m_it);
+                }
+
+                take_while_view *m_view = nullptr;
+                base_iterator m_it;
+                bool m_done = false;
+            };
+
+            iterator begin() {
+                iterator it{ this, this->m_base.begin() };
+                it.check();
+                return it;
+            }
+        };
+
+        template< typename range_t >
+        struct enumerate_view : adaptor_view_base< range_t, std::size_t >
+        {
+            using adaptor_view_base< range_t, std::size_t >::adaptor_view_base;
+
+            struct iterator
+            {
+                using base_iterator     = base_iterator_t< range_t >;
+                using iterator_category = std::input_iterator_tag;
+                using difference_type   = std::ptrdiff_t;
+                using reference  = std::pair< std::size_t, std::iter_reference_t< base_iterator > >;
+                using value_type = std::pair< std::size_t, std::iter_value_t< base_iterator > >;
+
+                friend bool operator==(const iterator &it, const base_sentinel_t< range_t > &end) {
+                    return it.m_it == end;
+                }
+
+                iterator &operator++() {
+                    ++m_it;
+                    ++m_index;
+                    return *this;
+                }
+
+                void operator++(int) { ++*this; }
+
+                reference operator*() const { return { m_index, *m_it }; }
+
+                base_iterator m_it;
+                std::size_t m_index = 0;
+            };
+
+            iterator begin() { return { this->m_base.begin(), this->m_fn }; }
+        };
+
+        // Groups consecutive elements into vectors of up to 'size' elements,
+        // the last one may be shorter.
+        template< typename range_t >
+        struct chunk_view : adaptor_view_base< range_t, std::size_t >
+        {
+            using adaptor_view_base< range_t, std::size_t >::adaptor_view_base;
+
+            struct iterator
+            {
+                using base_iterator     = base_iterator_t< range_t >;
+                using iterator_category = std::input_iterator_tag;
+                using difference_type   = std::ptrdiff_t;
+                using value_type        = std::vector< std::iter_value_t< base_iterator > >;
+                using reference         = value_type&;
+
+                friend bool operator==(const iterator &it, const base_sentinel_t< range_t > &) {
+                    return it.m_chunk.empty();
+                }
+
+                iterator &operator++() {
+                    fill();
+                    return *this;
+                }
+
+                void operator++(int) { ++*this; }
+
+                reference operator*() const { return m_chunk; }
+
+                void fill() {
+                    m_chunk.clear();
+                    auto end = m_view->m_base.end();
+                    while (m_chunk.size() < m_view->m_fn && m_it != end) {
+                        m_chunk.push_back(*m_it);
+                        ++m_it;
+                    }
+                }
+
+                chunk_view *m_view = nullptr;
+                base_iterator m_it;
+                mutable value_type m_chunk;
+            };
+
+            iterator begin() {
+                assert(this->m_fn > 0);
+                iterator it{ this, this->m_base.begin(), {} };
+                it.fill();
+                return it;
+            }
+        };
+
+        // The right-hand side of 'range | adaptor', holding the arguments of
+        // the adaptor until the range is known.
+        template< template< typename, typename... > class view_t, typename arg_t >
+        struct adaptor_closure
+        {
+            arg_t m_arg;
+
+            template< adaptable_range range_t >
+            friend auto operator|(range_t &&range, adaptor_closure closure) {
+                if constexpr (std::is_same_v< arg_t, std::size_t >) {
+                    return view_t< range_t >(std::forward< range_t >(range), closure.m_arg);
+                } else {
+                    return view_t< range_t, arg_t >(
+                        std::forward< range_t >(range), std::move(closure.m_arg)
+                    );
+                }
+            }
+        };
+
+        struct enumerate_closure
+        {
+            template< adaptable_range range_t >
+            friend auto operator|(range_t &&range, enumerate_closure) {
+                return enumerate_view< range_t >(std::forward< range_t >(range), std::size_t(0));
+            }
+        };
+
+    } // namespace detail
+
+    template< typename fn_t >
+    auto transform(fn_t &&fn) {
+        return detail::adaptor_closure< detail::transform_view, std::decay_t< fn_t > >{
+            std::forward< fn_t >(fn)
+        };
+    }
+
+    template< typename fn_t >
+    auto filter(fn_t &&fn) {
+        return detail::adaptor_closure< detail::filter_view, std::decay_t< fn_t > >{
+            std::forward< fn_t >(fn)
+        };
+    }
+
+    template< typename fn_t >
+    auto take_while(fn_t &&fn) {
+        return detail::adaptor_closure< detail::take_while_view, std::decay_t< fn_t > >{
+            std::forward< fn_t >(fn)
+        };
+    }
+
+    inline constexpr detail::enumerate_closure enumerate{};
+
+    inline auto chunk(std::size_t size) {
+        return detail::adaptor_closure< detail::chunk_view, std::size_t >{ size };
+    }
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,150 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/blocking_pool.hpp>
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/scheduler_ref.hpp>
+
+    #include <atomic>
+    #include <cstddef>
+    #include <cstdint>
+    #include <memory>
+    #include <thread>
+
+namespace gap::coro
+{
+    enum class io_backend : std::uint8_t
+    {
+        // io_uring where the kernel supports it, the blocking pool otherwise.
+        automatic,
+        blocking
+    };
+
+    struct io_statistics
+    {
+        std::uint64_t operations = 0;
+        // io_uring_enter calls, every one submits all operations queued
+        // since the previous call.
+        std::uint64_t submissions = 0;
+    };
+
+    // Runs file reads and writes for async_file. With io_uring, awaiting
+    // coroutines queue their operations on a lock-free stack and a single
+    // thread moves everything queued into the submission ring and submits
+    // it with the same io_uring_enter call that waits for completions, so
+    // a thousand reads issued together cost a handful of syscalls. Without
+    // io_uring, every operation is a pread or pwrite on the blocking pool.
+    //
+    // Coroutines resume on the scheduler they were running on, as with
+    // run_blocking(), or on the completion thread if they had none.
+    struct io_service
+    {
+        enum class opcode : std::uint8_t { read, write };
+
+        struct operation
+        {
+            operation(
+                io_service &service, opcode code, int fd, std::uint64_t offset, void *buffer,
+                std::size_t length
+            ) noexcept
+                : m_service(service)
+                , m_opcode(code)
+                , m_fd(fd)
+                , m_offset(offset)
+                , m_buffer(buffer)
+                , m_length(length)
+            {}
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept;
+
+            // Bytes transferred, or a negated errno value.
+            std::int64_t await_resume() const noexcept { return m_result; }
+
+          private:
+            friend struct io_service;
+
+            io_service &m_service;
+            opcode m_opcode;
+            int m_fd;
+            std::uint64_t m_offset;
+            void *m_buffer;
+            std::size_t m_length;
+            std::int64_t m_result = 0;
+            gap::coroutine_handle<> m_awaiting_coroutine = nullptr;
+            scheduler_ref m_resume_on;
+            operation *m_next = nullptr;
+        };
+
+        explicit io_service(
+            io_backend backend = io_backend::automatic,
+            std::uint32_t entries = 256,
+            blocking_pool &blocking = blocking_pool::global()
+        );
+
+        // Waits for all outstanding operations to complete.
+        ~io_service();
+
+        io_service(const io_service &) = delete;
+        io_service &operator=(const io_service &) = delete;
+
+        // The service behind async_file unless another one is given.
+        static io_service &global();
+
+        bool uses_io_uring() const noexcept { return m_ring != nullptr; }
+
+        io_statistics statistics() const noexcept {
+            return {
+                m_operations.load(std::memory_order_relaxed),
+                m_submissions.load(std::memory_order_relaxed)
+            };
+        }
+
+        [[nodiscard]] operation read(
+            int fd, std::uint64_t offset, void *buffer, std::size_t length
+        ) noexcept {
+            return { *this, opcode::read, fd, offset, buffer, length };
+        }
+
+        [[nodiscard]] operation write(
+            int fd, std::uint64_t offset, const void *buffer, std::size_t length
+        ) noexcept {
+            return { *this, opcode::write, fd, offset, const_cast< void* >(buffer), length };
+        }
+
+      private:
+        struct ring;
+
+        void submit(operation *op) noexcept;
+
+        void run_completion_thread() noexcept;
+
+        void wake_completion_thread() noexcept;
+
+        static void execute_blocking(operation &op) noexcept;
+
+        blocking_pool &m_blocking;
+        std::unique_ptr< ring > m_ring;
+        std::thread m_completion_thread;
+
+        // Head of an intrusive stack of operations not yet in the ring.
+        std::atomic< operation* > m_queue_head = nullptr;
+
+        // Set by the completion thread before it waits in the kernel, whoever
+        // flips it back wakes it up through the ring's eventfd.
+        std::atomic< bool > m_sleeping = false;
+        std::atomic< bool > m_stop_requested = false;
+
+        // Threads inside submit(), waited for before the service goes away.
+        std::atomic< std::uint32_t > m_submitters = 0;
+
+        std::atomic< std::uint64_t > m_operations = 0;
+        std::atomic< std::uint64_t > m_submissions = 0;
+    };
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
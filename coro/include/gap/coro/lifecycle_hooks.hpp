@@ -0,0 +1,135 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include "gap/coro/awaitable_traits.hpp"
+    #include "gap/coro/coroutine.hpp"
+    #include "gap/coro/coroutine_trace.hpp"
+
+    // Lifecycle hooks are opt-in, configure with GAP_ENABLE_LIFECYCLE_HOOKS
+    // or define GAP_CORO_LIFECYCLE_HOOKS=1 consistently for every translation
+    // unit. When it is off promises carry no extra state and no hooks run.
+    //
+    // The hooks default to trace_hooks. Others are selected by defining
+    // GAP_CORO_LIFECYCLE_HOOKS_TYPE to their type and, unless every user of
+    // gap-coro includes them first, GAP_CORO_LIFECYCLE_HOOKS_HEADER to the
+    // header declaring it.
+    #ifndef GAP_CORO_LIFECYCLE_HOOKS
+        #define GAP_CORO_LIFECYCLE_HOOKS 0
+    #endif
+
+    #if GAP_CORO_LIFECYCLE_HOOKS
+        #ifdef GAP_CORO_LIFECYCLE_HOOKS_HEADER
+            #include GAP_CORO_LIFECYCLE_HOOKS_HEADER
+        #endif
+        #ifndef GAP_CORO_LIFECYCLE_HOOKS_TYPE
+            #define GAP_CORO_LIFECYCLE_HOOKS_TYPE ::gap::coro::trace_hooks
+        #endif
+    #endif
+
+namespace gap::coro
+{
+    inline constexpr bool lifecycle_hooks_enabled = GAP_CORO_LIFECYCLE_HOOKS;
+
+    // Called by task and shared_task promises on the thread making the
+    // transition, with an address inside the promise as the coroutine's
+    // identity. Resume and suspend alternate, starting when the coroutine
+    // first runs and ending at its final suspend.
+    template< typename hooks_t >
+    concept coroutine_lifecycle_hooks = requires(const void *coroutine, coroutine_kind kind) {
+        { hooks_t::on_create(coroutine, kind) } noexcept;
+        { hooks_t::on_resume(coroutine, kind) } noexcept;
+        { hooks_t::on_suspend(coroutine, kind) } noexcept;
+        { hooks_t::on_destroy(coroutine, kind) } noexcept;
+    };
+
+    static_assert(coroutine_lifecycle_hooks< trace_hooks >);
+
+    #if GAP_CORO_LIFECYCLE_HOOKS
+
+    using lifecycle_hooks = GAP_CORO_LIFECYCLE_HOOKS_TYPE;
+
+    static_assert(
+        coroutine_lifecycle_hooks< lifecycle_hooks >,
+        "GAP_CORO_LIFECYCLE_HOOKS_TYPE does not provide the lifecycle hooks"
+    );
+
+    namespace detail
+    {
+        // Reports the lifetime of the promise deriving from it.
+        template< coroutine_kind kind >
+        struct lifecycle_frame
+        {
+            lifecycle_frame() noexcept { lifecycle_hooks::on_create(this, kind); }
+            ~lifecycle_frame() { lifecycle_hooks::on_destroy(this, kind); }
+
+            lifecycle_frame(const lifecycle_frame &) = delete;
+            lifecycle_frame &operator=(const lifecycle_frame &) = delete;
+
+            void on_resume() noexcept { lifecycle_hooks::on_resume(this, kind); }
+            void on_suspend() noexcept { lifecycle_hooks::on_suspend(this, kind); }
+        };
+
+        // Wraps the initial suspend of a hooked promise to report its first
+        // resume.
+        template< typename awaiter_t, typename frame_t >
+        struct hooked_initial_suspend
+        {
+            awaiter_t m_awaiter;
+            frame_t &m_frame;
+
+            decltype(auto) await_ready() { return m_awaiter.await_ready(); }
+
+            decltype(auto) await_suspend(gap::coroutine_handle<> coroutine) {
+                return m_awaiter.await_suspend(coroutine);
+            }
+
+            void await_resume() {
+                m_awaiter.await_resume();
+                m_frame.on_resume();
+            }
+        };
+
+        // Wraps every awaiter a hooked promise awaits on. The suspend is
+        // reported before the coroutine is handed over, it may run elsewhere
+        // right after.
+        template< typename awaiter_t, typename frame_t >
+        struct hooked_awaiter
+        {
+            awaiter_t m_awaiter;
+            frame_t &m_frame;
+            bool m_suspended = false;
+
+            decltype(auto) await_ready() { return m_awaiter.await_ready(); }
+
+            template< typename promise_t >
+            decltype(auto) await_suspend(gap::coroutine_handle< promise_t > coroutine) {
+                m_suspended = true;
+                m_frame.on_suspend();
+                return m_awaiter.await_suspend(coroutine);
+            }
+
+            decltype(auto) await_resume() {
+                if (m_suspended) {
+                    m_frame.on_resume();
+                }
+                return m_awaiter.await_resume();
+            }
+        };
+
+        template< awaitable awaitable_t, typename frame_t >
+        auto make_hooked_awaiter(awaitable_t &&awaitable, frame_t &frame) {
+            return hooked_awaiter< awaiter_type_t< awaitable_t >, frame_t >{
+                get_awaiter(static_cast< awaitable_t&& >(awaitable)), frame
+            };
+        }
+
+    } // namespace detail
+
+    #endif // GAP_CORO_LIFECYCLE_HOOKS
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
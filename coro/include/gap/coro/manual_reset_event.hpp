@@ -13,34 +13,47 @@
 
 #ifdef GAP_ENABLE_COROUTINES
 
-#include <condition_variable>
-#include <mutex>
+    #include <atomic>
 
 namespace gap::coro
 {
-    struct manual_reset_event {
-        void set() noexcept {
-            std::lock_guard lock(m_mutex);
-            m_is_set = true;
-            m_cv.notify_all();
-        }
-
-        void reset() noexcept {
-            std::lock_guard lock(m_mutex);
-            m_is_set = false;
-        }
-
-        void wait() noexcept {
-            std::unique_lock lock(m_mutex);
-            m_cv.wait(lock, [this] { return m_is_set; });
-        }
+    // A thread-blocking event, used by sync_wait() to block the calling
+    // thread until the awaited operation completes.
+    //
+    // wait() spins for a short, per-thread adaptive number of iterations
+    // before parking the thread with std::atomic::wait (a futex on Linux).
+    // Waits on work that is already complete, or that completes within a few
+    // microseconds, therefore never enter the kernel, and set() only issues
+    // a wake-up when a waiter has actually parked.
+    //
+    // set() is done with the event by the time wait() returns, so that the
+    // waiter may destroy it right away, as sync_wait() does.
+    struct manual_reset_event
+    {
+        explicit manual_reset_event(bool initially_set = false) noexcept;
+
+        manual_reset_event(const manual_reset_event &) = delete;
+        manual_reset_event &operator=(const manual_reset_event &) = delete;
+
+        bool is_set() const noexcept;
+
+        void set() noexcept;
+
+        void reset() noexcept;
+
+        void wait() noexcept;
 
       private:
-        std::mutex m_mutex;
-        std::condition_variable m_cv;
-        bool m_is_set = false;
+        static constexpr int not_set_state   = 0;
+        static constexpr int not_set_waiting = 1;
+        // Set, while set() wakes the parked waiters.
+        static constexpr int notifying_state = 2;
+        static constexpr int set_state       = 3;
+
+        // Kept 'int' sized, so that waiting maps directly onto a futex.
+        std::atomic< int > m_state;
     };
 
 } // namespace gap::coro
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,587 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/multi_producer_sequencer.hpp
+// from the cppcoro project. The original file is licenced under the MIT
+// license and the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/sequence_barrier.hpp>
+    #include <gap/coro/sequence_range.hpp>
+
+    #include <atomic>
+    #include <cassert>
+    #include <cstddef>
+    #include <limits>
+    #include <memory>
+
+namespace gap::coro
+{
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct multi_producer_sequencer_claim_one_operation;
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct multi_producer_sequencer_claim_operation;
+
+    template< typename sequence_t, typename traits_t >
+    struct multi_producer_sequencer_wait_operation_base;
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct multi_producer_sequencer_wait_operation;
+
+    // Hands out slots of a ring buffer of 'buffer_size' elements, a power of
+    // two, to any number of concurrent producers.
+    //
+    // Producers claim sequence numbers with a single fetch_add and may
+    // publish them out of order. Every slot records the last sequence number
+    // published to it, so consumers find the last published sequence number
+    // by scanning forward from the last one they know of:
+    //
+    //     // producers
+    //     auto range = co_await sequencer.claim_up_to(16);
+    //     for (auto seq : range) { buffer[seq & mask] = ...; }
+    //     sequencer.publish(range);
+    //
+    //     // consumer
+    //     auto available = co_await sequencer.wait_until_published(next, last_known);
+    //     for (; next <= available; ++next) { read(buffer[next & mask]); }
+    //     last_known = available;
+    //     consumer_barrier.publish(available);
+    template< typename sequence_t = std::size_t, typename traits_t = sequence_traits< sequence_t > >
+    struct multi_producer_sequencer
+    {
+        using awaiter_t = multi_producer_sequencer_wait_operation_base< sequence_t, traits_t >;
+
+        multi_producer_sequencer(
+            const sequence_barrier< sequence_t, traits_t > &consumer_barrier,
+            std::size_t buffer_size,
+            sequence_t initial_sequence = traits_t::initial_sequence
+        );
+
+        ~multi_producer_sequencer() {
+            assert(m_awaiters.load(std::memory_order_relaxed) == nullptr);
+        }
+
+        multi_producer_sequencer(const multi_producer_sequencer&) = delete;
+        multi_producer_sequencer& operator=(const multi_producer_sequencer&) = delete;
+
+        std::size_t buffer_size() const noexcept { return m_sequence_mask + 1; }
+
+        // Claims a single sequence number, waiting until the consumers have
+        // released its slot.
+        [[nodiscard]] auto claim_one() noexcept {
+            return claim_one(detail::inline_scheduler_instance);
+        }
+
+        template< scheduler scheduler_t >
+        [[nodiscard]] multi_producer_sequencer_claim_one_operation< sequence_t, traits_t, scheduler_t >
+        claim_one(scheduler_t &scheduler) noexcept {
+            return { *this, scheduler };
+        }
+
+        // Claims a range of min(count, buffer_size()) consecutive sequence
+        // numbers, waiting until the consumers have released all of them.
+        [[nodiscard]] auto claim_up_to(std::size_t count) noexcept {
+            return claim_up_to(count, detail::inline_scheduler_instance);
+        }
+
+        template< scheduler scheduler_t >
+        [[nodiscard]] multi_producer_sequencer_claim_operation< sequence_t, traits_t, scheduler_t >
+        claim_up_to(std::size_t count, scheduler_t &scheduler) noexcept {
+            return { *this, count, scheduler };
+        }
+
+        // Publishes a single sequence number. Unlike the sequence_barrier this
+        // does not publish the preceding sequence numbers, those are published
+        // by the producers that claimed them.
+        void publish(sequence_t sequence) noexcept;
+
+        void publish(const sequence_range< sequence_t, traits_t > &range) noexcept;
+
+        // The last sequence number such that it, and all sequence numbers
+        // after 'last_known_published' up to it, have been published.
+        sequence_t last_published_after(sequence_t last_known_published) const noexcept;
+
+        // Waits until 'target_sequence' and every sequence number before it
+        // have been published. 'last_known_published' must be a sequence
+        // number that was already published, the result of the previous wait
+        // serves well. Returns the last published sequence number.
+        [[nodiscard]] auto wait_until_published(
+            sequence_t target_sequence, sequence_t last_known_published
+        ) const noexcept {
+            return wait_until_published(target_sequence, last_known_published, detail::inline_scheduler_instance);
+        }
+
+        template< scheduler scheduler_t >
+        [[nodiscard]] multi_producer_sequencer_wait_operation< sequence_t, traits_t, scheduler_t >
+        wait_until_published(
+            sequence_t target_sequence, sequence_t last_known_published, scheduler_t &scheduler
+        ) const noexcept {
+            return { *this, target_sequence, last_known_published, scheduler };
+        }
+
+      private:
+        template< typename, typename, scheduler >
+        friend struct multi_producer_sequencer_claim_one_operation;
+
+        template< typename, typename, scheduler >
+        friend struct multi_producer_sequencer_claim_operation;
+
+        friend struct multi_producer_sequencer_wait_operation_base< sequence_t, traits_t >;
+
+        void resume_ready_awaiters() noexcept;
+        void add_awaiter(awaiter_t *awaiter) const noexcept;
+
+        const sequence_barrier< sequence_t, traits_t > &m_consumer_barrier;
+        const std::size_t m_sequence_mask;
+        const std::unique_ptr< std::atomic< sequence_t >[] > m_published;
+
+        alignas(64) std::atomic< sequence_t > m_next_to_claim;
+
+        alignas(64) mutable std::atomic< awaiter_t* > m_awaiters;
+    };
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct multi_producer_sequencer_claim_one_operation
+    {
+        multi_producer_sequencer_claim_one_operation(
+            multi_producer_sequencer< sequence_t, traits_t > &sequencer, scheduler_t &scheduler
+        ) noexcept
+            : m_consumer_wait_operation(
+                sequencer.m_consumer_barrier,
+                static_cast< sequence_t >(
+                    sequencer.m_next_to_claim.fetch_add(1, std::memory_order_relaxed)
+                    - sequencer.buffer_size()
+                ),
+                scheduler
+            )
+            , m_sequencer(sequencer)
+        {}
+
+        bool await_ready() const noexcept { return m_consumer_wait_operation.await_ready(); }
+
+        auto await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+            return m_consumer_wait_operation.await_suspend(awaiting_coroutine);
+        }
+
+        sequence_t await_resume() {
+            m_consumer_wait_operation.await_resume();
+            return static_cast< sequence_t >(
+                m_consumer_wait_operation.target_sequence() + m_sequencer.buffer_size()
+            );
+        }
+
+      private:
+        sequence_barrier_wait_operation< sequence_t, traits_t, scheduler_t > m_consumer_wait_operation;
+        multi_producer_sequencer< sequence_t, traits_t > &m_sequencer;
+    };
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct multi_producer_sequencer_claim_operation
+    {
+        multi_producer_sequencer_claim_operation(
+            multi_producer_sequencer< sequence_t, traits_t > &sequencer,
+            std::size_t count,
+            scheduler_t &scheduler
+        ) noexcept
+            : multi_producer_sequencer_claim_operation(
+                sequencer,
+                count < sequencer.buffer_size() ? count : sequencer.buffer_size(),
+                scheduler,
+                0
+            )
+        {}
+
+        bool await_ready() const noexcept { return m_consumer_wait_operation.await_ready(); }
+
+        auto await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+            return m_consumer_wait_operation.await_suspend(awaiting_coroutine);
+        }
+
+        sequence_range< sequence_t, traits_t > await_resume() {
+            m_consumer_wait_operation.await_resume();
+            return m_claimed_range;
+        }
+
+      private:
+        multi_producer_sequencer_claim_operation(
+            multi_producer_sequencer< sequence_t, traits_t > &sequencer,
+            std::size_t count,
+            scheduler_t &scheduler,
+            int
+        ) noexcept
+            : m_claimed_range(claim(sequencer, count))
+            , m_consumer_wait_operation(
+                sequencer.m_consumer_barrier,
+                // The consumers must have released the last slot of the range.
+                static_cast< sequence_t >(m_claimed_range.back() - sequencer.buffer_size()),
+                scheduler
+            )
+        {}
+
+        static sequence_range< sequence_t, traits_t > claim(
+            multi_producer_sequencer< sequence_t, traits_t > &sequencer, std::size_t count
+        ) noexcept {
+            auto begin = sequencer.m_next_to_claim.fetch_add(
+                static_cast< sequence_t >(count), std::memory_order_relaxed
+            );
+            return { begin, static_cast< sequence_t >(begin + count) };
+        }
+
+        sequence_range< sequence_t, traits_t > m_claimed_range;
+        sequence_barrier_wait_operation< sequence_t, traits_t, scheduler_t > m_consumer_wait_operation;
+    };
+
+    template< typename sequence_t, typename traits_t >
+    struct multi_producer_sequencer_wait_operation_base
+    {
+        multi_producer_sequencer_wait_operation_base(
+            const multi_producer_sequencer< sequence_t, traits_t > &sequencer,
+            sequence_t target_sequence,
+            sequence_t last_known_published
+        ) noexcept
+            : m_sequencer(sequencer)
+            , m_target_sequence(target_sequence)
+            , m_last_known_published(last_known_published)
+            , m_ready_to_resume(false)
+        {}
+
+        multi_producer_sequencer_wait_operation_base(
+            const multi_producer_sequencer_wait_operation_base &other
+        ) noexcept
+            : m_sequencer(other.m_sequencer)
+            , m_target_sequence(other.m_target_sequence)
+            , m_last_known_published(other.m_last_known_published)
+            , m_ready_to_resume(false)
+        {}
+
+        bool await_ready() const noexcept {
+            return !traits_t::precedes(m_last_known_published, m_target_sequence);
+        }
+
+        bool await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+            m_awaiting_coroutine = awaiting_coroutine;
+            m_sequencer.add_awaiter(this);
+
+            // add_awaiter() may have resumed us already.
+            return !m_ready_to_resume.exchange(true, std::memory_order_acq_rel);
+        }
+
+        sequence_t await_resume() noexcept { return m_last_known_published; }
+
+      protected:
+        friend struct multi_producer_sequencer< sequence_t, traits_t >;
+
+        ~multi_producer_sequencer_wait_operation_base() = default;
+
+        void resume() noexcept {
+            // Pairs with the exchange in await_suspend(), see
+            // sequence_barrier_wait_operation_base::resume().
+            if (m_ready_to_resume.exchange(true, std::memory_order_acq_rel)) {
+                resume_impl();
+            }
+        }
+
+        virtual void resume_impl() noexcept = 0;
+
+        const multi_producer_sequencer< sequence_t, traits_t > &m_sequencer;
+        sequence_t m_target_sequence;
+        sequence_t m_last_known_published;
+        multi_producer_sequencer_wait_operation_base *m_next = nullptr;
+        gap::coroutine_handle<> m_awaiting_coroutine;
+        std::atomic< bool > m_ready_to_resume;
+    };
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct multi_producer_sequencer_wait_operation final
+        : multi_producer_sequencer_wait_operation_base< sequence_t, traits_t >
+    {
+        using base = multi_producer_sequencer_wait_operation_base< sequence_t, traits_t >;
+
+        multi_producer_sequencer_wait_operation(
+            const multi_producer_sequencer< sequence_t, traits_t > &sequencer,
+            sequence_t target_sequence,
+            sequence_t last_known_published,
+            scheduler_t &scheduler
+        ) noexcept
+            : base(sequencer, target_sequence, last_known_published)
+            , m_resumption(scheduler)
+        {}
+
+        multi_producer_sequencer_wait_operation(const multi_producer_sequencer_wait_operation &other) noexcept
+            : base(other)
+            , m_resumption(other.m_resumption)
+        {}
+
+        sequence_t await_resume() {
+            m_resumption.await_resume();
+            return base::await_resume();
+        }
+
+      private:
+        void resume_impl() noexcept override { m_resumption.resume(this->m_awaiting_coroutine); }
+
+        detail::scheduled_resumption< scheduler_t > m_resumption;
+    };
+
+    template< typename sequence_t, typename traits_t >
+    multi_producer_sequencer< sequence_t, traits_t >::multi_producer_sequencer(
+        const sequence_barrier< sequence_t, traits_t > &consumer_barrier,
+        std::size_t buffer_size,
+        sequence_t initial_sequence
+    )
+        : m_consumer_barrier(consumer_barrier)
+        , m_sequence_mask(buffer_size - 1)
+        , m_published(std::make_unique< std::atomic< sequence_t >[] >(buffer_size))
+        , m_next_to_claim(static_cast< sequence_t >(initial_sequence + 1))
+        , m_awaiters(nullptr)
+    {
+        // The buffer size must be a positive power of two, but no larger than
+        // the maximal difference between two sequence numbers.
+        assert(buffer_size > 0 && (buffer_size & (buffer_size - 1)) == 0);
+        assert(buffer_size <= static_cast< std::size_t >(traits_t::max_difference));
+
+        // Mark every slot as published by the lap before the first one.
+        auto seq = static_cast< sequence_t >(initial_sequence - (buffer_size - 1));
+        do {
+            m_published[seq & m_sequence_mask].store(seq, std::memory_order_relaxed);
+        } while (seq++ != initial_sequence);
+    }
+
+    template< typename sequence_t, typename traits_t >
+    sequence_t multi_producer_sequencer< sequence_t, traits_t >::last_published_after(
+        sequence_t last_known_published
+    ) const noexcept {
+        const auto mask = m_sequence_mask;
+        auto seq = static_cast< sequence_t >(last_known_published + 1);
+        while (m_published[seq & mask].load(std::memory_order_acquire) == seq) {
+            last_known_published = seq++;
+        }
+        return last_known_published;
+    }
+
+    template< typename sequence_t, typename traits_t >
+    void multi_producer_sequencer< sequence_t, traits_t >::publish(sequence_t sequence) noexcept {
+        m_published[sequence & m_sequence_mask].store(sequence, std::memory_order_seq_cst);
+
+        // Resume any waiters that might have been satisfied by this publish.
+        resume_ready_awaiters();
+    }
+
+    template< typename sequence_t, typename traits_t >
+    void multi_producer_sequencer< sequence_t, traits_t >::publish(
+        const sequence_range< sequence_t, traits_t > &range
+    ) noexcept {
+        if (range.empty()) {
+            return;
+        }
+
+        // Publish all but the first sequence number using relaxed atomics. No
+        // consumer reads them before it has seen the first one published.
+        for (sequence_t seq : range.skip(1)) {
+            m_published[seq & m_sequence_mask].store(seq, std::memory_order_relaxed);
+        }
+
+        m_published[range.front() & m_sequence_mask].store(range.front(), std::memory_order_seq_cst);
+
+        resume_ready_awaiters();
+    }
+
+    template< typename sequence_t, typename traits_t >
+    void multi_producer_sequencer< sequence_t, traits_t >::resume_ready_awaiters() noexcept {
+        auto *awaiters = m_awaiters.load(std::memory_order_seq_cst);
+        if (awaiters == nullptr) {
+            // No awaiters.
+            return;
+        }
+
+        // There were some awaiters. Try to acquire the list of waiters with
+        // an exchange. Other producers may be doing the same concurrently.
+        awaiters = m_awaiters.exchange(nullptr, std::memory_order_seq_cst);
+        if (awaiters == nullptr) {
+            // Another thread took the list.
+            return;
+        }
+
+        sequence_t last_known_published;
+
+        awaiter_t *awaiters_to_resume;
+        awaiter_t **awaiters_to_resume_tail = &awaiters_to_resume;
+
+        awaiter_t *awaiters_to_requeue;
+        awaiter_t **awaiters_to_requeue_tail = &awaiters_to_requeue;
+
+        do {
+            using difference_t = typename traits_t::difference_type;
+
+            last_known_published = last_published_after(awaiters->m_last_known_published);
+
+            // Split the list of awaiters into the ones that are ready to be
+            // resumed and the ones that need to be requeued.
+            auto min_diff = std::numeric_limits< difference_t >::max();
+
+            do {
+                auto diff = traits_t::difference(awaiters->m_target_sequence, last_known_published);
+                if (diff > 0) {
+                    // Not ready yet.
+                    min_diff = diff < min_diff ? diff : min_diff;
+                    *awaiters_to_requeue_tail = awaiters;
+                    awaiters_to_requeue_tail  = &awaiters->m_next;
+                } else {
+                    *awaiters_to_resume_tail = awaiters;
+                    awaiters_to_resume_tail  = &awaiters->m_next;
+                }
+                awaiters->m_last_known_published = last_known_published;
+                awaiters = awaiters->m_next;
+            } while (awaiters != nullptr);
+
+            // Null-terminate the requeue list.
+            *awaiters_to_requeue_tail = nullptr;
+
+            if (awaiters_to_requeue != nullptr) {
+                // Requeue the waiters that are not ready yet.
+                awaiter_t *old_head = nullptr;
+                while (!m_awaiters.compare_exchange_weak(
+                    old_head, awaiters_to_requeue, std::memory_order_seq_cst, std::memory_order_relaxed
+                )) {
+                    *awaiters_to_requeue_tail = old_head;
+                }
+
+                // Reset the awaiters_to_requeue list.
+                awaiters_to_requeue_tail = &awaiters_to_requeue;
+
+                const auto earliest_target_sequence = static_cast< sequence_t >(last_known_published + min_diff);
+
+                // Check again whether any of the awaiters we just requeued
+                // was satisfied by a concurrent call to publish().
+                //
+                // We no longer hold any awaiters, so the producers and the
+                // consumers may advance the sequence number arbitrarily far,
+                // even wrapping around the slots. In that case another thread
+                // has already resumed the awaiters waiting for
+                // 'earliest_target_sequence'. The only case to care about is
+                // when every slot in [last_known_published + 1,
+                // earliest_target_sequence] holds the matching sequence.
+                const auto mask = m_sequence_mask;
+                auto seq = static_cast< sequence_t >(last_known_published + 1);
+                while (m_published[seq & mask].load(std::memory_order_seq_cst) == seq) {
+                    last_known_published = seq;
+                    if (seq == earliest_target_sequence) {
+                        // At least one of the awaiters we just requeued is
+                        // satisfied now. Reacquire the list and go around the
+                        // outer loop again.
+                        awaiters = m_awaiters.exchange(nullptr, std::memory_order_acquire);
+                        break;
+                    }
+                    ++seq;
+                }
+            }
+        } while (awaiters != nullptr);
+
+        // Null-terminate the list of awaiters to resume.
+        *awaiters_to_resume_tail = nullptr;
+
+        while (awaiters_to_resume != nullptr) {
+            // Read m_next before resuming, resuming may destroy the awaiter.
+            auto *next = awaiters_to_resume->m_next;
+            awaiters_to_resume->resume();
+            awaiters_to_resume = next;
+        }
+    }
+
+    template< typename sequence_t, typename traits_t >
+    void multi_producer_sequencer< sequence_t, traits_t >::add_awaiter(awaiter_t *awaiter) const noexcept {
+        sequence_t target_sequence      = awaiter->m_target_sequence;
+        sequence_t last_known_published = awaiter->m_last_known_published;
+
+        awaiter_t *awaiters_to_enqueue        = awaiter;
+        awaiter_t **awaiters_to_enqueue_tail  = &awaiter->m_next;
+
+        awaiter_t *awaiters_to_resume;
+        awaiter_t **awaiters_to_resume_tail = &awaiters_to_resume;
+
+        const auto mask = m_sequence_mask;
+
+        do {
+            // Enqueue the awaiters.
+            {
+                auto *old_head = m_awaiters.load(std::memory_order_relaxed);
+                do {
+                    *awaiters_to_enqueue_tail = old_head;
+                } while (!m_awaiters.compare_exchange_weak(
+                    old_head, awaiters_to_enqueue, std::memory_order_seq_cst, std::memory_order_relaxed
+                ));
+            }
+
+            // Reset the list of awaiters to enqueue.
+            awaiters_to_enqueue_tail = &awaiters_to_enqueue;
+
+            // Check whether the last published sequence number advanced while
+            // we were enqueueing. This needs seq_cst so that a concurrent
+            // publish() either sees our write to 'm_awaiters', or we see its
+            // write to the slot.
+            //
+            // The published sequence number can't advance more than
+            // buffer_size() beyond 'target_sequence', the consumer waiting for
+            // it can't release its slot to the producers until it is resumed.
+            while (m_published[static_cast< sequence_t >(last_known_published + 1) & mask].load(
+                       std::memory_order_seq_cst
+                   ) == static_cast< sequence_t >(last_known_published + 1))
+            {
+                ++last_known_published;
+            }
+
+            if (!traits_t::precedes(last_known_published, target_sequence)) {
+                // At least one awaiter we just enqueued is satisfied now.
+                // Reacquire the list of awaiters to make sure it is resumed.
+                auto *awaiters = m_awaiters.exchange(nullptr, std::memory_order_acquire);
+
+                using difference_t = typename traits_t::difference_type;
+                auto min_diff = std::numeric_limits< difference_t >::max();
+
+                while (awaiters != nullptr) {
+                    auto diff = traits_t::difference(awaiters->m_target_sequence, last_known_published);
+                    if (diff > 0) {
+                        // Not yet ready.
+                        min_diff = diff < min_diff ? diff : min_diff;
+                        *awaiters_to_enqueue_tail = awaiters;
+                        awaiters_to_enqueue_tail  = &awaiters->m_next;
+                        awaiters->m_last_known_published = last_known_published;
+                    } else {
+                        *awaiters_to_resume_tail = awaiters;
+                        awaiters_to_resume_tail  = &awaiters->m_next;
+                        awaiters->m_last_known_published = last_known_published;
+                    }
+                    awaiters = awaiters->m_next;
+                }
+
+                // The earliest sequence number any of the awaiters to enqueue
+                // is waiting for, used the next time around the loop.
+                target_sequence = static_cast< sequence_t >(last_known_published + min_diff);
+            }
+
+            // Null-terminate the list of awaiters to enqueue.
+            *awaiters_to_enqueue_tail = nullptr;
+        } while (awaiters_to_enqueue != nullptr);
+
+        // Null-terminate the list of awaiters to resume.
+        *awaiters_to_resume_tail = nullptr;
+
+        while (awaiters_to_resume != nullptr) {
+            // Read m_next before resuming, resuming may destroy the awaiter.
+            auto *next = awaiters_to_resume->m_next;
+            awaiters_to_resume->resume();
+            awaiters_to_resume = next;
+        }
+    }
+
+} // namespace gap::coro
+
+#endif
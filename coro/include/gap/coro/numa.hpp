@@ -0,0 +1,205 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <array>
+    #include <cstddef>
+    #include <cstdint>
+    #include <filesystem>
+    #include <memory>
+    #include <memory_resource>
+    #include <mutex>
+    #include <string_view>
+    #include <thread>
+    #include <vector>
+
+namespace gap::coro
+{
+    struct numa_node
+    {
+        // The id of the node in /sys/devices/system/node.
+        std::uint32_t id;
+        std::vector< std::uint32_t > cpus;
+    };
+
+    // The NUMA nodes of the machine that have CPUs, memory-only nodes are
+    // left out. Machines that don't expose a topology are described as a
+    // single node holding every CPU.
+    struct numa_topology
+    {
+        std::vector< numa_node > nodes;
+
+        static numa_topology detect();
+
+        // Reads the nodes under 'root', laid out as /sys/devices/system/node.
+        // Yields no nodes if there are none to read.
+        static numa_topology from_sysfs(const std::filesystem::path &root);
+
+        // The machine split into 'count' nodes of 'cpus_per_node' CPUs each,
+        // for spreading work as if the machine had that topology.
+        static numa_topology uniform(std::uint32_t count, std::uint32_t cpus_per_node);
+
+        // Parses a cpulist such as "0-3,8,10-11".
+        static std::vector< std::uint32_t > parse_cpulist(std::string_view list);
+
+        std::size_t cpu_count() const noexcept;
+    };
+
+    // Page-aligned memory bound to the NUMA node 'node_id' where the system
+    // supports it. The binding is a preference, when the node runs out of
+    // memory pages come from elsewhere.
+    void *allocate_on_node(std::size_t bytes, std::uint32_t node_id);
+    void deallocate_on_node(void *ptr, std::size_t bytes) noexcept;
+
+    // Coroutine frames and other short-lived blocks in memory of one node.
+    // Freed blocks go to size-class free lists of the freeing thread, which
+    // allocates from them without locking. What does not fit there moves in
+    // batches to lists shared by the threads of the node. Blocks are only
+    // returned to the system when the pool is destroyed.
+    struct numa_frame_pool
+    {
+        static constexpr std::size_t min_block_size  = 64;
+        static constexpr std::size_t size_classes    = 8; // 64 B .. 8 KiB
+        static constexpr std::size_t max_pooled_size = min_block_size << (size_classes - 1);
+        static constexpr std::size_t chunk_size      = std::size_t(1) << 20;
+
+        // Blocks per size class a thread keeps for itself, and how many it
+        // moves from or to the shared lists at once.
+        static constexpr std::size_t max_cached_per_class = 256;
+        static constexpr std::size_t batch_size           = 32;
+
+        explicit numa_frame_pool(std::uint32_t node_id) noexcept;
+        ~numa_frame_pool();
+
+        numa_frame_pool(const numa_frame_pool &) = delete;
+        numa_frame_pool &operator=(const numa_frame_pool &) = delete;
+
+        void *allocate(std::size_t bytes);
+        void deallocate(void *ptr, std::size_t bytes) noexcept;
+
+        std::uint32_t node_id() const noexcept { return m_node_id; }
+
+        // Bytes taken from the node for pooled blocks.
+        std::size_t reserved() const;
+
+      private:
+        struct free_block
+        {
+            free_block *m_next;
+        };
+
+        // The free lists of one thread, only touched by that thread. They
+        // belong to the pool and stay with it when the thread exits, a new
+        // thread with the same id takes them over.
+        struct thread_cache
+        {
+            std::thread::id m_thread;
+            std::array< free_block*, size_classes > m_free{};
+            std::array< std::size_t, size_classes > m_count{};
+        };
+
+        // The cache of the pool the calling thread used last. Pools are told
+        // apart by id rather than address, which a new pool may reuse.
+        struct cache_ref
+        {
+            std::uint64_t m_pool_id = 0;
+            thread_cache *m_cache   = nullptr;
+        };
+
+        static thread_local cache_ref t_cache;
+
+        // Null if the cache could not be created, the shared lists are used
+        // alone then.
+        thread_cache *local_cache() noexcept;
+        void *refill(thread_cache *cache, std::size_t index);
+        void spill(thread_cache *cache, std::size_t index, free_block *block) noexcept;
+
+        std::uint32_t m_node_id;
+        const std::uint64_t m_id;
+
+        // Guards everything below.
+        mutable std::mutex m_mutex;
+        std::array< free_block*, size_classes > m_free{};
+        std::vector< std::unique_ptr< thread_cache > > m_caches;
+        std::vector< std::byte* > m_chunks;
+        std::byte *m_chunk_next = nullptr;
+        std::byte *m_chunk_end  = nullptr;
+    };
+
+    // A standard allocator over a numa_frame_pool, to place the frames of
+    // coroutines taking 'std::allocator_arg_t, const allocator_t&' on the
+    // pool's node:
+    //
+    //     task<> lift(std::allocator_arg_t, numa_frame_allocator< std::byte >, function &f);
+    //     co_await lift(std::allocator_arg, pool.frame_allocator(node), f);
+    template< typename T >
+    struct numa_frame_allocator
+    {
+        using value_type = T;
+
+        explicit numa_frame_allocator(numa_frame_pool &pool) noexcept : m_pool(&pool) {}
+
+        template< typename U >
+        numa_frame_allocator(const numa_frame_allocator< U > &other) noexcept
+            : m_pool(other.m_pool)
+        {}
+
+        T *allocate(std::size_t n) { return static_cast< T* >(m_pool->allocate(n * sizeof(T))); }
+
+        void deallocate(T *ptr, std::size_t n) noexcept { m_pool->deallocate(ptr, n * sizeof(T)); }
+
+        template< typename U >
+        bool operator==(const numa_frame_allocator< U > &other) const noexcept {
+            return m_pool == other.m_pool;
+        }
+
+        numa_frame_pool *m_pool;
+    };
+
+    // A monotonic arena in memory of one node, for data such as IR that is
+    // built once and then read by the workers of the node. Deallocation is
+    // a no-op, everything is released by release() or the destructor.
+    struct numa_arena : std::pmr::memory_resource
+    {
+        static constexpr std::size_t default_chunk_size = std::size_t(4) << 20;
+
+        explicit numa_arena(std::uint32_t node_id, std::size_t chunk_size = default_chunk_size) noexcept
+            : m_node_id(node_id)
+            , m_chunk_size(chunk_size)
+        {}
+
+        ~numa_arena() override { release(); }
+
+        numa_arena(const numa_arena &) = delete;
+        numa_arena &operator=(const numa_arena &) = delete;
+
+        std::uint32_t node_id() const noexcept { return m_node_id; }
+
+        void release() noexcept;
+
+      private:
+        struct chunk
+        {
+            std::byte *m_data;
+            std::size_t m_size;
+        };
+
+        void *do_allocate(std::size_t bytes, std::size_t alignment) override;
+        void do_deallocate(void *, std::size_t, std::size_t) override {}
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override {
+            return this == &other;
+        }
+
+        std::uint32_t m_node_id;
+        std::size_t m_chunk_size;
+        std::mutex m_mutex;
+        std::vector< chunk > m_chunks;
+        std::byte *m_next = nullptr;
+        std::byte *m_end  = nullptr;
+    };
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,165 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/numa.hpp>
+
+    #include <atomic>
+    #include <cstddef>
+    #include <cstdint>
+    #include <memory>
+    #include <optional>
+    #include <thread>
+    #include <vector>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        template< typename state_t >
+        struct worker_group;
+
+    } // namespace detail
+
+    struct numa_pool_options
+    {
+        // Workers started on every node, 0 starts one per CPU of the node.
+        std::uint32_t threads_per_node = 0;
+
+        // Restrict every worker to the CPUs of its node.
+        bool pin_threads = true;
+
+        // Let workers with nothing to do on their own node steal from the
+        // workers of other nodes, trading locality for utilisation.
+        bool steal_across_nodes = true;
+    };
+
+    // A work-stealing pool like static_thread_pool with its workers grouped
+    // by NUMA node. Idle workers steal from workers of their own node first
+    // and only then, if allowed, from the other nodes. Work can be sent to
+    // the node holding its data:
+    //
+    //     co_await pool.schedule_on(node);
+    //     sum(pool.arena(node), data);
+    //
+    // Nodes are referred to by their index in topology().nodes. Every node
+    // has a frame pool and an arena in its own memory, so that coroutines
+    // and the data they work on can live next to the workers using them.
+    struct numa_thread_pool
+    {
+        struct schedule_operation
+        {
+            schedule_operation(numa_thread_pool &pool, std::uint32_t node) noexcept
+                : m_pool(pool)
+                , m_node(node)
+            {}
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept;
+            void await_resume() const noexcept {}
+
+          private:
+            friend struct numa_thread_pool;
+            template< typename state_t >
+            friend struct detail::worker_group;
+
+            numa_thread_pool &m_pool;
+            std::uint32_t m_node;
+            gap::coroutine_handle<> m_awaiting_coroutine = nullptr;
+            schedule_operation *m_next = nullptr;
+        };
+
+        // Spreads over the nodes of the machine as found by
+        // numa_topology::detect().
+        numa_thread_pool();
+
+        explicit numa_thread_pool(numa_topology topology, numa_pool_options options = {});
+
+        // Waits for all queued work to be resumed before joining the workers.
+        ~numa_thread_pool();
+
+        numa_thread_pool(const numa_thread_pool &) = delete;
+        numa_thread_pool &operator=(const numa_thread_pool &) = delete;
+
+        std::uint32_t thread_count() const noexcept { return m_thread_count; }
+        std::uint32_t node_count() const noexcept { return std::uint32_t(m_nodes.size()); }
+
+        const numa_topology &topology() const noexcept { return m_topology; }
+
+        // Resumes on the current worker's node when awaited from a worker,
+        // on the nodes in turn otherwise.
+        [[nodiscard]] schedule_operation schedule() noexcept;
+
+        // Resumes on a worker of 'node'.
+        [[nodiscard]] schedule_operation schedule_on(std::uint32_t node) noexcept {
+            return schedule_operation{ *this, node };
+        }
+
+        // The node of the calling worker, nothing outside of the pool.
+        std::optional< std::uint32_t > current_node() const noexcept;
+
+        numa_frame_allocator< std::byte > frame_allocator(std::uint32_t node) noexcept;
+
+        numa_arena &arena(std::uint32_t node) noexcept;
+
+      private:
+        struct thread_state;
+
+        // Schedules onto one node, for scheduler_ref.
+        struct node_scheduler
+        {
+            schedule_operation schedule() noexcept { return m_pool->schedule_on(m_node); }
+
+            numa_thread_pool *m_pool;
+            std::uint32_t m_node;
+        };
+
+        struct alignas(64) node_state
+        {
+            node_state(numa_thread_pool &pool, std::uint32_t node, std::uint32_t node_id) noexcept
+                : m_scheduler{ &pool, node }
+                , m_frames(node_id)
+                , m_arena(node_id)
+            {}
+
+            // Head of an intrusive stack of operations scheduled onto the
+            // node from threads that do not belong to it.
+            std::atomic< schedule_operation* > m_global_queue_head = nullptr;
+
+            std::uint32_t m_first_thread = 0;
+            std::uint32_t m_thread_count = 0;
+
+            node_scheduler m_scheduler;
+            numa_frame_pool m_frames;
+            numa_arena m_arena;
+        };
+
+        void run_worker_thread(thread_state &state) noexcept;
+
+        void schedule_impl(schedule_operation *operation) noexcept;
+
+        schedule_operation *try_get_work(thread_state &state) noexcept;
+        schedule_operation *try_steal(
+            thread_state &state, std::uint32_t first, std::uint32_t count
+        ) noexcept;
+
+        // Wakes a sleeping worker of 'node', or of any node if work may be
+        // stolen across nodes and the node has none sleeping.
+        void wake_one_thread(std::uint32_t node) noexcept;
+
+        numa_topology m_topology;
+        numa_pool_options m_options;
+        std::vector< std::unique_ptr< node_state > > m_nodes;
+
+        std::uint32_t m_thread_count = 0;
+        std::unique_ptr< detail::worker_group< thread_state > > m_workers;
+
+        std::atomic< std::uint32_t > m_next_node = 0;
+    };
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,29 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/operation_cancelled.hpp from
+// the cppcoro project. The original file is licenced under the MIT license and
+// the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <exception>
+
+namespace gap::coro
+{
+    // Exception thrown by cancellable operations that were cancelled through
+    // their cancellation_token.
+    struct operation_cancelled : std::exception {
+        operation_cancelled() noexcept : std::exception() {}
+
+        const char* what() const noexcept override { return "operation cancelled"; }
+    };
+} // namespace gap::coro
+
+#endif
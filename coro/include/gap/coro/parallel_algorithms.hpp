@@ -0,0 +1,377 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <algorithm>
+    #include <atomic>
+    #include <concepts>
+    #include <cstddef>
+    #include <functional>
+    #include <iterator>
+    #include <memory>
+    #include <optional>
+    #include <ranges>
+    #include <thread>
+    #include <utility>
+    #include <vector>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        template< scheduler scheduler_t >
+        std::size_t concurrency_of(scheduler_t &scheduler) noexcept {
+            if constexpr (requires { { scheduler.thread_count() } -> std::convertible_to< std::size_t >; }) {
+                return std::max< std::size_t >(1, scheduler.thread_count());
+            } else {
+                return std::max< std::size_t >(1, std::thread::hardware_concurrency());
+            }
+        }
+
+        // Hands out chunks of the index range [0, size) to the workers of a
+        // parallel algorithm. Chunks start large and shrink as the range is
+        // used up (guided self-scheduling), which keeps the number of claims
+        // small while still letting fast workers pick up the tail.
+        struct chunk_dispenser
+        {
+            chunk_dispenser(std::size_t size, std::size_t workers, std::size_t grain) noexcept
+                : m_size(size)
+                , m_divisor(2 * workers)
+                , m_grain(std::max< std::size_t >(1, grain))
+            {}
+
+            // The number of workers worth starting for 'workers' threads.
+            std::size_t useful_workers(std::size_t workers) const noexcept {
+                return std::min(workers, (m_size + m_grain - 1) / m_grain);
+            }
+
+            std::optional< std::pair< std::size_t, std::size_t > > next() noexcept {
+                auto begin = m_next.load(std::memory_order_relaxed);
+                while (begin < m_size) {
+                    auto remaining = m_size - begin;
+                    auto chunk     = std::min(remaining, std::max(m_grain, remaining / m_divisor));
+                    if (m_next.compare_exchange_weak(begin, begin + chunk, std::memory_order_relaxed)) {
+                        return std::pair{ begin, begin + chunk };
+                    }
+                }
+                return std::nullopt;
+            }
+
+            // Stops handing out chunks, used once a worker has failed.
+            void stop() noexcept { m_next.store(m_size, std::memory_order_relaxed); }
+
+          private:
+            const std::size_t m_size;
+            const std::size_t m_divisor;
+            const std::size_t m_grain;
+            alignas(64) std::atomic< std::size_t > m_next = 0;
+        };
+
+        // Runs 'body(partial, begin, end)' for chunks claimed from 'chunks'
+        // on the scheduler, producing the worker's partial result.
+        template< typename partial_t, scheduler scheduler_t, typename body_t >
+        task< partial_t > chunk_worker(scheduler_t &scheduler, chunk_dispenser &chunks, body_t &body) {
+            co_await scheduler.schedule();
+            partial_t partial{};
+            try {
+                while (auto chunk = chunks.next()) {
+                    body(partial, chunk->first, chunk->second);
+                }
+            } catch (...) {
+                chunks.stop();
+                throw;
+            }
+            co_return partial;
+        }
+
+        // Starts one worker per thread of the scheduler and waits for all of
+        // them, rethrowing the first failure.
+        template< typename partial_t, scheduler scheduler_t, typename body_t >
+        task< std::vector< partial_t > > run_chunked(
+            scheduler_t &scheduler, std::size_t size, std::size_t grain, body_t body
+        ) {
+            auto concurrency = concurrency_of(scheduler);
+            chunk_dispenser chunks{ size, concurrency, grain };
+
+            std::vector< task< partial_t > > workers;
+            for (std::size_t i = 0; i < chunks.useful_workers(concurrency); ++i) {
+                workers.push_back(chunk_worker< partial_t >(scheduler, chunks, body));
+            }
+
+            auto finished = co_await when_all_ready_vec(std::move(workers));
+
+            std::vector< partial_t > partials;
+            partials.reserve(finished.size());
+            for (auto &worker : finished) {
+                partials.push_back(std::move(worker.result()));
+            }
+            co_return partials;
+        }
+
+        // Starts 'work' on the scheduler instead of the current thread.
+        template< scheduler scheduler_t >
+        task<> on_scheduler(scheduler_t &scheduler, task<> work) {
+            co_await scheduler.schedule();
+            co_await std::move(work);
+        }
+
+        // Runs both tasks concurrently, 'first' on the scheduler and 'second'
+        // on the current thread, and rethrows the first failure.
+        template< scheduler scheduler_t >
+        task<> fork_join(scheduler_t &scheduler, task<> first, task<> second) {
+            auto [a, b] = co_await when_all_ready(
+                on_scheduler(scheduler, std::move(first)), std::move(second)
+            );
+            a.result();
+            b.result();
+        }
+
+        // Merges the sorted ranges [first1, last1) and [first2, last2) into
+        // 'out', splitting large merges around the middle of the longer
+        // range so that both halves can be merged in parallel.
+        template< scheduler scheduler_t, typename in_t, typename out_t, typename compare_t >
+        task<> parallel_merge(
+            scheduler_t &scheduler,
+            in_t first1, in_t last1,
+            in_t first2, in_t last2,
+            out_t out, compare_t &comp, std::size_t cutoff
+        ) {
+            auto size1 = static_cast< std::size_t >(last1 - first1);
+            auto size2 = static_cast< std::size_t >(last2 - first2);
+
+            if (size1 + size2 <= cutoff) {
+                std::merge(
+                    std::make_move_iterator(first1), std::make_move_iterator(last1),
+                    std::make_move_iterator(first2), std::make_move_iterator(last2),
+                    out, std::ref(comp)
+                );
+                co_return;
+            }
+
+            if (size1 < size2) {
+                std::swap(first1, first2);
+                std::swap(last1, last2);
+                std::swap(size1, size2);
+            }
+
+            auto mid1    = first1 + static_cast< std::ptrdiff_t >(size1 / 2);
+            auto mid2    = std::lower_bound(first2, last2, *mid1, std::ref(comp));
+            auto out_mid = out + (mid1 - first1) + (mid2 - first2);
+            *out_mid     = std::move(*mid1);
+
+            co_await fork_join(
+                scheduler,
+                parallel_merge(scheduler, first1, mid1, first2, mid2, out, comp, cutoff),
+                parallel_merge(scheduler, mid1 + 1, last1, mid2, last2, out_mid + 1, comp, cutoff)
+            );
+        }
+
+        // Sorts the 'size' elements at 'a', using the elements at 'b' as
+        // scratch space, and leaves the result in 'b' if 'to_b' is set and
+        // in 'a' otherwise. Levels alternate between the two buffers, so
+        // every level costs a single merge pass.
+        template< scheduler scheduler_t, typename a_t, typename b_t, typename compare_t >
+        task<> parallel_sort_impl(
+            scheduler_t &scheduler, a_t a, b_t b, std::size_t size, bool to_b,
+            compare_t &comp, std::size_t cutoff
+        ) {
+            if (size <= cutoff) {
+                std::sort(a, a + static_cast< std::ptrdiff_t >(size), std::ref(comp));
+                if (to_b) {
+                    std::move(a, a + static_cast< std::ptrdiff_t >(size), b);
+                }
+                co_return;
+            }
+
+            auto half = static_cast< std::ptrdiff_t >(size / 2);
+            auto rest = size - size / 2;
+
+            co_await fork_join(
+                scheduler,
+                parallel_sort_impl(scheduler, a, b, size / 2, !to_b, comp, cutoff),
+                parallel_sort_impl(scheduler, a + half, b + half, rest, !to_b, comp, cutoff)
+            );
+
+            auto end = static_cast< std::ptrdiff_t >(size);
+            if (to_b) {
+                co_await parallel_merge(scheduler, a, a + half, a + half, a + end, b, comp, cutoff);
+            } else {
+                co_await parallel_merge(scheduler, b, b + half, b + half, b + end, a, comp, cutoff);
+            }
+        }
+
+    } // namespace detail
+
+    // Invokes 'fn(element)' for every element of [first, last) on the
+    // threads of 'scheduler'.
+    //
+    // One worker per scheduler thread claims chunks of at least 'grain'
+    // elements; chunks shrink as the range runs out so that the workers
+    // finish together. 'fn' is shared by the workers and called
+    // concurrently. If an invocation throws, no further chunks are handed
+    // out and the first exception is rethrown once every worker has stopped.
+    //
+    //     sync_wait(parallel_for(pool, functions, [](auto &f) { summarize(f); }));
+    template< scheduler scheduler_t, std::random_access_iterator iterator_t, typename fn_t >
+    requires std::invocable< fn_t&, std::iter_reference_t< iterator_t > >
+    task<> parallel_for(
+        scheduler_t &scheduler, iterator_t first, iterator_t last, fn_t fn, std::size_t grain = 1
+    ) {
+        auto size = static_cast< std::size_t >(last - first);
+        if (size == 0) {
+            co_return;
+        }
+
+        struct no_partial {};
+        co_await detail::run_chunked< no_partial >(
+            scheduler, size, grain,
+            [first, &fn](no_partial &, std::size_t begin, std::size_t end) {
+                std::for_each(
+                    first + static_cast< std::ptrdiff_t >(begin),
+                    first + static_cast< std::ptrdiff_t >(end),
+                    std::ref(fn)
+                );
+            }
+        );
+    }
+
+    template< scheduler scheduler_t, std::ranges::random_access_range range_t, typename fn_t >
+    requires std::ranges::sized_range< range_t >
+          && std::invocable< fn_t&, std::ranges::range_reference_t< range_t > >
+    task<> parallel_for(scheduler_t &scheduler, range_t &range, fn_t fn, std::size_t grain = 1) {
+        auto first = std::ranges::begin(range);
+        return parallel_for(
+            scheduler, first, first + std::ranges::ssize(range), std::move(fn), grain
+        );
+    }
+
+    // Computes 'reduce(... reduce(init, transform(x0)) ..., transform(xn))'
+    // on the threads of 'scheduler'.
+    //
+    // Every worker folds the chunks it claims into a partial result, the
+    // partial results are then folded into 'init'. As with
+    // std::transform_reduce, 'reduce' has to be associative and commutative
+    // since the grouping and order of the operations are unspecified.
+    template<
+        scheduler scheduler_t, std::random_access_iterator iterator_t,
+        typename value_t, typename reduce_t, typename transform_t
+    >
+    requires std::invocable< transform_t&, std::iter_reference_t< iterator_t > >
+          && std::invocable< reduce_t&, value_t, value_t >
+    task< value_t > parallel_transform_reduce(
+        scheduler_t &scheduler, iterator_t first, iterator_t last, value_t init,
+        reduce_t reduce, transform_t transform, std::size_t grain = 1
+    ) {
+        auto size = static_cast< std::size_t >(last - first);
+        if (size == 0) {
+            co_return init;
+        }
+
+        auto partials = co_await detail::run_chunked< std::optional< value_t > >(
+            scheduler, size, grain,
+            [first, &reduce, &transform](
+                std::optional< value_t > &partial, std::size_t begin, std::size_t end
+            ) {
+                auto it   = first + static_cast< std::ptrdiff_t >(begin);
+                auto stop = first + static_cast< std::ptrdiff_t >(end);
+                if (!partial) {
+                    partial.emplace(transform(*it++));
+                }
+                for (; it != stop; ++it) {
+                    *partial = reduce(std::move(*partial), transform(*it));
+                }
+            }
+        );
+
+        for (auto &partial : partials) {
+            if (partial) {
+                init = reduce(std::move(init), std::move(*partial));
+            }
+        }
+        co_return init;
+    }
+
+    template<
+        scheduler scheduler_t, std::ranges::random_access_range range_t,
+        typename value_t, typename reduce_t, typename transform_t
+    >
+    requires std::ranges::sized_range< range_t >
+          && std::invocable< transform_t&, std::ranges::range_reference_t< range_t > >
+          && std::invocable< reduce_t&, value_t, value_t >
+    task< value_t > parallel_transform_reduce(
+        scheduler_t &scheduler, range_t &range, value_t init,
+        reduce_t reduce, transform_t transform, std::size_t grain = 1
+    ) {
+        auto first = std::ranges::begin(range);
+        return parallel_transform_reduce(
+            scheduler, first, first + std::ranges::ssize(range), std::move(init),
+            std::move(reduce), std::move(transform), grain
+        );
+    }
+
+    // Sorts [first, last) with a parallel merge sort on the threads of
+    // 'scheduler'.
+    //
+    // The range is split into about four leaves per thread that are sorted
+    // with std::sort, and then merged pairwise with a parallel merge through
+    // a scratch buffer of the same size. The sort is not stable. If 'comp'
+    // throws, some elements may be left in a moved-from state.
+    template<
+        scheduler scheduler_t, std::random_access_iterator iterator_t,
+        typename compare_t = std::ranges::less
+    >
+    requires std::sortable< iterator_t, compare_t >
+    task<> parallel_sort(
+        scheduler_t &scheduler, iterator_t first, iterator_t last, compare_t comp = {}
+    ) {
+        using value_t = std::iter_value_t< iterator_t >;
+
+        // Below this size the scheduling overhead outweighs the parallelism.
+        constexpr std::size_t min_leaf_size = 4096;
+
+        auto size   = static_cast< std::size_t >(last - first);
+        auto leaves = 4 * detail::concurrency_of(scheduler);
+        auto cutoff = std::max(min_leaf_size, (size + leaves - 1) / leaves);
+
+        if (size <= cutoff) {
+            std::sort(first, last, std::ref(comp));
+            co_return;
+        }
+
+        if constexpr (std::default_initializable< value_t >) {
+            auto buffer = std::make_unique_for_overwrite< value_t[] >(size);
+            co_await detail::parallel_sort_impl(
+                scheduler, first, buffer.get(), size, false, comp, cutoff
+            );
+        } else {
+            // Without a default constructor, move the elements into the
+            // buffer and sort from there back into the range.
+            std::vector< value_t > buffer(
+                std::make_move_iterator(first), std::make_move_iterator(last)
+            );
+            co_await detail::parallel_sort_impl(
+                scheduler, buffer.begin(), first, size, true, comp, cutoff
+            );
+        }
+    }
+
+    template<
+        scheduler scheduler_t, std::ranges::random_access_range range_t,
+        typename compare_t = std::ranges::less
+    >
+    requires std::ranges::sized_range< range_t >
+          && std::sortable< std::ranges::iterator_t< range_t >, compare_t >
+    task<> parallel_sort(scheduler_t &scheduler, range_t &range, compare_t comp = {}) {
+        auto first = std::ranges::begin(range);
+        return parallel_sort(scheduler, first, first + std::ranges::ssize(range), std::move(comp));
+    }
+
+} // namespace gap::coro
+
+#endif
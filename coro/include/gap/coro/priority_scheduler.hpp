@@ -0,0 +1,146 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/coroutine.hpp>
+
+    #include <array>
+    #include <atomic>
+    #include <cstddef>
+    #include <cstdint>
+    #include <memory>
+    #include <thread>
+    #include <vector>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        template< typename state_t >
+        struct worker_group;
+
+    } // namespace detail
+
+    enum class priority : std::uint8_t { high, normal, low };
+
+    // A fixed-size pool of worker threads like static_thread_pool, resuming
+    // coroutines in order of priority:
+    //
+    //     co_await sched.schedule(priority::low);
+    //     for (auto &function : module) {
+    //         lift(function);
+    //         co_await sched.yield();
+    //     }
+    //
+    // Every level has its own set of queues, a Chase-Lev deque per worker
+    // and a global injection queue, and workers look for work, stealing
+    // included, one level at a time starting from the highest. Coroutines
+    // are never interrupted, a long-running one lets more urgent work in by
+    // awaiting yield(). That is a couple of atomic loads unless work of the
+    // same or a higher priority is queued, in which case the coroutine goes
+    // to the back of its level and the worker picks up the queued work.
+    struct priority_scheduler
+    {
+        static constexpr std::size_t priority_levels = 3;
+
+        struct schedule_operation
+        {
+            schedule_operation(priority_scheduler &scheduler, priority level) noexcept
+                : m_scheduler(scheduler)
+                , m_priority(level)
+            {}
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept;
+            void await_resume() const noexcept {}
+
+          protected:
+            friend struct priority_scheduler;
+            template< typename state_t >
+            friend struct detail::worker_group;
+
+            priority_scheduler &m_scheduler;
+            priority m_priority;
+            gap::coroutine_handle<> m_awaiting_coroutine = nullptr;
+            schedule_operation *m_next = nullptr;
+        };
+
+        struct yield_operation : schedule_operation
+        {
+            using schedule_operation::schedule_operation;
+
+            // Carries on without suspending unless work that is at least as
+            // urgent is waiting.
+            bool await_ready() const noexcept;
+            void await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept;
+        };
+
+        // Initialise to a number of threads equal to the number of cores
+        // on the current machine.
+        priority_scheduler();
+
+        explicit priority_scheduler(std::uint32_t thread_count);
+
+        // Waits for all queued work to be resumed before joining the workers.
+        ~priority_scheduler();
+
+        priority_scheduler(const priority_scheduler &) = delete;
+        priority_scheduler &operator=(const priority_scheduler &) = delete;
+
+        std::uint32_t thread_count() const noexcept { return m_thread_count; }
+
+        [[nodiscard]] schedule_operation schedule(priority level = priority::normal) noexcept {
+            return schedule_operation{ *this, level };
+        }
+
+        // A yield point for the coroutine running on the current worker, at
+        // the priority it was scheduled with. Awaited from any other thread,
+        // it schedules the coroutine onto the workers at normal priority.
+        [[nodiscard]] yield_operation yield() noexcept;
+
+        // Number of coroutines queued at 'level' and not yet picked up.
+        std::size_t queued(priority level) const noexcept {
+            auto count = m_levels[std::size_t(level)].m_queued.load(std::memory_order_relaxed);
+            return count > 0 ? std::size_t(count) : 0;
+        }
+
+      private:
+        struct thread_state;
+
+        // Schedules at one priority, for scheduler_ref.
+        struct level_scheduler
+        {
+            schedule_operation schedule() noexcept { return m_scheduler->schedule(m_priority); }
+
+            priority_scheduler *m_scheduler = nullptr;
+            priority m_priority = priority::normal;
+        };
+
+        struct alignas(64) level_state
+        {
+            // Head of an intrusive stack of operations scheduled from threads
+            // that do not belong to the scheduler.
+            std::atomic< schedule_operation* > m_global_queue_head = nullptr;
+            std::atomic< std::int64_t > m_queued = 0;
+            level_scheduler m_scheduler;
+        };
+
+        void run_worker_thread(thread_state &state) noexcept;
+
+        void schedule_impl(schedule_operation *operation) noexcept;
+
+        schedule_operation *try_get_work(thread_state &state) noexcept;
+
+        bool has_work_up_to(priority level) const noexcept;
+
+        const std::uint32_t m_thread_count;
+        std::unique_ptr< detail::worker_group< thread_state > > m_workers;
+
+        std::array< level_state, priority_levels > m_levels;
+    };
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,99 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+// Built on the reactor and pidfds, only available on Linux.
+#if defined(GAP_ENABLE_COROUTINES) && defined(__linux__)
+
+    #include <gap/coro/async_generator.hpp>
+    #include <gap/coro/reactor.hpp>
+    #include <gap/coro/task.hpp>
+
+    #include <stdexcept>
+    #include <string>
+    #include <vector>
+
+namespace gap::coro
+{
+    struct process_options
+    {
+        // Gives the child a pipe for stdin instead of /dev/null.
+        bool pipe_stdin = false;
+        // Sends the child's stderr down its stdout pipe instead of ours.
+        bool merge_stderr = false;
+    };
+
+    // Thrown by run_process() when the child exits with a non-zero code.
+    struct process_error : std::runtime_error
+    {
+        process_error(const std::string &program, int exit_code)
+            : std::runtime_error(program + " exited with code " + std::to_string(exit_code))
+            , m_exit_code(exit_code)
+        {}
+
+        int exit_code() const noexcept { return m_exit_code; }
+
+      private:
+        int m_exit_code;
+    };
+
+    // A child process whose pipes and exit are awaited on a reactor, so that
+    // supervising it takes no thread of its own.
+    struct child_process
+    {
+        // Starts 'argv[0]', looked up in PATH, with 'argv' as its arguments.
+        // Throws std::system_error if it cannot be started.
+        static child_process spawn(
+            const std::vector< std::string > &argv,
+            process_options options = {},
+            reactor &r = reactor::global()
+        );
+
+        child_process(child_process &&other) noexcept;
+        child_process &operator=(child_process &&other) noexcept;
+
+        // Kills and reaps the child unless it has been waited for.
+        ~child_process();
+
+        int pid() const noexcept { return m_pid; }
+
+        // Open only with 'process_options::pipe_stdin', close it to send EOF.
+        async_pipe &stdin_pipe() noexcept { return m_stdin; }
+        async_pipe &stdout_pipe() noexcept { return m_stdout; }
+
+        // Waits for the child to exit and returns its exit code, or 128 plus
+        // the signal number if a signal killed it.
+        task< int > wait();
+
+      private:
+        child_process(int pid, int pidfd, async_pipe in, async_pipe out, reactor &r) noexcept;
+
+        void release() noexcept;
+
+        int m_pid       = -1;
+        int m_pidfd     = -1;
+        int m_exit_code = -1;
+        async_pipe m_stdin;
+        async_pipe m_stdout;
+        reactor *m_reactor;
+    };
+
+    // Runs a program and streams its stdout in chunks as they arrive:
+    //
+    //     auto output = run_process({ "objdump", "-d", path });
+    //     for (auto it = co_await output.begin(); it != output.end(); co_await ++it) {
+    //         parse(*it);
+    //     }
+    //
+    // The child reads /dev/null, 'options.pipe_stdin' is ignored. Once its
+    // stdout is closed the generator waits for it to exit and throws
+    // process_error if it failed. Abandoning the generator kills the child.
+    async_generator< std::string > run_process(
+        std::vector< std::string > argv,
+        process_options options = {},
+        reactor &r = reactor::global()
+    );
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES && __linux__
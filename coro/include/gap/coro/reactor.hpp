@@ -0,0 +1,130 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+// Built on epoll, only available on Linux.
+#if defined(GAP_ENABLE_COROUTINES) && defined(__linux__)
+
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/scheduler_ref.hpp>
+    #include <gap/coro/task.hpp>
+
+    #include <atomic>
+    #include <cstddef>
+    #include <cstdint>
+    #include <span>
+    #include <thread>
+    #include <utility>
+    #include <vector>
+
+namespace gap::coro
+{
+    // An epoll loop that resumes coroutines once their file descriptors are
+    // ready. Waits are one-shot, a coroutine awaits readiness, retries its
+    // non-blocking call and waits again if needed, so a handful of reactor
+    // threads serve any number of descriptors.
+    //
+    // Coroutines resume on the scheduler they were running on, as with
+    // run_blocking(), or on a reactor thread if they had none. The reactor
+    // has to outlive all waits on it.
+    struct reactor
+    {
+        struct wait_operation
+        {
+            wait_operation(reactor &r, int fd, std::uint32_t events) noexcept
+                : m_reactor(r)
+                , m_fd(fd)
+                , m_events(events)
+            {}
+
+            bool await_ready() const noexcept { return false; }
+
+            // Carries on without suspending if the descriptor could not be
+            // registered, await_resume() throws the error then.
+            bool await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept;
+
+            void await_resume() const;
+
+          private:
+            friend struct reactor;
+
+            reactor &m_reactor;
+            int m_fd;
+            std::uint32_t m_events;
+            int m_error = 0;
+            gap::coroutine_handle<> m_awaiting_coroutine = nullptr;
+            scheduler_ref m_resume_on;
+            // Hands the fields above to the reactor thread, the kernel orders
+            // epoll_ctl() before the event but the memory model knows nothing
+            // of it.
+            std::atomic< bool > m_armed = false;
+        };
+
+        explicit reactor(std::uint32_t thread_count = 1);
+        ~reactor();
+
+        reactor(const reactor &) = delete;
+        reactor &operator=(const reactor &) = delete;
+
+        // The reactor behind async_pipe and run_process() unless another one
+        // is given.
+        static reactor &global();
+
+        std::uint32_t thread_count() const noexcept { return std::uint32_t(m_threads.size()); }
+
+        // At most one wait per descriptor may be outstanding.
+        [[nodiscard]] wait_operation wait_readable(int fd) noexcept;
+        [[nodiscard]] wait_operation wait_writable(int fd) noexcept;
+
+        // Drops the descriptor from the epoll set, called before closing it.
+        void forget(int fd) noexcept;
+
+      private:
+        void run_reactor_thread() noexcept;
+        void stop() noexcept;
+
+        int m_epoll_fd  = -1;
+        int m_wakeup_fd = -1;
+        std::vector< std::thread > m_threads;
+    };
+
+    // One end of a pipe, read or written without blocking the thread.
+    struct async_pipe
+    {
+        // A new pipe as its read end and its write end.
+        static std::pair< async_pipe, async_pipe > create(reactor &r = reactor::global());
+
+        // A closed pipe.
+        async_pipe() noexcept = default;
+
+        // Takes over 'fd' and switches it to non-blocking mode.
+        explicit async_pipe(int fd, reactor &r = reactor::global());
+
+        async_pipe(async_pipe &&other) noexcept;
+        async_pipe &operator=(async_pipe &&other) noexcept;
+
+        ~async_pipe() { close(); }
+
+        // Reads whatever is available, up to 'buffer.size()' bytes, waiting
+        // only if nothing is. Returns 0 once the write end is closed.
+        task< std::size_t > read_some(std::span< std::byte > buffer);
+
+        // Writes as much as fits into the pipe, waiting only if nothing does.
+        task< std::size_t > write_some(std::span< const std::byte > buffer);
+
+        // Writes all of 'buffer'.
+        task<> write_all(std::span< const std::byte > buffer);
+
+        void close() noexcept;
+
+        bool is_open() const noexcept { return m_fd >= 0; }
+        int native_handle() const noexcept { return m_fd; }
+
+      private:
+        int m_fd           = -1;
+        reactor *m_reactor = nullptr;
+    };
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES && __linux__
@@ -14,6 +14,7 @@
 #ifdef GAP_ENABLE_COROUTINES
 
     #include "gap/coro/coroutine.hpp"
+    #include "gap/coro/frame_allocator.hpp"
     #include "gap/coro/generator.hpp"
 
     #include <cassert>
@@ -32,7 +33,7 @@ namespace gap
     namespace detail
     {
         template< typename T >
-        struct recursive_generator_promise_type final {
+        struct recursive_generator_promise_type final : coro::promise_allocator {
             using value_type     = std::remove_reference_t< T >;
             using reference_type = std::conditional_t< std::is_reference_v< T >, T, T& >;
             using pointer_type   = std::add_pointer_t< T >;
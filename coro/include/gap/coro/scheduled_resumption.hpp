@@ -0,0 +1,86 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/coroutine.hpp>
+
+    #include <optional>
+    #include <type_traits>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        // Resumes the awaiting coroutine on the thread that released it.
+        struct inline_scheduler
+        {
+            gap::suspend_never schedule() const noexcept { return {}; }
+        };
+
+        inline inline_scheduler inline_scheduler_instance;
+
+        // Resumes a coroutine through 'co_await scheduler.schedule()' from
+        // outside of the coroutine, keeping the schedule operation alive
+        // until the coroutine picks up the result in await_resume().
+        template< scheduler scheduler_t >
+        struct scheduled_resumption
+        {
+            explicit scheduled_resumption(scheduler_t &scheduler) noexcept
+                : m_scheduler(scheduler)
+            {}
+
+            scheduled_resumption(const scheduled_resumption &other) noexcept
+                : m_scheduler(other.m_scheduler)
+            {}
+
+            void resume(gap::coroutine_handle<> coroutine) noexcept {
+                if constexpr (std::is_same_v< scheduler_t, inline_scheduler >) {
+                    coroutine.resume();
+                } else {
+                    try {
+                        auto &operation = m_operation.emplace(m_scheduler.schedule());
+                        if (!operation.await_ready()) {
+                            using await_suspend_result_t = decltype(operation.await_suspend(coroutine));
+                            if constexpr (std::is_void_v< await_suspend_result_t >) {
+                                operation.await_suspend(coroutine);
+                                return;
+                            } else if constexpr (std::is_same_v< await_suspend_result_t, bool >) {
+                                if (operation.await_suspend(coroutine)) {
+                                    return;
+                                }
+                            } else {
+                                operation.await_suspend(coroutine).resume();
+                                return;
+                            }
+                        }
+                    } catch (...) {
+                        // Failing to reschedule falls back to resuming the
+                        // coroutine inline.
+                    }
+
+                    // Resume outside of the catch block.
+                    coroutine.resume();
+                }
+            }
+
+            void await_resume() {
+                if (m_operation) {
+                    m_operation->await_resume();
+                }
+            }
+
+          private:
+            using schedule_operation_t = decltype(std::declval< scheduler_t& >().schedule());
+
+            scheduler_t &m_scheduler;
+            std::optional< schedule_operation_t > m_operation;
+        };
+
+    } // namespace detail
+
+} // namespace gap::coro
+
+#endif
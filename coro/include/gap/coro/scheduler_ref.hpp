@@ -0,0 +1,77 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/async_scope.hpp>
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/coroutine.hpp>
+
+namespace gap::coro
+{
+    // A type-erased reference to a scheduler that can send a coroutine back
+    // onto it from any thread. The workers of gap's thread pools publish the
+    // scheduler they run for through current(), so that operations that
+    // complete on threads of their own, such as run_blocking(), resume the
+    // awaiting coroutine where it came from.
+    struct scheduler_ref
+    {
+        scheduler_ref() noexcept = default;
+
+        template< scheduler scheduler_t >
+        explicit scheduler_ref(scheduler_t &scheduler) noexcept
+            : m_scheduler(&scheduler)
+            , m_resume(&resume_on< scheduler_t >)
+        {}
+
+        explicit operator bool() const noexcept { return m_resume != nullptr; }
+
+        // Schedules 'coroutine' onto the scheduler, or resumes it inline if
+        // there is none.
+        void resume(gap::coroutine_handle<> coroutine) const noexcept {
+            if (m_resume) {
+                m_resume(m_scheduler, coroutine);
+            } else {
+                coroutine.resume();
+            }
+        }
+
+        // The scheduler whose worker is the calling thread, if any.
+        static scheduler_ref current() noexcept;
+
+        // Called by the workers of a scheduler when they start and stop.
+        static void set_current(scheduler_ref scheduler) noexcept;
+
+      private:
+        using resume_fn = void (*)(void *scheduler, gap::coroutine_handle<> coroutine) noexcept;
+
+        template< scheduler scheduler_t >
+        static detail::detached_task reschedule(
+            scheduler_t &scheduler, gap::coroutine_handle<> coroutine
+        ) {
+            co_await scheduler.schedule();
+            coroutine.resume();
+        }
+
+        template< scheduler scheduler_t >
+        static void resume_on(void *scheduler, gap::coroutine_handle<> coroutine) noexcept {
+            try {
+                reschedule(*static_cast< scheduler_t* >(scheduler), coroutine);
+                return;
+            } catch (...) {
+                // Failing to reschedule falls back to resuming the
+                // coroutine inline.
+            }
+
+            // Resume outside of the catch block.
+            coroutine.resume();
+        }
+
+        void *m_scheduler = nullptr;
+        resume_fn m_resume = nullptr;
+    };
+
+} // namespace gap::coro
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,345 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/sequence_barrier.hpp from the
+// cppcoro project. The original file is licenced under the MIT license and the
+// original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/scheduled_resumption.hpp>
+    #include <gap/coro/sequence_traits.hpp>
+
+    #include <atomic>
+    #include <cassert>
+    #include <cstddef>
+    #include <limits>
+
+namespace gap::coro
+{
+    template< typename sequence_t, typename traits_t >
+    struct sequence_barrier_wait_operation_base;
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct sequence_barrier_wait_operation;
+
+    // A sequence_barrier is a synchronisation primitive that allows a single
+    // producer and multiple consumers to coordinate with respect to a
+    // monotonically increasing sequence number.
+    //
+    // The single producer advances the sequence number by publishing new
+    // sequence numbers with publish(). One or more consumers can query the
+    // last published sequence number and wait until a particular sequence
+    // number has been published.
+    //
+    // A sequence barrier can be used to represent a cursor into a
+    // thread-safe producer/consumer ring buffer, see the sequencers in
+    // single_producer_sequencer.hpp and multi_producer_sequencer.hpp.
+    template< typename sequence_t = std::size_t, typename traits_t = sequence_traits< sequence_t > >
+    struct sequence_barrier
+    {
+        static_assert(
+            std::is_integral_v< sequence_t >,
+            "sequence_barrier requires an integral sequence type"
+        );
+
+        using awaiter_t = sequence_barrier_wait_operation_base< sequence_t, traits_t >;
+
+        sequence_barrier(sequence_t initial_sequence = traits_t::initial_sequence) noexcept
+            : m_last_published(initial_sequence)
+            , m_awaiters(nullptr)
+        {}
+
+        ~sequence_barrier() {
+            // Shouldn't be destructing a sequence barrier if there are still
+            // waiters.
+            assert(m_awaiters.load(std::memory_order_relaxed) == nullptr);
+        }
+
+        sequence_barrier(const sequence_barrier&) = delete;
+        sequence_barrier& operator=(const sequence_barrier&) = delete;
+
+        sequence_t last_published() const noexcept {
+            return m_last_published.load(std::memory_order_acquire);
+        }
+
+        // Waits until 'target_sequence', or any later sequence number, has
+        // been published and returns the last published sequence number.
+        // The coroutine is resumed on the publishing thread.
+        [[nodiscard]] sequence_barrier_wait_operation< sequence_t, traits_t, detail::inline_scheduler >
+        wait_until_published(sequence_t target_sequence) const noexcept;
+
+        // Like wait_until_published(target_sequence), but the coroutine is
+        // resumed through 'co_await scheduler.schedule()' so that it does not
+        // run inside of the producer's call to publish().
+        template< scheduler scheduler_t >
+        [[nodiscard]] sequence_barrier_wait_operation< sequence_t, traits_t, scheduler_t >
+        wait_until_published(sequence_t target_sequence, scheduler_t &scheduler) const noexcept;
+
+        // Publishes every sequence number up to and including 'sequence',
+        // resuming the waiters it satisfies.
+        void publish(sequence_t sequence) noexcept;
+
+      private:
+        friend struct sequence_barrier_wait_operation_base< sequence_t, traits_t >;
+
+        void add_awaiter(awaiter_t *awaiter) const noexcept;
+
+        // First cache-line is written to by the producer only.
+        alignas(64) std::atomic< sequence_t > m_last_published;
+
+        // Second cache-line is written to by both the producer and consumers.
+        alignas(64) mutable std::atomic< awaiter_t* > m_awaiters;
+    };
+
+    template< typename sequence_t, typename traits_t >
+    struct sequence_barrier_wait_operation_base
+    {
+        explicit sequence_barrier_wait_operation_base(
+            const sequence_barrier< sequence_t, traits_t > &barrier, sequence_t target_sequence
+        ) noexcept
+            : m_barrier(barrier)
+            , m_target_sequence(target_sequence)
+            , m_last_known_published(barrier.last_published())
+            , m_ready_to_resume(false)
+        {}
+
+        sequence_barrier_wait_operation_base(const sequence_barrier_wait_operation_base &other) noexcept
+            : m_barrier(other.m_barrier)
+            , m_target_sequence(other.m_target_sequence)
+            , m_last_known_published(other.m_last_known_published)
+            , m_ready_to_resume(false)
+        {}
+
+        sequence_t target_sequence() const noexcept { return m_target_sequence; }
+
+        bool await_ready() const noexcept {
+            return !traits_t::precedes(m_last_known_published, m_target_sequence);
+        }
+
+        bool await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+            m_awaiting_coroutine = awaiting_coroutine;
+            m_barrier.add_awaiter(this);
+
+            // add_awaiter() may have found the target already published and
+            // called resume(), in which case we continue without suspending.
+            return !m_ready_to_resume.exchange(true, std::memory_order_acq_rel);
+        }
+
+        sequence_t await_resume() noexcept { return m_last_known_published; }
+
+      protected:
+        friend struct sequence_barrier< sequence_t, traits_t >;
+
+        ~sequence_barrier_wait_operation_base() = default;
+
+        void resume() noexcept {
+            // Whichever of this and the exchange in await_suspend() comes
+            // second resumes the coroutine. Both are acq_rel so that the
+            // suspending thread's writes to the frame happen before the
+            // resumption, whichever thread it runs on.
+            if (m_ready_to_resume.exchange(true, std::memory_order_acq_rel)) {
+                resume_impl();
+            }
+        }
+
+        virtual void resume_impl() noexcept = 0;
+
+        const sequence_barrier< sequence_t, traits_t > &m_barrier;
+        const sequence_t m_target_sequence;
+        sequence_t m_last_known_published;
+        sequence_barrier_wait_operation_base *m_next = nullptr;
+        gap::coroutine_handle<> m_awaiting_coroutine;
+        std::atomic< bool > m_ready_to_resume;
+    };
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct sequence_barrier_wait_operation final
+        : sequence_barrier_wait_operation_base< sequence_t, traits_t >
+    {
+        using base = sequence_barrier_wait_operation_base< sequence_t, traits_t >;
+
+        sequence_barrier_wait_operation(
+            const sequence_barrier< sequence_t, traits_t > &barrier,
+            sequence_t target_sequence,
+            scheduler_t &scheduler
+        ) noexcept
+            : base(barrier, target_sequence)
+            , m_resumption(scheduler)
+        {}
+
+        sequence_barrier_wait_operation(const sequence_barrier_wait_operation &other) noexcept
+            : base(other)
+            , m_resumption(other.m_resumption)
+        {}
+
+        sequence_t await_resume() {
+            m_resumption.await_resume();
+            return base::await_resume();
+        }
+
+      private:
+        void resume_impl() noexcept override { m_resumption.resume(this->m_awaiting_coroutine); }
+
+        detail::scheduled_resumption< scheduler_t > m_resumption;
+    };
+
+    template< typename sequence_t, typename traits_t >
+    sequence_barrier_wait_operation< sequence_t, traits_t, detail::inline_scheduler >
+    sequence_barrier< sequence_t, traits_t >::wait_until_published(
+        sequence_t target_sequence
+    ) const noexcept {
+        return { *this, target_sequence, detail::inline_scheduler_instance };
+    }
+
+    template< typename sequence_t, typename traits_t >
+    template< scheduler scheduler_t >
+    sequence_barrier_wait_operation< sequence_t, traits_t, scheduler_t >
+    sequence_barrier< sequence_t, traits_t >::wait_until_published(
+        sequence_t target_sequence, scheduler_t &scheduler
+    ) const noexcept {
+        return { *this, target_sequence, scheduler };
+    }
+
+    template< typename sequence_t, typename traits_t >
+    void sequence_barrier< sequence_t, traits_t >::publish(sequence_t sequence) noexcept {
+        m_last_published.store(sequence, std::memory_order_seq_cst);
+
+        // Cheaper check to see if there are any awaiting coroutines.
+        auto *awaiters = m_awaiters.load(std::memory_order_seq_cst);
+        if (awaiters == nullptr) {
+            return;
+        }
+
+        // Acquire the list of awaiters.
+        awaiters = m_awaiters.exchange(nullptr, std::memory_order_acquire);
+        if (awaiters == nullptr) {
+            return;
+        }
+
+        // Split the awaiters into the ones satisfied by the sequence number we
+        // just published and the ones that need to be requeued.
+        awaiter_t *awaiters_to_resume;
+        awaiter_t **awaiters_to_resume_tail = &awaiters_to_resume;
+
+        awaiter_t *awaiters_to_requeue;
+        awaiter_t **awaiters_to_requeue_tail = &awaiters_to_requeue;
+
+        do {
+            if (traits_t::precedes(sequence, awaiters->m_target_sequence)) {
+                *awaiters_to_requeue_tail = awaiters;
+                awaiters_to_requeue_tail  = &awaiters->m_next;
+            } else {
+                *awaiters_to_resume_tail = awaiters;
+                awaiters_to_resume_tail  = &awaiters->m_next;
+            }
+            awaiters = awaiters->m_next;
+        } while (awaiters != nullptr);
+
+        *awaiters_to_requeue_tail = nullptr;
+        *awaiters_to_resume_tail  = nullptr;
+
+        if (awaiters_to_requeue != nullptr) {
+            awaiter_t *old_head = nullptr;
+            while (!m_awaiters.compare_exchange_weak(
+                old_head, awaiters_to_requeue, std::memory_order_release, std::memory_order_relaxed
+            )) {
+                *awaiters_to_requeue_tail = old_head;
+            }
+        }
+
+        while (awaiters_to_resume != nullptr) {
+            // Read m_next before resuming, resuming may destroy the awaiter.
+            auto *next = awaiters_to_resume->m_next;
+            awaiters_to_resume->m_last_known_published = sequence;
+            awaiters_to_resume->resume();
+            awaiters_to_resume = next;
+        }
+    }
+
+    template< typename sequence_t, typename traits_t >
+    void sequence_barrier< sequence_t, traits_t >::add_awaiter(awaiter_t *awaiter) const noexcept {
+        sequence_t target_sequence = awaiter->m_target_sequence;
+
+        awaiter_t *awaiters_to_requeue        = awaiter;
+        awaiter_t **awaiters_to_requeue_tail  = &awaiter->m_next;
+
+        sequence_t last_known_published;
+        awaiter_t *awaiters_to_resume;
+        awaiter_t **awaiters_to_resume_tail = &awaiters_to_resume;
+
+        do {
+            // Enqueue the awaiter(s).
+            {
+                auto *old_head = m_awaiters.load(std::memory_order_relaxed);
+                do {
+                    *awaiters_to_requeue_tail = old_head;
+                } while (!m_awaiters.compare_exchange_weak(
+                    old_head, awaiters_to_requeue, std::memory_order_seq_cst, std::memory_order_relaxed
+                ));
+            }
+
+            // Check that the sequence we were waiting for wasn't published
+            // while we were enqueueing the waiter. This needs to be seq_cst so
+            // that a concurrent publish() either sees our write to
+            // 'm_awaiters', or we see its write to 'm_last_published'.
+            last_known_published = m_last_published.load(std::memory_order_seq_cst);
+            if (traits_t::precedes(last_known_published, target_sequence)) {
+                // None of the awaiters we enqueued have been satisfied yet.
+                break;
+            }
+
+            // Reset the requeue list to empty.
+            awaiters_to_requeue_tail = &awaiters_to_requeue;
+
+            // At least one of the awaiters we just enqueued is satisfied by a
+            // concurrently published sequence number that the producer may
+            // have published before seeing our awaiters. Reacquire the list to
+            // make sure they are woken up.
+            auto *awaiters = m_awaiters.exchange(nullptr, std::memory_order_acquire);
+
+            using difference_t = typename traits_t::difference_type;
+            auto min_diff = std::numeric_limits< difference_t >::max();
+
+            while (awaiters != nullptr) {
+                const auto diff = traits_t::difference(awaiters->m_target_sequence, last_known_published);
+                if (diff > 0) {
+                    *awaiters_to_requeue_tail = awaiters;
+                    awaiters_to_requeue_tail  = &awaiters->m_next;
+                    min_diff = diff < min_diff ? diff : min_diff;
+                } else {
+                    *awaiters_to_resume_tail = awaiters;
+                    awaiters_to_resume_tail  = &awaiters->m_next;
+                }
+                awaiters = awaiters->m_next;
+            }
+
+            // Null-terminate the list of awaiters to requeue.
+            *awaiters_to_requeue_tail = nullptr;
+
+            // The earliest target sequence of the awaiters to requeue.
+            target_sequence = static_cast< sequence_t >(last_known_published + min_diff);
+        } while (awaiters_to_requeue != nullptr);
+
+        // Null-terminate the list of awaiters to resume.
+        *awaiters_to_resume_tail = nullptr;
+
+        while (awaiters_to_resume != nullptr) {
+            auto *next = awaiters_to_resume->m_next;
+            awaiters_to_resume->m_last_known_published = last_known_published;
+            awaiters_to_resume->resume();
+            awaiters_to_resume = next;
+        }
+    }
+
+} // namespace gap::coro
+
+#endif
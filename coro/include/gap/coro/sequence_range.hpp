@@ -0,0 +1,142 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/sequence_range.hpp from the
+// cppcoro project. The original file is licenced under the MIT license and the
+// original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/sequence_traits.hpp>
+
+    #include <algorithm>
+    #include <iterator>
+    #include <memory>
+
+namespace gap::coro
+{
+    // The half-open range of sequence numbers [begin, end), e.g. a batch of
+    // slots claimed from a sequencer.
+    template< typename sequence_t, typename traits_t = sequence_traits< sequence_t > >
+    struct sequence_range
+    {
+        using value_type      = sequence_t;
+        using difference_type = typename traits_t::difference_type;
+        using size_type       = typename traits_t::size_type;
+
+        struct const_iterator
+        {
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = sequence_t;
+            using difference_type   = typename traits_t::difference_type;
+            using reference         = const sequence_t&;
+            using pointer           = const sequence_t*;
+
+            constexpr const_iterator() noexcept = default;
+
+            explicit constexpr const_iterator(sequence_t value) noexcept
+                : m_value(value)
+            {}
+
+            constexpr const sequence_t& operator*() const noexcept { return m_value; }
+            constexpr const sequence_t* operator->() const noexcept { return std::addressof(m_value); }
+
+            constexpr const_iterator& operator++() noexcept { ++m_value; return *this; }
+            constexpr const_iterator& operator--() noexcept { --m_value; return *this; }
+
+            constexpr const_iterator operator++(int) noexcept { return const_iterator(m_value++); }
+            constexpr const_iterator operator--(int) noexcept { return const_iterator(m_value--); }
+
+            constexpr const_iterator& operator+=(difference_type n) noexcept {
+                m_value = static_cast< sequence_t >(m_value + n);
+                return *this;
+            }
+
+            constexpr const_iterator& operator-=(difference_type n) noexcept {
+                m_value = static_cast< sequence_t >(m_value - n);
+                return *this;
+            }
+
+            constexpr const_iterator operator+(difference_type n) const noexcept {
+                return const_iterator(static_cast< sequence_t >(m_value + n));
+            }
+
+            constexpr const_iterator operator-(difference_type n) const noexcept {
+                return const_iterator(static_cast< sequence_t >(m_value - n));
+            }
+
+            constexpr difference_type operator-(const_iterator other) const noexcept {
+                return traits_t::difference(m_value, other.m_value);
+            }
+
+            constexpr sequence_t operator[](difference_type n) const noexcept {
+                return static_cast< sequence_t >(m_value + n);
+            }
+
+            constexpr bool operator==(const const_iterator &other) const noexcept {
+                return m_value == other.m_value;
+            }
+
+            constexpr bool operator<(const const_iterator &other) const noexcept {
+                return traits_t::precedes(m_value, other.m_value);
+            }
+
+            constexpr bool operator>(const const_iterator &other) const noexcept { return other < *this; }
+            constexpr bool operator<=(const const_iterator &other) const noexcept { return !(other < *this); }
+            constexpr bool operator>=(const const_iterator &other) const noexcept { return !(*this < other); }
+
+            friend constexpr const_iterator operator+(difference_type n, const_iterator it) noexcept {
+                return it + n;
+            }
+
+          private:
+            sequence_t m_value = sequence_t();
+        };
+
+        constexpr sequence_range() noexcept = default;
+
+        constexpr sequence_range(sequence_t begin, sequence_t end) noexcept
+            : m_begin(begin)
+            , m_end(end)
+        {}
+
+        constexpr const_iterator begin() const noexcept { return const_iterator(m_begin); }
+        constexpr const_iterator end() const noexcept { return const_iterator(m_end); }
+
+        constexpr sequence_t front() const noexcept { return m_begin; }
+        constexpr sequence_t back() const noexcept { return static_cast< sequence_t >(m_end - 1); }
+
+        constexpr size_type size() const noexcept {
+            return static_cast< size_type >(traits_t::difference(m_end, m_begin));
+        }
+
+        constexpr bool empty() const noexcept { return m_begin == m_end; }
+
+        constexpr sequence_t operator[](size_type index) const noexcept {
+            return static_cast< sequence_t >(m_begin + index);
+        }
+
+        // The first 'count' sequence numbers of the range.
+        constexpr sequence_range first(size_type count) const noexcept {
+            return sequence_range{ m_begin, static_cast< sequence_t >(m_begin + std::min(size(), count)) };
+        }
+
+        // The range without its first 'count' sequence numbers.
+        constexpr sequence_range skip(size_type count) const noexcept {
+            return sequence_range{ static_cast< sequence_t >(m_begin + std::min(size(), count)), m_end };
+        }
+
+      private:
+        sequence_t m_begin = sequence_t();
+        sequence_t m_end   = sequence_t();
+    };
+
+} // namespace gap::coro
+
+#endif
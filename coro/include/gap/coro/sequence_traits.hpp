@@ -0,0 +1,48 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/sequence_traits.hpp from the
+// cppcoro project. The original file is licenced under the MIT license and the
+// original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <limits>
+    #include <type_traits>
+
+namespace gap::coro
+{
+    // Arithmetic on sequence numbers that are allowed to wrap around. Two
+    // sequence numbers are compared by their signed difference, so they must
+    // never be more than 'max_difference' apart.
+    template< typename sequence_t >
+    struct sequence_traits
+    {
+        static_assert(std::is_integral_v< sequence_t >, "sequence number must be an integer");
+
+        using value_type      = sequence_t;
+        using difference_type = std::make_signed_t< sequence_t >;
+        using size_type       = std::make_unsigned_t< sequence_t >;
+
+        static constexpr value_type initial_sequence = static_cast< value_type >(-1);
+
+        static constexpr difference_type max_difference = std::numeric_limits< difference_type >::max();
+
+        static constexpr difference_type difference(value_type a, value_type b) noexcept {
+            return static_cast< difference_type >(a - b);
+        }
+
+        static constexpr bool precedes(value_type a, value_type b) noexcept {
+            return difference(a, b) < 0;
+        }
+    };
+
+} // namespace gap::coro
+
+#endif
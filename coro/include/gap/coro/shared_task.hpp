@@ -18,6 +18,8 @@
     #include <gap/coro/coroutine.hpp>
     #include <gap/coro/awaitable_traits.hpp>
     #include <gap/coro/broken_promise.hpp>
+    #include <gap/coro/frame_allocator.hpp>
+    #include <gap/coro/lifecycle_hooks.hpp>
     #include <gap/coro/task.hpp>
 
     #include <atomic>
@@ -37,7 +39,16 @@ namespace gap::coro
             shared_task_waiter* m_next;
         };
 
-        struct shared_task_promise_base {
+    #if GAP_CORO_LIFECYCLE_HOOKS
+        using shared_task_lifecycle_frame = lifecycle_frame< coroutine_kind::shared_task >;
+    #endif
+
+        struct shared_task_promise_base
+            : promise_allocator
+        #if GAP_CORO_LIFECYCLE_HOOKS
+            , shared_task_lifecycle_frame
+        #endif
+        {
             friend struct final_awaiter;
 
             struct final_awaiter {
@@ -49,6 +60,9 @@ namespace gap::coro
                 template< typename promise_t >
                 void await_suspend(gap::coroutine_handle< promise_t > handle) noexcept {
                     shared_task_promise_base& promise = handle.promise();
+                #if GAP_CORO_LIFECYCLE_HOOKS
+                    static_cast< shared_task_lifecycle_frame& >(promise).on_suspend();
+                #endif
 
                     // Exchange operation needs to be 'release' so that subsequent awaiters have
 					// visibility of the result. Also needs to be 'acquire' so we have visibility
@@ -82,9 +96,25 @@ namespace gap::coro
                 , m_exception(nullptr)
             {}
 
+        #if GAP_CORO_LIFECYCLE_HOOKS
+            auto initial_suspend() noexcept {
+                return hooked_initial_suspend< gap::suspend_always, shared_task_lifecycle_frame >{
+                    {}, *this
+                };
+            }
+
+            template< awaitable awaitable_t >
+            auto await_transform(awaitable_t &&awaitable) {
+                return make_hooked_awaiter(
+                    static_cast< awaitable_t&& >(awaitable),
+                    static_cast< shared_task_lifecycle_frame& >(*this)
+                );
+            }
+        #else
             gap::suspend_always initial_suspend() noexcept {
                 return {};
             }
+        #endif
 
             final_awaiter final_suspend() noexcept {
                 return {};
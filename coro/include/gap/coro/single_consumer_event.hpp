@@ -15,9 +15,15 @@
 
     #include <gap/coro/coroutine.hpp>
     #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/cancellation_registration.hpp>
+    #include <gap/coro/cancellation_token.hpp>
+    #include <gap/coro/operation_cancelled.hpp>
 
     #include <atomic>
     #include <concepts>
+    #include <memory>
+    #include <optional>
+    #include <thread>
     #include <type_traits>
     #include <utility>
 
@@ -50,29 +56,138 @@ namespace gap::coro
         }
 
         auto operator co_await() noexcept {
+            return awaiter_base{ *this };
+        }
+
+        // Like 'co_await event' but stops waiting and throws
+        // operation_cancelled if cancellation is requested on 'token' before
+        // the event is set.
+        auto wait(cancellation_token token) noexcept {
             struct awaiter {
+                // Hand-shake between await_suspend() and the cancellation
+                // callback. It outlives the awaiter because the coroutine may
+                // be resumed by set(), and the awaiter destroyed, right after
+                // it was published as the waiter.
+                struct wait_state {
+                    enum phase_kind { registering, publishing, suspended, not_suspended, cancelled };
+
+                    std::atomic< phase_kind > m_phase = registering;
+                    bool m_resumed_by_cancellation = false;
+                };
+
                 single_consumer_event &m_event;
+                cancellation_token m_token;
+                std::shared_ptr< wait_state > m_state = nullptr;
+                std::optional< cancellation_registration > m_registration = std::nullopt;
 
                 bool await_ready() const noexcept {
-                    return m_event.is_set();
+                    return m_event.is_set() || m_token.is_cancellation_requested();
                 }
 
-                bool await_suspend(gap::coroutine_handle<> handle) noexcept {
+                bool await_suspend(gap::coroutine_handle<> handle) {
+                    if (!m_token.can_be_cancelled()) {
+                        return awaiter_base{ m_event }.await_suspend(handle);
+                    }
+
+                    auto state = std::make_shared< wait_state >();
+                    m_state = state;
                     m_event.m_awaiter = handle;
+
+                    m_registration.emplace(m_token, [state, &event = m_event] {
+                        on_cancel(*state, event);
+                    });
+
+                    auto phase = wait_state::registering;
+                    if (!state->m_phase.compare_exchange_strong(phase, wait_state::publishing)) {
+                        // Cancelled while registering the callback.
+                        return false;
+                    }
+
                     state_kind old = state_kind::notset;
-                    return m_event.m_state.compare_exchange_strong(
-                        old, state_kind::waiting,
-                        std::memory_order_release,
-                        std::memory_order_acquire
-                    );
+                    if (!m_event.m_state.compare_exchange_strong(
+                            old, state_kind::waiting,
+                            std::memory_order_release,
+                            std::memory_order_acquire))
+                    {
+                        state->m_phase.store(wait_state::not_suspended);
+                        return false;
+                    }
+
+                    // Only the local copy of the state may be touched from here.
+                    state->m_phase.store(wait_state::suspended);
+                    return true;
+                }
+
+                void await_resume() const {
+                    if (m_state) {
+                        auto phase = m_state->m_phase.load(std::memory_order_acquire);
+                        if (phase == wait_state::cancelled || m_state->m_resumed_by_cancellation) {
+                            throw operation_cancelled{};
+                        }
+                    } else if (!m_event.is_set()) {
+                        // await_ready() saw the cancellation request.
+                        throw operation_cancelled{};
+                    }
                 }
 
-                void await_resume() const noexcept {}
+                static void on_cancel(wait_state &state, single_consumer_event &event) {
+                    while (true) {
+                        auto phase = state.m_phase.load();
+                        switch (phase) {
+                            case wait_state::registering:
+                                // Invoked before await_suspend() committed to
+                                // waiting, let it back out instead.
+                                if (state.m_phase.compare_exchange_strong(phase, wait_state::cancelled)) {
+                                    return;
+                                }
+                                break;
+                            case wait_state::publishing:
+                                // A few instructions away from 'suspended'.
+                                std::this_thread::yield();
+                                break;
+                            case wait_state::suspended: {
+                                state_kind old = state_kind::waiting;
+                                if (event.m_state.compare_exchange_strong(
+                                        old, state_kind::notset,
+                                        std::memory_order_acquire,
+                                        std::memory_order_relaxed))
+                                {
+                                    state.m_resumed_by_cancellation = true;
+                                    event.m_awaiter.resume();
+                                }
+                                return;
+                            }
+                            default:
+                                return;
+                        }
+                    }
+                }
             };
 
-            return awaiter{ *this };
+            return awaiter{ *this, std::move(token) };
         }
+
       private:
+        struct awaiter_base {
+            single_consumer_event &m_event;
+
+            bool await_ready() const noexcept {
+                return m_event.is_set();
+            }
+
+            bool await_suspend(gap::coroutine_handle<> handle) noexcept {
+                m_event.m_awaiter = handle;
+                state_kind old = state_kind::notset;
+                return m_event.m_state.compare_exchange_strong(
+                    old, state_kind::waiting,
+                    std::memory_order_release,
+                    std::memory_order_acquire
+                );
+            }
+
+            void await_resume() const noexcept {}
+        };
+
         std::atomic< state_kind > m_state = state_kind::notset;
         gap::coroutine_handle<> m_awaiter = nullptr;
     };
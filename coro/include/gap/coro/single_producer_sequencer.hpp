@@ -0,0 +1,205 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/single_producer_sequencer.hpp
+// from the cppcoro project. The original file is licenced under the MIT
+// license and the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/sequence_barrier.hpp>
+    #include <gap/coro/sequence_range.hpp>
+
+    #include <algorithm>
+    #include <cassert>
+    #include <cstddef>
+
+namespace gap::coro
+{
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct single_producer_sequencer_claim_one_operation;
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct single_producer_sequencer_claim_operation;
+
+    // Hands out slots of a ring buffer of 'buffer_size' elements to a single
+    // producer and publishes them to the consumers.
+    //
+    // The producer claims sequence numbers, writes the elements at
+    // 'sequence % buffer_size' and publishes them. Claiming waits on the
+    // 'consumer_barrier' until the consumers have released the slots, which
+    // they do by publishing the last sequence number they have finished
+    // reading:
+    //
+    //     // producer
+    //     auto range = co_await sequencer.claim_up_to(16);
+    //     for (auto seq : range) { buffer[seq % size] = ...; }
+    //     sequencer.publish(range.back());
+    //
+    //     // consumer
+    //     auto available = co_await sequencer.wait_until_published(next);
+    //     for (; next <= available; ++next) { read(buffer[next % size]); }
+    //     consumer_barrier.publish(available);
+    //
+    // The producer must not call claim operations concurrently.
+    template< typename sequence_t = std::size_t, typename traits_t = sequence_traits< sequence_t > >
+    struct single_producer_sequencer
+    {
+        using size_type = typename sequence_range< sequence_t, traits_t >::size_type;
+
+        single_producer_sequencer(
+            const sequence_barrier< sequence_t, traits_t > &consumer_barrier,
+            std::size_t buffer_size,
+            sequence_t initial_sequence = traits_t::initial_sequence
+        ) noexcept
+            : m_consumer_barrier(consumer_barrier)
+            , m_buffer_size(buffer_size)
+            , m_next_to_claim(static_cast< sequence_t >(initial_sequence + 1))
+            , m_producer_barrier(initial_sequence)
+        {
+            assert(buffer_size > 0);
+        }
+
+        std::size_t buffer_size() const noexcept { return m_buffer_size; }
+
+        // Claims the next sequence number, waiting until the consumers have
+        // released its slot.
+        [[nodiscard]] auto claim_one() noexcept {
+            return claim_one(detail::inline_scheduler_instance);
+        }
+
+        template< scheduler scheduler_t >
+        [[nodiscard]] single_producer_sequencer_claim_one_operation< sequence_t, traits_t, scheduler_t >
+        claim_one(scheduler_t &scheduler) noexcept {
+            return { *this, scheduler };
+        }
+
+        // Claims a range of up to 'count' consecutive sequence numbers. Waits
+        // until at least one slot is available and then claims as many of
+        // the available slots as possible.
+        [[nodiscard]] auto claim_up_to(std::size_t count) noexcept {
+            return claim_up_to(count, detail::inline_scheduler_instance);
+        }
+
+        template< scheduler scheduler_t >
+        [[nodiscard]] single_producer_sequencer_claim_operation< sequence_t, traits_t, scheduler_t >
+        claim_up_to(std::size_t count, scheduler_t &scheduler) noexcept {
+            return { *this, count, scheduler };
+        }
+
+        // Publishes every sequence number up to and including 'sequence'.
+        void publish(sequence_t sequence) noexcept { m_producer_barrier.publish(sequence); }
+
+        sequence_t last_published() const noexcept { return m_producer_barrier.last_published(); }
+
+        // Waits until 'target_sequence' has been published by the producer
+        // and returns the last published sequence number.
+        [[nodiscard]] auto wait_until_published(sequence_t target_sequence) const noexcept {
+            return m_producer_barrier.wait_until_published(target_sequence);
+        }
+
+        template< scheduler scheduler_t >
+        [[nodiscard]] auto wait_until_published(
+            sequence_t target_sequence, scheduler_t &scheduler
+        ) const noexcept {
+            return m_producer_barrier.wait_until_published(target_sequence, scheduler);
+        }
+
+      private:
+        template< typename, typename, scheduler >
+        friend struct single_producer_sequencer_claim_one_operation;
+
+        template< typename, typename, scheduler >
+        friend struct single_producer_sequencer_claim_operation;
+
+        const sequence_barrier< sequence_t, traits_t > &m_consumer_barrier;
+        const std::size_t m_buffer_size;
+
+        // Only touched by the producer.
+        alignas(64) sequence_t m_next_to_claim;
+
+        sequence_barrier< sequence_t, traits_t > m_producer_barrier;
+    };
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct single_producer_sequencer_claim_one_operation
+    {
+        single_producer_sequencer_claim_one_operation(
+            single_producer_sequencer< sequence_t, traits_t > &sequencer, scheduler_t &scheduler
+        ) noexcept
+            : m_consumer_wait_operation(
+                sequencer.m_consumer_barrier,
+                static_cast< sequence_t >(sequencer.m_next_to_claim - sequencer.m_buffer_size),
+                scheduler
+            )
+            , m_sequencer(sequencer)
+        {}
+
+        bool await_ready() const noexcept { return m_consumer_wait_operation.await_ready(); }
+
+        auto await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+            return m_consumer_wait_operation.await_suspend(awaiting_coroutine);
+        }
+
+        sequence_t await_resume() {
+            m_consumer_wait_operation.await_resume();
+            return m_sequencer.m_next_to_claim++;
+        }
+
+      private:
+        sequence_barrier_wait_operation< sequence_t, traits_t, scheduler_t > m_consumer_wait_operation;
+        single_producer_sequencer< sequence_t, traits_t > &m_sequencer;
+    };
+
+    template< typename sequence_t, typename traits_t, scheduler scheduler_t >
+    struct single_producer_sequencer_claim_operation
+    {
+        single_producer_sequencer_claim_operation(
+            single_producer_sequencer< sequence_t, traits_t > &sequencer,
+            std::size_t count,
+            scheduler_t &scheduler
+        ) noexcept
+            : m_consumer_wait_operation(
+                sequencer.m_consumer_barrier,
+                static_cast< sequence_t >(sequencer.m_next_to_claim - sequencer.m_buffer_size),
+                scheduler
+            )
+            , m_sequencer(sequencer)
+            , m_count(count)
+        {}
+
+        bool await_ready() const noexcept { return m_consumer_wait_operation.await_ready(); }
+
+        auto await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+            return m_consumer_wait_operation.await_suspend(awaiting_coroutine);
+        }
+
+        sequence_range< sequence_t, traits_t > await_resume() {
+            const auto last_available = static_cast< sequence_t >(
+                m_consumer_wait_operation.await_resume() + m_sequencer.m_buffer_size
+            );
+
+            const sequence_t begin = m_sequencer.m_next_to_claim;
+            const auto available   = static_cast< std::size_t >(last_available - begin) + 1;
+            const auto to_claim    = std::min(m_count, available);
+            const auto end         = static_cast< sequence_t >(begin + to_claim);
+
+            m_sequencer.m_next_to_claim = end;
+            return { begin, end };
+        }
+
+      private:
+        sequence_barrier_wait_operation< sequence_t, traits_t, scheduler_t > m_consumer_wait_operation;
+        single_producer_sequencer< sequence_t, traits_t > &m_sequencer;
+        std::size_t m_count;
+    };
+
+} // namespace gap::coro
+
+#endif
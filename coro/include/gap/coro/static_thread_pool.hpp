@@ -0,0 +1,134 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/static_thread_pool.hpp from the
+// cppcoro project. The original file is licenced under the MIT license and the
+// original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/cancellation_token.hpp>
+    #include <gap/coro/coroutine.hpp>
+
+    #include <atomic>
+    #include <cstdint>
+    #include <memory>
+    #include <thread>
+    #include <utility>
+    #include <vector>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        template< typename state_t >
+        struct worker_group;
+
+    } // namespace detail
+
+    // A fixed-size pool of worker threads that resumes coroutines awaiting
+    // 'co_await pool.schedule()'.
+    //
+    // Every worker owns a Chase-Lev deque. Coroutines scheduled from a worker
+    // are pushed to that worker's deque, coroutines scheduled from any other
+    // thread go through a global injection queue. Idle workers first drain
+    // their own deque, then the injection queue and finally try to steal from
+    // the other workers before going to sleep.
+    struct static_thread_pool
+    {
+        struct schedule_operation
+        {
+            explicit schedule_operation(static_thread_pool &pool) noexcept
+                : m_pool(pool)
+            {}
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept;
+            void await_resume() const noexcept {}
+
+          private:
+            friend struct static_thread_pool;
+            template< typename state_t >
+            friend struct detail::worker_group;
+
+            static_thread_pool &m_pool;
+            gap::coroutine_handle<> m_awaiting_coroutine = nullptr;
+            schedule_operation *m_next = nullptr;
+        };
+
+        // A schedule operation that observes a cancellation token. It does
+        // not enqueue anything if cancellation was requested beforehand and
+        // throws operation_cancelled as soon as a worker picks it up if the
+        // request came in while it was queued, so a cancelled coroutine
+        // never runs its continuation on the pool.
+        struct cancellable_schedule_operation : schedule_operation
+        {
+            cancellable_schedule_operation(
+                static_thread_pool &pool, cancellation_token token
+            ) noexcept
+                : schedule_operation(pool)
+                , m_cancellation_token(std::move(token))
+            {}
+
+            bool await_ready() const noexcept {
+                return m_cancellation_token.is_cancellation_requested();
+            }
+
+            void await_resume() const {
+                m_cancellation_token.throw_if_cancellation_requested();
+            }
+
+          private:
+            cancellation_token m_cancellation_token;
+        };
+
+        // Initialise to a number of threads equal to the number of cores
+        // on the current machine.
+        static_thread_pool();
+
+        explicit static_thread_pool(std::uint32_t thread_count);
+
+        // Waits for all queued work to be resumed before joining the workers.
+        ~static_thread_pool();
+
+        static_thread_pool(const static_thread_pool&) = delete;
+        static_thread_pool& operator=(const static_thread_pool&) = delete;
+
+        std::uint32_t thread_count() const noexcept { return m_thread_count; }
+
+        [[nodiscard]] schedule_operation schedule() noexcept {
+            return schedule_operation{ *this };
+        }
+
+        [[nodiscard]] cancellable_schedule_operation schedule(
+            cancellation_token token
+        ) noexcept {
+            return cancellable_schedule_operation{ *this, std::move(token) };
+        }
+
+      private:
+        struct thread_state;
+
+        void run_worker_thread(thread_state &state) noexcept;
+
+        void schedule_impl(schedule_operation *operation) noexcept;
+
+        schedule_operation *try_get_work(thread_state &state) noexcept;
+
+        const std::uint32_t m_thread_count;
+        std::unique_ptr< detail::worker_group< thread_state > > m_workers;
+
+        // Head of an intrusive stack of operations scheduled from threads
+        // that do not belong to the pool.
+        std::atomic< schedule_operation* > m_global_queue_head = nullptr;
+    };
+
+} // namespace gap::coro
+
+#endif
@@ -14,8 +14,11 @@
 #ifdef GAP_ENABLE_COROUTINES
 
     #include "gap/coro/coroutine.hpp"
+    #include "gap/coro/async_stack.hpp"
     #include "gap/coro/broken_promise.hpp"
     #include "gap/coro/awaitable_traits.hpp"
+    #include "gap/coro/frame_allocator.hpp"
+    #include "gap/coro/lifecycle_hooks.hpp"
 
     #include <atomic>
     #include <cassert>
@@ -31,7 +34,19 @@ namespace gap::coro
 
     namespace detail
     {
-        struct task_promise_base {
+    #if GAP_CORO_LIFECYCLE_HOOKS
+        using task_lifecycle_frame = lifecycle_frame< coroutine_kind::task >;
+    #endif
+
+        struct task_promise_base
+            : promise_allocator
+        #if GAP_CORO_ASYNC_STACKS
+            , async_frame
+        #endif
+        #if GAP_CORO_LIFECYCLE_HOOKS
+            , task_lifecycle_frame
+        #endif
+        {
           private:
             friend struct final_awaitable;
 
@@ -43,6 +58,12 @@ namespace gap::coro
                 gap::coroutine_handle<> await_suspend(
                     gap::coroutine_handle< promise_t > coroutine) noexcept
                 {
+                #if GAP_CORO_ASYNC_STACKS
+                    coroutine.promise().on_complete();
+                #endif
+                #if GAP_CORO_LIFECYCLE_HOOKS
+                    static_cast< task_lifecycle_frame& >(coroutine.promise()).on_suspend();
+                #endif
                     return coroutine.promise().m_continuation;
                 }
             #else
@@ -50,6 +71,12 @@ namespace gap::coro
                 GAP_NOINLINE
                 void await_suspend(gap::coroutine_handle< promise_t > coroutine) noexcept {
                     task_promise_base& promise = coroutine.promise();
+                #if GAP_CORO_ASYNC_STACKS
+                    promise.on_complete();
+                #endif
+                #if GAP_CORO_LIFECYCLE_HOOKS
+                    static_cast< task_lifecycle_frame& >(promise).on_suspend();
+                #endif
                     // Use 'release' memory semantics in case we finish before the
 					// awaiter can suspend so that the awaiting thread sees our
 					// writes to the resulting value.
@@ -66,9 +93,56 @@ namespace gap::coro
             };
 
           public:
+        #if GAP_CORO_ASYNC_STACKS
+            explicit task_promise_base(gap::source_location location) noexcept
+                : async_frame(location)
+            {}
+        #else
             task_promise_base() noexcept = default;
+        #endif
+
+        #if GAP_CORO_ASYNC_STACKS && GAP_CORO_LIFECYCLE_HOOKS
+            auto initial_suspend() noexcept {
+                return hooked_initial_suspend< tracked_initial_suspend, task_lifecycle_frame >{
+                    { *this }, *this
+                };
+            }
 
+            // The tracked awaiter is a temporary here, the hooked one keeps
+            // it by value.
+            template< awaitable awaitable_t >
+            auto await_transform(awaitable_t &&awaitable) {
+                using tracked_t = decltype(make_tracked_awaiter(
+                    static_cast< awaitable_t&& >(awaitable), std::declval< async_frame& >()
+                ));
+                return hooked_awaiter< tracked_t, task_lifecycle_frame >{
+                    make_tracked_awaiter(static_cast< awaitable_t&& >(awaitable), *this), *this
+                };
+            }
+        #elif GAP_CORO_ASYNC_STACKS
+            tracked_initial_suspend initial_suspend() noexcept { return { *this }; }
+
+            template< awaitable awaitable_t >
+            auto await_transform(awaitable_t &&awaitable) {
+                return make_tracked_awaiter(static_cast< awaitable_t&& >(awaitable), *this);
+            }
+        #elif GAP_CORO_LIFECYCLE_HOOKS
+            auto initial_suspend() noexcept {
+                return hooked_initial_suspend< gap::suspend_always, task_lifecycle_frame >{
+                    {}, *this
+                };
+            }
+
+            template< awaitable awaitable_t >
+            auto await_transform(awaitable_t &&awaitable) {
+                return make_hooked_awaiter(
+                    static_cast< awaitable_t&& >(awaitable), static_cast< task_lifecycle_frame& >(*this)
+                );
+            }
+        #else
             gap::suspend_always initial_suspend() const noexcept { return {}; }
+        #endif
+
             final_awaiter final_suspend() const noexcept { return {}; }
 
         #if GAP_COMPILER_SUPPORTS_SYMMETRIC_TRANSFER
@@ -96,7 +170,13 @@ namespace gap::coro
         struct task_promise final : task_promise_base {
             using result_type = std::variant< std::monostate, T, std::exception_ptr >;
 
+        #if GAP_CORO_ASYNC_STACKS
+            task_promise(gap::source_location location = gap::source_location::current()) noexcept
+                : task_promise_base(location)
+            {}
+        #else
             task_promise() noexcept = default;
+        #endif
 
             task< T > get_return_object() noexcept;
 
@@ -143,7 +223,13 @@ namespace gap::coro
 
         template<>
         struct task_promise< void > : task_promise_base {
+        #if GAP_CORO_ASYNC_STACKS
+            task_promise(gap::source_location location = gap::source_location::current()) noexcept
+                : task_promise_base(location)
+            {}
+        #else
             task_promise() noexcept = default;
+        #endif
 
             task< void > get_return_object() noexcept;
 
@@ -163,7 +249,13 @@ namespace gap::coro
 
         template< typename T >
         struct task_promise< T& > : task_promise_base {
+        #if GAP_CORO_ASYNC_STACKS
+            task_promise(gap::source_location location = gap::source_location::current()) noexcept
+                : task_promise_base(location)
+            {}
+        #else
             task_promise() noexcept = default;
+        #endif
 
             task< T& > get_return_object() noexcept;
 
@@ -208,11 +300,17 @@ namespace gap::coro
 
         #if GAP_COMPILER_SUPPORTS_SYMMETRIC_TRANSFER
             gap::coroutine_handle<> await_suspend(gap::coroutine_handle<> coroutine) noexcept {
+            #if GAP_CORO_ASYNC_STACKS
+                m_coroutine.promise().set_parent(detail::async_frame::awaiting());
+            #endif
                 m_coroutine.promise().set_continuation(coroutine);
                 return m_coroutine;
             }
         #else
             bool await_suspend(gap::coroutine_handle<> coroutine) noexcept {
+            #if GAP_CORO_ASYNC_STACKS
+                m_coroutine.promise().set_parent(detail::async_frame::awaiting());
+            #endif
                 m_coroutine.resume();
                 return m_coroutine.promise().try_set_continuation(coroutine);
             }
@@ -0,0 +1,244 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/cancellation_registration.hpp>
+    #include <gap/coro/cancellation_token.hpp>
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/scheduled_resumption.hpp>
+
+    #include <array>
+    #include <atomic>
+    #include <chrono>
+    #include <condition_variable>
+    #include <cstddef>
+    #include <cstdint>
+    #include <mutex>
+    #include <optional>
+    #include <thread>
+    #include <type_traits>
+    #include <utility>
+
+namespace gap::coro
+{
+    struct timer_service;
+
+    template< scheduler scheduler_t >
+    struct timer_schedule_operation;
+
+    namespace detail
+    {
+        // The part of a timer operation that lives in the wheel. All of the
+        // wheel bookkeeping is guarded by the mutex of the timer_service.
+        struct timer_operation_base
+        {
+            timer_operation_base(
+                timer_service &service,
+                std::chrono::steady_clock::duration delay,
+                cancellation_token token
+            ) noexcept
+                : m_service(service)
+                , m_delay(delay)
+                , m_cancellation_token(std::move(token))
+            {}
+
+            timer_operation_base(const timer_operation_base &) = delete;
+            timer_operation_base &operator=(const timer_operation_base &) = delete;
+
+          protected:
+            ~timer_operation_base() = default;
+
+            // Starts the timer, returns false if the coroutine should
+            // continue without suspending, either because the deadline has
+            // already passed or because cancellation was already requested.
+            bool start(gap::coroutine_handle<> awaiting_coroutine);
+
+            // Throws operation_cancelled if the timer was cancelled.
+            void finish() const;
+
+            virtual void resume_impl() noexcept = 0;
+
+            gap::coroutine_handle<> m_awaiting_coroutine;
+
+          private:
+            friend struct gap::coro::timer_service;
+
+            enum class state : std::uint8_t { idle, pending, fired, cancelled };
+
+            void resume() noexcept {
+                // Whichever of the timer firing (or being cancelled) and
+                // start() comes second resumes the coroutine.
+                if (m_ready_to_resume.exchange(true, std::memory_order_acq_rel)) {
+                    resume_impl();
+                }
+            }
+
+            timer_service &m_service;
+            std::chrono::steady_clock::duration m_delay;
+            cancellation_token m_cancellation_token;
+            std::optional< cancellation_registration > m_cancellation_registration;
+
+            timer_operation_base *m_prev = nullptr;
+            timer_operation_base *m_next = nullptr;
+            std::uint64_t m_deadline     = 0;
+            std::uint32_t m_slot         = 0;
+            state m_state                = state::idle;
+            std::atomic< bool > m_ready_to_resume = false;
+        };
+
+    } // namespace detail
+
+    // Resumes coroutines after a delay, 'co_await timers.schedule_after(5s)'.
+    //
+    // Timers are kept in a hierarchical timing wheel (four levels of 256
+    // slots, each slot an intrusive list) that is advanced by a dedicated
+    // thread, so starting and cancelling a timer are O(1) regardless of how
+    // many timers are pending, and a timer never allocates. The thread only
+    // wakes up for slots that hold timers and, while timers are pending
+    // further out, once per revolution of the lowest level to cascade them
+    // down.
+    //
+    // Timers fire no earlier than requested and at most one 'resolution'
+    // late, plus scheduling latency. Coroutines are resumed on the timer
+    // thread unless a scheduler is given to resume them on.
+    struct timer_service
+    {
+        using clock    = std::chrono::steady_clock;
+        using duration = clock::duration;
+
+        explicit timer_service(duration resolution = std::chrono::milliseconds(1));
+
+        // Stops the timer thread. Timers that are still pending are
+        // cancelled, their coroutines are resumed with operation_cancelled.
+        ~timer_service();
+
+        timer_service(const timer_service &) = delete;
+        timer_service &operator=(const timer_service &) = delete;
+
+        duration resolution() const noexcept { return m_resolution; }
+
+        // Number of timers currently waiting in the wheel.
+        std::size_t pending_timers() const noexcept {
+            return m_pending.load(std::memory_order_relaxed);
+        }
+
+        // Resumes the awaiting coroutine on the timer thread once 'delay'
+        // has elapsed. Throws operation_cancelled if cancellation is
+        // requested on 'token' first, which also removes the timer.
+        [[nodiscard]] timer_schedule_operation< detail::inline_scheduler >
+        schedule_after(duration delay, cancellation_token token = {}) noexcept;
+
+        // Like schedule_after(delay, token), but the coroutine is resumed
+        // through 'co_await scheduler.schedule()'.
+        template< scheduler scheduler_t >
+        [[nodiscard]] timer_schedule_operation< scheduler_t >
+        schedule_after(duration delay, scheduler_t &scheduler, cancellation_token token = {}) noexcept;
+
+      private:
+        friend struct detail::timer_operation_base;
+
+        using timer = detail::timer_operation_base;
+
+        static constexpr std::uint32_t slot_bits  = 8;
+        static constexpr std::uint32_t slot_count = 1u << slot_bits;
+        static constexpr std::uint32_t slot_mask  = slot_count - 1;
+        static constexpr std::uint32_t levels     = 4;
+
+        struct wheel_level
+        {
+            std::array< timer*, slot_count > m_slots{};
+            std::array< std::uint64_t, slot_count / 64 > m_occupied{};
+        };
+
+        void run() noexcept;
+
+        std::uint64_t now_tick() const noexcept;
+        std::uint64_t deadline_tick(duration delay) const noexcept;
+
+        // Wheel operations, called with the mutex held.
+        bool insert(timer &t);
+        bool cancel(timer &t) noexcept;
+        void place(timer &t) noexcept;
+        void unlink(timer &t) noexcept;
+        timer *take_slot(std::uint32_t slot) noexcept;
+        void advance(timer *&expired) noexcept;
+        void skip_idle_ticks() noexcept;
+        std::uint64_t next_wake_tick() const noexcept;
+
+        const duration m_resolution;
+        const clock::time_point m_start;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wake;
+        bool m_stop = false;
+
+        // The last tick that has been processed and the tick the timer
+        // thread sleeps until.
+        std::uint64_t m_current_tick = 0;
+        std::uint64_t m_wake_tick    = 0;
+
+        std::array< wheel_level, levels > m_levels{};
+        std::atomic< std::size_t > m_pending = 0;
+
+        std::thread m_thread;
+    };
+
+    template< scheduler scheduler_t >
+    struct timer_schedule_operation final : detail::timer_operation_base
+    {
+        timer_schedule_operation(
+            timer_service &service,
+            timer_service::duration delay,
+            scheduler_t &scheduler,
+            cancellation_token token
+        ) noexcept
+            : detail::timer_operation_base(service, delay, std::move(token))
+            , m_resumption(scheduler)
+        {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(gap::coroutine_handle<> awaiting_coroutine) {
+            if (start(awaiting_coroutine)) {
+                return true;
+            }
+
+            if constexpr (!std::is_same_v< scheduler_t, detail::inline_scheduler >) {
+                // Still hop onto the scheduler when the deadline had already
+                // passed.
+                m_resumption.resume(awaiting_coroutine);
+                return true;
+            } else {
+                return false;
+            }
+        }
+
+        void await_resume() {
+            m_resumption.await_resume();
+            finish();
+        }
+
+      private:
+        void resume_impl() noexcept override { m_resumption.resume(m_awaiting_coroutine); }
+
+        detail::scheduled_resumption< scheduler_t > m_resumption;
+    };
+
+    inline timer_schedule_operation< detail::inline_scheduler >
+    timer_service::schedule_after(duration delay, cancellation_token token) noexcept {
+        return { *this, delay, detail::inline_scheduler_instance, std::move(token) };
+    }
+
+    template< scheduler scheduler_t >
+    timer_schedule_operation< scheduler_t > timer_service::schedule_after(
+        duration delay, scheduler_t &scheduler, cancellation_token token
+    ) noexcept {
+        return { *this, delay, scheduler, std::move(token) };
+    }
+
+} // namespace gap::coro
+
+#endif
@@ -0,0 +1,106 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/when_all.hpp from the cppcoro
+// project. The original file is licenced under the MIT license and the original
+// license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/fmap.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <functional>
+    #include <tuple>
+    #include <type_traits>
+    #include <utility>
+    #include <vector>
+
+namespace gap::coro
+{
+    // Awaits all of the awaitables concurrently and produces a tuple of their
+    // results, with 'void' results represented by detail::void_type.
+    //
+    // If any of the awaitables failed then the exception of the first one, in
+    // argument order, is rethrown once all of them have completed.
+    template< awaitable... awaitables_t >
+    requires (sizeof...(awaitables_t) > 0)
+    [[nodiscard]] auto when_all(awaitables_t &&...awaitables) {
+        return fmap(
+            [](auto &&task_tuple) {
+                return std::apply(
+                    [](auto &&...tasks) {
+                        // Braced initialisation evaluates the results left to
+                        // right, so the first exception in argument order wins.
+                        return std::tuple< std::decay_t<
+                            decltype(static_cast< decltype(tasks) >(tasks).non_void_result())
+                        >... >{ static_cast< decltype(tasks) >(tasks).non_void_result()... };
+                    },
+                    static_cast< decltype(task_tuple) >(task_tuple)
+                );
+            },
+            when_all_ready(std::forward< awaitables_t >(awaitables)...)
+        );
+    }
+
+    // Awaits all of the awaitables concurrently.
+    //
+    // Produces a std::vector of the results in the same order as the input,
+    // lvalue-reference results are returned as std::reference_wrapper. Awaiting
+    // a vector of 'void' awaitables produces nothing. The exception of the
+    // first failed awaitable is rethrown once all of them have completed.
+    template<
+        awaitable awaitable_t,
+        typename result_t = await_result_t< std::remove_reference_t< awaitable_t > >
+    >
+    requires std::is_void_v< result_t >
+    [[nodiscard]] auto when_all_vec(std::vector< awaitable_t > awaitables) {
+        return fmap(
+            [](auto &&tasks) {
+                for (auto &task : tasks) {
+                    task.result();
+                }
+            },
+            when_all_ready_vec(std::move(awaitables))
+        );
+    }
+
+    template<
+        awaitable awaitable_t,
+        typename result_t = await_result_t< std::remove_reference_t< awaitable_t > >
+    >
+    requires (not std::is_void_v< result_t >)
+    [[nodiscard]] auto when_all_vec(std::vector< awaitable_t > awaitables) {
+        using value_t = std::conditional_t<
+            std::is_lvalue_reference_v< result_t >,
+            std::reference_wrapper< std::remove_reference_t< result_t > >,
+            std::remove_cvref_t< result_t >
+        >;
+
+        return fmap(
+            [](auto &&tasks) {
+                std::vector< value_t > results;
+                results.reserve(tasks.size());
+                for (auto &task : tasks) {
+                    if constexpr (std::is_rvalue_reference_v< decltype(tasks) >) {
+                        results.emplace_back(std::move(task).result());
+                    } else {
+                        results.emplace_back(task.result());
+                    }
+                }
+                return results;
+            },
+            when_all_ready_vec(std::move(awaitables))
+        );
+    }
+
+} // namespace gap::coro
+
+#endif
@@ -417,7 +417,7 @@ namespace gap::coro
 
             decltype(auto) non_void_result() & {
                 if constexpr (std::is_void_v< decltype(this->result()) >) {
-                    return this->result();
+                    this->result();
                     return void_type{};
                 } else {
                     return this->result();
@@ -0,0 +1,278 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/when_all_ready.hpp> // for detail::void_type
+
+    #include <atomic>
+    #include <cstddef>
+    #include <exception>
+    #include <functional>
+    #include <memory>
+    #include <optional>
+    #include <stdexcept>
+    #include <type_traits>
+    #include <utility>
+    #include <variant>
+    #include <vector>
+
+namespace gap::coro
+{
+    namespace detail
+    {
+        template< typename result_t >
+        using when_any_value_t = std::conditional_t<
+            std::is_void_v< result_t >,
+            void_type,
+            std::conditional_t<
+                std::is_lvalue_reference_v< result_t >,
+                std::reference_wrapper< std::remove_reference_t< result_t > >,
+                std::remove_cvref_t< result_t >
+            >
+        >;
+
+        // State shared by the awaiting coroutine and the tasks racing for the
+        // result. The first task to finish claims it, stores its value or
+        // exception and then resumes the awaiter, unless the awaiter has not
+        // finished starting the tasks yet, in which case it does not suspend.
+        template< typename result_t >
+        struct when_any_state
+        {
+            bool try_await(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+                m_awaiting_coroutine = awaiting_coroutine;
+                return m_parties.fetch_sub(1, std::memory_order_acq_rel) > 1;
+            }
+
+            template< typename emplace_t >
+            void try_complete(emplace_t &&emplace) noexcept {
+                if (m_claimed.exchange(true, std::memory_order_relaxed)) {
+                    return;
+                }
+
+                try {
+                    std::forward< emplace_t >(emplace)(m_result);
+                } catch (...) {
+                    m_exception = std::current_exception();
+                }
+
+                notify();
+            }
+
+            void try_complete_exceptionally(std::exception_ptr exception) noexcept {
+                if (m_claimed.exchange(true, std::memory_order_relaxed)) {
+                    return;
+                }
+
+                m_exception = std::move(exception);
+                notify();
+            }
+
+            result_t result() {
+                if (m_exception) {
+                    std::rethrow_exception(m_exception);
+                }
+
+                return std::move(*m_result);
+            }
+
+          private:
+            void notify() noexcept {
+                if (m_parties.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    m_awaiting_coroutine.resume();
+                }
+            }
+
+            std::atomic< bool > m_claimed = false;
+
+            // The winning task and the awaiter, whoever comes second resumes
+            // the awaiter (or lets it continue without suspending).
+            std::atomic< int > m_parties = 2;
+
+            gap::coroutine_handle<> m_awaiting_coroutine = nullptr;
+            std::optional< result_t > m_result;
+            std::exception_ptr m_exception;
+        };
+
+        // A coroutine that owns itself once started and destroys its frame
+        // when it runs to completion.
+        struct when_any_task
+        {
+            struct promise_type
+            {
+                when_any_task get_return_object() noexcept {
+                    return when_any_task{
+                        gap::coroutine_handle< promise_type >::from_promise(*this)
+                    };
+                }
+
+                gap::suspend_always initial_suspend() const noexcept { return {}; }
+                gap::suspend_never final_suspend() const noexcept { return {}; }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept { std::terminate(); }
+            };
+
+            explicit when_any_task(gap::coroutine_handle< promise_type > coroutine) noexcept
+                : m_coroutine(coroutine)
+            {}
+
+            when_any_task(when_any_task &&other) noexcept
+                : m_coroutine(std::exchange(other.m_coroutine, nullptr))
+            {}
+
+            when_any_task(const when_any_task&) = delete;
+            when_any_task& operator=(const when_any_task&) = delete;
+            when_any_task& operator=(when_any_task&&) = delete;
+
+            // Only destroys tasks that were never started.
+            ~when_any_task() {
+                if (m_coroutine) {
+                    m_coroutine.destroy();
+                }
+            }
+
+            void start() noexcept {
+                std::exchange(m_coroutine, nullptr).resume();
+            }
+
+          private:
+            gap::coroutine_handle< promise_type > m_coroutine;
+        };
+
+        template< typename state_t, awaitable awaitable_t, typename store_t >
+        when_any_task make_when_any_task(
+            std::shared_ptr< state_t > state, awaitable_t awaitable, store_t store
+        ) {
+            try {
+                if constexpr (std::is_void_v< await_result_t< awaitable_t&& > >) {
+                    co_await static_cast< awaitable_t&& >(awaitable);
+                    state->try_complete([&](auto &slot) { store(slot, void_type{}); });
+                } else {
+                    decltype(auto) result = co_await static_cast< awaitable_t&& >(awaitable);
+                    state->try_complete([&](auto &slot) {
+                        store(slot, static_cast< decltype(result)&& >(result));
+                    });
+                }
+            } catch (...) {
+                state->try_complete_exceptionally(std::current_exception());
+            }
+        }
+
+        template< typename result_t >
+        struct when_any_awaitable
+        {
+            using state_t = when_any_state< result_t >;
+
+            when_any_awaitable(std::shared_ptr< state_t > state, std::vector< when_any_task > tasks)
+                noexcept
+                : m_state(std::move(state))
+                , m_tasks(std::move(tasks))
+            {}
+
+            when_any_awaitable(when_any_awaitable&&) noexcept = default;
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+                // Keep the state alive even if a task finishes synchronously
+                // and resumes the awaiter, which destroys this object.
+                auto state = m_state;
+                auto tasks = std::move(m_tasks);
+                for (auto &task : tasks) {
+                    task.start();
+                }
+
+                return state->try_await(awaiting_coroutine);
+            }
+
+            result_t await_resume() { return m_state->result(); }
+
+          private:
+            std::shared_ptr< state_t > m_state;
+            std::vector< when_any_task > m_tasks;
+        };
+
+        template< std::size_t... idxs, typename... awaitables_t >
+        auto make_when_any_awaitable(std::index_sequence< idxs... >, awaitables_t &&...awaitables) {
+            using result_t = std::variant<
+                when_any_value_t< await_result_t< std::remove_cvref_t< awaitables_t >&& > >...
+            >;
+
+            auto state = std::make_shared< when_any_state< result_t > >();
+
+            std::vector< when_any_task > tasks;
+            tasks.reserve(sizeof...(awaitables_t));
+            (tasks.push_back(make_when_any_task(
+                state,
+                std::remove_cvref_t< awaitables_t >(std::forward< awaitables_t >(awaitables)),
+                [](auto &slot, auto &&value) {
+                    slot.emplace(std::in_place_index< idxs >, static_cast< decltype(value) >(value));
+                }
+             )), ...);
+
+            return when_any_awaitable< result_t >(std::move(state), std::move(tasks));
+        }
+
+    } // namespace detail
+
+    // Starts all of the awaitables concurrently and resumes the awaiting
+    // coroutine as soon as the first one of them completes.
+    //
+    // Produces a std::variant whose active alternative, index(), tells which
+    // of the awaitables won. 'void' results are represented by
+    // detail::void_type. If the first awaitable to complete failed, its
+    // exception is rethrown.
+    //
+    // The remaining awaitables are not cancelled, they keep running in the
+    // background and their results are discarded. Anything they refer to
+    // must outlive them.
+    template< awaitable... awaitables_t >
+    requires (sizeof...(awaitables_t) > 0)
+    [[nodiscard]] auto when_any(awaitables_t &&...awaitables) {
+        return detail::make_when_any_awaitable(
+            std::index_sequence_for< awaitables_t... >{},
+            std::forward< awaitables_t >(awaitables)...
+        );
+    }
+
+    // Like when_any() for a homogeneous vector of awaitables.
+    //
+    // Produces a std::pair of the index of the first awaitable to complete
+    // and its result. An empty vector has no first one to complete and
+    // throws std::invalid_argument.
+    template<
+        awaitable awaitable_t,
+        typename result_t = await_result_t< std::remove_reference_t< awaitable_t > >
+    >
+    [[nodiscard]] auto when_any_vec(std::vector< awaitable_t > awaitables) {
+        if (awaitables.empty()) {
+            throw std::invalid_argument("when_any_vec needs at least one awaitable");
+        }
+
+        using value_t = std::pair< std::size_t, detail::when_any_value_t< result_t > >;
+
+        auto state = std::make_shared< detail::when_any_state< value_t > >();
+
+        std::vector< detail::when_any_task > tasks;
+        tasks.reserve(awaitables.size());
+        for (std::size_t index = 0; index < awaitables.size(); ++index) {
+            tasks.push_back(detail::make_when_any_task(
+                state,
+                std::move(awaitables[index]),
+                [index](auto &slot, auto &&value) {
+                    slot.emplace(index, static_cast< decltype(value) >(value));
+                }
+            ));
+        }
+
+        return detail::when_any_awaitable< value_t >(std::move(state), std::move(tasks));
+    }
+
+} // namespace gap::coro
+
+#endif
@@ -0,0 +1,84 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/core/on_scope_exit.hpp>
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/cancellation_source.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/timer_service.hpp>
+    #include <gap/coro/when_any.hpp>
+
+    #include <exception>
+    #include <type_traits>
+    #include <utility>
+
+namespace gap::coro
+{
+    // Exception thrown by with_timeout() when the deadline passes before the
+    // awaitable completes.
+    struct operation_timed_out : std::exception {
+        operation_timed_out() noexcept : std::exception() {}
+
+        const char* what() const noexcept override { return "operation timed out"; }
+    };
+
+    namespace detail
+    {
+        template< typename result_t >
+        using with_timeout_result_t = std::conditional_t<
+            std::is_lvalue_reference_v< result_t >, result_t, std::remove_cvref_t< result_t >
+        >;
+
+        inline task<> timeout_after(
+            timer_service &timers, timer_service::duration timeout, cancellation_token token
+        ) {
+            co_await timers.schedule_after(timeout, std::move(token));
+        }
+
+    } // namespace detail
+
+    // Awaits 'awaitable' for at most 'timeout', producing its result or
+    // throwing operation_timed_out.
+    //
+    // Completing in time cancels the timer, so no timer stays behind in the
+    // wheel. Timing out does not cancel the awaitable: like with when_any(),
+    // it keeps running in the background and its result is discarded, so
+    // anything it refers to must outlive it. Cancellable work should observe
+    // a token that the caller cancels on operation_timed_out.
+    template< awaitable awaitable_t >
+    auto with_timeout(timer_service &timers, awaitable_t awaitable, timer_service::duration timeout)
+        -> task< detail::with_timeout_result_t< await_result_t< awaitable_t > > >
+    {
+        using result_t = await_result_t< awaitable_t >;
+
+        // Removes the timer however the awaitable completes, a no-op once
+        // the timer has fired.
+        cancellation_source timer_cancellation;
+        auto cancel_timer = on_scope_exit([&timer_cancellation] {
+            timer_cancellation.request_cancellation();
+        });
+
+        auto result = co_await when_any(
+            std::move(awaitable),
+            detail::timeout_after(timers, timeout, timer_cancellation.token())
+        );
+
+        if (result.index() == 1) {
+            throw operation_timed_out{};
+        }
+
+        if constexpr (std::is_void_v< result_t >) {
+            co_return;
+        } else if constexpr (std::is_lvalue_reference_v< result_t >) {
+            co_return std::get< 0 >(result).get();
+        } else {
+            co_return std::get< 0 >(std::move(result));
+        }
+    }
+
+} // namespace gap::coro
+
+#endif
@@ -0,0 +1,83 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/async_file.hpp>
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace gap::coro {
+
+    namespace
+    {
+        std::size_t check_result(std::int64_t result, const char *what) {
+            if (result < 0) {
+                throw std::system_error(int(-result), std::system_category(), what);
+            }
+            return std::size_t(result);
+        }
+
+    } // namespace
+
+    async_file async_file::open(const std::filesystem::path &path, file_mode mode, io_service &service) {
+        int flags = O_CLOEXEC;
+        switch (mode) {
+            case file_mode::read: flags |= O_RDONLY; break;
+            case file_mode::write: flags |= O_WRONLY | O_CREAT | O_TRUNC; break;
+            case file_mode::read_write: flags |= O_RDWR | O_CREAT; break;
+        }
+
+        int fd = ::open(path.c_str(), flags, 0666);
+        if (fd < 0) {
+            throw std::system_error(errno, std::system_category(), path.string());
+        }
+        return async_file(fd, service);
+    }
+
+    async_file::async_file(async_file &&other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1))
+        , m_service(other.m_service)
+    {}
+
+    async_file &async_file::operator=(async_file &&other) noexcept {
+        if (this != &other) {
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+            m_fd      = std::exchange(other.m_fd, -1);
+            m_service = other.m_service;
+        }
+        return *this;
+    }
+
+    async_file::~async_file() {
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+    }
+
+    task< std::size_t > async_file::read_at(std::uint64_t offset, std::span< std::byte > buffer) {
+        auto result = co_await m_service->read(m_fd, offset, buffer.data(), buffer.size());
+        co_return check_result(result, "async_file::read_at");
+    }
+
+    task< std::size_t > async_file::write_at(
+        std::uint64_t offset, std::span< const std::byte > buffer
+    ) {
+        auto result = co_await m_service->write(m_fd, offset, buffer.data(), buffer.size());
+        co_return check_result(result, "async_file::write_at");
+    }
+
+    std::uint64_t async_file::size() const {
+        struct stat info;
+        if (::fstat(m_fd, &info) < 0) {
+            throw std::system_error(errno, std::system_category(), "async_file::size");
+        }
+        return std::uint64_t(info.st_size);
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <gap/coro/async_mutex.hpp>
+
+#include <cassert>
+
+namespace gap::coro {
+
+    async_mutex::async_mutex() noexcept
+        : m_state(not_locked)
+        , m_waiters(nullptr)
+    {}
+
+    async_mutex::~async_mutex() {
+        [[maybe_unused]] auto state = m_state.load(std::memory_order_relaxed);
+        assert(state == not_locked || state == locked_no_waiters);
+        assert(m_waiters == nullptr);
+    }
+
+    bool async_mutex::try_lock() noexcept {
+        // Try to atomically transition from 'not_locked' -> 'locked_no_waiters'.
+        auto old_state = not_locked;
+        return m_state.compare_exchange_strong(
+            old_state, locked_no_waiters, std::memory_order_acquire, std::memory_order_relaxed
+        );
+    }
+
+    async_mutex_lock_operation async_mutex::lock_async() noexcept {
+        return async_mutex_lock_operation{ *this };
+    }
+
+    async_mutex_scoped_lock_operation async_mutex::scoped_lock_async() noexcept {
+        return async_mutex_scoped_lock_operation{ *this };
+    }
+
+    void async_mutex::unlock() {
+        assert(m_state.load(std::memory_order_relaxed) != not_locked);
+
+        auto *waiters_head = m_waiters;
+        if (waiters_head == nullptr) {
+            auto old_state = locked_no_waiters;
+            const bool released_lock = m_state.compare_exchange_strong(
+                old_state, not_locked, std::memory_order_release, std::memory_order_relaxed
+            );
+            if (released_lock) {
+                return;
+            }
+
+            // At least one new waiter. Acquire the list of new waiters
+            // atomically.
+            old_state = m_state.exchange(locked_no_waiters, std::memory_order_acquire);
+
+            assert(old_state != locked_no_waiters && old_state != not_locked);
+
+            // Transfer the list to m_waiters, reversing the list in the process
+            // so that the head of the list is the first to be resumed.
+            auto *next = reinterpret_cast< async_mutex_lock_operation* >(old_state);
+            do {
+                auto *temp = next->m_next;
+                next->m_next = waiters_head;
+                waiters_head = next;
+                next = temp;
+            } while (next != nullptr);
+        }
+
+        assert(waiters_head != nullptr);
+
+        m_waiters = waiters_head->m_next;
+
+        // Resume the waiter. This will pass the ownership of the lock on to
+        // that operation/coroutine.
+        waiters_head->m_awaiter.resume();
+    }
+
+    bool async_mutex_lock_operation::await_suspend(gap::coroutine_handle<> awaiter) noexcept {
+        m_awaiter = awaiter;
+
+        auto old_state = m_mutex.m_state.load(std::memory_order_acquire);
+        while (true) {
+            if (old_state == async_mutex::not_locked) {
+                if (m_mutex.m_state.compare_exchange_weak(
+                        old_state,
+                        async_mutex::locked_no_waiters,
+                        std::memory_order_acquire,
+                        std::memory_order_relaxed))
+                {
+                    // Acquired lock, don't suspend.
+                    return false;
+                }
+            } else {
+                // Try to push this operation onto the head of the waiter stack.
+                m_next = reinterpret_cast< async_mutex_lock_operation* >(old_state);
+                if (m_mutex.m_state.compare_exchange_weak(
+                        old_state,
+                        reinterpret_cast< std::uintptr_t >(this),
+                        std::memory_order_release,
+                        std::memory_order_relaxed))
+                {
+                    // Queued operation to waiters list, suspend now.
+                    return true;
+                }
+            }
+        }
+    }
+
+} // namespace gap::coro
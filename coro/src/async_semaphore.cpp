@@ -0,0 +1,141 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/async_semaphore.hpp>
+
+#include <gap/core/on_scope_exit.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace gap::coro {
+
+    namespace {
+
+        // Waiters that were handed a permit on this thread and are not
+        // resumed yet. Only the outermost release() on a thread resumes
+        // them, a release() from inside a resumed waiter queues its waiters
+        // behind instead of nesting another resumption on the stack.
+        struct ready_waiters
+        {
+            async_semaphore_acquire_operation *m_head = nullptr;
+            async_semaphore_acquire_operation *m_tail = nullptr;
+            bool m_resuming = false;
+        };
+
+        thread_local ready_waiters t_ready;
+
+    } // namespace
+
+    async_semaphore::async_semaphore(std::int64_t initial_count) noexcept
+        : m_count(initial_count)
+    {
+        assert(initial_count >= 0);
+    }
+
+    async_semaphore::~async_semaphore() {
+        assert(m_waiters_head == nullptr);
+        assert(m_count.load(std::memory_order_relaxed) >= 0);
+    }
+
+    bool async_semaphore::try_acquire() noexcept {
+        auto count = m_count.load(std::memory_order_relaxed);
+        while (count > 0) {
+            if (m_count.compare_exchange_weak(
+                    count, count - 1, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    async_semaphore_acquire_operation async_semaphore::acquire() noexcept {
+        return async_semaphore_acquire_operation{ *this };
+    }
+
+    void async_semaphore::release(std::int64_t count) {
+        assert(count >= 0);
+
+        auto old_count = m_count.fetch_add(count, std::memory_order_acq_rel);
+        if (old_count >= 0) {
+            // Nobody is waiting, the permits are simply available now.
+            return;
+        }
+
+        // Each negative unit in 'old_count' is an acquirer that needs one of
+        // our permits handed to it directly.
+        auto handoffs = std::min(count, -old_count);
+
+        auto &ready = t_ready;
+        {
+            std::lock_guard lock(m_mutex);
+            while (handoffs > 0 && m_waiters_head != nullptr) {
+                auto *waiter = m_waiters_head;
+                m_waiters_head = waiter->m_next;
+                if (m_waiters_head == nullptr) {
+                    m_waiters_tail = nullptr;
+                }
+
+                waiter->m_next = nullptr;
+                if (ready.m_tail != nullptr) {
+                    ready.m_tail->m_next = waiter;
+                } else {
+                    ready.m_head = waiter;
+                }
+                ready.m_tail = waiter;
+                --handoffs;
+            }
+
+            // The remaining acquirers decremented 'm_count' but have not
+            // reached enqueue_waiter() yet, leave a permit for each of them.
+            m_pending_handoffs += handoffs;
+        }
+
+        if (ready.m_resuming) {
+            return;
+        }
+
+        ready.m_resuming = true;
+        auto done = on_scope_exit([&ready]() noexcept { ready.m_resuming = false; });
+        while (auto *waiter = ready.m_head) {
+            ready.m_head = waiter->m_next;
+            if (ready.m_head == nullptr) {
+                ready.m_tail = nullptr;
+            }
+            waiter->m_awaiter.resume();
+        }
+    }
+
+    bool async_semaphore::enqueue_waiter(async_semaphore_acquire_operation *operation) noexcept {
+        std::lock_guard lock(m_mutex);
+        if (m_pending_handoffs > 0) {
+            --m_pending_handoffs;
+            return false;
+        }
+
+        operation->m_next = nullptr;
+        if (m_waiters_tail != nullptr) {
+            m_waiters_tail->m_next = operation;
+        } else {
+            m_waiters_head = operation;
+        }
+        m_waiters_tail = operation;
+        return true;
+    }
+
+    bool async_semaphore_acquire_operation::await_suspend(
+        gap::coroutine_handle<> awaiter
+    ) noexcept {
+        m_awaiter = awaiter;
+
+        // Claim a permit or a place in line.
+        auto old_count = m_semaphore.m_count.fetch_sub(1, std::memory_order_acq_rel);
+        if (old_count > 0) {
+            return false;
+        }
+
+        return m_semaphore.enqueue_waiter(this);
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,201 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/async_stack.hpp>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <tuple>
+#include <unordered_set>
+
+namespace gap::coro {
+
+    namespace {
+
+        using site_key = std::tuple< std::string_view, std::string_view, unsigned >;
+
+        site_key key_of(const gap::source_location &location) {
+            return { location.file(), location.function(), location.line() };
+        }
+
+        struct frame_registry
+        {
+            std::mutex m_mutex;
+            detail::async_frame *m_head = nullptr;
+
+            // Totals of the tasks that already finished, by coroutine function.
+            std::map< site_key, task_profile > m_finished;
+        };
+
+        // Never destroyed, tasks owned by static objects may outlive it
+        // otherwise.
+        frame_registry &registry() {
+            static auto *instance = new frame_registry{};
+            return *instance;
+        }
+
+        void add_to(task_profile &profile, const async_stack_frame &frame) {
+            profile.tasks        += 1;
+            profile.suspends     += frame.suspends;
+            profile.running_time += frame.running_time;
+        }
+
+        task_profile &profile_of(std::map< site_key, task_profile > &sites,
+                                 const gap::source_location &location) {
+            auto [it, inserted] = sites.try_emplace(
+                key_of(location), task_profile{ location, 0, 0, {} }
+            );
+            return it->second;
+        }
+
+        const char *to_string(task_state state) {
+            switch (state) {
+                case task_state::created:   return "created";
+                case task_state::running:   return "running";
+                case task_state::suspended: return "suspended";
+                case task_state::completed: return "completed";
+            }
+            return "unknown";
+        }
+
+        double to_us(std::chrono::nanoseconds time) {
+            return std::chrono::duration< double, std::micro >(time).count();
+        }
+
+    } // namespace
+
+    namespace detail {
+
+        async_frame::async_frame(gap::source_location location) noexcept
+            : m_location(location)
+        {
+            auto &frames = registry();
+            std::lock_guard lock(frames.m_mutex);
+            m_next = frames.m_head;
+            if (m_next) {
+                m_next->m_prev = this;
+            }
+            frames.m_head = this;
+        }
+
+        async_frame::~async_frame() {
+            auto &frames = registry();
+            std::lock_guard lock(frames.m_mutex);
+            if (m_prev) {
+                m_prev->m_next = m_next;
+            } else {
+                frames.m_head = m_next;
+            }
+            if (m_next) {
+                m_next->m_prev = m_prev;
+            }
+
+            add_to(profile_of(frames.m_finished, m_location), snapshot());
+        }
+
+        async_stack_frame async_frame::snapshot() const noexcept {
+            return {
+                m_location,
+                m_state.load(std::memory_order_relaxed),
+                m_suspends.load(std::memory_order_relaxed),
+                std::chrono::nanoseconds(m_running_ns.load(std::memory_order_relaxed))
+            };
+        }
+
+    } // namespace detail
+
+    std::vector< async_stack > capture_async_stacks() {
+        auto &frames = registry();
+        std::lock_guard lock(frames.m_mutex);
+
+        // Frames are alive for as long as they are registered, parents that
+        // are not registered any more are never followed.
+        std::unordered_set< const detail::async_frame* > live, awaited;
+        for (auto *frame = frames.m_head; frame; frame = frame->m_next) {
+            live.insert(frame);
+        }
+        for (auto *frame : live) {
+            awaited.insert(frame->m_parent.load(std::memory_order_relaxed));
+        }
+
+        std::vector< async_stack > stacks;
+        for (auto *frame = frames.m_head; frame; frame = frame->m_next) {
+            if (awaited.contains(frame)) {
+                continue;
+            }
+
+            auto &stack = stacks.emplace_back();
+            for (const detail::async_frame *link = frame;
+                 link && live.contains(link) && stack.size() < live.size();
+                 link = link->m_parent.load(std::memory_order_relaxed))
+            {
+                stack.push_back(link->snapshot());
+            }
+        }
+
+        return stacks;
+    }
+
+    void dump_async_stacks(std::ostream &os) {
+        auto stacks = capture_async_stacks();
+        os << stacks.size() << " async stacks\n";
+        for (std::size_t i = 0; i < stacks.size(); ++i) {
+            os << "async stack " << i << ":\n";
+            for (std::size_t depth = 0; depth < stacks[i].size(); ++depth) {
+                const auto &frame = stacks[i][depth];
+                os << "  #" << depth << " " << frame.location.function()
+                   << " (" << frame.location.file() << ":" << frame.location.line() << ") "
+                   << to_string(frame.state) << ", " << frame.suspends << " suspends, "
+                   << to_us(frame.running_time) << " us\n";
+            }
+        }
+    }
+
+    std::vector< task_profile > hottest_tasks(std::size_t count) {
+        std::map< site_key, task_profile > sites;
+        {
+            auto &frames = registry();
+            std::lock_guard lock(frames.m_mutex);
+            sites = frames.m_finished;
+            for (auto *frame = frames.m_head; frame; frame = frame->m_next) {
+                add_to(profile_of(sites, frame->m_location), frame->snapshot());
+            }
+        }
+
+        std::vector< task_profile > profiles;
+        profiles.reserve(sites.size());
+        for (auto &[key, profile] : sites) {
+            profiles.push_back(profile);
+        }
+
+        auto hottest = [](const task_profile &a, const task_profile &b) {
+            return a.running_time > b.running_time;
+        };
+
+        count = std::min(count, profiles.size());
+        std::partial_sort(profiles.begin(), profiles.begin() + std::ptrdiff_t(count),
+                          profiles.end(), hottest);
+        profiles.erase(profiles.begin() + std::ptrdiff_t(count), profiles.end());
+        return profiles;
+    }
+
+    void dump_hottest_tasks(std::ostream &os, std::size_t count) {
+        auto profiles = hottest_tasks(count);
+        os << "hottest tasks:\n";
+        for (const auto &profile : profiles) {
+            os << "  " << to_us(profile.running_time) << " us in " << profile.tasks
+               << " tasks, " << profile.suspends << " suspends: "
+               << profile.location.function() << " (" << profile.location.file() << ":"
+               << profile.location.line() << ")\n";
+        }
+    }
+
+    void reset_task_profiles() {
+        auto &frames = registry();
+        std::lock_guard lock(frames.m_mutex);
+        frames.m_finished.clear();
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,107 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/blocking_pool.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <thread>
+
+namespace gap::coro {
+
+    blocking_pool::blocking_pool(std::uint32_t max_threads, std::chrono::milliseconds idle_timeout)
+        : m_max_threads(std::max(max_threads, 1u))
+        , m_idle_timeout(idle_timeout)
+    {}
+
+    blocking_pool::~blocking_pool() {
+        std::unique_lock lock(m_mutex);
+        m_stop_requested = true;
+        m_work_available.notify_all();
+        m_threads_exited.wait(lock, [this] { return m_thread_count == 0; });
+    }
+
+    blocking_pool &blocking_pool::global() {
+        static blocking_pool pool;
+        return pool;
+    }
+
+    std::uint32_t blocking_pool::thread_count() const {
+        std::lock_guard lock(m_mutex);
+        return m_thread_count;
+    }
+
+    std::uint32_t blocking_pool::idle_thread_count() const {
+        std::lock_guard lock(m_mutex);
+        return m_idle_thread_count;
+    }
+
+    void blocking_pool::submit(detail::blocking_work *work) {
+        std::lock_guard lock(m_mutex);
+        assert(!m_stop_requested && "blocking_pool is being destroyed");
+
+        // Idle threads that were notified but did not wake up yet still count
+        // as idle, as do the calls they are about to take, so a new thread is
+        // needed once there are at least as many queued calls as idle threads.
+        if (m_idle_thread_count <= m_queued && m_thread_count < m_max_threads) {
+            // The threads are detached, the destructor waits for
+            // 'm_thread_count' to drop to zero instead of joining them.
+            ++m_thread_count;
+            try {
+                std::thread([this] { this->run_worker_thread(); }).detach();
+            } catch (...) {
+                // Without any thread the call would never run, otherwise it
+                // waits for one of the running threads.
+                if (--m_thread_count == 0) {
+                    throw;
+                }
+            }
+        }
+
+        if (m_tail) {
+            m_tail->m_next = work;
+        } else {
+            m_head = work;
+        }
+        m_tail = work;
+        ++m_queued;
+
+        m_work_available.notify_one();
+    }
+
+    void blocking_pool::run_worker_thread() noexcept {
+        std::unique_lock lock(m_mutex);
+        while (true) {
+            if (auto *work = m_head) {
+                m_head = work->m_next;
+                if (m_head == nullptr) {
+                    m_tail = nullptr;
+                }
+                --m_queued;
+
+                lock.unlock();
+                work->m_execute(work);
+                lock.lock();
+                continue;
+            }
+
+            if (m_stop_requested) {
+                break;
+            }
+
+            ++m_idle_thread_count;
+            bool woken = m_work_available.wait_for(lock, m_idle_timeout, [this] {
+                return m_head != nullptr || m_stop_requested;
+            });
+            --m_idle_thread_count;
+
+            if (!woken) {
+                // Idle for too long, the pool shrinks.
+                break;
+            }
+        }
+
+        --m_thread_count;
+        m_threads_exited.notify_all();
+    }
+
+} // namespace gap::coro
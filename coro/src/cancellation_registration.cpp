@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <gap/coro/cancellation_registration.hpp>
+
+#include "cancellation_state.hpp"
+
+namespace gap::coro {
+
+    cancellation_registration::~cancellation_registration() {
+        if (m_state != nullptr) {
+            if (m_slot != nullptr) {
+                m_state->deregister_callback(this);
+            }
+
+            m_state->release_token_ref();
+        }
+    }
+
+    void cancellation_registration::register_callback(cancellation_token &&token) {
+        auto *state = token.m_state;
+        if (state == nullptr || !state->can_be_cancelled()) {
+            return;
+        }
+
+        // Keep the token's reference for as long as we are registered.
+        m_state = std::exchange(token.m_state, nullptr);
+
+        try {
+            if (!m_state->try_register_callback(this)) {
+                m_callback();
+            }
+        } catch (...) {
+            // The destructor does not run if the constructor throws.
+            std::exchange(m_state, nullptr)->release_token_ref();
+            throw;
+        }
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,173 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include "cancellation_state.hpp"
+
+#include <cassert>
+#include <exception>
+
+namespace gap::coro::detail {
+
+    cancellation_state::~cancellation_state() {
+        auto *chunk = m_chunks.load(std::memory_order_relaxed);
+        while (chunk != nullptr) {
+            delete std::exchange(chunk, chunk->m_next);
+        }
+    }
+
+    void cancellation_state::add_token_ref() noexcept {
+        m_ref_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void cancellation_state::release_token_ref() noexcept {
+        if (m_ref_count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    void cancellation_state::add_source_ref() noexcept {
+        m_source_count.fetch_add(1, std::memory_order_relaxed);
+        add_token_ref();
+    }
+
+    void cancellation_state::release_source_ref() noexcept {
+        m_source_count.fetch_sub(1, std::memory_order_release);
+        release_token_ref();
+    }
+
+    bool cancellation_state::can_be_cancelled() const noexcept {
+        return m_source_count.load(std::memory_order_acquire) > 0
+            || is_cancellation_requested();
+    }
+
+    bool cancellation_state::is_cancellation_requested() const noexcept {
+        return m_cancellation_requested.load(std::memory_order_acquire);
+    }
+
+    void cancellation_state::request_cancellation() {
+        if (m_cancellation_requested.exchange(true, std::memory_order_seq_cst)) {
+            // Some other thread already requested cancellation.
+            return;
+        }
+
+        m_notifying_thread.store(std::this_thread::get_id(), std::memory_order_relaxed);
+
+        // Sequentially consistent, paired with the chunk being published in
+        // claim_slot() and the load of the request in try_register_callback().
+        // Either we see the new chunk here or the registering thread sees
+        // the request.
+        for (auto *chunk = m_chunks.load(std::memory_order_seq_cst); chunk != nullptr;
+             chunk = chunk->m_next)
+        {
+            for (std::size_t i = 0; i < chunk->m_size; ++i) {
+                auto *registration = chunk->m_slots[i].exchange(nullptr, std::memory_order_seq_cst);
+                if (registration == nullptr) {
+                    continue;
+                }
+
+                bool destroyed = false;
+                registration->m_destroyed_in_callback = &destroyed;
+                try {
+                    registration->m_callback();
+                } catch (...) {
+                    // Not to be thrown through the cancelling thread. Leave
+                    // nothing pointing at this frame and let a concurrent
+                    // deregistration finish before terminating.
+                    if (!destroyed) {
+                        registration->m_destroyed_in_callback = nullptr;
+                        registration->m_callback_completed.store(true, std::memory_order_release);
+                    }
+                    std::terminate();
+                }
+
+                if (destroyed) {
+                    continue;
+                }
+
+                registration->m_destroyed_in_callback = nullptr;
+                registration->m_callback_completed.store(true, std::memory_order_release);
+            }
+        }
+    }
+
+    bool cancellation_state::try_register_callback(cancellation_registration *registration) {
+        if (is_cancellation_requested()) {
+            return false;
+        }
+
+        auto *slot = claim_slot(registration);
+
+        // Paired with the exchange in request_cancellation(). Either we see
+        // the request here or the cancelling thread sees our slot.
+        if (m_cancellation_requested.load(std::memory_order_seq_cst)) {
+            auto expected = registration;
+            if (slot->compare_exchange_strong(
+                    expected, nullptr, std::memory_order_relaxed, std::memory_order_relaxed))
+            {
+                return false;
+            }
+
+            // The cancelling thread already took the registration and is
+            // going to run the callback.
+        }
+
+        registration->m_slot = slot;
+        return true;
+    }
+
+    void cancellation_state::deregister_callback(cancellation_registration *registration) noexcept {
+        auto expected = registration;
+        if (registration->m_slot->compare_exchange_strong(
+                expected, nullptr, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        // The callback was picked up by request_cancellation(). Wait until
+        // it has finished, unless we are being called from the callback.
+        if (m_notifying_thread.load(std::memory_order_relaxed) == std::this_thread::get_id()) {
+            if (registration->m_destroyed_in_callback) {
+                *registration->m_destroyed_in_callback = true;
+            }
+            return;
+        }
+
+        while (!registration->m_callback_completed.load(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    cancellation_state::slot_t *cancellation_state::claim_slot(
+        cancellation_registration *registration
+    ) {
+        auto *head = m_chunks.load(std::memory_order_acquire);
+        for (auto *chunk = head; chunk != nullptr; chunk = chunk->m_next) {
+            for (std::size_t i = 0; i < chunk->m_size; ++i) {
+                auto &slot = chunk->m_slots[i];
+                if (slot.load(std::memory_order_relaxed) != nullptr) {
+                    continue;
+                }
+
+                cancellation_registration *expected = nullptr;
+                if (slot.compare_exchange_strong(
+                        expected, registration, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    return &slot;
+                }
+            }
+        }
+
+        // Every slot is taken, add a chunk twice the size of the largest one
+        // and take its first slot. Chunks are only ever prepended.
+        auto size   = head ? head->m_size * 2 : initial_chunk_size;
+        auto *chunk = new registration_chunk(size);
+        chunk->m_slots[0].store(registration, std::memory_order_relaxed);
+
+        chunk->m_next = head;
+        while (!m_chunks.compare_exchange_weak(
+            chunk->m_next, chunk, std::memory_order_seq_cst, std::memory_order_acquire))
+        {}
+
+        return &chunk->m_slots[0];
+    }
+
+} // namespace gap::coro::detail
@@ -0,0 +1,83 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#include <gap/coro/cancellation_registration.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+namespace gap::coro::detail
+{
+    // Shared state of a cancellation_source and all of its tokens and
+    // registrations.
+    //
+    // Registrations live in a table of slots split into chunks that are only
+    // ever prepended, never removed, until the state is destroyed. Adding a
+    // registration claims an empty slot with a CAS and removing it clears the
+    // slot again, so registering and deregistering is lock-free. The thread
+    // requesting cancellation exchanges every slot with nullptr and runs the
+    // callbacks it finds, which arbitrates against concurrent deregistration.
+    struct cancellation_state
+    {
+        static cancellation_state *create() { return new cancellation_state(); }
+
+        ~cancellation_state();
+
+        void add_token_ref() noexcept;
+        void release_token_ref() noexcept;
+
+        void add_source_ref() noexcept;
+        void release_source_ref() noexcept;
+
+        bool can_be_cancelled() const noexcept;
+        bool is_cancellation_requested() const noexcept;
+
+        void request_cancellation();
+
+        // Returns false if cancellation was requested before the registration
+        // could be added, the caller is then responsible for running the
+        // callback itself.
+        bool try_register_callback(cancellation_registration *registration);
+
+        void deregister_callback(cancellation_registration *registration) noexcept;
+
+      private:
+        using slot_t = std::atomic< cancellation_registration* >;
+
+        struct registration_chunk
+        {
+            explicit registration_chunk(std::size_t size)
+                : m_size(size)
+                , m_slots(std::make_unique< slot_t[] >(size))
+            {}
+
+            registration_chunk *m_next = nullptr;
+            const std::size_t m_size;
+            std::unique_ptr< slot_t[] > m_slots;
+        };
+
+        static constexpr std::size_t initial_chunk_size = 16;
+
+        cancellation_state() noexcept = default;
+
+        slot_t *claim_slot(cancellation_registration *registration);
+
+        // Counts both sources and tokens, registrations hold a token
+        // reference for as long as they are alive.
+        std::atomic< std::uint32_t > m_ref_count = 1;
+        std::atomic< std::uint32_t > m_source_count = 1;
+
+        std::atomic< bool > m_cancellation_requested = false;
+
+        // Thread that is running the callbacks, so that a callback can
+        // deregister itself without waiting for its own completion.
+        std::atomic< std::thread::id > m_notifying_thread;
+
+        std::atomic< registration_chunk* > m_chunks = nullptr;
+    };
+
+} // namespace gap::coro::detail
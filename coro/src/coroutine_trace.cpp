@@ -0,0 +1,301 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/coroutine_trace.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <set>
+#include <string_view>
+#include <utility>
+
+namespace gap::coro {
+
+    namespace {
+
+        struct trace_ring
+        {
+            struct slot
+            {
+                std::atomic< std::int64_t > time;
+                std::atomic< const void* > coroutine;
+                std::atomic< std::uint32_t > thread;
+                std::atomic< coroutine_event > event;
+                std::atomic< coroutine_kind > kind;
+            };
+
+            // Only called by the thread owning the ring. The slot is claimed
+            // before it is written and published after, so that readers can
+            // tell which of the slots they copied were overwritten meanwhile.
+            void push(const trace_record &record) noexcept {
+                auto index = m_claimed.load(std::memory_order_relaxed);
+                m_claimed.store(index + 1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_release);
+
+                auto &entry = m_slots[index % trace_ring_capacity];
+                entry.time.store(record.time, std::memory_order_relaxed);
+                entry.coroutine.store(record.coroutine, std::memory_order_relaxed);
+                entry.thread.store(record.thread, std::memory_order_relaxed);
+                entry.event.store(record.event, std::memory_order_relaxed);
+                entry.kind.store(record.kind, std::memory_order_relaxed);
+
+                m_published.store(index + 1, std::memory_order_release);
+            }
+
+            // Appends the records that were published and not overwritten
+            // by the time they were copied.
+            void copy_to(std::vector< trace_record > &records) const {
+                auto published = m_published.load(std::memory_order_acquire);
+                auto first = std::max(
+                    m_cleared, published > trace_ring_capacity ? published - trace_ring_capacity : 0
+                );
+
+                auto start = records.size();
+                for (auto index = first; index < published; ++index) {
+                    const auto &entry = m_slots[index % trace_ring_capacity];
+                    records.push_back({
+                        entry.time.load(std::memory_order_relaxed),
+                        entry.coroutine.load(std::memory_order_relaxed),
+                        entry.thread.load(std::memory_order_relaxed),
+                        entry.event.load(std::memory_order_relaxed),
+                        entry.kind.load(std::memory_order_relaxed)
+                    });
+                }
+
+                std::atomic_thread_fence(std::memory_order_acquire);
+                auto claimed = m_claimed.load(std::memory_order_relaxed);
+                if (claimed > trace_ring_capacity && claimed - trace_ring_capacity > first) {
+                    auto overwritten = std::min(claimed - trace_ring_capacity, published) - first;
+                    auto begin = records.begin() + std::ptrdiff_t(start);
+                    records.erase(begin, begin + std::ptrdiff_t(overwritten));
+                }
+            }
+
+            std::atomic< std::uint64_t > m_claimed   = 0;
+            std::atomic< std::uint64_t > m_published = 0;
+            slot m_slots[trace_ring_capacity];
+
+            // Guarded by the registry mutex.
+            std::uint64_t m_cleared = 0;
+            bool m_in_use        = false;
+            trace_ring *m_next   = nullptr;
+        };
+
+        struct ring_registry
+        {
+            std::mutex m_mutex;
+            trace_ring *m_head = nullptr;
+            std::uint32_t m_threads = 0;
+        };
+
+        // Never destroyed, threads may record after static destruction.
+        ring_registry &registry() {
+            static auto *instance = new ring_registry{};
+            return *instance;
+        }
+
+        thread_local trace_ring *t_ring  = nullptr;
+        thread_local std::uint32_t t_thread = 0;
+        thread_local bool t_exited = false;
+
+        // Hands the ring of an exiting thread to the next new thread, its
+        // records stay readable until they are overwritten.
+        struct ring_releaser
+        {
+            ~ring_releaser() {
+                auto &rings = registry();
+                std::lock_guard lock(rings.m_mutex);
+                t_ring->m_in_use = false;
+                t_ring   = nullptr;
+                t_exited = true;
+            }
+        };
+
+        trace_ring *acquire_ring() noexcept {
+            if (t_exited) {
+                return nullptr;
+            }
+
+            auto &rings = registry();
+            {
+                std::lock_guard lock(rings.m_mutex);
+                t_thread = ++rings.m_threads;
+                for (auto *ring = rings.m_head; ring; ring = ring->m_next) {
+                    if (!ring->m_in_use) {
+                        ring->m_in_use = true;
+                        t_ring         = ring;
+                        break;
+                    }
+                }
+
+                if (!t_ring) {
+                    auto *ring = new (std::nothrow) trace_ring{};
+                    if (!ring) {
+                        return nullptr;
+                    }
+                    ring->m_in_use = true;
+                    ring->m_next   = std::exchange(rings.m_head, ring);
+                    t_ring         = ring;
+                }
+            }
+
+            static thread_local ring_releaser releaser;
+            return t_ring;
+        }
+
+        void record(const void *coroutine, coroutine_event event, coroutine_kind kind) noexcept {
+            auto *ring = t_ring ? t_ring : acquire_ring();
+            if (!ring) {
+                return;
+            }
+
+            auto now = std::chrono::duration_cast< std::chrono::nanoseconds >(
+                std::chrono::steady_clock::now().time_since_epoch()
+            );
+            ring->push({ now.count(), coroutine, t_thread, event, kind });
+        }
+
+        std::string_view name_of(coroutine_kind kind) {
+            switch (kind) {
+                case coroutine_kind::task: return "task";
+                case coroutine_kind::shared_task: return "shared_task";
+            }
+            return "coroutine";
+        }
+
+        // Nanoseconds as the microseconds Chrome expects.
+        void write_time(std::ostream &os, std::int64_t ns) {
+            char buffer[32];
+            auto result = std::to_chars(
+                std::begin(buffer), std::end(buffer), double(ns) / 1000.0, std::chars_format::fixed, 3
+            );
+            os.write(buffer, result.ptr - buffer);
+        }
+
+        void write_id(std::ostream &os, const void *coroutine) {
+            char buffer[2 + 2 * sizeof(std::uintptr_t)] = { '0', 'x' };
+            auto result = std::to_chars(
+                std::begin(buffer) + 2, std::end(buffer), reinterpret_cast< std::uintptr_t >(coroutine), 16
+            );
+            os << '"';
+            os.write(buffer, result.ptr - buffer);
+            os << '"';
+        }
+
+    } // namespace
+
+    void trace_hooks::on_create(const void *coroutine, coroutine_kind kind) noexcept {
+        record(coroutine, coroutine_event::create, kind);
+    }
+
+    void trace_hooks::on_resume(const void *coroutine, coroutine_kind kind) noexcept {
+        record(coroutine, coroutine_event::resume, kind);
+    }
+
+    void trace_hooks::on_suspend(const void *coroutine, coroutine_kind kind) noexcept {
+        record(coroutine, coroutine_event::suspend, kind);
+    }
+
+    void trace_hooks::on_destroy(const void *coroutine, coroutine_kind kind) noexcept {
+        record(coroutine, coroutine_event::destroy, kind);
+    }
+
+    std::vector< trace_record > collect_coroutine_trace() {
+        std::vector< trace_record > records;
+        {
+            auto &rings = registry();
+            std::lock_guard lock(rings.m_mutex);
+            for (auto *ring = rings.m_head; ring; ring = ring->m_next) {
+                ring->copy_to(records);
+            }
+        }
+
+        std::stable_sort(records.begin(), records.end(), [](const auto &a, const auto &b) {
+            return a.time < b.time;
+        });
+        return records;
+    }
+
+    void dump_chrome_trace(std::ostream &os) {
+        auto records = collect_coroutine_trace();
+        auto origin  = records.empty() ? 0 : records.front().time;
+
+        bool first = true;
+        auto begin_event = [&] {
+            os << (first ? "\n" : ",\n");
+            first = false;
+        };
+
+        os << "{\"traceEvents\":[";
+
+        std::set< std::uint32_t > threads;
+        for (const auto &record : records) {
+            threads.insert(record.thread);
+        }
+        for (auto thread : threads) {
+            begin_event();
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread
+               << ",\"args\":{\"name\":\"thread " << thread << "\"}}";
+        }
+
+        // When each coroutine running on a thread was resumed there.
+        std::map< std::pair< std::uint32_t, const void* >, std::int64_t > running;
+
+        for (const auto &record : records) {
+            auto time = record.time - origin;
+            auto name = name_of(record.kind);
+
+            switch (record.event) {
+                case coroutine_event::create:
+                case coroutine_event::destroy:
+                    begin_event();
+                    os << "{\"name\":\"" << name << "\",\"cat\":\"coroutine\",\"ph\":\""
+                       << (record.event == coroutine_event::create ? 'b' : 'e') << "\",\"id\":";
+                    write_id(os, record.coroutine);
+                    os << ",\"ts\":";
+                    write_time(os, time);
+                    os << ",\"pid\":1,\"tid\":" << record.thread << "}";
+                    break;
+                case coroutine_event::resume:
+                    running[{ record.thread, record.coroutine }] = time;
+                    break;
+                case coroutine_event::suspend: {
+                    // Slices whose resume was overwritten, or that are still
+                    // running, are left out.
+                    auto it = running.find({ record.thread, record.coroutine });
+                    if (it == running.end()) {
+                        break;
+                    }
+
+                    begin_event();
+                    os << "{\"name\":\"" << name << "\",\"cat\":\"coroutine\",\"ph\":\"X\",\"ts\":";
+                    write_time(os, it->second);
+                    os << ",\"dur\":";
+                    write_time(os, time - it->second);
+                    os << ",\"pid\":1,\"tid\":" << record.thread << ",\"args\":{\"coroutine\":";
+                    write_id(os, record.coroutine);
+                    os << "}}";
+                    running.erase(it);
+                    break;
+                }
+            }
+        }
+
+        os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    }
+
+    void clear_coroutine_trace() {
+        auto &rings = registry();
+        std::lock_guard lock(rings.m_mutex);
+        for (auto *ring = rings.m_head; ring; ring = ring->m_next) {
+            ring->m_cleared = ring->m_published.load(std::memory_order_acquire);
+        }
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,422 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/io_service.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+    #include <poll.h>
+    #include <sys/eventfd.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+
+    #define GAP_CORO_HAS_IO_URING 1
+#else
+    #define GAP_CORO_HAS_IO_URING 0
+#endif
+
+namespace gap::coro {
+
+#if GAP_CORO_HAS_IO_URING
+
+    // The rings shared with the kernel, set up with raw syscalls rather than
+    // through liburing.
+    struct io_service::ring
+    {
+        // user_data of the poll that keeps the eventfd armed.
+        static constexpr std::uint64_t wakeup_tag = 0;
+
+        static std::unique_ptr< ring > create(std::uint32_t entries) {
+            io_uring_params params{};
+            int fd = int(::syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0) {
+                // Old kernels, or io_uring disabled by policy or seccomp.
+                return nullptr;
+            }
+
+            // Plain IORING_OP_READ and IORING_OP_WRITE came with 5.6, as did
+            // this feature flag.
+            if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+                ::close(fd);
+                return nullptr;
+            }
+
+            auto result = std::make_unique< ring >();
+            result->m_fd = fd;
+            if (!result->map(params)) {
+                return nullptr;
+            }
+
+            result->m_eventfd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+            if (result->m_eventfd < 0) {
+                return nullptr;
+            }
+
+            return result;
+        }
+
+        ~ring() {
+            if (m_sqes) {
+                ::munmap(m_sqes, m_sqes_size);
+            }
+            if (m_cq_ptr && m_cq_ptr != m_sq_ptr) {
+                ::munmap(m_cq_ptr, m_cq_size);
+            }
+            if (m_sq_ptr) {
+                ::munmap(m_sq_ptr, m_sq_size);
+            }
+            if (m_fd >= 0) {
+                ::close(m_fd);
+            }
+            if (m_eventfd >= 0) {
+                ::close(m_eventfd);
+            }
+        }
+
+        bool map(const io_uring_params &params) {
+            m_sq_size = params.sq_off.array + params.sq_entries * sizeof(std::uint32_t);
+            m_cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single_mmap) {
+                m_sq_size = m_cq_size = std::max(m_sq_size, m_cq_size);
+            }
+
+            auto map_region = [&](std::size_t size, std::uint64_t offset) -> std::byte* {
+                void *ptr = ::mmap(
+                    nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_fd,
+                    static_cast< off_t >(offset)
+                );
+                return ptr == MAP_FAILED ? nullptr : static_cast< std::byte* >(ptr);
+            };
+
+            m_sq_ptr = map_region(m_sq_size, IORING_OFF_SQ_RING);
+            if (!m_sq_ptr) {
+                return false;
+            }
+
+            m_cq_ptr = single_mmap ? m_sq_ptr : map_region(m_cq_size, IORING_OFF_CQ_RING);
+            if (!m_cq_ptr) {
+                return false;
+            }
+
+            m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            m_sqes      = reinterpret_cast< io_uring_sqe* >(map_region(m_sqes_size, IORING_OFF_SQES));
+            if (!m_sqes) {
+                return false;
+            }
+
+            auto field = [](std::byte *base, std::uint32_t offset) {
+                return reinterpret_cast< std::uint32_t* >(base + offset);
+            };
+
+            m_sq_head    = field(m_sq_ptr, params.sq_off.head);
+            m_sq_tail    = field(m_sq_ptr, params.sq_off.tail);
+            m_sq_mask    = *field(m_sq_ptr, params.sq_off.ring_mask);
+            m_sq_array   = field(m_sq_ptr, params.sq_off.array);
+            m_sq_entries = params.sq_entries;
+
+            m_cq_head    = field(m_cq_ptr, params.cq_off.head);
+            m_cq_tail    = field(m_cq_ptr, params.cq_off.tail);
+            m_cq_mask    = *field(m_cq_ptr, params.cq_off.ring_mask);
+            m_cqes       = reinterpret_cast< io_uring_cqe* >(m_cq_ptr + params.cq_off.cqes);
+            m_cq_entries = params.cq_entries;
+            return true;
+        }
+
+        // Only the completion thread touches the rings, the kernel is the
+        // other side of every head and tail. Without SQPOLL the kernel reads
+        // submissions only within io_uring_enter.
+        static std::uint32_t load_acquire(std::uint32_t *ptr) noexcept {
+            return std::atomic_ref< std::uint32_t >(*ptr).load(std::memory_order_acquire);
+        }
+
+        static void store_release(std::uint32_t *ptr, std::uint32_t value) noexcept {
+            std::atomic_ref< std::uint32_t >(*ptr).store(value, std::memory_order_release);
+        }
+
+        // Entries queued in the submission ring and not consumed by the
+        // kernel yet, including those a previous io_uring_enter left over.
+        std::uint32_t unsubmitted() const noexcept { return *m_sq_tail - load_acquire(m_sq_head); }
+
+        std::uint32_t free_sqes() const noexcept { return m_sq_entries - unsubmitted(); }
+
+        io_uring_sqe &next_sqe() noexcept {
+            auto tail  = *m_sq_tail;
+            auto index = tail & m_sq_mask;
+            m_sq_array[index] = index;
+            store_release(m_sq_tail, tail + 1);
+
+            auto &sqe = m_sqes[index];
+            std::memset(&sqe, 0, sizeof(sqe));
+            return sqe;
+        }
+
+        void prepare(const operation &op) noexcept {
+            auto &sqe     = next_sqe();
+            sqe.opcode    = op.m_opcode == opcode::read ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe.fd        = op.m_fd;
+            sqe.off       = op.m_offset;
+            sqe.addr      = reinterpret_cast< std::uintptr_t >(op.m_buffer);
+            // Larger transfers come back short, as they may with pread().
+            sqe.len       = std::uint32_t(std::min< std::size_t >(op.m_length, std::size_t(1) << 30));
+            sqe.user_data = reinterpret_cast< std::uintptr_t >(&op);
+        }
+
+        // A poll rather than a read, so that the kernel never writes into
+        // memory of the ring after the completion thread is gone.
+        void arm_wakeup() noexcept {
+            auto &sqe         = next_sqe();
+            sqe.opcode        = IORING_OP_POLL_ADD;
+            sqe.fd            = m_eventfd;
+            sqe.poll32_events = POLLIN;
+            sqe.user_data     = wakeup_tag;
+        }
+
+        void drain_wakeup() noexcept {
+            std::uint64_t value = 0;
+            while (::read(m_eventfd, &value, sizeof(value)) > 0) {
+            }
+        }
+
+        int enter(std::uint32_t to_submit, std::uint32_t min_complete) noexcept {
+            auto flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0u;
+            return int(::syscall(__NR_io_uring_enter, m_fd, to_submit, min_complete, flags, nullptr, 0));
+        }
+
+        int m_fd      = -1;
+        int m_eventfd = -1;
+
+        std::byte *m_sq_ptr = nullptr;
+        std::byte *m_cq_ptr = nullptr;
+        std::size_t m_sq_size = 0;
+        std::size_t m_cq_size = 0;
+
+        io_uring_sqe *m_sqes = nullptr;
+        std::size_t m_sqes_size = 0;
+
+        std::uint32_t *m_sq_head = nullptr;
+        std::uint32_t *m_sq_tail = nullptr;
+        std::uint32_t *m_sq_array = nullptr;
+        std::uint32_t m_sq_mask = 0;
+        std::uint32_t m_sq_entries = 0;
+
+        std::uint32_t *m_cq_head = nullptr;
+        std::uint32_t *m_cq_tail = nullptr;
+        io_uring_cqe *m_cqes = nullptr;
+        std::uint32_t m_cq_mask = 0;
+        std::uint32_t m_cq_entries = 0;
+    };
+
+#else
+
+    struct io_service::ring
+    {
+        static std::unique_ptr< ring > create(std::uint32_t) { return nullptr; }
+    };
+
+#endif
+
+    io_service::io_service(io_backend backend, std::uint32_t entries, blocking_pool &blocking)
+        : m_blocking(blocking)
+    {
+        if (backend == io_backend::automatic) {
+            m_ring = ring::create(std::max(entries, 2u));
+        }
+
+        if (m_ring) {
+            m_completion_thread = std::thread([this] { this->run_completion_thread(); });
+        }
+    }
+
+    io_service::~io_service() {
+        if (m_completion_thread.joinable()) {
+            m_stop_requested.store(true, std::memory_order_relaxed);
+            wake_completion_thread();
+            m_completion_thread.join();
+        }
+
+        // Like the thread pools, a submitting thread may still be in submit()
+        // after its operation completed.
+        while (m_submitters.load(std::memory_order_acquire) != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    io_service &io_service::global() {
+        static io_service service;
+        return service;
+    }
+
+    void io_service::operation::await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+        m_awaiting_coroutine = awaiting_coroutine;
+        m_resume_on          = scheduler_ref::current();
+        m_service.submit(this);
+    }
+
+    void io_service::execute_blocking(operation &op) noexcept {
+        ssize_t result = 0;
+        auto offset    = static_cast< off_t >(op.m_offset);
+        do {
+            result = op.m_opcode == opcode::read
+                ? ::pread(op.m_fd, op.m_buffer, op.m_length, offset)
+                : ::pwrite(op.m_fd, op.m_buffer, op.m_length, offset);
+        } while (result < 0 && errno == EINTR);
+
+        op.m_result = result < 0 ? -std::int64_t(errno) : result;
+    }
+
+    void io_service::submit(operation *op) noexcept {
+        m_operations.fetch_add(1, std::memory_order_relaxed);
+
+        if (!m_ring) {
+            // The detached coroutine comes back to the submitting thread's
+            // scheduler after the call, and resumes the operation from there.
+            [](blocking_pool &blocking, operation &blocking_op) -> detail::detached_task {
+                try {
+                    co_await blocking.run([&blocking_op] { execute_blocking(blocking_op); });
+                } catch (...) {
+                    // No blocking thread could be started, make the call here.
+                    execute_blocking(blocking_op);
+                }
+                blocking_op.m_awaiting_coroutine.resume();
+            }(m_blocking, *op);
+            return;
+        }
+
+        m_submitters.fetch_add(1, std::memory_order_relaxed);
+
+        auto *head = m_queue_head.load(std::memory_order_relaxed);
+        do {
+            op->m_next = head;
+        } while (!m_queue_head.compare_exchange_weak(
+            head, op, std::memory_order_release, std::memory_order_relaxed)
+        );
+
+        // Paired with the fence in run_completion_thread(), either the
+        // completion thread sees the operation or we see it sleeping.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_sleeping.load(std::memory_order_relaxed)) {
+            wake_completion_thread();
+        }
+
+        m_submitters.fetch_sub(1, std::memory_order_release);
+    }
+
+    void io_service::wake_completion_thread() noexcept {
+#if GAP_CORO_HAS_IO_URING
+        if (m_sleeping.exchange(false, std::memory_order_acq_rel)
+            || m_stop_requested.load(std::memory_order_relaxed))
+        {
+            std::uint64_t one = 1;
+            while (::write(m_ring->m_eventfd, &one, sizeof(one)) < 0 && errno == EINTR) {
+            }
+        }
+#endif
+    }
+
+    void io_service::run_completion_thread() noexcept {
+#if GAP_CORO_HAS_IO_URING
+        auto &uring = *m_ring;
+
+        // Operations taken off the stack that did not fit into the ring yet.
+        operation *pending      = nullptr;
+        operation *pending_tail = nullptr;
+
+        // Operations in the kernel, kept below the size of the completion
+        // queue so that completions are never dropped.
+        std::uint32_t in_flight = 0;
+        bool wakeup_armed       = false;
+
+        auto take_queued = [&] {
+            auto *head = m_queue_head.exchange(nullptr, std::memory_order_acquire);
+
+            // The stack is in LIFO order, reverse it so that operations are
+            // submitted in the order they were issued.
+            operation *reversed = nullptr;
+            operation *last     = head;
+            while (head != nullptr) {
+                auto *next   = head->m_next;
+                head->m_next = reversed;
+                reversed     = head;
+                head         = next;
+            }
+
+            if (reversed == nullptr) {
+                return;
+            }
+            if (pending_tail) {
+                pending_tail->m_next = reversed;
+            } else {
+                pending = reversed;
+            }
+            pending_tail = last;
+        };
+
+        while (true) {
+            take_queued();
+
+            bool stopping = m_stop_requested.load(std::memory_order_relaxed);
+            if (stopping && in_flight == 0 && !pending) {
+                break;
+            }
+
+            if (!wakeup_armed && !stopping && uring.free_sqes() > 0) {
+                uring.arm_wakeup();
+                wakeup_armed = true;
+            }
+
+            while (pending && uring.free_sqes() > 0 && in_flight + 1 < uring.m_cq_entries) {
+                auto *op = pending;
+                pending  = op->m_next;
+                if (!pending) {
+                    pending_tail = nullptr;
+                }
+                uring.prepare(*op);
+                ++in_flight;
+            }
+
+            // Announce that we are about to wait in the kernel and look for
+            // new operations once more, see submit().
+            m_sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            bool wait = m_queue_head.load(std::memory_order_relaxed) == nullptr;
+
+            // Submits everything prepared above and waits for a completion
+            // in the same syscall.
+            m_submissions.fetch_add(1, std::memory_order_relaxed);
+            int result = uring.enter(uring.unsubmitted(), wait ? 1 : 0);
+            if (result < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+                std::terminate();
+            }
+            m_sleeping.store(false, std::memory_order_relaxed);
+
+            auto head = *uring.m_cq_head;
+            auto tail = ring::load_acquire(uring.m_cq_tail);
+            for (; head != tail; ++head) {
+                const auto &cqe = uring.m_cqes[head & uring.m_cq_mask];
+                if (cqe.user_data == ring::wakeup_tag) {
+                    uring.drain_wakeup();
+                    wakeup_armed = false;
+                    continue;
+                }
+
+                auto *op     = reinterpret_cast< operation* >(std::uintptr_t(cqe.user_data));
+                op->m_result = cqe.res;
+                --in_flight;
+
+                // The operation may be gone as soon as the coroutine resumes.
+                auto resume_on = op->m_resume_on;
+                resume_on.resume(op->m_awaiting_coroutine);
+            }
+            ring::store_release(uring.m_cq_head, head);
+        }
+#endif
+    }
+
+} // namespace gap::coro
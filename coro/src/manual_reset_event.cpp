@@ -0,0 +1,109 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/manual_reset_event.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+namespace gap::coro {
+
+    namespace {
+
+        // Bounds of the per-thread spin budget. The budget doubles whenever
+        // spinning observed the event being set and halves whenever the
+        // thread had to park, so threads that wait on quick work keep
+        // spinning while threads that wait on slow work quickly stop
+        // burning cycles.
+        constexpr std::uint32_t min_spin_count     = 8;
+        constexpr std::uint32_t initial_spin_count = 128;
+        constexpr std::uint32_t max_spin_count     = 2048;
+
+        thread_local std::uint32_t spin_count = initial_spin_count;
+
+        inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+            asm volatile("yield");
+#endif
+        }
+
+    } // namespace
+
+    manual_reset_event::manual_reset_event(bool initially_set) noexcept
+        : m_state(initially_set ? set_state : not_set_state)
+    {}
+
+    bool manual_reset_event::is_set() const noexcept {
+        return m_state.load(std::memory_order_acquire) == set_state;
+    }
+
+    void manual_reset_event::set() noexcept {
+        // The waiter may return as soon as it observes 'set_state', so that
+        // has to be the last thing set() does with the event. Parked waiters
+        // see 'notifying_state' first and keep waiting until the wake-up is
+        // done.
+        int state = m_state.load(std::memory_order_relaxed);
+        int next  = set_state;
+        do {
+            if (state == set_state || state == notifying_state) {
+                return;
+            }
+            next = state == not_set_waiting ? notifying_state : set_state;
+        } while (!m_state.compare_exchange_weak(
+            state, next, std::memory_order_release, std::memory_order_relaxed)
+        );
+
+        if (next == notifying_state) {
+            m_state.notify_all();
+            m_state.store(set_state, std::memory_order_release);
+        }
+    }
+
+    void manual_reset_event::reset() noexcept {
+        int old_state = set_state;
+        m_state.compare_exchange_strong(old_state, not_set_state, std::memory_order_relaxed);
+    }
+
+    void manual_reset_event::wait() noexcept {
+        if (is_set()) {
+            return;
+        }
+
+        const auto budget = spin_count;
+        for (std::uint32_t i = 0; i < budget; ++i) {
+            cpu_relax();
+            if (is_set()) {
+                spin_count = std::min(budget * 2, max_spin_count);
+                return;
+            }
+        }
+
+        spin_count = std::max(budget / 2, min_spin_count);
+
+        int state = m_state.load(std::memory_order_acquire);
+        while (state != set_state) {
+            // set() is waking the parked waiters, which takes no longer
+            // than a syscall.
+            if (state == notifying_state) {
+                std::this_thread::yield();
+                state = m_state.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // Announce the parked waiter so that set() knows to notify it.
+            if (state == not_set_state
+                && !m_state.compare_exchange_weak(
+                    state, not_set_waiting,
+                    std::memory_order_acquire, std::memory_order_acquire))
+            {
+                continue;
+            }
+
+            m_state.wait(not_set_waiting, std::memory_order_acquire);
+            state = m_state.load(std::memory_order_acquire);
+        }
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,356 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/numa.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <climits>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace gap::coro {
+
+    namespace
+    {
+        // From <numaif.h>, which comes with libnuma rather than libc.
+        constexpr int mpol_preferred = 1;
+
+        constexpr std::size_t page_alignment = 4096;
+
+        std::size_t page_size() noexcept {
+#if defined(__linux__)
+            static const auto size = static_cast< std::size_t >(::sysconf(_SC_PAGESIZE));
+            return size;
+#else
+            return page_alignment;
+#endif
+        }
+
+        std::size_t round_up(std::size_t size, std::size_t alignment) noexcept {
+            return (size + alignment - 1) / alignment * alignment;
+        }
+
+        std::size_t size_class(std::size_t size) noexcept {
+            return std::bit_width(
+                (std::max(size, numa_frame_pool::min_block_size) - 1) / numa_frame_pool::min_block_size
+            );
+        }
+
+        constexpr std::size_t class_size(std::size_t index) noexcept {
+            return numa_frame_pool::min_block_size << index;
+        }
+
+        // Tells pools apart in the thread-local cache lookup.
+        std::atomic< std::uint64_t > next_pool_id = 1;
+
+        bool parse_number(std::string_view text, std::uint32_t &value) {
+            auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+            return error == std::errc{} && end == text.data() + text.size();
+        }
+
+    } // namespace
+
+    std::vector< std::uint32_t > numa_topology::parse_cpulist(std::string_view list) {
+        std::vector< std::uint32_t > cpus;
+        while (!list.empty()) {
+            auto comma = list.find(',');
+            auto range = list.substr(0, comma);
+            list       = comma == std::string_view::npos ? std::string_view{} : list.substr(comma + 1);
+
+            while (!range.empty() && (range.back() == '\n' || range.back() == ' ')) {
+                range.remove_suffix(1);
+            }
+            if (range.empty()) {
+                continue;
+            }
+
+            std::uint32_t first = 0, last = 0;
+            auto dash = range.find('-');
+            if (dash == std::string_view::npos) {
+                if (!parse_number(range, first)) {
+                    return {};
+                }
+                last = first;
+            } else if (!parse_number(range.substr(0, dash), first)
+                       || !parse_number(range.substr(dash + 1), last) || last < first)
+            {
+                return {};
+            }
+
+            for (auto cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+
+        std::sort(cpus.begin(), cpus.end());
+        cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+        return cpus;
+    }
+
+    numa_topology numa_topology::from_sysfs(const std::filesystem::path &root) {
+        numa_topology topology;
+
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator(root, error)) {
+            auto name = entry.path().filename().string();
+            std::uint32_t id = 0;
+            if (!name.starts_with("node") || !parse_number(std::string_view(name).substr(4), id)) {
+                continue;
+            }
+
+            std::ifstream file(entry.path() / "cpulist");
+            std::string list;
+            std::getline(file, list);
+
+            auto cpus = parse_cpulist(list);
+            if (!cpus.empty()) {
+                topology.nodes.push_back({ id, std::move(cpus) });
+            }
+        }
+
+        std::sort(topology.nodes.begin(), topology.nodes.end(), [](const auto &a, const auto &b) {
+            return a.id < b.id;
+        });
+        return topology;
+    }
+
+    numa_topology numa_topology::detect() {
+        auto topology = from_sysfs("/sys/devices/system/node");
+        if (topology.nodes.empty()) {
+            topology = uniform(1, std::max(std::thread::hardware_concurrency(), 1u));
+        }
+        return topology;
+    }
+
+    numa_topology numa_topology::uniform(std::uint32_t count, std::uint32_t cpus_per_node) {
+        numa_topology topology;
+        for (std::uint32_t id = 0; id < count; ++id) {
+            numa_node node{ id, {} };
+            for (std::uint32_t cpu = 0; cpu < cpus_per_node; ++cpu) {
+                node.cpus.push_back(id * cpus_per_node + cpu);
+            }
+            topology.nodes.push_back(std::move(node));
+        }
+        return topology;
+    }
+
+    std::size_t numa_topology::cpu_count() const noexcept {
+        std::size_t count = 0;
+        for (const auto &node : nodes) {
+            count += node.cpus.size();
+        }
+        return count;
+    }
+
+    void *allocate_on_node(std::size_t bytes, std::uint32_t node_id) {
+#if defined(__linux__)
+        auto size = round_up(std::max< std::size_t >(bytes, 1), page_size());
+        void *ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+
+    #if defined(SYS_mbind)
+        constexpr std::size_t bits = sizeof(unsigned long) * CHAR_BIT;
+        std::vector< unsigned long > mask(node_id / bits + 1);
+        mask[node_id / bits] |= 1ul << (node_id % bits);
+
+        // Kernels without NUMA support, or sandboxes, may refuse. The memory
+        // is as usable as any other then.
+        (void) ::syscall(SYS_mbind, ptr, size, mpol_preferred, mask.data(), mask.size() * bits + 1, 0u);
+    #endif
+
+        return ptr;
+#else
+        (void) node_id;
+        return ::operator new(bytes, std::align_val_t(page_alignment));
+#endif
+    }
+
+    void deallocate_on_node(void *ptr, std::size_t bytes) noexcept {
+#if defined(__linux__)
+        ::munmap(ptr, round_up(std::max< std::size_t >(bytes, 1), page_size()));
+#else
+        ::operator delete(ptr, bytes, std::align_val_t(page_alignment));
+#endif
+    }
+
+    thread_local numa_frame_pool::cache_ref numa_frame_pool::t_cache;
+
+    numa_frame_pool::numa_frame_pool(std::uint32_t node_id) noexcept
+        : m_node_id(node_id)
+        , m_id(next_pool_id.fetch_add(1, std::memory_order_relaxed))
+    {}
+
+    numa_frame_pool::~numa_frame_pool() {
+        for (auto *chunk : m_chunks) {
+            deallocate_on_node(chunk, chunk_size);
+        }
+    }
+
+    void *numa_frame_pool::allocate(std::size_t bytes) {
+        if (bytes > max_pooled_size) {
+            return allocate_on_node(bytes, m_node_id);
+        }
+
+        auto index  = size_class(bytes);
+        auto *cache = local_cache();
+        if (cache) {
+            if (auto *block = cache->m_free[index]) {
+                cache->m_free[index] = block->m_next;
+                --cache->m_count[index];
+                return block;
+            }
+        }
+
+        return refill(cache, index);
+    }
+
+    void numa_frame_pool::deallocate(void *ptr, std::size_t bytes) noexcept {
+        if (bytes > max_pooled_size) {
+            deallocate_on_node(ptr, bytes);
+            return;
+        }
+
+        auto index  = size_class(bytes);
+        auto *cache = local_cache();
+        if (cache && cache->m_count[index] < max_cached_per_class) {
+            cache->m_free[index] = ::new (ptr) free_block{ cache->m_free[index] };
+            ++cache->m_count[index];
+            return;
+        }
+
+        spill(cache, index, ::new (ptr) free_block{ nullptr });
+    }
+
+    numa_frame_pool::thread_cache *numa_frame_pool::local_cache() noexcept {
+        if (t_cache.m_pool_id == m_id) {
+            return t_cache.m_cache;
+        }
+
+        auto thread = std::this_thread::get_id();
+        std::lock_guard lock(m_mutex);
+        auto it = std::find_if(m_caches.begin(), m_caches.end(), [&](const auto &cache) {
+            return cache->m_thread == thread;
+        });
+
+        if (it == m_caches.end()) {
+            try {
+                auto cache      = std::make_unique< thread_cache >();
+                cache->m_thread = thread;
+                m_caches.push_back(std::move(cache));
+            } catch (...) {
+                return nullptr;
+            }
+            it = std::prev(m_caches.end());
+        }
+
+        t_cache = { m_id, it->get() };
+        return t_cache.m_cache;
+    }
+
+    void *numa_frame_pool::refill(thread_cache *cache, std::size_t index) {
+        std::lock_guard lock(m_mutex);
+        if (auto *block = m_free[index]) {
+            m_free[index] = block->m_next;
+
+            // Take a batch along, so that the next allocations need no lock.
+            for (std::size_t i = 1; cache && i < batch_size && m_free[index]; ++i) {
+                auto *next           = m_free[index];
+                m_free[index]        = next->m_next;
+                next->m_next         = cache->m_free[index];
+                cache->m_free[index] = next;
+                ++cache->m_count[index];
+            }
+            return block;
+        }
+
+        // The tail of the previous chunk is left unused.
+        auto size = class_size(index);
+        if (std::size_t(m_chunk_end - m_chunk_next) < size) {
+            auto *chunk = static_cast< std::byte* >(allocate_on_node(chunk_size, m_node_id));
+            try {
+                m_chunks.push_back(chunk);
+            } catch (...) {
+                deallocate_on_node(chunk, chunk_size);
+                throw;
+            }
+            m_chunk_next = chunk;
+            m_chunk_end  = chunk + chunk_size;
+        }
+
+        return std::exchange(m_chunk_next, m_chunk_next + size);
+    }
+
+    void numa_frame_pool::spill(thread_cache *cache, std::size_t index, free_block *block) noexcept {
+        // The thread's list is full, hand a batch of it over together with
+        // the block.
+        auto *last = block;
+        for (std::size_t i = 1; cache && i < batch_size && cache->m_free[index]; ++i) {
+            auto *next           = cache->m_free[index];
+            cache->m_free[index] = next->m_next;
+            --cache->m_count[index];
+            last->m_next = next;
+            last         = next;
+        }
+
+        std::lock_guard lock(m_mutex);
+        last->m_next  = m_free[index];
+        m_free[index] = block;
+    }
+
+    std::size_t numa_frame_pool::reserved() const {
+        std::lock_guard lock(m_mutex);
+        return m_chunks.size() * chunk_size;
+    }
+
+    void *numa_arena::do_allocate(std::size_t bytes, std::size_t alignment) {
+        std::lock_guard lock(m_mutex);
+
+        auto aligned = [&] {
+            auto address = reinterpret_cast< std::uintptr_t >(m_next);
+            return reinterpret_cast< std::byte* >(round_up(address, alignment));
+        };
+
+        if (!m_next || aligned() + bytes > m_end) {
+            auto size   = std::max(m_chunk_size, round_up(bytes + alignment, page_size()));
+            auto *data  = static_cast< std::byte* >(allocate_on_node(size, m_node_id));
+            try {
+                m_chunks.push_back({ data, size });
+            } catch (...) {
+                deallocate_on_node(data, size);
+                throw;
+            }
+            m_next = data;
+            m_end  = data + size;
+        }
+
+        auto *ptr = aligned();
+        m_next    = ptr + bytes;
+        return ptr;
+    }
+
+    void numa_arena::release() noexcept {
+        std::lock_guard lock(m_mutex);
+        for (auto &allocation : m_chunks) {
+            deallocate_on_node(allocation.m_data, allocation.m_size);
+        }
+        m_chunks.clear();
+        m_next = nullptr;
+        m_end  = nullptr;
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,204 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/numa_thread_pool.hpp>
+#include <gap/coro/scheduler_ref.hpp>
+
+#include "worker_group.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__linux__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+namespace gap::coro {
+
+    namespace
+    {
+        // Best effort, the worker runs wherever the system puts it if the
+        // CPUs are not available to the process.
+        void pin_current_thread(const std::vector< std::uint32_t > &cpus) noexcept {
+#if defined(__linux__)
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (auto cpu : cpus) {
+                if (cpu < CPU_SETSIZE) {
+                    CPU_SET(cpu, &set);
+                }
+            }
+            (void) ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+#else
+            (void) cpus;
+#endif
+        }
+
+    } // namespace
+
+    struct numa_thread_pool::thread_state : detail::worker_state
+    {
+        detail::work_stealing_deque< schedule_operation* > m_local_queue;
+        std::uint32_t m_node = 0;
+    };
+
+    numa_thread_pool::numa_thread_pool()
+        : numa_thread_pool(numa_topology::detect())
+    {}
+
+    numa_thread_pool::numa_thread_pool(numa_topology topology, numa_pool_options options)
+        : m_topology(std::move(topology))
+        , m_options(options)
+    {
+        if (m_topology.nodes.empty()) {
+            m_topology = numa_topology::uniform(1, 1);
+        }
+
+        // Workers of a node are kept next to each other, so that stealing
+        // within a node walks a contiguous range of thread states.
+        for (const auto &node : m_topology.nodes) {
+            auto threads = m_options.threads_per_node;
+            if (threads == 0) {
+                threads = std::uint32_t(node.cpus.size());
+            }
+
+            auto index  = std::uint32_t(m_nodes.size());
+            auto &state = m_nodes.emplace_back(std::make_unique< node_state >(*this, index, node.id));
+            state->m_first_thread = m_thread_count;
+            state->m_thread_count = std::max(threads, 1u);
+            m_thread_count += state->m_thread_count;
+        }
+
+        m_workers = std::make_unique< detail::worker_group< thread_state > >(m_thread_count);
+        for (std::uint32_t node = 0; node < node_count(); ++node) {
+            const auto &state = *m_nodes[node];
+            for (std::uint32_t i = 0; i < state.m_thread_count; ++i) {
+                m_workers->state(state.m_first_thread + i).m_node = node;
+            }
+        }
+
+        m_workers->start([this](thread_state &state) { this->run_worker_thread(state); });
+    }
+
+    numa_thread_pool::~numa_thread_pool() { m_workers->shutdown(); }
+
+    void numa_thread_pool::schedule_operation::await_suspend(
+        gap::coroutine_handle<> awaiting_coroutine
+    ) noexcept {
+        m_awaiting_coroutine = awaiting_coroutine;
+        m_pool.schedule_impl(this);
+    }
+
+    numa_thread_pool::schedule_operation numa_thread_pool::schedule() noexcept {
+        if (auto node = current_node()) {
+            return schedule_operation{ *this, *node };
+        }
+        auto node = m_next_node.fetch_add(1, std::memory_order_relaxed) % node_count();
+        return schedule_operation{ *this, node };
+    }
+
+    std::optional< std::uint32_t > numa_thread_pool::current_node() const noexcept {
+        if (auto *state = m_workers->current()) {
+            return state->m_node;
+        }
+        return std::nullopt;
+    }
+
+    numa_frame_allocator< std::byte > numa_thread_pool::frame_allocator(std::uint32_t node) noexcept {
+        assert(node < node_count());
+        return numa_frame_allocator< std::byte >{ m_nodes[node]->m_frames };
+    }
+
+    numa_arena &numa_thread_pool::arena(std::uint32_t node) noexcept {
+        assert(node < node_count());
+        return m_nodes[node]->m_arena;
+    }
+
+    void numa_thread_pool::run_worker_thread(thread_state &state) noexcept {
+        // Coroutines sent back to the pool return to this worker's node.
+        scheduler_ref::set_current(scheduler_ref(m_nodes[state.m_node]->m_scheduler));
+
+        if (m_options.pin_threads) {
+            pin_current_thread(m_topology.nodes[state.m_node].cpus);
+        }
+
+        m_workers->run_worker(
+            state,
+            [this](thread_state &self) { return try_get_work(self); },
+            [](schedule_operation *operation) { operation->m_awaiting_coroutine.resume(); }
+        );
+
+        scheduler_ref::set_current({});
+    }
+
+    void numa_thread_pool::schedule_impl(schedule_operation *operation) noexcept {
+        auto node = operation->m_node;
+        assert(node < node_count());
+
+        // Only workers of the node use their own deque, work sent to another
+        // node goes through the injection queue of that node.
+        m_workers->schedule(
+            [&](thread_state *state) {
+                if (state == nullptr || state->m_node != node
+                    || !state->m_local_queue.push(operation))
+                {
+                    m_workers->inject(m_nodes[node]->m_global_queue_head, operation);
+                }
+            },
+            [this, node] { wake_one_thread(node); }
+        );
+    }
+
+    numa_thread_pool::schedule_operation *numa_thread_pool::try_get_work(
+        thread_state &state
+    ) noexcept {
+        if (auto *operation = state.m_local_queue.pop()) {
+            return operation;
+        }
+
+        auto &node = *m_nodes[state.m_node];
+        auto *operation = m_workers->take_injected(
+            node.m_global_queue_head, state.m_local_queue,
+            [this, &state] { wake_one_thread(state.m_node); }
+        );
+        if (operation != nullptr) {
+            return operation;
+        }
+
+        if (auto *stolen = try_steal(state, node.m_first_thread, node.m_thread_count)) {
+            return stolen;
+        }
+
+        // Injection queues of other nodes are left alone, work sent to a node
+        // only leaves it once a worker of the node has taken it over.
+        if (m_options.steal_across_nodes && node_count() > 1) {
+            if (auto *stolen = try_steal(state, 0, m_thread_count)) {
+                return stolen;
+            }
+        }
+
+        return nullptr;
+    }
+
+    numa_thread_pool::schedule_operation *numa_thread_pool::try_steal(
+        thread_state &state, std::uint32_t first, std::uint32_t count
+    ) noexcept {
+        return m_workers->steal(
+            state, first, count,
+            [](thread_state &victim) -> auto & { return victim.m_local_queue; },
+            [this](thread_state &victim) { wake_one_thread(victim.m_node); }
+        );
+    }
+
+    void numa_thread_pool::wake_one_thread(std::uint32_t node) noexcept {
+        const auto &state = *m_nodes[node];
+        if (m_workers->wake_one(state.m_first_thread, state.m_thread_count)) {
+            return;
+        }
+
+        if (m_options.steal_across_nodes) {
+            m_workers->wake_one();
+        }
+    }
+
+} // namespace gap::coro
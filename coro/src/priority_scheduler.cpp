@@ -0,0 +1,152 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/priority_scheduler.hpp>
+#include <gap/coro/scheduler_ref.hpp>
+
+#include "worker_group.hpp"
+
+#include <algorithm>
+
+namespace gap::coro {
+
+    struct priority_scheduler::thread_state : detail::worker_state
+    {
+        std::array< detail::work_stealing_deque< schedule_operation* >, priority_levels >
+            m_local_queues;
+
+        // Of the coroutine being resumed, for yield().
+        priority m_priority = priority::normal;
+    };
+
+    priority_scheduler::priority_scheduler()
+        : priority_scheduler(std::thread::hardware_concurrency())
+    {}
+
+    priority_scheduler::priority_scheduler(std::uint32_t thread_count)
+        : m_thread_count(std::max(thread_count, 1u))
+        , m_workers(std::make_unique< detail::worker_group< thread_state > >(m_thread_count))
+    {
+        for (std::size_t level = 0; level < priority_levels; ++level) {
+            m_levels[level].m_scheduler = { this, priority(level) };
+        }
+
+        m_workers->start([this](thread_state &state) { this->run_worker_thread(state); });
+    }
+
+    priority_scheduler::~priority_scheduler() { m_workers->shutdown(); }
+
+    void priority_scheduler::schedule_operation::await_suspend(
+        gap::coroutine_handle<> awaiting_coroutine
+    ) noexcept {
+        m_awaiting_coroutine = awaiting_coroutine;
+        m_scheduler.schedule_impl(this);
+    }
+
+    bool priority_scheduler::yield_operation::await_ready() const noexcept {
+        return m_scheduler.m_workers->current() != nullptr
+            && !m_scheduler.has_work_up_to(m_priority);
+    }
+
+    void priority_scheduler::yield_operation::await_suspend(
+        gap::coroutine_handle<> awaiting_coroutine
+    ) noexcept {
+        // The injection queue rather than the worker's own deque, which the
+        // worker pops from the newest end and would hand the coroutine
+        // straight back ahead of the work it yielded to.
+        auto &scheduler      = m_scheduler;
+        auto &level          = scheduler.m_levels[std::size_t(m_priority)];
+        m_awaiting_coroutine = awaiting_coroutine;
+
+        auto &workers = *scheduler.m_workers;
+        workers.schedule(
+            [&](thread_state *) {
+                level.m_queued.fetch_add(1, std::memory_order_relaxed);
+                workers.inject(level.m_global_queue_head, static_cast< schedule_operation* >(this));
+            },
+            [&] { workers.wake_one(); }
+        );
+    }
+
+    priority_scheduler::yield_operation priority_scheduler::yield() noexcept {
+        if (auto *state = m_workers->current()) {
+            return yield_operation{ *this, state->m_priority };
+        }
+        return yield_operation{ *this, priority::normal };
+    }
+
+    void priority_scheduler::run_worker_thread(thread_state &state) noexcept {
+        m_workers->run_worker(
+            state,
+            [this](thread_state &self) { return try_get_work(self); },
+            [this, &state](schedule_operation *operation) {
+                auto &level = m_levels[std::size_t(operation->m_priority)];
+                level.m_queued.fetch_sub(1, std::memory_order_relaxed);
+
+                // Coroutines sent back to the scheduler return at the priority
+                // they were running with.
+                state.m_priority = operation->m_priority;
+                scheduler_ref::set_current(scheduler_ref(level.m_scheduler));
+                operation->m_awaiting_coroutine.resume();
+            }
+        );
+
+        scheduler_ref::set_current({});
+    }
+
+    void priority_scheduler::schedule_impl(schedule_operation *operation) noexcept {
+        auto &level = m_levels[std::size_t(operation->m_priority)];
+        m_workers->schedule(
+            [&](thread_state *state) {
+                level.m_queued.fetch_add(1, std::memory_order_relaxed);
+
+                auto index = std::size_t(operation->m_priority);
+                if (state == nullptr || !state->m_local_queues[index].push(operation)) {
+                    m_workers->inject(level.m_global_queue_head, operation);
+                }
+            },
+            [this] { m_workers->wake_one(); }
+        );
+    }
+
+    bool priority_scheduler::has_work_up_to(priority level) const noexcept {
+        for (std::size_t i = 0; i <= std::size_t(level); ++i) {
+            if (m_levels[i].m_queued.load(std::memory_order_relaxed) > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    priority_scheduler::schedule_operation *priority_scheduler::try_get_work(
+        thread_state &state
+    ) noexcept {
+        auto wake_any = [this] { m_workers->wake_one(); };
+
+        // Every source of a level is exhausted before looking at the next
+        // one, so that a worker never picks low priority work from its own
+        // deque while high priority work waits elsewhere.
+        for (std::size_t level = 0; level < priority_levels; ++level) {
+            auto &local = state.m_local_queues[level];
+            if (auto *operation = local.pop()) {
+                return operation;
+            }
+
+            auto &head = m_levels[level].m_global_queue_head;
+            if (auto *operation = m_workers->take_injected(head, local, wake_any)) {
+                return operation;
+            }
+
+            auto *operation = m_workers->steal(
+                state, 0, m_thread_count,
+                [level](thread_state &victim) -> auto & { return victim.m_local_queues[level]; },
+                [&](thread_state &) { wake_any(); }
+            );
+            if (operation != nullptr) {
+                return operation;
+            }
+        }
+
+        return nullptr;
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,249 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/process.hpp>
+#include <gap/coro/blocking_pool.hpp>
+
+#include <cerrno>
+#include <csignal>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <tuple>
+#include <utility>
+
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+namespace gap::coro {
+
+    namespace
+    {
+        [[noreturn]] void throw_errno(int error, const std::string &what) {
+            throw std::system_error(error, std::system_category(), what);
+        }
+
+        // The child's ends of its pipes, closed in the parent once it has
+        // been spawned.
+        struct child_fds
+        {
+            ~child_fds() {
+                for (int fd : { stdin_fd, stdout_fd }) {
+                    if (fd >= 0) {
+                        ::close(fd);
+                    }
+                }
+            }
+
+            int stdin_fd  = -1;
+            int stdout_fd = -1;
+        };
+
+        // Returns the parent's end of a new pipe, as an async_pipe, and the
+        // child's end.
+        std::pair< async_pipe, int > make_pipe(bool parent_reads, reactor &r) {
+            int fds[2];
+            if (::pipe2(fds, O_CLOEXEC) < 0) {
+                throw_errno(errno, "pipe2");
+            }
+
+            auto [parent, child] = parent_reads ? std::pair(fds[0], fds[1]) : std::pair(fds[1], fds[0]);
+            try {
+                return { async_pipe(parent, r), child };
+            } catch (...) {
+                ::close(child);
+                throw;
+            }
+        }
+
+        // A descriptor that becomes readable once the process exits, or -1
+        // if the kernel predates pidfd_open().
+        int open_pidfd([[maybe_unused]] pid_t pid) noexcept {
+    #ifdef SYS_pidfd_open
+            return int(::syscall(SYS_pidfd_open, pid, 0));
+    #else
+            return -1;
+    #endif
+        }
+
+        int reap(pid_t pid) {
+            int status = 0;
+            while (::waitpid(pid, &status, 0) < 0) {
+                if (errno != EINTR) {
+                    throw_errno(errno, "waitpid");
+                }
+            }
+            return status;
+        }
+
+        int exit_code(int status) noexcept {
+            if (WIFSIGNALED(status)) {
+                return 128 + WTERMSIG(status);
+            }
+            return WEXITSTATUS(status);
+        }
+
+        struct file_actions
+        {
+            file_actions() { posix_spawn_file_actions_init(&m_actions); }
+            ~file_actions() { posix_spawn_file_actions_destroy(&m_actions); }
+
+            file_actions(const file_actions &) = delete;
+            file_actions &operator=(const file_actions &) = delete;
+
+            posix_spawn_file_actions_t m_actions;
+        };
+
+    } // namespace
+
+    child_process child_process::spawn(
+        const std::vector< std::string > &argv, process_options options, reactor &r
+    ) {
+        if (argv.empty()) {
+            throw std::invalid_argument("child_process::spawn: empty argv");
+        }
+
+        child_fds child;
+        async_pipe stdin_pipe;
+        if (options.pipe_stdin) {
+            std::tie(stdin_pipe, child.stdin_fd) = make_pipe(false, r);
+        }
+
+        async_pipe stdout_pipe;
+        std::tie(stdout_pipe, child.stdout_fd) = make_pipe(true, r);
+
+        file_actions actions;
+        if (child.stdin_fd >= 0) {
+            posix_spawn_file_actions_adddup2(&actions.m_actions, child.stdin_fd, STDIN_FILENO);
+        } else {
+            posix_spawn_file_actions_addopen(
+                &actions.m_actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0
+            );
+        }
+
+        posix_spawn_file_actions_adddup2(&actions.m_actions, child.stdout_fd, STDOUT_FILENO);
+        if (options.merge_stderr) {
+            posix_spawn_file_actions_adddup2(&actions.m_actions, child.stdout_fd, STDERR_FILENO);
+        }
+
+        std::vector< char* > args;
+        args.reserve(argv.size() + 1);
+        for (const auto &arg : argv) {
+            args.push_back(const_cast< char* >(arg.c_str()));
+        }
+        args.push_back(nullptr);
+
+        pid_t pid = 0;
+        int error = ::posix_spawnp(
+            &pid, argv.front().c_str(), &actions.m_actions, nullptr, args.data(), environ
+        );
+        if (error != 0) {
+            throw_errno(error, argv.front());
+        }
+
+        return child_process(pid, open_pidfd(pid), std::move(stdin_pipe), std::move(stdout_pipe), r);
+    }
+
+    child_process::child_process(
+        int pid, int pidfd, async_pipe in, async_pipe out, reactor &r
+    ) noexcept
+        : m_pid(pid)
+        , m_pidfd(pidfd)
+        , m_stdin(std::move(in))
+        , m_stdout(std::move(out))
+        , m_reactor(&r)
+    {}
+
+    child_process::child_process(child_process &&other) noexcept
+        : m_pid(std::exchange(other.m_pid, -1))
+        , m_pidfd(std::exchange(other.m_pidfd, -1))
+        , m_exit_code(other.m_exit_code)
+        , m_stdin(std::move(other.m_stdin))
+        , m_stdout(std::move(other.m_stdout))
+        , m_reactor(other.m_reactor)
+    {}
+
+    child_process &child_process::operator=(child_process &&other) noexcept {
+        if (this != &other) {
+            release();
+            m_pid       = std::exchange(other.m_pid, -1);
+            m_pidfd     = std::exchange(other.m_pidfd, -1);
+            m_exit_code = other.m_exit_code;
+            m_stdin     = std::move(other.m_stdin);
+            m_stdout    = std::move(other.m_stdout);
+            m_reactor   = other.m_reactor;
+        }
+        return *this;
+    }
+
+    child_process::~child_process() { release(); }
+
+    void child_process::release() noexcept {
+        if (m_pid > 0) {
+            ::kill(m_pid, SIGKILL);
+            while (::waitpid(m_pid, nullptr, 0) < 0 && errno == EINTR) {
+            }
+            m_pid = -1;
+        }
+
+        if (m_pidfd >= 0) {
+            m_reactor->forget(m_pidfd);
+            ::close(std::exchange(m_pidfd, -1));
+        }
+
+        m_stdin.close();
+        m_stdout.close();
+    }
+
+    task< int > child_process::wait() {
+        if (m_pid <= 0) {
+            co_return m_exit_code;
+        }
+
+        int status = 0;
+        if (m_pidfd >= 0) {
+            co_await m_reactor->wait_readable(m_pidfd);
+            status = reap(m_pid);
+
+            m_reactor->forget(m_pidfd);
+            ::close(std::exchange(m_pidfd, -1));
+        } else {
+            // No pidfd to wait on, park a blocking waitpid() instead.
+            status = co_await run_blocking([pid = m_pid] { return reap(pid); });
+        }
+
+        m_pid       = -1;
+        m_exit_code = exit_code(status);
+        co_return m_exit_code;
+    }
+
+    async_generator< std::string > run_process(
+        std::vector< std::string > argv, process_options options, reactor &r
+    ) {
+        options.pipe_stdin = false;
+        auto child = child_process::spawn(argv, options, r);
+
+        constexpr std::size_t chunk_size = 64 * 1024;
+        std::string chunk;
+        while (true) {
+            chunk.resize(chunk_size);
+            auto read = co_await child.stdout_pipe().read_some(std::as_writable_bytes(std::span(chunk)));
+            if (read == 0) {
+                break;
+            }
+
+            chunk.resize(read);
+            co_yield chunk;
+        }
+
+        child.stdout_pipe().close();
+        if (auto code = co_await child.wait(); code != 0) {
+            throw process_error(argv.front(), code);
+        }
+    }
+
+} // namespace gap::coro
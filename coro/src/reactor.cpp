@@ -0,0 +1,273 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/reactor.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <exception>
+#include <system_error>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace gap::coro {
+
+    namespace
+    {
+        [[noreturn]] void throw_errno(int error, const char *what) {
+            throw std::system_error(error, std::system_category(), what);
+        }
+
+        void set_non_blocking(int fd) {
+            int flags = ::fcntl(fd, F_GETFL);
+            if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+                throw_errno(errno, "fcntl");
+            }
+        }
+
+        // Writing to a pipe whose read end is closed raises SIGPIPE, which
+        // kills the process unless handled. The signal is blocked around the
+        // write and, if the write raised it, consumed before unblocking, so
+        // that the caller only sees EPIPE.
+        ssize_t write_without_sigpipe(int fd, const void *data, std::size_t size) {
+            sigset_t sigpipe, previous;
+            sigemptyset(&sigpipe);
+            sigaddset(&sigpipe, SIGPIPE);
+
+            sigset_t pending;
+            sigpending(&pending);
+            bool already_pending = sigismember(&pending, SIGPIPE);
+
+            pthread_sigmask(SIG_BLOCK, &sigpipe, &previous);
+            auto result = ::write(fd, data, size);
+            int error   = errno;
+
+            if (result < 0 && error == EPIPE && !already_pending) {
+                timespec zero{};
+                while (sigtimedwait(&sigpipe, nullptr, &zero) < 0 && errno == EINTR) {
+                }
+            }
+
+            pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+            errno = error;
+            return result;
+        }
+
+    } // namespace
+
+    reactor::reactor(std::uint32_t thread_count) {
+        m_epoll_fd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (m_epoll_fd < 0) {
+            throw_errno(errno, "epoll_create1");
+        }
+
+        // Level-triggered and never read, once signalled it wakes every
+        // reactor thread for good.
+        m_wakeup_fd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        epoll_event event{};
+        event.events   = EPOLLIN;
+        event.data.ptr = nullptr;
+        if (m_wakeup_fd < 0 || ::epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_wakeup_fd, &event) < 0) {
+            int error = errno;
+            if (m_wakeup_fd >= 0) {
+                ::close(m_wakeup_fd);
+            }
+            ::close(m_epoll_fd);
+            throw_errno(error, "eventfd");
+        }
+
+        thread_count = std::max(thread_count, 1u);
+        m_threads.reserve(thread_count);
+        try {
+            for (std::uint32_t i = 0; i < thread_count; ++i) {
+                m_threads.emplace_back([this] { this->run_reactor_thread(); });
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    reactor::~reactor() { stop(); }
+
+    void reactor::stop() noexcept {
+        std::uint64_t one = 1;
+        while (::write(m_wakeup_fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+        }
+
+        for (auto &thread : m_threads) {
+            thread.join();
+        }
+        m_threads.clear();
+
+        ::close(m_wakeup_fd);
+        ::close(m_epoll_fd);
+    }
+
+    reactor &reactor::global() {
+        static reactor instance;
+        return instance;
+    }
+
+    reactor::wait_operation reactor::wait_readable(int fd) noexcept {
+        return { *this, fd, EPOLLIN | EPOLLRDHUP };
+    }
+
+    reactor::wait_operation reactor::wait_writable(int fd) noexcept {
+        return { *this, fd, EPOLLOUT };
+    }
+
+    void reactor::forget(int fd) noexcept { ::epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr); }
+
+    bool reactor::wait_operation::await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+        m_awaiting_coroutine = awaiting_coroutine;
+        m_resume_on          = scheduler_ref::current();
+
+        epoll_event event{};
+        event.events   = m_events | EPOLLONESHOT;
+        event.data.ptr = this;
+
+        // Descriptors stay in the epoll set between waits, disarmed by
+        // EPOLLONESHOT, so re-arming is usually a single EPOLL_CTL_MOD.
+        // Nothing of the operation is touched once it is armed, a reactor
+        // thread may already be resuming the coroutine.
+        auto epoll_fd = m_reactor.m_epoll_fd;
+        auto fd       = m_fd;
+        m_armed.store(true, std::memory_order_release);
+        if (::epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event) == 0) {
+            return true;
+        }
+
+        if (errno == ENOENT && ::epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0) {
+            return true;
+        }
+
+        m_error = errno;
+        return false;
+    }
+
+    void reactor::wait_operation::await_resume() const {
+        if (m_error != 0) {
+            throw_errno(m_error, "epoll_ctl");
+        }
+    }
+
+    void reactor::run_reactor_thread() noexcept {
+        constexpr int max_events = 64;
+        epoll_event events[max_events];
+
+        while (true) {
+            int count = ::epoll_wait(m_epoll_fd, events, max_events, -1);
+            if (count < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::terminate();
+            }
+
+            for (int i = 0; i < count; ++i) {
+                auto *operation = static_cast< wait_operation* >(events[i].data.ptr);
+                if (operation == nullptr) {
+                    // Woken up to stop. Any other event in this batch belongs
+                    // to a wait that must have completed already.
+                    return;
+                }
+
+                // The operation may be gone as soon as the coroutine resumes.
+                [[maybe_unused]] auto armed = operation->m_armed.load(std::memory_order_acquire);
+                assert(armed);
+                auto resume_on = operation->m_resume_on;
+                resume_on.resume(operation->m_awaiting_coroutine);
+            }
+        }
+    }
+
+    std::pair< async_pipe, async_pipe > async_pipe::create(reactor &r) {
+        int fds[2];
+        if (::pipe2(fds, O_CLOEXEC) < 0) {
+            throw_errno(errno, "pipe2");
+        }
+
+        async_pipe read_end(fds[0], r);
+        async_pipe write_end(fds[1], r);
+        return { std::move(read_end), std::move(write_end) };
+    }
+
+    async_pipe::async_pipe(int fd, reactor &r)
+        : m_fd(fd)
+        , m_reactor(&r)
+    {
+        try {
+            set_non_blocking(fd);
+        } catch (...) {
+            ::close(fd);
+            throw;
+        }
+    }
+
+    async_pipe::async_pipe(async_pipe &&other) noexcept
+        : m_fd(std::exchange(other.m_fd, -1))
+        , m_reactor(other.m_reactor)
+    {}
+
+    async_pipe &async_pipe::operator=(async_pipe &&other) noexcept {
+        if (this != &other) {
+            close();
+            m_fd      = std::exchange(other.m_fd, -1);
+            m_reactor = other.m_reactor;
+        }
+        return *this;
+    }
+
+    void async_pipe::close() noexcept {
+        if (m_fd >= 0) {
+            // A child process may hold a duplicate of the descriptor for a
+            // moment, which would keep it in the epoll set past close().
+            m_reactor->forget(m_fd);
+            ::close(std::exchange(m_fd, -1));
+        }
+    }
+
+    task< std::size_t > async_pipe::read_some(std::span< std::byte > buffer) {
+        while (true) {
+            auto result = ::read(m_fd, buffer.data(), buffer.size());
+            if (result >= 0) {
+                co_return std::size_t(result);
+            }
+
+            if (errno == EAGAIN) {
+                co_await m_reactor->wait_readable(m_fd);
+            } else if (errno != EINTR) {
+                throw_errno(errno, "async_pipe::read_some");
+            }
+        }
+    }
+
+    task< std::size_t > async_pipe::write_some(std::span< const std::byte > buffer) {
+        while (true) {
+            auto result = write_without_sigpipe(m_fd, buffer.data(), buffer.size());
+            if (result >= 0) {
+                co_return std::size_t(result);
+            }
+
+            if (errno == EAGAIN) {
+                co_await m_reactor->wait_writable(m_fd);
+            } else if (errno != EINTR) {
+                throw_errno(errno, "async_pipe::write_some");
+            }
+        }
+    }
+
+    task<> async_pipe::write_all(std::span< const std::byte > buffer) {
+        while (!buffer.empty()) {
+            buffer = buffer.subspan(co_await write_some(buffer));
+        }
+    }
+
+} // namespace gap::coro
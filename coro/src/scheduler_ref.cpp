@@ -0,0 +1,19 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/scheduler_ref.hpp>
+
+namespace gap::coro {
+
+    namespace
+    {
+        thread_local scheduler_ref t_current_scheduler;
+
+    } // namespace
+
+    scheduler_ref scheduler_ref::current() noexcept { return t_current_scheduler; }
+
+    void scheduler_ref::set_current(scheduler_ref scheduler) noexcept {
+        t_current_scheduler = scheduler;
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <gap/coro/static_thread_pool.hpp>
+#include <gap/coro/scheduler_ref.hpp>
+
+#include "worker_group.hpp"
+
+#include <algorithm>
+
+namespace gap::coro {
+
+    struct static_thread_pool::thread_state : detail::worker_state
+    {
+        detail::work_stealing_deque< schedule_operation* > m_local_queue;
+    };
+
+    static_thread_pool::static_thread_pool()
+        : static_thread_pool(std::thread::hardware_concurrency())
+    {}
+
+    static_thread_pool::static_thread_pool(std::uint32_t thread_count)
+        : m_thread_count(std::max(thread_count, 1u))
+        , m_workers(std::make_unique< detail::worker_group< thread_state > >(m_thread_count))
+    {
+        m_workers->start([this](thread_state &state) { this->run_worker_thread(state); });
+    }
+
+    static_thread_pool::~static_thread_pool() { m_workers->shutdown(); }
+
+    void static_thread_pool::schedule_operation::await_suspend(
+        gap::coroutine_handle<> awaiting_coroutine
+    ) noexcept {
+        m_awaiting_coroutine = awaiting_coroutine;
+        m_pool.schedule_impl(this);
+    }
+
+    void static_thread_pool::run_worker_thread(thread_state &state) noexcept {
+        scheduler_ref::set_current(scheduler_ref(*this));
+
+        m_workers->run_worker(
+            state,
+            [this](thread_state &self) { return try_get_work(self); },
+            [](schedule_operation *operation) { operation->m_awaiting_coroutine.resume(); }
+        );
+
+        scheduler_ref::set_current({});
+    }
+
+    void static_thread_pool::schedule_impl(schedule_operation *operation) noexcept {
+        // Scheduling from a worker uses the worker's own deque instead of
+        // the global injection queue.
+        m_workers->schedule(
+            [&](thread_state *state) {
+                if (state == nullptr || !state->m_local_queue.push(operation)) {
+                    m_workers->inject(m_global_queue_head, operation);
+                }
+            },
+            [this] { m_workers->wake_one(); }
+        );
+    }
+
+    static_thread_pool::schedule_operation *static_thread_pool::try_get_work(
+        thread_state &state
+    ) noexcept {
+        if (auto *operation = state.m_local_queue.pop()) {
+            return operation;
+        }
+
+        auto wake_any = [this] { m_workers->wake_one(); };
+        auto *operation = m_workers->take_injected(m_global_queue_head, state.m_local_queue, wake_any);
+        if (operation != nullptr) {
+            return operation;
+        }
+
+        return m_workers->steal(
+            state, 0, m_thread_count,
+            [](thread_state &victim) -> auto & { return victim.m_local_queue; },
+            [&](thread_state &) { wake_any(); }
+        );
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,308 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#include <gap/coro/timer_service.hpp>
+
+#include <gap/coro/operation_cancelled.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <limits>
+
+namespace gap::coro {
+
+    namespace detail {
+
+        bool timer_operation_base::start(gap::coroutine_handle<> awaiting_coroutine) {
+            m_awaiting_coroutine = awaiting_coroutine;
+
+            if (m_cancellation_token.is_cancellation_requested()) {
+                m_state = state::cancelled;
+                return false;
+            }
+
+            if (m_cancellation_token.can_be_cancelled()) {
+                // Registered before the timer is inserted, so that a failure
+                // to register leaves nothing behind. A request that comes in
+                // now marks the timer cancelled before it is ever inserted.
+                m_cancellation_registration.emplace(m_cancellation_token, [this] {
+                    if (m_service.cancel(*this)) {
+                        resume();
+                    }
+                });
+            }
+
+            if (!m_service.insert(*this)) {
+                return false;
+            }
+
+            return !m_ready_to_resume.exchange(true, std::memory_order_acq_rel);
+        }
+
+        void timer_operation_base::finish() const {
+            if (m_state == state::cancelled) {
+                throw operation_cancelled{};
+            }
+        }
+
+    } // namespace detail
+
+    timer_service::timer_service(duration resolution)
+        : m_resolution(resolution)
+        , m_start(clock::now())
+    {
+        assert(resolution > duration::zero());
+        m_wake_tick = std::numeric_limits< std::uint64_t >::max();
+        m_thread    = std::thread([this] { run(); });
+    }
+
+    timer_service::~timer_service() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+
+        timer *cancelled = nullptr;
+        {
+            std::lock_guard lock(m_mutex);
+            for (std::uint32_t slot = 0; slot < levels * slot_count; ++slot) {
+                auto *list = take_slot(slot);
+                while (list) {
+                    auto *next    = list->m_next;
+                    list->m_state = timer::state::cancelled;
+                    list->m_next  = cancelled;
+                    cancelled     = list;
+                    list          = next;
+                }
+            }
+            m_pending.store(0, std::memory_order_relaxed);
+        }
+
+        while (cancelled) {
+            auto *next = cancelled->m_next;
+            cancelled->resume();
+            cancelled = next;
+        }
+    }
+
+    std::uint64_t timer_service::now_tick() const noexcept {
+        return static_cast< std::uint64_t >((clock::now() - m_start) / m_resolution);
+    }
+
+    std::uint64_t timer_service::deadline_tick(duration delay) const noexcept {
+        // Rounded up on both ends, so that a timer never fires early.
+        auto ceil_ticks = [this](duration d) -> std::uint64_t {
+            if (d <= duration::zero()) {
+                return 0;
+            }
+            return static_cast< std::uint64_t >(d / m_resolution)
+                 + (d % m_resolution != duration::zero() ? 1 : 0);
+        };
+
+        return ceil_ticks(clock::now() - m_start) + ceil_ticks(delay);
+    }
+
+    bool timer_service::insert(timer &t) {
+        const auto deadline = deadline_tick(t.m_delay);
+
+        std::lock_guard lock(m_mutex);
+        if (t.m_state == timer::state::cancelled) {
+            return false;
+        }
+
+        skip_idle_ticks();
+        if (t.m_delay <= duration::zero() || deadline <= m_current_tick) {
+            t.m_state = timer::state::fired;
+            return false;
+        }
+
+        t.m_state    = timer::state::pending;
+        t.m_deadline = deadline;
+        place(t);
+        m_pending.fetch_add(1, std::memory_order_relaxed);
+
+        if (deadline < m_wake_tick) {
+            m_wake.notify_one();
+        }
+
+        return true;
+    }
+
+    bool timer_service::cancel(timer &t) noexcept {
+        std::lock_guard lock(m_mutex);
+        switch (t.m_state) {
+            case timer::state::idle:
+                // start() has not inserted the timer yet and will back out.
+                t.m_state = timer::state::cancelled;
+                return false;
+            case timer::state::pending:
+                unlink(t);
+                t.m_state = timer::state::cancelled;
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    void timer_service::skip_idle_ticks() noexcept {
+        // With the wheel empty there is nothing to fire or cascade, so after
+        // an idle period it jumps to the present instead of stepping through
+        // every tick it missed.
+        if (m_pending.load(std::memory_order_relaxed) == 0) {
+            m_current_tick = std::max(m_current_tick, now_tick());
+        }
+    }
+
+    void timer_service::place(timer &t) noexcept {
+        assert(t.m_deadline > m_current_tick);
+
+        const auto delta = t.m_deadline - m_current_tick;
+
+        std::uint32_t lvl = 0;
+        while (lvl + 1 < levels && delta >> (slot_bits * (lvl + 1))) {
+            ++lvl;
+        }
+
+        // Timers beyond the range of the wheel park in the top level and
+        // are placed again each time they are cascaded.
+        constexpr std::uint64_t max_delta = (std::uint64_t(1) << (slot_bits * levels)) - 1;
+        const auto target = delta > max_delta ? m_current_tick + max_delta : t.m_deadline;
+
+        const auto index = static_cast< std::uint32_t >(target >> (slot_bits * lvl)) & slot_mask;
+        auto &wheel      = m_levels[lvl];
+        auto *&head      = wheel.m_slots[index];
+
+        t.m_slot = lvl * slot_count + index;
+        t.m_prev = nullptr;
+        t.m_next = head;
+        if (head) {
+            head->m_prev = &t;
+        }
+        head = &t;
+
+        wheel.m_occupied[index / 64] |= std::uint64_t(1) << (index % 64);
+    }
+
+    void timer_service::unlink(timer &t) noexcept {
+        auto &wheel = m_levels[t.m_slot / slot_count];
+        auto index  = t.m_slot % slot_count;
+
+        if (t.m_prev) {
+            t.m_prev->m_next = t.m_next;
+        } else {
+            wheel.m_slots[index] = t.m_next;
+            if (!t.m_next) {
+                wheel.m_occupied[index / 64] &= ~(std::uint64_t(1) << (index % 64));
+            }
+        }
+
+        if (t.m_next) {
+            t.m_next->m_prev = t.m_prev;
+        }
+    }
+
+    timer_service::timer *timer_service::take_slot(std::uint32_t slot) noexcept {
+        auto &wheel = m_levels[slot / slot_count];
+        auto index  = slot % slot_count;
+
+        wheel.m_occupied[index / 64] &= ~(std::uint64_t(1) << (index % 64));
+        return std::exchange(wheel.m_slots[index], nullptr);
+    }
+
+    void timer_service::advance(timer *&expired) noexcept {
+        const auto tick = ++m_current_tick;
+
+        // Whenever a level wraps around, move the timers of the next slot of
+        // the level above down the wheel.
+        for (std::uint32_t lvl = 1; lvl < levels; ++lvl) {
+            if (tick & ((std::uint64_t(1) << (slot_bits * lvl)) - 1)) {
+                break;
+            }
+
+            const auto index = static_cast< std::uint32_t >(tick >> (slot_bits * lvl)) & slot_mask;
+            auto *list       = take_slot(lvl * slot_count + index);
+            while (list) {
+                auto *next = list->m_next;
+                if (list->m_deadline <= tick) {
+                    list->m_state = timer::state::fired;
+                    list->m_next  = expired;
+                    expired       = list;
+                    m_pending.fetch_sub(1, std::memory_order_relaxed);
+                } else {
+                    place(*list);
+                }
+                list = next;
+            }
+        }
+
+        auto *list = take_slot(static_cast< std::uint32_t >(tick) & slot_mask);
+        while (list) {
+            auto *next = list->m_next;
+            assert(list->m_deadline <= tick);
+            list->m_state = timer::state::fired;
+            list->m_next  = expired;
+            expired       = list;
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            list = next;
+        }
+    }
+
+    std::uint64_t timer_service::next_wake_tick() const noexcept {
+        if (m_pending.load(std::memory_order_relaxed) == 0) {
+            return std::numeric_limits< std::uint64_t >::max();
+        }
+
+        // The next occupied slot of the lowest level in this revolution,
+        // otherwise the start of the next revolution, which cascades.
+        const auto &occupied = m_levels[0].m_occupied;
+        const auto base      = m_current_tick & ~std::uint64_t(slot_mask);
+
+        for (auto index = static_cast< std::uint32_t >(m_current_tick & slot_mask) + 1;
+             index < slot_count;)
+        {
+            auto word = occupied[index / 64] >> (index % 64);
+            if (word) {
+                return base + index + static_cast< std::uint32_t >(std::countr_zero(word));
+            }
+            index = (index / 64 + 1) * 64;
+        }
+
+        return base + slot_count;
+    }
+
+    void timer_service::run() noexcept {
+        std::unique_lock lock(m_mutex);
+        while (!m_stop) {
+            skip_idle_ticks();
+            const auto now = now_tick();
+
+            timer *expired = nullptr;
+            while (m_current_tick < now) {
+                advance(expired);
+            }
+
+            if (expired) {
+                lock.unlock();
+                while (expired) {
+                    auto *next = expired->m_next;
+                    expired->resume();
+                    expired = next;
+                }
+                lock.lock();
+                continue;
+            }
+
+            m_wake_tick = next_wake_tick();
+            if (m_wake_tick == std::numeric_limits< std::uint64_t >::max()) {
+                m_wake.wait(lock);
+            } else {
+                m_wake.wait_until(lock, m_start + m_resolution * m_wake_tick);
+            }
+            m_wake_tick = std::numeric_limits< std::uint64_t >::max();
+        }
+    }
+
+} // namespace gap::coro
@@ -0,0 +1,127 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace gap::coro::detail
+{
+    // Fixed-capacity Chase-Lev work-stealing deque of pointers.
+    //
+    // The owning thread pushes and pops at the bottom (LIFO) while any other
+    // thread may steal from the top (FIFO). The algorithm follows "Correct
+    // and Efficient Work-Stealing for Weak Memory Models" (Le, Pop, Cohen,
+    // Zappa Nardelli, PPoPP'13), with the stand-alone fences folded into
+    // seq_cst accesses so that thread sanitizer can follow the hand-off.
+    //
+    // The buffer never grows: push() reports a full deque and leaves it to
+    // the caller to spill the item elsewhere (e.g. a global queue). This
+    // avoids having to reclaim retired buffers that thieves may still read.
+    template< typename T >
+    struct work_stealing_deque
+    {
+        static_assert(std::is_pointer_v< T >);
+
+        explicit work_stealing_deque(std::size_t capacity = 1024)
+            : m_mask(round_up_to_power_of_two(capacity) - 1)
+            , m_buffer(std::make_unique< std::atomic< T >[] >(m_mask + 1))
+        {}
+
+        work_stealing_deque(const work_stealing_deque&) = delete;
+        work_stealing_deque& operator=(const work_stealing_deque&) = delete;
+
+        std::size_t capacity() const noexcept { return m_mask + 1; }
+
+        // Owner only. Returns false if the deque is full.
+        bool push(T item) noexcept {
+            std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            std::int64_t top    = m_top.load(std::memory_order_acquire);
+            if (bottom - top >= static_cast< std::int64_t >(capacity())) {
+                return false;
+            }
+
+            slot(bottom).store(item, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Owner only. Returns nullptr if the deque is empty.
+        T pop() noexcept {
+            std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            m_bottom.store(bottom, std::memory_order_seq_cst);
+            std::int64_t top = m_top.load(std::memory_order_seq_cst);
+
+            if (top > bottom) {
+                // Deque was already empty.
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            T item = slot(bottom).load(std::memory_order_relaxed);
+            if (top == bottom) {
+                // Last item, race against concurrent thieves for it.
+                if (!m_top.compare_exchange_strong(
+                        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                {
+                    item = nullptr;
+                }
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+
+            return item;
+        }
+
+        // Any thread. Returns nullptr if the deque is empty or if the steal
+        // lost a race with the owner or another thief.
+        T steal() noexcept {
+            std::int64_t top    = m_top.load(std::memory_order_seq_cst);
+            std::int64_t bottom = m_bottom.load(std::memory_order_seq_cst);
+
+            if (top >= bottom) {
+                return nullptr;
+            }
+
+            T item = slot(top).load(std::memory_order_relaxed);
+            if (!m_top.compare_exchange_strong(
+                    top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                return nullptr;
+            }
+
+            return item;
+        }
+
+        // Any thread. Only a hint, the result may be stale immediately.
+        bool empty_approx() const noexcept {
+            return m_bottom.load(std::memory_order_relaxed)
+                <= m_top.load(std::memory_order_relaxed);
+        }
+
+      private:
+        static std::size_t round_up_to_power_of_two(std::size_t value) noexcept {
+            std::size_t result = 2;
+            while (result < value) {
+                result <<= 1;
+            }
+            return result;
+        }
+
+        std::atomic< T >& slot(std::int64_t index) noexcept {
+            return m_buffer[static_cast< std::size_t >(index) & m_mask];
+        }
+
+        // Keep the indices on separate cache lines, 'top' is hammered by
+        // thieves while 'bottom' is mostly touched by the owner.
+        alignas(64) std::atomic< std::int64_t > m_top    = 0;
+        alignas(64) std::atomic< std::int64_t > m_bottom = 0;
+
+        const std::size_t m_mask;
+        std::unique_ptr< std::atomic< T >[] > m_buffer;
+    };
+
+} // namespace gap::coro::detail
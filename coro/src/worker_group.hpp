@@ -0,0 +1,344 @@
+// Copyright (c) 2024, Trail of Bits, Inc.
+
+#pragma once
+
+#include "work_stealing_deque.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <semaphore>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace gap::coro::detail
+{
+    // What a worker_group needs of every worker, schedulers derive the state
+    // of their workers from it.
+    struct worker_state
+    {
+        // Set by the worker right before it goes to sleep. Whoever manages to
+        // flip it back to false (the worker itself, or a thread that wakes it)
+        // is responsible for decrementing 'm_sleeping_thread_count'.
+        std::atomic< bool > m_sleeping = false;
+        std::binary_semaphore m_wakeup{ 0 };
+
+        std::uint32_t m_index = 0;
+        std::uint32_t m_steal_seed = 0;
+    };
+
+    // The worker threads of a work-stealing scheduler and the protocol that
+    // puts them to sleep when they run out of work and wakes them up again.
+    //
+    // The scheduler owns the queues and decides where work goes and where
+    // workers look for it. Workers keep Chase-Lev deques in their state,
+    // operations scheduled from other threads are pushed to injection stacks,
+    // intrusive lists linked through the operations' 'm_next'.
+    template< typename state_t >
+    struct worker_group
+    {
+        static_assert(std::is_base_of_v< worker_state, state_t >);
+
+        explicit worker_group(std::uint32_t thread_count)
+            : m_thread_count(thread_count)
+            , m_states(std::make_unique< state_t[] >(thread_count))
+        {
+            for (std::uint32_t i = 0; i < thread_count; ++i) {
+                m_states[i].m_index      = i;
+                m_states[i].m_steal_seed = i + 1;
+            }
+        }
+
+        worker_group(const worker_group &) = delete;
+        worker_group &operator=(const worker_group &) = delete;
+
+        std::uint32_t thread_count() const noexcept { return m_thread_count; }
+
+        state_t &state(std::uint32_t index) noexcept { return m_states[index]; }
+
+        // The state of the calling thread if it is a worker of this group
+        // running its loop.
+        state_t *current() const noexcept { return t_group == this ? t_state : nullptr; }
+
+        // Starts a thread per worker calling 'body' with its state, which is
+        // expected to end in run_worker(). If not every thread can be started
+        // the ones that were are stopped again.
+        template< typename body_t >
+        void start(body_t body) {
+            m_threads.reserve(m_thread_count);
+            try {
+                for (std::uint32_t i = 0; i < m_thread_count; ++i) {
+                    m_threads.emplace_back([this, body, i] { body(m_states[i]); });
+                }
+            } catch (...) {
+                try {
+                    shutdown();
+                } catch (...) {
+                    std::terminate();
+                }
+
+                throw;
+            }
+        }
+
+        // Resumes whatever 'get_work' finds until stop is requested and no
+        // work is left, sleeping whenever there is none.
+        template< typename get_work_t, typename resume_t >
+        void run_worker(state_t &state, get_work_t get_work, resume_t resume) noexcept {
+            t_group = this;
+            t_state = &state;
+
+            while (true) {
+                if (auto *operation = get_work(state)) {
+                    resume(operation);
+                    continue;
+                }
+
+                // Announce that we are about to sleep and then look for work
+                // once more. Paired with the fence in schedule() this
+                // guarantees that either we see the newly queued work or the
+                // scheduling thread sees us sleeping and wakes us up.
+                state.m_sleeping.store(true, std::memory_order_relaxed);
+                m_sleeping_thread_count.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                auto *operation = get_work(state);
+                bool stop       = m_stop_requested.load(std::memory_order_relaxed);
+
+                if (operation != nullptr || stop) {
+                    if (state.m_sleeping.exchange(false, std::memory_order_acq_rel)) {
+                        m_sleeping_thread_count.fetch_sub(1, std::memory_order_relaxed);
+                    } else {
+                        // Somebody else already claimed our sleeping flag and
+                        // is about to release the semaphore, consume that
+                        // wake-up.
+                        state.m_wakeup.acquire();
+                    }
+
+                    if (operation != nullptr) {
+                        resume(operation);
+                        continue;
+                    }
+
+                    // Stop was requested and there is no queued work left.
+                    break;
+                }
+
+                state.m_wakeup.acquire();
+            }
+
+            t_group = nullptr;
+            t_state = nullptr;
+        }
+
+        // Lets the workers finish the queued work and joins them.
+        void shutdown() {
+            m_stop_requested.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            for (std::uint32_t i = 0; i < m_threads.size(); ++i) {
+                auto &state = m_states[i];
+                if (state.m_sleeping.exchange(false, std::memory_order_acq_rel)) {
+                    m_sleeping_thread_count.fetch_sub(1, std::memory_order_relaxed);
+                    state.m_wakeup.release();
+                }
+            }
+
+            for (auto &thread : m_threads) {
+                thread.join();
+            }
+
+            // Threads outside of the group may still be finishing schedule()
+            // for a coroutine that already ran, such as a blocking_pool thread
+            // sending one back. They are done with it once this drops to 0.
+            while (m_remote_schedulers.load(std::memory_order_acquire) != 0) {
+                std::this_thread::yield();
+            }
+
+            m_threads.clear();
+        }
+
+        // Queues work by calling 'enqueue' with the state of the calling
+        // worker, null on any other thread, then calls 'wake' if a worker is
+        // sleeping. Nothing of the queued operation may be touched once it
+        // is queued, another worker may already be resuming the coroutine.
+        template< typename enqueue_t, typename wake_t >
+        void schedule(enqueue_t enqueue, wake_t wake) noexcept {
+            auto *state = current();
+            if (state == nullptr) {
+                m_remote_schedulers.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            enqueue(state);
+
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (has_sleeping()) {
+                wake();
+            }
+
+            if (state == nullptr) {
+                m_remote_schedulers.fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        bool has_sleeping() const noexcept {
+            return m_sleeping_thread_count.load(std::memory_order_relaxed) > 0;
+        }
+
+        // Wakes a sleeping worker among [first, first + count), returns
+        // whether there was one.
+        bool wake_one(std::uint32_t first, std::uint32_t count) noexcept {
+            for (std::uint32_t i = first; i < first + count; ++i) {
+                auto &state = m_states[i];
+                if (!state.m_sleeping.load(std::memory_order_relaxed)) {
+                    continue;
+                }
+
+                if (state.m_sleeping.exchange(false, std::memory_order_acq_rel)) {
+                    m_sleeping_thread_count.fetch_sub(1, std::memory_order_relaxed);
+                    state.m_wakeup.release();
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool wake_one() noexcept { return wake_one(0, m_thread_count); }
+
+        // Steals from the deques 'queue_of' picks out of the workers among
+        // [first, first + count) other than 'thief'. If the victim has more
+        // left and a worker is sleeping, 'wake' is called with the victim.
+        template< typename queue_of_t, typename wake_t >
+        auto steal(
+            state_t &thief, std::uint32_t first, std::uint32_t count,
+            queue_of_t queue_of, wake_t wake
+        ) noexcept -> decltype(queue_of(thief).steal()) {
+            if (count <= 1) {
+                return nullptr;
+            }
+
+            // xorshift32 to pick a pseudo-random first victim, so that idle
+            // threads don't all hammer the same worker.
+            auto seed = thief.m_steal_seed;
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            thief.m_steal_seed = seed;
+
+            const auto start = seed % count;
+            for (std::uint32_t i = 0; i < count; ++i) {
+                auto victim = first + (start + i) % count;
+                if (victim == thief.m_index) {
+                    continue;
+                }
+
+                auto &other = queue_of(m_states[victim]);
+                if (other.empty_approx()) {
+                    continue;
+                }
+
+                if (auto *operation = other.steal()) {
+                    // There might be more where that came from, ramp up
+                    // another sleeping worker instead of leaving the victim
+                    // on its own.
+                    if (!other.empty_approx() && has_sleeping()) {
+                        wake(m_states[victim]);
+                    }
+
+                    return operation;
+                }
+            }
+
+            return nullptr;
+        }
+
+        template< typename operation_t >
+        static void inject(std::atomic< operation_t* > &head, operation_t *operation) noexcept {
+            auto *top = head.load(std::memory_order_relaxed);
+            do {
+                operation->m_next = top;
+            } while (!head.compare_exchange_weak(
+                top, operation, std::memory_order_release, std::memory_order_relaxed)
+            );
+        }
+
+        // Takes over everything injected into 'head'. Returns the oldest
+        // operation and moves the rest to 'local', where idle workers can
+        // steal it, then calls 'wake' if any was moved and a worker is
+        // sleeping.
+        template< typename operation_t, typename wake_t >
+        operation_t *take_injected(
+            std::atomic< operation_t* > &head, work_stealing_deque< operation_t* > &local,
+            wake_t wake
+        ) noexcept {
+            if (head.load(std::memory_order_relaxed) == nullptr) {
+                return nullptr;
+            }
+
+            // Detach the whole stack at once. Taking everything avoids the ABA
+            // problem of popping single items from a shared lock-free stack.
+            auto *top = head.exchange(nullptr, std::memory_order_acquire);
+            if (top == nullptr) {
+                return nullptr;
+            }
+
+            // The stack is in LIFO order, reverse it so that injected work is
+            // started roughly in submission order.
+            operation_t *reversed = nullptr;
+            while (top != nullptr) {
+                auto *next   = top->m_next;
+                top->m_next  = reversed;
+                reversed     = top;
+                top          = next;
+            }
+
+            auto *first = reversed;
+            reversed    = reversed->m_next;
+
+            // Pushing the oldest item first keeps it closest to the stealing
+            // end. What does not fit goes back to the injection stack.
+            bool moved_to_local = false;
+            operation_t *overflow = nullptr;
+            while (reversed != nullptr) {
+                auto *next = reversed->m_next;
+                if (!local.push(reversed)) {
+                    reversed->m_next = overflow;
+                    overflow         = reversed;
+                } else {
+                    moved_to_local = true;
+                }
+                reversed = next;
+            }
+
+            while (overflow != nullptr) {
+                auto *next = overflow->m_next;
+                inject(head, overflow);
+                overflow = next;
+            }
+
+            // Let a sleeping worker help with the batch we just took over.
+            if (moved_to_local && has_sleeping()) {
+                wake();
+            }
+
+            return first;
+        }
+
+      private:
+        static inline thread_local const worker_group *t_group = nullptr;
+        static inline thread_local state_t *t_state = nullptr;
+
+        const std::uint32_t m_thread_count;
+        std::unique_ptr< state_t[] > m_states;
+        std::vector< std::thread > m_threads;
+
+        std::atomic< bool > m_stop_requested = false;
+        std::atomic< std::uint32_t > m_sleeping_thread_count = 0;
+
+        // Threads that do not belong to the group and are inside schedule().
+        std::atomic< std::uint32_t > m_remote_schedulers = 0;
+    };
+
+} // namespace gap::coro::detail
@@ -0,0 +1,276 @@
+// Copyright 2024-present, Trail of Bits, Inc.
+
+#pragma once
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <gap/coro/awaitable_traits.hpp>
+    #include <gap/coro/coroutine.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+    #include <gap/graph/graph.hpp>
+
+    #include <algorithm>
+    #include <atomic>
+    #include <chrono>
+    #include <cstddef>
+    #include <exception>
+    #include <memory>
+    #include <stdexcept>
+    #include <unordered_map>
+    #include <utility>
+    #include <vector>
+
+namespace gap::graph
+{
+    // Thrown by execute() for graphs whose dependencies form a cycle.
+    struct cyclic_graph : std::logic_error {
+        cyclic_graph() : std::logic_error("graph contains a cycle") {}
+    };
+
+    // Timing summary of a graph execution.
+    struct execution_report
+    {
+        using duration = std::chrono::steady_clock::duration;
+
+        std::size_t nodes = 0;
+
+        // From the start of the execution until the last node finished.
+        duration wall_time{};
+
+        // Sum of the time every node took, from being started on the
+        // scheduler until its coroutine completed.
+        duration busy_time{};
+
+        // The longest chain of dependent nodes, by the sum of their measured
+        // times, and the number of nodes on it.
+        duration critical_path{};
+        std::size_t critical_path_nodes = 0;
+
+        // The average number of nodes that were running at once.
+        double parallelism() const noexcept {
+            return wall_time.count() ? double(busy_time.count()) / double(wall_time.count()) : 0.0;
+        }
+
+        // The parallelism the graph would allow given unlimited threads.
+        double available_parallelism() const noexcept {
+            return critical_path.count()
+                ? double(busy_time.count()) / double(critical_path.count())
+                : 0.0;
+        }
+    };
+
+    namespace detail
+    {
+        // A node of the graph as seen by the executor. A node may start once
+        // 'm_pending' drops to zero: it starts at the number of dependencies
+        // plus one for the node's own task, so that whichever of the last
+        // dependency and the node's task comes last resumes the node.
+        struct execution_node
+        {
+            std::atomic< std::size_t > m_pending = 0;
+            gap::coroutine_handle<> m_awaiting_coroutine;
+
+            std::vector< std::size_t > m_dependencies;
+            std::vector< std::size_t > m_dependents;
+
+            // Set by failed or skipped dependencies, the node is skipped then.
+            std::atomic< bool > m_poisoned = false;
+
+            std::chrono::steady_clock::duration m_time{};
+            std::chrono::steady_clock::time_point m_finished{};
+        };
+
+        struct dependencies_awaiter
+        {
+            execution_node &m_node;
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(gap::coroutine_handle<> awaiting_coroutine) noexcept {
+                m_node.m_awaiting_coroutine = awaiting_coroutine;
+                return m_node.m_pending.fetch_sub(1, std::memory_order_acq_rel) != 1;
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        // The nodes of a graph with their dependencies resolved to indices,
+        // in an order in which every node comes after its dependencies.
+        template< typename node_pointer >
+        struct execution_plan
+        {
+            std::vector< node_pointer > m_pointers;
+            std::vector< execution_node > m_nodes;
+            std::vector< std::size_t > m_order;
+        };
+
+        // Resolves the graph into an execution plan, throws cyclic_graph if
+        // some nodes can never start.
+        template< graph_like graph_type >
+        auto make_execution_plan(const graph_type &graph) {
+            execution_plan< typename graph_type::node_pointer > plan;
+            auto &[pointers, nodes, order] = plan;
+
+            std::unordered_map< typename graph_type::node_pointer, std::size_t > indices;
+            for (auto node : graph.nodes()) {
+                if (indices.emplace(node, pointers.size()).second) {
+                    pointers.push_back(node);
+                }
+            }
+
+            nodes = std::vector< execution_node >(pointers.size());
+            for (auto edge : graph.edges()) {
+                auto source = indices.find(edge.source());
+                auto target = indices.find(edge.target());
+                if (source == indices.end() || target == indices.end()) {
+                    throw std::invalid_argument("graph edge refers to a node outside of the graph");
+                }
+
+                // The source depends on the target.
+                nodes[source->second].m_dependencies.push_back(target->second);
+                nodes[target->second].m_dependents.push_back(source->second);
+            }
+
+            // Kahn's algorithm, both to reject cycles up front, as the nodes
+            // on a cycle would never start, and to order the critical path
+            // pass.
+            order.reserve(nodes.size());
+            std::vector< std::size_t > remaining(nodes.size());
+            for (std::size_t i = 0; i < nodes.size(); ++i) {
+                remaining[i] = nodes[i].m_dependencies.size();
+                if (remaining[i] == 0) {
+                    order.push_back(i);
+                }
+            }
+
+            for (std::size_t next = 0; next < order.size(); ++next) {
+                for (auto dependent : nodes[order[next]].m_dependents) {
+                    if (--remaining[dependent] == 0) {
+                        order.push_back(dependent);
+                    }
+                }
+            }
+
+            if (order.size() != nodes.size()) {
+                throw cyclic_graph{};
+            }
+
+            for (auto &node : nodes) {
+                node.m_pending.store(node.m_dependencies.size() + 1, std::memory_order_relaxed);
+            }
+
+            return plan;
+        }
+
+        template< typename node_pointer, coro::scheduler scheduler_t, typename fn_t >
+        coro::task<> execute_node(
+            std::vector< execution_node > &nodes, std::size_t index,
+            node_pointer node, scheduler_t &scheduler, fn_t &fn
+        ) {
+            auto &self = nodes[index];
+            co_await dependencies_awaiter{ self };
+
+            // Every dependent is released through this, however this node
+            // completes, so that the rest of the graph drains.
+            auto release = [&nodes, &self](bool failed) noexcept {
+                for (auto dependent : self.m_dependents) {
+                    auto &next = nodes[dependent];
+                    if (failed) {
+                        next.m_poisoned.store(true, std::memory_order_relaxed);
+                    }
+                    if (next.m_pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        next.m_awaiting_coroutine.resume();
+                    }
+                }
+            };
+
+            // Skipped nodes go through the scheduler as well, so that a long
+            // chain of them does not unwind recursively on one stack.
+            co_await scheduler.schedule();
+
+            if (self.m_poisoned.load(std::memory_order_relaxed)) {
+                release(true);
+                co_return;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            try {
+                co_await fn(node);
+            } catch (...) {
+                self.m_finished = std::chrono::steady_clock::now();
+                self.m_time     = self.m_finished - start;
+                release(true);
+                throw;
+            }
+
+            self.m_finished = std::chrono::steady_clock::now();
+            self.m_time     = self.m_finished - start;
+            release(false);
+        }
+
+    } // namespace detail
+
+    // Runs 'fn(node)' for every node of the graph on 'scheduler', starting
+    // each node as soon as all of its children have finished, the same order
+    // in which toposort() yields them. 'fn' returns an awaitable, usually a
+    // task, and is called concurrently.
+    //
+    // Nodes are counted down through an atomic counter of outstanding
+    // children each, so independent parts of the graph run in parallel
+    // without any central queue. If a node fails, the nodes that depend on
+    // it are skipped, everything else still runs, and the first exception is
+    // rethrown once the execution has drained. Throws cyclic_graph before
+    // running anything if the graph has a cycle.
+    //
+    //     auto report = sync_wait(graph::execute(g, pool, [](auto node) -> task<> {
+    //         co_await lift(node);
+    //     }));
+    template< graph_like graph_type, coro::scheduler scheduler_t, typename fn_t >
+    coro::task< execution_report > execute(const graph_type &graph, scheduler_t &scheduler, fn_t fn) {
+        auto plan   = detail::make_execution_plan(graph);
+        auto &nodes = plan.m_nodes;
+
+        std::vector< coro::task<> > tasks;
+        tasks.reserve(nodes.size());
+        for (std::size_t i = 0; i < nodes.size(); ++i) {
+            tasks.push_back(detail::execute_node(nodes, i, plan.m_pointers[i], scheduler, fn));
+        }
+
+        auto start    = std::chrono::steady_clock::now();
+        auto finished = co_await coro::when_all_ready_vec(std::move(tasks));
+
+        execution_report report;
+        report.nodes = nodes.size();
+
+        // Longest chain ending in each node, by time and by node count.
+        std::vector< std::pair< execution_report::duration, std::size_t > > chains(nodes.size());
+        for (auto index : plan.m_order) {
+            auto &node   = nodes[index];
+            auto longest = std::pair< execution_report::duration, std::size_t >{};
+            for (auto dependency : node.m_dependencies) {
+                longest = std::max(longest, chains[dependency]);
+            }
+
+            auto &[time, length] = chains[index];
+            time   = longest.first + node.m_time;
+            length = longest.second + 1;
+            if (time > report.critical_path) {
+                report.critical_path       = time;
+                report.critical_path_nodes = length;
+            }
+
+            report.busy_time += node.m_time;
+            report.wall_time  = std::max(report.wall_time, node.m_finished - start);
+        }
+
+        for (auto &t : finished) {
+            t.result();
+        }
+
+        co_return report;
+    }
+
+} // namespace gap::graph
+
+#endif // GAP_ENABLE_COROUTINES
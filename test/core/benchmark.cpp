@@ -13,6 +13,10 @@ namespace gap::test
 
     static_assert(bench::mean(std::array{ 1, 2, 3 }) == 2);
     static_assert(bench::mean(std::array{ 2, 4, 4, 4, 5, 5, 7, 9 }) == 5);
+    // Fractional samples are not truncated.
+    static_assert(bench::sum(std::array{ 0.25, 0.5 }) == 0.75);
+    static_assert(bench::mean(std::array{ 0.25, 0.75 }) == 0.5);
+
     static_assert(bench::standard_deviation(std::array{ 2, 4, 4, 4, 5, 5, 7, 9 }) == 4);
 
 } // namespace gap::test
@@ -0,0 +1,150 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_barrier.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_barrier");
+
+    TEST_CASE("single participant never suspends") {
+        int phases = 0;
+        async_barrier barrier{ 1, [&]() noexcept { ++phases; } };
+
+        sync_wait([&]() -> task<> {
+            co_await barrier.arrive_and_wait();
+            co_await barrier.arrive_and_wait();
+        }());
+
+        CHECK(phases == 2);
+    }
+
+    TEST_CASE("participants advance through phases together") {
+        constexpr int rounds = 5;
+
+        int phase = 0;
+        async_barrier barrier{ 3, [&]() noexcept { ++phase; } };
+
+        auto participant = [&]() -> task< int > {
+            int mismatches = 0;
+            for (int round = 0; round < rounds; ++round) {
+                if (phase != round) {
+                    ++mismatches;
+                }
+                co_await barrier.arrive_and_wait();
+                if (phase != round + 1) {
+                    ++mismatches;
+                }
+            }
+            co_return mismatches;
+        };
+
+        auto [a, b, c] = sync_wait(when_all_ready(participant(), participant(), participant()));
+        CHECK(a.result() == 0);
+        CHECK(b.result() == 0);
+        CHECK(c.result() == 0);
+        CHECK(phase == rounds);
+    }
+
+    TEST_CASE("completion runs before the waiters are resumed") {
+        bool completed = false;
+        bool resumed   = false;
+        async_barrier barrier{ 2, [&]() noexcept {
+            CHECK(!resumed);
+            completed = true;
+        } };
+
+        auto waiter = [&]() -> task<> {
+            co_await barrier.arrive_and_wait();
+            CHECK(completed);
+            resumed = true;
+        };
+
+        auto last = [&]() -> task<> {
+            CHECK(!completed);
+            co_await barrier.arrive_and_wait();
+            CHECK(resumed);
+        };
+
+        sync_wait(when_all_ready(waiter(), last()));
+    }
+
+    TEST_CASE("arrive_and_drop") {
+        int phases = 0;
+        async_barrier barrier{ 2, [&]() noexcept { ++phases; } };
+
+        bool resumed = false;
+        auto waiter = [&]() -> task<> {
+            co_await barrier.arrive_and_wait();
+            resumed = true;
+            // The dropped participant no longer counts.
+            co_await barrier.arrive_and_wait();
+        };
+
+        auto dropper = [&]() -> task<> {
+            CHECK(!resumed);
+            barrier.arrive_and_drop();
+            CHECK(resumed);
+            co_return;
+        };
+
+        sync_wait(when_all_ready(waiter(), dropper()));
+        CHECK(phases == 2);
+    }
+
+    TEST_CASE("phases on a thread pool") {
+        static_thread_pool pool{ 4 };
+
+        constexpr int participants = 64;
+        constexpr int rounds       = 100;
+
+        std::atomic< int > arrivals = 0;
+        int phases                  = 0;
+        int bad_phases              = 0;
+
+        async_barrier barrier{ participants, [&]() noexcept {
+            if (arrivals.exchange(0, std::memory_order_relaxed) != participants) {
+                ++bad_phases;
+            }
+            ++phases;
+        } };
+
+        auto participant = [&]() -> task<> {
+            co_await pool.schedule();
+            for (int round = 0; round < rounds; ++round) {
+                arrivals.fetch_add(1, std::memory_order_relaxed);
+                co_await barrier.arrive_and_wait(pool);
+            }
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < participants; ++i) {
+            tasks.push_back(participant());
+        }
+
+        auto finished = sync_wait(when_all_ready_vec(std::move(tasks)));
+        for (auto &t : finished) {
+            t.result();
+        }
+
+        CHECK(phases == rounds);
+        CHECK(bad_phases == 0);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
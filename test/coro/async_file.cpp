@@ -0,0 +1,259 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/async_file.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <chrono>
+    #include <cstring>
+    #include <filesystem>
+    #include <semaphore>
+    #include <string_view>
+    #include <system_error>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_file");
+
+    namespace
+    {
+        std::filesystem::path temp_file(const char *name) {
+            return std::filesystem::temp_directory_path() / name;
+        }
+
+        std::span< const std::byte > bytes(std::string_view text) {
+            return std::as_bytes(std::span(text.data(), text.size()));
+        }
+
+        std::string_view text(std::span< const std::byte > data) {
+            return { reinterpret_cast< const char* >(data.data()), data.size() };
+        }
+
+        // Runs 'check' with an io_service of every backend available here.
+        template< typename check_t >
+        void for_each_backend(check_t &&check) {
+            for (auto backend : { io_backend::automatic, io_backend::blocking }) {
+                io_service service{ backend };
+                INFO("io_uring: " << service.uses_io_uring());
+                check(service);
+            }
+        }
+
+    } // namespace
+
+    TEST_CASE("write then read") {
+        auto path = temp_file("gap-test-async-file-rw");
+        for_each_backend([&](io_service &service) {
+            auto file = async_file::open(path, file_mode::write, service);
+            CHECK(sync_wait(file.write_at(0, bytes("hello, world"))) == 12);
+            CHECK(sync_wait(file.write_at(7, bytes("gap"))) == 3);
+            CHECK(file.size() == 12);
+
+            auto reader = async_file::open(path, file_mode::read, service);
+            std::vector< std::byte > buffer(32);
+            auto read = sync_wait(reader.read_at(0, buffer));
+            CHECK(text(std::span(buffer).first(read)) == "hello, gapld");
+
+            // Short at the end of the file, empty past it.
+            CHECK(sync_wait(reader.read_at(10, buffer)) == 2);
+            CHECK(sync_wait(reader.read_at(100, buffer)) == 0);
+        });
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("errors are thrown") {
+        auto path = temp_file("gap-test-async-file-errors");
+        CHECK_THROWS_AS(async_file::open(path / "missing"), std::system_error);
+
+        for_each_backend([&](io_service &service) {
+            auto file = async_file::open(path, file_mode::write, service);
+            std::vector< std::byte > buffer(8);
+            CHECK_THROWS_AS(sync_wait(file.read_at(0, buffer)), std::system_error);
+        });
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("many reads in flight") {
+        constexpr int reads = 1'000;
+        constexpr std::size_t block = 64;
+
+        auto path = temp_file("gap-test-async-file-many");
+        {
+            io_service service{ io_backend::blocking };
+            auto file = async_file::open(path, file_mode::write, service);
+            std::vector< std::byte > data(reads * block);
+            for (std::size_t i = 0; i < data.size(); ++i) {
+                data[i] = std::byte(i / block);
+            }
+            sync_wait(file.write_at(0, data));
+        }
+
+        for_each_backend([&](io_service &service) {
+            auto file = async_file::open(path, file_mode::read, service);
+            std::vector< std::vector< std::byte > > buffers(reads, std::vector< std::byte >(block));
+
+            auto read = [&](int i) -> task< bool > {
+                auto count = co_await file.read_at(std::uint64_t(i) * block, buffers[std::size_t(i)]);
+                co_return count == block && buffers[std::size_t(i)][block - 1] == std::byte(i);
+            };
+
+            std::vector< task< bool > > tasks;
+            for (int i = 0; i < reads; ++i) {
+                tasks.push_back(read(i));
+            }
+
+            auto results = sync_wait(when_all_ready_vec(std::move(tasks)));
+            int correct  = 0;
+            for (auto &result : results) {
+                correct += result.result();
+            }
+            CHECK(correct == reads);
+
+            CHECK(service.statistics().operations == reads);
+        });
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("reads queued together are submitted together") {
+        constexpr std::size_t reads = 1'000;
+
+        auto path = temp_file("gap-test-async-file-batch");
+        {
+            io_service service{ io_backend::blocking };
+            auto file = async_file::open(path, file_mode::write, service);
+            sync_wait(file.write_at(0, std::vector< std::byte >(reads)));
+        }
+
+        io_service service;
+        if (!service.uses_io_uring()) {
+            std::filesystem::remove(path);
+            return;
+        }
+
+        auto file = async_file::open(path, file_mode::read, service);
+        std::vector< std::byte > buffer(reads + 1);
+
+        // The first read resumes on the completion thread and keeps it there
+        // until all the others are queued, so that it takes them all at once.
+        // It awaits the operation itself, a task could also resume it here
+        // if the read completes before the task is done suspending.
+        std::binary_semaphore parked{ 0 };
+        std::binary_semaphore released{ 0 };
+        io_statistics before;
+
+        auto gate = [&]() -> task<> {
+            co_await service.read(file.native_handle(), 0, buffer.data(), 1);
+            parked.release();
+            released.acquire();
+        };
+        auto wait_parked = [&]() -> task<> {
+            parked.acquire();
+            before = service.statistics();
+            co_return;
+        };
+        auto read = [&](std::size_t i) -> task<> {
+            co_await file.read_at(i, std::span(buffer).subspan(i + 1, 1));
+        };
+        auto release = [&]() -> task<> {
+            released.release();
+            co_return;
+        };
+
+        // Started in this order on this thread, each runs until it suspends.
+        std::vector< task<> > tasks;
+        tasks.push_back(gate());
+        tasks.push_back(wait_parked());
+        for (std::size_t i = 0; i < reads; ++i) {
+            tasks.push_back(read(i));
+        }
+        tasks.push_back(release());
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+
+        // Nothing woke the completion thread in between, it fills the ring
+        // with queued reads on every io_uring_enter call.
+        auto after = service.statistics();
+        CHECK(after.operations - before.operations == reads);
+        CHECK(after.submissions - before.submissions <= reads / 100);
+        std::filesystem::remove(path);
+    }
+
+    TEST_CASE("resumes on the original scheduler") {
+        auto path = temp_file("gap-test-async-file-scheduler");
+        static_thread_pool pool{ 1 };
+
+        for_each_backend([&](io_service &service) {
+            auto file = async_file::open(path, file_mode::read_write, service);
+            sync_wait([&]() -> task<> {
+                co_await pool.schedule();
+                auto worker = std::this_thread::get_id();
+                co_await file.write_at(0, bytes("abc"));
+                CHECK(std::this_thread::get_id() == worker);
+            }());
+        });
+        std::filesystem::remove(path);
+    }
+
+    //
+    // A thousand small reads in flight at once, io_uring versus the blocking
+    // pool, run with --no-skip.
+    //
+    TEST_CASE("async_file read throughput" * doctest::skip()) {
+        constexpr int reads = 1'000;
+        constexpr std::size_t block = 4096;
+
+        auto path = temp_file("gap-test-async-file-bench");
+        {
+            io_service service{ io_backend::blocking };
+            auto file = async_file::open(path, file_mode::write, service);
+            std::vector< std::byte > data(reads * block, std::byte{ 1 });
+            sync_wait(file.write_at(0, data));
+        }
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        for_each_backend([&](io_service &service) {
+            auto file = async_file::open(path, file_mode::read, service);
+            std::vector< std::vector< std::byte > > buffers(reads, std::vector< std::byte >(block));
+
+            std::vector< double > times;
+            for (int round = 0; round < 10; ++round) {
+                times.push_back(measure_us([&] {
+                    std::vector< task< std::size_t > > tasks;
+                    for (int i = 0; i < reads; ++i) {
+                        tasks.push_back(file.read_at(std::uint64_t(i) * block, buffers[std::size_t(i)]));
+                    }
+                    sync_wait(when_all_ready_vec(std::move(tasks)));
+                }));
+            }
+
+            auto stats = service.statistics();
+            MESSAGE(
+                (service.uses_io_uring() ? "io_uring" : "blocking pool") << ": mean "
+                << bench::mean(times) << " us per " << reads << " reads, "
+                << stats.submissions << " io_uring_enter calls for " << stats.operations
+                << " operations"
+            );
+        });
+        std::filesystem::remove(path);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
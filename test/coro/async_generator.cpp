@@ -0,0 +1,270 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/test/async_generator_tests.cpp
+// from the cppcoro project. The original file is licenced under the MIT
+// license and the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_generator.hpp>
+    #include <gap/coro/single_consumer_event.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <cstdint>
+    #include <stdexcept>
+    #include <string>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_generator");
+
+    TEST_CASE("default-constructed async_generator is an empty sequence") {
+        sync_wait([]() -> task<> {
+            async_generator< int > gen;
+            auto it = co_await gen.begin();
+            CHECK(it == gen.end());
+        }());
+    }
+
+    TEST_CASE("async_generator doesn't start until begin is awaited") {
+        bool started = false;
+        auto make = [&]() -> async_generator< int > {
+            started = true;
+            co_return;
+        };
+
+        sync_wait([&]() -> task<> {
+            auto gen = make();
+            CHECK(!started);
+            auto it = co_await gen.begin();
+            CHECK(started);
+            CHECK(it == gen.end());
+        }());
+    }
+
+    TEST_CASE("enumerate sequence of values produced synchronously") {
+        auto make = []() -> async_generator< std::uint32_t > {
+            for (std::uint32_t i = 0; i < 5; ++i) {
+                co_yield i;
+            }
+        };
+
+        sync_wait([&]() -> task<> {
+            std::uint32_t expected = 0;
+            auto gen = make();
+            for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) {
+                CHECK(*it == expected++);
+            }
+            CHECK(expected == 5);
+        }());
+    }
+
+    TEST_CASE("yield lvalues and access members through the iterator") {
+        auto make = []() -> async_generator< std::string > {
+            std::string value = "abc";
+            co_yield value;
+            value += "def";
+            co_yield value;
+        };
+
+        sync_wait([&]() -> task<> {
+            auto gen = make();
+            auto it = co_await gen.begin();
+            CHECK(*it == "abc");
+            CHECK(it->size() == 3);
+            co_await ++it;
+            CHECK(*it == "abcdef");
+            co_await ++it;
+            CHECK(it == gen.end());
+        }());
+    }
+
+    TEST_CASE("long synchronous sequence doesn't overflow the stack") {
+        auto make = []() -> async_generator< int > {
+            for (int i = 0; i < 1'000'000; ++i) {
+                co_yield i;
+            }
+        };
+
+        auto sum = sync_wait([&]() -> task< long long > {
+            long long total = 0;
+            auto gen = make();
+            for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) {
+                total += *it;
+            }
+            co_return total;
+        }());
+
+        CHECK(sum == 999'999LL * 1'000'000LL / 2);
+    }
+
+    TEST_CASE("producer awaits an event between values") {
+        single_consumer_event p1;
+        single_consumer_event p2;
+        single_consumer_event p3;
+        single_consumer_event c1;
+
+        auto make = [&]() -> async_generator< std::uint32_t > {
+            co_await p1;
+            co_yield 1;
+            co_await p2;
+            co_yield 2;
+            co_await p3;
+        };
+
+        bool consumer_finished = false;
+
+        auto consumer = [&]() -> task<> {
+            auto gen = make();
+            auto it = co_await gen.begin();
+            CHECK(*it == 1u);
+            co_await ++it;
+            CHECK(*it == 2u);
+            co_await c1;
+            co_await ++it;
+            CHECK(it == gen.end());
+            consumer_finished = true;
+        };
+
+        auto unblocker = [&]() -> task<> {
+            CHECK(!consumer_finished);
+            p1.set();
+            p2.set();
+            p3.set();
+            CHECK(!consumer_finished);
+            c1.set();
+            CHECK(consumer_finished);
+            co_return;
+        };
+
+        sync_wait(when_all_ready(consumer(), unblocker()));
+    }
+
+    TEST_CASE("consumer stops early and destroys the suspended producer") {
+        bool destroyed = false;
+
+        auto make = [&]() -> async_generator< int > {
+            struct set_on_exit
+            {
+                bool &value;
+                ~set_on_exit() { value = true; }
+            } guard{ destroyed };
+
+            for (int i = 0;; ++i) {
+                co_yield i;
+            }
+        };
+
+        sync_wait([&]() -> task<> {
+            auto gen = make();
+            for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) {
+                if (*it == 10) {
+                    break;
+                }
+            }
+            CHECK(!destroyed);
+        }());
+
+        CHECK(destroyed);
+    }
+
+    TEST_CASE("exception thrown before the first yield is rethrown from begin") {
+        auto make = []() -> async_generator< int > {
+            throw std::runtime_error("producer failed");
+            co_return;
+        };
+
+        sync_wait([&]() -> task<> {
+            auto gen = make();
+            CHECK_THROWS_AS(co_await gen.begin(), const std::runtime_error&);
+        }());
+    }
+
+    TEST_CASE("exception thrown after a yield is rethrown from increment") {
+        auto make = []() -> async_generator< int > {
+            co_yield 1;
+            throw std::runtime_error("producer failed");
+        };
+
+        sync_wait([&]() -> task<> {
+            auto gen = make();
+            auto it = co_await gen.begin();
+            CHECK(*it == 1);
+
+            bool caught = false;
+            try {
+                co_await ++it;
+            } catch (const std::runtime_error&) {
+                caught = true;
+            }
+
+            CHECK(caught);
+            CHECK(it == gen.end());
+        }());
+    }
+
+    TEST_CASE("moved-from async_generator is empty") {
+        auto make = []() -> async_generator< int > {
+            co_yield 1;
+            co_yield 2;
+        };
+
+        sync_wait([&]() -> task<> {
+            auto gen = make();
+            auto other = std::move(gen);
+
+            auto empty = co_await gen.begin();
+            CHECK(empty == gen.end());
+
+            std::vector< int > values;
+            for (auto it = co_await other.begin(); it != other.end(); co_await ++it) {
+                values.push_back(*it);
+            }
+            CHECK(values == std::vector< int >{ 1, 2 });
+        }());
+    }
+
+    TEST_CASE("stream values from a thread pool producer") {
+        static_thread_pool pool{ 2 };
+        auto main_thread = std::this_thread::get_id();
+
+        auto make = [&]() -> async_generator< std::thread::id > {
+            for (int i = 0; i < 1000; ++i) {
+                // Every value is computed on a pool thread, racing with the
+                // consumer suspending for it.
+                co_await pool.schedule();
+                co_yield std::this_thread::get_id();
+            }
+        };
+
+        auto count = sync_wait([&]() -> task< int > {
+            int received = 0;
+            auto gen = make();
+            for (auto it = co_await gen.begin(); it != gen.end(); co_await ++it) {
+                CHECK(*it != main_thread);
+                ++received;
+            }
+            co_return received;
+        }());
+
+        CHECK(count == 1000);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
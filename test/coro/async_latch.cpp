@@ -0,0 +1,144 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/test/async_latch_tests.cpp from
+// the cppcoro project. The original file is licenced under the MIT license and
+// the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_latch.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_latch");
+
+    TEST_CASE("latch constructed with zero count is ready") {
+        async_latch latch{ 0 };
+        CHECK(latch.is_ready());
+    }
+
+    TEST_CASE("latch constructed with negative count is ready") {
+        async_latch latch{ -3 };
+        CHECK(latch.is_ready());
+    }
+
+    TEST_CASE("count_down and is_ready") {
+        async_latch latch{ 3 };
+        CHECK(!latch.is_ready());
+        latch.count_down();
+        CHECK(!latch.is_ready());
+        latch.count_down();
+        CHECK(!latch.is_ready());
+        latch.count_down();
+        CHECK(latch.is_ready());
+    }
+
+    TEST_CASE("count_down by n") {
+        async_latch latch{ 5 };
+        latch.count_down(3);
+        CHECK(!latch.is_ready());
+        latch.count_down(2);
+        CHECK(latch.is_ready());
+    }
+
+    TEST_CASE("single awaiter") {
+        async_latch latch{ 2 };
+        bool after = false;
+
+        sync_wait(when_all_ready(
+            [&]() -> task<> {
+                co_await latch;
+                after = true;
+            }(),
+            [&]() -> task<> {
+                CHECK(!after);
+                latch.count_down();
+                CHECK(!after);
+                latch.count_down();
+                CHECK(after);
+                co_return;
+            }()
+        ));
+    }
+
+    TEST_CASE("multiple awaiters") {
+        async_latch latch{ 2 };
+        bool after1 = false;
+        bool after2 = false;
+        bool after3 = false;
+
+        sync_wait(when_all_ready(
+            [&]() -> task<> {
+                co_await latch;
+                after1 = true;
+            }(),
+            [&]() -> task<> {
+                co_await latch;
+                after2 = true;
+            }(),
+            [&]() -> task<> {
+                co_await latch;
+                after3 = true;
+            }(),
+            [&]() -> task<> {
+                CHECK(!after1);
+                CHECK(!after2);
+                CHECK(!after3);
+                latch.count_down();
+                CHECK(!after1);
+                latch.count_down();
+                CHECK(after1);
+                CHECK(after2);
+                CHECK(after3);
+                co_return;
+            }()
+        ));
+    }
+
+    TEST_CASE("workers on a thread pool count down") {
+        static_thread_pool pool{ 4 };
+
+        constexpr int workers = 64;
+        async_latch latch{ workers };
+        std::atomic< int > done = 0;
+
+        auto worker = [&]() -> task<> {
+            co_await pool.schedule();
+            ++done;
+            latch.count_down();
+        };
+
+        auto waiter = [&]() -> task< int > {
+            co_await latch;
+            co_return done.load();
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < workers; ++i) {
+            tasks.push_back(worker());
+        }
+
+        auto [result, finished] = sync_wait(when_all_ready(waiter(), when_all_ready_vec(std::move(tasks))));
+        CHECK(result.result() == workers);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
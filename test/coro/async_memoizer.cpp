@@ -0,0 +1,196 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_manual_reset_event.hpp>
+    #include <gap/coro/async_memoizer.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <stdexcept>
+    #include <string>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_memoizer");
+
+    TEST_CASE("completed results are reused") {
+        int calls = 0;
+        auto square = async_memoize< int >([&](int v) -> task< int > {
+            ++calls;
+            co_return v * v;
+        });
+
+        CHECK(sync_wait(square(3)) == 9);
+        CHECK(sync_wait(square(3)) == 9);
+        CHECK(sync_wait(square(4)) == 16);
+        CHECK(calls == 2);
+        CHECK(square.cached(3));
+        CHECK(!square.cached(5));
+        CHECK(square.size() == 2);
+
+        auto stats = square.statistics();
+        CHECK(stats.misses == 2);
+        CHECK(stats.hits == 1);
+        CHECK(stats.joins == 0);
+    }
+
+    TEST_CASE("concurrent callers join the computation in flight") {
+        async_manual_reset_event release;
+        int calls = 0;
+
+        auto memo = async_memoize< std::string >([&](const std::string &key) -> task< std::string > {
+            ++calls;
+            co_await release;
+            co_return key + "!";
+        });
+
+        std::vector< std::string > results;
+        auto caller = [&]() -> task<> {
+            results.push_back(co_await memo("summary"));
+        };
+
+        auto releaser = [&]() -> task<> {
+            release.set();
+            co_return;
+        };
+
+        sync_wait(when_all_ready(caller(), caller(), caller(), caller(), releaser()));
+
+        CHECK(calls == 1);
+        CHECK(results == std::vector< std::string >(4, "summary!"));
+
+        auto stats = memo.statistics();
+        CHECK(stats.misses == 1);
+        CHECK(stats.joins == 3);
+        CHECK(stats.hits == 0);
+    }
+
+    TEST_CASE("failed computations are retried") {
+        int calls = 0;
+        auto memo = async_memoize< int >([&](int v) -> task< int > {
+            if (++calls == 1) {
+                throw std::runtime_error("failed");
+            }
+            co_return v;
+        });
+
+        CHECK_THROWS_AS(sync_wait(memo(1)), std::runtime_error);
+        CHECK(!memo.cached(1));
+        CHECK(sync_wait(memo(1)) == 1);
+        CHECK(calls == 2);
+    }
+
+    TEST_CASE("void computations") {
+        int calls = 0;
+        auto memo = async_memoize< int >([&](int) -> task<> {
+            ++calls;
+            co_return;
+        });
+
+        sync_wait(memo(1));
+        sync_wait(memo(1));
+        CHECK(calls == 1);
+    }
+
+    TEST_CASE("explicit eviction") {
+        int calls = 0;
+        auto memo = async_memoize< int >([&](int v) -> task< int > {
+            ++calls;
+            co_return v;
+        });
+
+        sync_wait(memo(1));
+        sync_wait(memo(2));
+        auto pending = memo(3);
+
+        CHECK(memo.evict(1));
+        CHECK(!memo.evict(1));
+        CHECK(memo.evict_completed() == 1);
+        CHECK(memo.size() == 1);
+        CHECK(memo.cached(3));
+
+        CHECK(sync_wait(pending) == 3);
+        CHECK(sync_wait(memo(1)) == 1);
+        CHECK(calls == 4);
+    }
+
+    TEST_CASE("capacity evicts completed entries only") {
+        async_manual_reset_event release;
+        auto memo = async_memoize< int >(
+            [&](int v) -> task< int > {
+                if (v < 0) {
+                    co_await release;
+                }
+                co_return v;
+            },
+            8, 1
+        );
+
+        // Not completed, so kept however full the shard gets.
+        auto pending = memo(-1);
+        for (int i = 0; i < 7; ++i) {
+            sync_wait(memo(i));
+        }
+        CHECK(memo.size() == 8);
+
+        sync_wait(memo(100));
+        CHECK(memo.size() <= 5);
+        CHECK(memo.cached(-1));
+        CHECK(memo.cached(100));
+        CHECK(memo.statistics().evictions >= 4);
+
+        release.set();
+        CHECK(sync_wait(pending) == -1);
+    }
+
+    TEST_CASE("each key is computed once under contention") {
+        static_thread_pool pool{ 4 };
+        constexpr int keys = 64;
+
+        std::vector< std::atomic< int > > calls(keys);
+        auto memo = async_memoize< int >([&](int key) -> task< int > {
+            calls[std::size_t(key)].fetch_add(1, std::memory_order_relaxed);
+            co_await pool.schedule();
+            co_return key * 2;
+        });
+
+        std::atomic< int > wrong = 0;
+        auto worker = [&](int seed) -> task<> {
+            for (int i = 0; i < 500; ++i) {
+                co_await pool.schedule();
+                int key = (seed * 31 + i * 17) % keys;
+                if (co_await memo(key) != key * 2) {
+                    wrong.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < 16; ++i) {
+            tasks.push_back(worker(i));
+        }
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+
+        CHECK(wrong == 0);
+        for (auto &count : calls) {
+            CHECK(count.load() == 1);
+        }
+
+        auto stats = memo.statistics();
+        CHECK(stats.misses == keys);
+        CHECK(stats.hits + stats.joins + stats.misses == 16 * 500);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
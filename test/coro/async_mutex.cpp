@@ -0,0 +1,145 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/test/async_mutex_tests.cpp from
+// the cppcoro project. The original file is licenced under the MIT license and
+// the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_manual_reset_event.hpp>
+    #include <gap/coro/async_mutex.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_mutex");
+
+    TEST_CASE("try_lock") {
+        async_mutex mutex;
+
+        CHECK(mutex.try_lock());
+        CHECK_FALSE(mutex.try_lock());
+
+        mutex.unlock();
+
+        CHECK(mutex.try_lock());
+        mutex.unlock();
+    }
+
+    TEST_CASE("multiple lockers") {
+        int value = 0;
+        async_mutex mutex;
+        async_manual_reset_event a;
+        async_manual_reset_event b;
+        async_manual_reset_event c;
+        async_manual_reset_event d;
+
+        auto f = [&](async_manual_reset_event &e) -> task<> {
+            auto lock = co_await mutex.scoped_lock_async();
+            co_await e;
+            ++value;
+        };
+
+        auto check = [&]() -> task<> {
+            CHECK(value == 0);
+
+            a.set();
+
+            CHECK(value == 1);
+
+            // Waiters are resumed in the order they queued, not in the
+            // order their events are set.
+            c.set();
+
+            CHECK(value == 1);
+
+            b.set();
+
+            CHECK(value == 3);
+
+            d.set();
+
+            CHECK(value == 4);
+
+            co_return;
+        };
+
+        sync_wait(when_all_ready(f(a), f(b), f(c), f(d), check()));
+
+        CHECK(value == 4);
+    }
+
+    TEST_CASE("lock_async with manual unlock") {
+        async_mutex mutex;
+        async_manual_reset_event event;
+
+        std::vector< int > order;
+
+        auto holder = [&]() -> task<> {
+            co_await mutex.lock_async();
+            order.push_back(0);
+            co_await event;
+            mutex.unlock();
+        };
+
+        auto waiter = [&](int id) -> task<> {
+            co_await mutex.lock_async();
+            order.push_back(id);
+            mutex.unlock();
+        };
+
+        auto release = [&]() -> task<> {
+            event.set();
+            co_return;
+        };
+
+        sync_wait(when_all_ready(holder(), waiter(1), waiter(2), waiter(3), release()));
+
+        CHECK(order == std::vector< int >{ 0, 1, 2, 3 });
+        CHECK(mutex.try_lock());
+        mutex.unlock();
+    }
+
+    TEST_CASE("contended increments on a thread pool") {
+        static_thread_pool pool{ 4 };
+        async_mutex mutex;
+
+        // Deliberately not atomic, the mutex has to provide the ordering.
+        std::uint64_t counter = 0;
+
+        auto worker = [&]() -> task<> {
+            for (int i = 0; i < 1000; ++i) {
+                co_await pool.schedule();
+                auto lock = co_await mutex.scoped_lock_async();
+                ++counter;
+            }
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < 16; ++i) {
+            tasks.push_back(worker());
+        }
+
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+
+        CHECK(counter == 16'000u);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
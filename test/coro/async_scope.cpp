@@ -0,0 +1,152 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_manual_reset_event.hpp>
+    #include <gap/coro/async_scope.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+
+    #include <atomic>
+    #include <memory>
+    #include <stdexcept>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_scope");
+
+    TEST_CASE("joining an empty scope completes immediately") {
+        async_scope scope;
+        CHECK(scope.outstanding() == 0);
+        sync_wait([&]() -> task<> { co_await scope.join(); }());
+    }
+
+    TEST_CASE("join waits for all spawned work") {
+        async_manual_reset_event event;
+        int finished = 0;
+
+        auto work = [&]() -> task<> {
+            co_await event;
+            ++finished;
+        };
+
+        async_scope scope;
+        bool joined = false;
+        sync_wait([&]() -> task<> {
+            for (int i = 0; i < 3; ++i) {
+                scope.spawn(work());
+            }
+            CHECK(scope.outstanding() == 3);
+
+            scope.spawn([&]() -> task<> {
+                CHECK(!joined);
+                event.set();
+                co_return;
+            }());
+
+            co_await scope.join();
+            joined = true;
+        }());
+
+        CHECK(joined);
+        CHECK(finished == 3);
+        CHECK(scope.outstanding() == 0);
+    }
+
+    TEST_CASE("finished work is freed before the join") {
+        std::vector< std::unique_ptr< async_manual_reset_event > > events;
+        auto alive = std::make_shared< int >(0);
+
+        auto work = [](async_manual_reset_event &event, std::shared_ptr< int > keep) -> task<> {
+            co_await event;
+            (void) keep;
+        };
+
+        async_scope scope;
+        for (int i = 0; i < 4; ++i) {
+            events.push_back(std::make_unique< async_manual_reset_event >());
+            scope.spawn(work(*events.back(), alive));
+        }
+        CHECK(alive.use_count() == 5);
+
+        events[0]->set();
+        events[2]->set();
+        CHECK(alive.use_count() == 3);
+        CHECK(scope.outstanding() == 2);
+
+        events[1]->set();
+        events[3]->set();
+        CHECK(alive.use_count() == 1);
+
+        sync_wait([&]() -> task<> { co_await scope.join(); }());
+    }
+
+    TEST_CASE("spawned work can spawn more work") {
+        async_scope scope;
+        int runs = 0;
+
+        auto leaf = [&]() -> task<> {
+            ++runs;
+            co_return;
+        };
+
+        auto branch = [&]() -> task<> {
+            scope.spawn(leaf());
+            scope.spawn(leaf());
+            co_return;
+        };
+
+        sync_wait([&]() -> task<> {
+            scope.spawn(branch());
+            co_await scope.join();
+        }());
+        CHECK(runs == 2);
+    }
+
+    TEST_CASE("the first exception is rethrown by join") {
+        async_scope scope;
+        int finished = 0;
+
+        scope.spawn([]() -> task<> {
+            throw std::runtime_error("failed");
+            co_return;
+        }());
+        scope.spawn([&]() -> task<> {
+            ++finished;
+            co_return;
+        }());
+
+        CHECK_THROWS_AS(sync_wait([&]() -> task<> { co_await scope.join(); }()), std::runtime_error);
+        CHECK(finished == 1);
+    }
+
+    TEST_CASE("spawning onto a thread pool") {
+        static_thread_pool pool{ 4 };
+        std::atomic< int > counter = 0;
+
+        auto work = [&]() -> task<> {
+            co_await pool.schedule();
+            counter.fetch_add(1, std::memory_order_relaxed);
+        };
+
+        async_scope scope;
+        sync_wait([&]() -> task<> {
+            for (int i = 0; i < 10'000; ++i) {
+                scope.spawn(work());
+            }
+            co_await scope.join();
+        }());
+
+        CHECK(counter == 10'000);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
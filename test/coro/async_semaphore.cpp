@@ -0,0 +1,239 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_manual_reset_event.hpp>
+    #include <gap/coro/async_semaphore.hpp>
+    #include <gap/coro/bounded_when_all.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <stdexcept>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_semaphore");
+
+    TEST_CASE("try_acquire and release") {
+        async_semaphore semaphore{ 2 };
+
+        CHECK(semaphore.try_acquire());
+        CHECK(semaphore.try_acquire());
+        CHECK_FALSE(semaphore.try_acquire());
+
+        semaphore.release();
+        CHECK(semaphore.available() == 1);
+        CHECK(semaphore.try_acquire());
+
+        semaphore.release(2);
+        CHECK(semaphore.available() == 2);
+    }
+
+    TEST_CASE("waiters are resumed in FIFO order") {
+        async_semaphore semaphore{ 0 };
+        std::vector< int > order;
+
+        auto waiter = [&](int id) -> task<> {
+            co_await semaphore.acquire();
+            order.push_back(id);
+        };
+
+        auto release = [&]() -> task<> {
+            CHECK(order.empty());
+            CHECK(semaphore.available() == -3);
+
+            semaphore.release();
+            CHECK(order == std::vector< int >{ 1 });
+
+            semaphore.release(2);
+            CHECK(order == std::vector< int >{ 1, 2, 3 });
+            co_return;
+        };
+
+        sync_wait(when_all_ready(waiter(1), waiter(2), waiter(3), release()));
+
+        CHECK(semaphore.available() == 0);
+    }
+
+    TEST_CASE("release of more permits than waiters") {
+        async_semaphore semaphore{ 0 };
+        bool acquired = false;
+
+        auto waiter = [&]() -> task<> {
+            co_await semaphore.acquire();
+            acquired = true;
+        };
+
+        auto release = [&]() -> task<> {
+            semaphore.release(3);
+            co_return;
+        };
+
+        sync_wait(when_all_ready(waiter(), release()));
+
+        CHECK(acquired);
+        CHECK(semaphore.available() == 2);
+    }
+
+    TEST_CASE("limits concurrency on a thread pool") {
+        static_thread_pool pool{ 4 };
+        async_semaphore semaphore{ 3 };
+
+        std::atomic< int > in_flight = 0;
+        std::atomic< int > peak      = 0;
+
+        auto worker = [&]() -> task<> {
+            co_await pool.schedule();
+            co_await semaphore.acquire();
+
+            auto now = in_flight.fetch_add(1) + 1;
+            auto seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+
+            co_await pool.schedule();
+
+            in_flight.fetch_sub(1);
+            semaphore.release();
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < 500; ++i) {
+            tasks.push_back(worker());
+        }
+
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+
+        CHECK(peak.load() <= 3);
+        CHECK(semaphore.available() == 3);
+    }
+
+    TEST_CASE("bounded_when_all caps the number of started tasks") {
+        async_manual_reset_event event;
+        int started = 0;
+        int finished = 0;
+
+        auto make_task = [&](int value) -> task< int > {
+            ++started;
+            co_await event;
+            ++finished;
+            co_return value * 2;
+        };
+
+        std::vector< task< int > > tasks;
+        for (int i = 0; i < 10; ++i) {
+            tasks.push_back(make_task(i));
+        }
+
+        auto check = [&]() -> task<> {
+            CHECK(started == 4);
+            CHECK(finished == 0);
+            event.set();
+            CHECK(finished == 10);
+            co_return;
+        };
+
+        auto [results, unused] = sync_wait(
+            when_all_ready(bounded_when_all(std::move(tasks), 4), check())
+        );
+
+        auto values = std::move(results).result();
+        REQUIRE(values.size() == 10u);
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            CHECK(values[i].result() == static_cast< int >(i) * 2);
+        }
+    }
+
+    TEST_CASE("bounded_when_all with a long run of synchronous tasks") {
+        // Every finishing task hands its slot to the next one, which must
+        // not nest a stack frame per task.
+        constexpr int count = 200'000;
+        async_manual_reset_event event;
+
+        auto make_task = [&](int value) -> task< int > {
+            if (value == 0) {
+                co_await event;
+            }
+            co_return value;
+        };
+
+        std::vector< task< int > > tasks;
+        for (int i = 0; i < count; ++i) {
+            tasks.push_back(make_task(i));
+        }
+
+        auto open = [&]() -> task<> {
+            event.set();
+            co_return;
+        };
+
+        auto [results, unused] = sync_wait(
+            when_all_ready(bounded_when_all(std::move(tasks), 1), open())
+        );
+
+        auto values = std::move(results).result();
+        REQUIRE(values.size() == std::size_t(count));
+        CHECK(values.back().result() == count - 1);
+    }
+
+    TEST_CASE("bounded_when_all on a thread pool") {
+        static_thread_pool pool{ 4 };
+
+        std::atomic< int > in_flight = 0;
+        std::atomic< int > peak      = 0;
+
+        auto make_task = [&]() -> task<> {
+            co_await pool.schedule();
+
+            auto now = in_flight.fetch_add(1) + 1;
+            auto seen = peak.load();
+            while (now > seen && !peak.compare_exchange_weak(seen, now)) {}
+
+            co_await pool.schedule();
+            in_flight.fetch_sub(1);
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < 1000; ++i) {
+            tasks.push_back(make_task());
+        }
+
+        auto results = sync_wait(bounded_when_all(std::move(tasks), 8));
+
+        CHECK(results.size() == 1000u);
+        CHECK(peak.load() <= 8);
+    }
+
+    TEST_CASE("bounded_when_all releases the slot on exceptions") {
+        auto make_task = [](int value) -> task< int > {
+            if (value % 2) {
+                throw std::runtime_error("odd");
+            }
+            co_return value;
+        };
+
+        std::vector< task< int > > tasks;
+        for (int i = 0; i < 6; ++i) {
+            tasks.push_back(make_task(i));
+        }
+
+        auto results = sync_wait(bounded_when_all(std::move(tasks), 1));
+
+        REQUIRE(results.size() == 6u);
+        CHECK(results[0].result() == 0);
+        CHECK_THROWS_AS(results[1].result(), const std::runtime_error&);
+        CHECK(results[4].result() == 4);
+        CHECK_THROWS_AS(results[5].result(), const std::runtime_error&);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
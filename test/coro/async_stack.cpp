@@ -0,0 +1,170 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_manual_reset_event.hpp>
+    #include <gap/coro/async_stack.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <algorithm>
+    #include <chrono>
+    #include <sstream>
+    #include <string_view>
+    #include <type_traits>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("async_stack");
+
+    using namespace std::chrono_literals;
+
+    static void burn(std::chrono::nanoseconds time) {
+        auto until = std::chrono::steady_clock::now() + time;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+
+    static task< std::vector< async_stack > > innermost() { co_return capture_async_stacks(); }
+
+    static task< std::vector< async_stack > > middle() { co_return co_await innermost(); }
+
+    static task< std::vector< async_stack > > outermost() { co_return co_await middle(); }
+
+    static task<> hot_task() {
+        burn(5ms);
+        co_return;
+    }
+
+    static const task_profile *find_profile(
+        const std::vector< task_profile > &profiles, std::string_view function
+    ) {
+        auto it = std::find_if(profiles.begin(), profiles.end(), [&](const auto &profile) {
+            return profile.location.function() == function;
+        });
+        return it == profiles.end() ? nullptr : &*it;
+    }
+
+#if GAP_CORO_ASYNC_STACKS
+
+    static_assert(std::is_base_of_v< detail::async_frame, detail::task_promise< void > >);
+
+    static task<> waiter(async_manual_reset_event &event) { co_await event; }
+
+    static task<> waiting_root(async_manual_reset_event &event) { co_await waiter(event); }
+
+    static task<> hop(static_thread_pool &pool) {
+        for (int i = 0; i < 3; ++i) {
+            co_await pool.schedule();
+            burn(1ms);
+        }
+    }
+
+    static task<> cold_task() { co_return; }
+
+    TEST_CASE("captures the chain of awaiting tasks") {
+        auto stacks = sync_wait(outermost());
+
+        auto stack = std::find_if(stacks.begin(), stacks.end(), [](const auto &s) {
+            return !s.empty() && s.front().location.function() == "innermost";
+        });
+        REQUIRE(stack != stacks.end());
+        REQUIRE(stack->size() == 3);
+
+        CHECK((*stack)[0].state == task_state::running);
+        CHECK((*stack)[1].location.function() == "middle");
+        CHECK((*stack)[1].state == task_state::suspended);
+        CHECK((*stack)[2].location.function() == "outermost");
+        CHECK((*stack)[2].state == task_state::suspended);
+        CHECK((*stack)[0].location.file().ends_with("async_stack.cpp"));
+    }
+
+    TEST_CASE("dumps suspended tasks") {
+        async_manual_reset_event event;
+        std::ostringstream dump;
+
+        sync_wait(when_all_ready(waiting_root(event), [&]() -> task<> {
+            dump_async_stacks(dump);
+            event.set();
+            co_return;
+        }()));
+
+        auto text = dump.str();
+        auto leaf = text.find("waiter");
+        auto root = text.find("waiting_root");
+        REQUIRE(leaf != std::string::npos);
+        REQUIRE(root != std::string::npos);
+        CHECK(leaf < root);
+        CHECK(text.find("suspended") != std::string::npos);
+        CHECK(capture_async_stacks().empty());
+    }
+
+    TEST_CASE("counts suspends and running time") {
+        static_thread_pool pool{ 2 };
+        reset_task_profiles();
+
+        sync_wait(hop(pool));
+
+        auto profiles = hottest_tasks(100);
+        auto *profile = find_profile(profiles, "hop");
+        REQUIRE(profile);
+        CHECK(profile->tasks == 1);
+        CHECK(profile->suspends == 3);
+        CHECK(profile->running_time >= 3ms);
+    }
+
+    TEST_CASE("reports the hottest tasks first") {
+        reset_task_profiles();
+
+        sync_wait([]() -> task<> {
+            for (int i = 0; i < 10; ++i) {
+                co_await cold_task();
+            }
+            co_await hot_task();
+        }());
+
+        auto profiles = hottest_tasks(2);
+        REQUIRE(!profiles.empty());
+        CHECK(profiles.front().location.function() == "hot_task");
+
+        auto all  = hottest_tasks(100);
+        auto *hot = find_profile(all, "hot_task");
+        auto *cold = find_profile(all, "cold_task");
+        REQUIRE(hot);
+        REQUIRE(cold);
+        CHECK(cold->tasks == 10);
+        CHECK(hot->running_time > cold->running_time);
+
+        std::ostringstream dump;
+        dump_hottest_tasks(dump, 1);
+        CHECK(dump.str().find("hot_task") != std::string::npos);
+        CHECK(dump.str().find("cold_task") == std::string::npos);
+    }
+
+#else
+
+    static_assert(!std::is_base_of_v< detail::async_frame, detail::task_promise< void > >);
+
+    TEST_CASE("compiles away when disabled") {
+        reset_task_profiles();
+
+        auto stacks = sync_wait(outermost());
+        CHECK(stacks.empty());
+
+        sync_wait(hot_task());
+        CHECK(find_profile(hottest_tasks(), "hot_task") == nullptr);
+    }
+
+#endif
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
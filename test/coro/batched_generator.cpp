@@ -0,0 +1,264 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/batched_generator.hpp>
+    #include <gap/coro/generator.hpp>
+
+    #include <array>
+    #include <chrono>
+    #include <cmath>
+    #include <cstdint>
+    #include <memory>
+    #include <numeric>
+    #include <ranges>
+    #include <span>
+    #include <stdexcept>
+    #include <string>
+    #include <vector>
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("batched_generator");
+
+    static_assert(std::ranges::input_range< batched_generator< int > >);
+
+    static batched_generator< int, 4 > count_to(int count) {
+        for (int i = 0; i < count; ++i) {
+            co_yield i;
+        }
+    }
+
+    TEST_CASE("yields every element in order") {
+        for (int count : { 0, 1, 3, 4, 5, 8, 9, 100 }) {
+            std::vector< int > values;
+            for (int v : count_to(count)) {
+                values.push_back(v);
+            }
+
+            std::vector< int > expected(std::size_t(count), 0);
+            std::iota(expected.begin(), expected.end(), 0);
+            CHECK(values == expected);
+        }
+    }
+
+    TEST_CASE("batches fill up to the batch size") {
+        std::vector< std::size_t > sizes;
+        auto gen = count_to(10);
+        for (auto batch : gen.batches()) {
+            sizes.push_back(batch.size());
+        }
+        CHECK(sizes == std::vector< std::size_t >{ 4, 4, 2 });
+    }
+
+    TEST_CASE("resumes the producer once per batch") {
+        int resumes = 0;
+        auto gen = [&]() -> batched_generator< int, 16 > {
+            for (int i = 0; i < 64; ++i) {
+                ++resumes;
+                co_yield i;
+                --resumes;
+            }
+        };
+
+        // Only the element that fills a batch suspends, the rest of the
+        // batch is produced without leaving the coroutine.
+        int seen = 0;
+        for (int v : gen()) {
+            CHECK(v == seen++);
+            CHECK(resumes == 1);
+        }
+        CHECK(seen == 64);
+    }
+
+    TEST_CASE("spans are handed out after buffered elements") {
+        auto gen = []() -> batched_generator< int, 8 > {
+            std::array< int, 3 > block{ 10, 11, 12 };
+            co_yield 1;
+            co_yield 2;
+            co_yield std::span< const int >(block);
+            co_yield 3;
+            co_yield std::span< int >(block);
+        };
+
+        std::vector< std::vector< int > > batches;
+        auto blocks = gen();
+        for (auto batch : blocks.batches()) {
+            batches.emplace_back(batch.begin(), batch.end());
+        }
+
+        CHECK(batches == std::vector< std::vector< int > >{
+            { 1, 2 }, { 10, 11, 12 }, { 3 }, { 10, 11, 12 }
+        });
+    }
+
+    TEST_CASE("empty spans are skipped") {
+        auto gen = []() -> batched_generator< int > {
+            co_yield std::span< const int >{};
+            co_yield 7;
+            co_yield std::span< const int >{};
+        };
+
+        std::vector< int > values;
+        for (int v : gen()) {
+            values.push_back(v);
+        }
+        CHECK(values == std::vector< int >{ 7 });
+    }
+
+    TEST_CASE("move-only and non-trivial elements") {
+        auto gen = []() -> batched_generator< std::unique_ptr< std::string >, 2 > {
+            for (int i = 0; i < 5; ++i) {
+                co_yield std::make_unique< std::string >(std::to_string(i));
+            }
+        };
+
+        std::string joined;
+        for (const auto &v : gen()) {
+            joined += *v;
+        }
+        CHECK(joined == "01234");
+    }
+
+    TEST_CASE("elements before a failure are delivered") {
+        auto gen = []() -> batched_generator< int, 4 > {
+            co_yield 1;
+            co_yield 2;
+            throw std::runtime_error("failed");
+        };
+
+        std::vector< int > values;
+        auto consume = [&] {
+            for (int v : gen()) {
+                values.push_back(v);
+            }
+        };
+
+        CHECK_THROWS_AS(consume(), std::runtime_error);
+        CHECK(values == std::vector< int >{ 1, 2 });
+    }
+
+    TEST_CASE("default constructed generator is empty") {
+        batched_generator< int > gen;
+        CHECK(gen.begin() == gen.end());
+        CHECK(gen.batches().begin() == gen.batches().end());
+    }
+
+    TEST_CASE("stopping early destroys the producer") {
+        auto alive = std::make_shared< int >(0);
+        std::weak_ptr< int > watch = alive;
+
+        {
+            auto gen = [](std::shared_ptr< int > keep) -> batched_generator< int, 4 > {
+                for (int i = 0;; ++i) {
+                    co_yield i + *keep;
+                }
+            }(std::move(alive));
+
+            for (int v : gen) {
+                if (v == 9) {
+                    break;
+                }
+            }
+            CHECK(!watch.expired());
+        }
+        CHECK(watch.expired());
+    }
+
+    //
+    // Per-element against batched iteration, run with --no-skip.
+    //
+    static generator< std::uint32_t > offsets(std::uint32_t count) {
+        for (std::uint32_t i = 0; i < count; ++i) {
+            co_yield i;
+        }
+    }
+
+    static batched_generator< std::uint32_t, 1024 > batched_offsets(std::uint32_t count) {
+        for (std::uint32_t i = 0; i < count; ++i) {
+            co_yield i;
+        }
+    }
+
+    static batched_generator< std::uint32_t, 1024 > span_offsets(std::uint32_t count) {
+        std::array< std::uint32_t, 1024 > block;
+        for (std::uint32_t base = 0; base < count; base += block.size()) {
+            auto size = std::min< std::uint32_t >(block.size(), count - base);
+            std::iota(block.begin(), block.begin() + size, base);
+            co_yield std::span< const std::uint32_t >(block.data(), size);
+        }
+    }
+
+    TEST_CASE("batched generator throughput" * doctest::skip()) {
+        constexpr std::uint32_t count = 1 << 24;
+        constexpr int samples         = 5;
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        std::vector< double > per_element, flat, batches, spans;
+        std::uint64_t expected = std::uint64_t(count) * (count - 1) / 2;
+
+        for (int s = 0; s < samples; ++s) {
+            std::uint64_t sum = 0;
+            per_element.push_back(measure_us([&] {
+                for (auto v : offsets(count)) {
+                    sum += v;
+                }
+            }));
+            CHECK(sum == expected);
+
+            sum = 0;
+            flat.push_back(measure_us([&] {
+                for (auto v : batched_offsets(count)) {
+                    sum += v;
+                }
+            }));
+            CHECK(sum == expected);
+
+            sum = 0;
+            batches.push_back(measure_us([&] {
+                auto gen = batched_offsets(count);
+                for (auto batch : gen.batches()) {
+                    for (auto v : batch) {
+                        sum += v;
+                    }
+                }
+            }));
+            CHECK(sum == expected);
+
+            sum = 0;
+            spans.push_back(measure_us([&] {
+                auto gen = span_offsets(count);
+                for (auto batch : gen.batches()) {
+                    for (auto v : batch) {
+                        sum += v;
+                    }
+                }
+            }));
+            CHECK(sum == expected);
+        }
+
+        auto report = [&](const char *name, const std::vector< double > &us) {
+            auto deviation = std::sqrt(bench::standard_deviation(us));
+            MESSAGE(name << ": " << bench::mean(us) << " us (+-" << deviation << ")");
+        };
+
+        MESSAGE("elements: " << count);
+        report("generator", per_element);
+        report("batched_generator, by element", flat);
+        report("batched_generator, by batch", batches);
+        report("batched_generator, yielding spans", spans);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
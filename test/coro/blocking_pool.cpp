@@ -0,0 +1,239 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/async_scope.hpp>
+    #include <gap/coro/blocking_pool.hpp>
+    #include <gap/coro/numa_thread_pool.hpp>
+    #include <gap/coro/priority_scheduler.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <chrono>
+    #include <stdexcept>
+    #include <string>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("blocking_pool");
+
+    TEST_CASE("run returns the result") {
+        blocking_pool blocking{ 2 };
+
+        CHECK(sync_wait(blocking.run([] { return std::string("lifted"); })) == "lifted");
+
+        int value = 1;
+        int &ref  = sync_wait(blocking.run([&]() -> int& { return value; }));
+        CHECK(&ref == &value);
+
+        bool called = false;
+        sync_wait(blocking.run([&] { called = true; }));
+        CHECK(called);
+    }
+
+    TEST_CASE("run rethrows exceptions") {
+        blocking_pool blocking{ 1 };
+        CHECK_THROWS_AS(
+            sync_wait(blocking.run([]() -> int { throw std::runtime_error("solver failed"); })),
+            std::runtime_error
+        );
+    }
+
+    TEST_CASE("run_blocking resumes on the original scheduler") {
+        static_thread_pool pool{ 1 };
+
+        sync_wait([&]() -> task<> {
+            co_await pool.schedule();
+            auto worker = std::this_thread::get_id();
+
+            auto blocking_thread = co_await run_blocking([] { return std::this_thread::get_id(); });
+            CHECK(blocking_thread != worker);
+            CHECK(std::this_thread::get_id() == worker);
+        }());
+    }
+
+    TEST_CASE("run_blocking resumes on an explicit scheduler") {
+        static_thread_pool pool{ 1 };
+        auto worker = sync_wait([&]() -> task< std::thread::id > {
+            co_await pool.schedule();
+            co_return std::this_thread::get_id();
+        }());
+
+        sync_wait([&]() -> task<> {
+            co_await run_blocking(pool, [] {});
+            CHECK(std::this_thread::get_id() == worker);
+        }());
+    }
+
+    TEST_CASE("run_blocking keeps the priority and the node") {
+        priority_scheduler sched{ 1 };
+        async_scope scope;
+        auto other = [&]() -> task<> { co_await sched.schedule(priority::low); };
+
+        sync_wait([&]() -> task<> {
+            co_await sched.schedule(priority::low);
+            co_await run_blocking([] {});
+
+            // Queued low priority work is only worth yielding for if the
+            // coroutine came back at low priority.
+            scope.spawn(other());
+            CHECK(!sched.yield().await_ready());
+            co_await scope.join();
+        }());
+
+        numa_thread_pool numa{
+            numa_topology::uniform(2, 1),
+            { .threads_per_node = 1, .pin_threads = false, .steal_across_nodes = false }
+        };
+        sync_wait([&]() -> task<> {
+            co_await numa.schedule_on(1);
+            co_await run_blocking([] {});
+            CHECK(numa.current_node() == 1u);
+        }());
+    }
+
+    TEST_CASE("blocking calls do not stall the compute workers") {
+        static_thread_pool pool{ 1 };
+        blocking_pool blocking{ 8 };
+
+        std::atomic< int > in_flight = 0;
+        std::atomic< int > max_in_flight = 0;
+        std::atomic< int > computed = 0;
+
+        auto blocking_call = [&]() -> task<> {
+            co_await pool.schedule();
+            co_await blocking.run([&] {
+                auto now = ++in_flight;
+                auto max = max_in_flight.load();
+                while (now > max && !max_in_flight.compare_exchange_weak(max, now)) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                --in_flight;
+            });
+        };
+
+        auto compute = [&]() -> task<> {
+            co_await pool.schedule();
+            ++computed;
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < 8; ++i) {
+            tasks.push_back(blocking_call());
+        }
+        for (int i = 0; i < 100; ++i) {
+            tasks.push_back(compute());
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        CHECK(computed == 100);
+        CHECK(max_in_flight > 1);
+        CHECK(elapsed < std::chrono::milliseconds(8 * 50));
+        CHECK(blocking.thread_count() <= 8);
+    }
+
+    TEST_CASE("idle threads exit") {
+        blocking_pool blocking{ 4, std::chrono::milliseconds(20) };
+
+        std::vector< task<> > tasks;
+        auto call = [&]() -> task<> {
+            co_await blocking.run([] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+        };
+        for (int i = 0; i < 16; ++i) {
+            tasks.push_back(call());
+        }
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+        CHECK(blocking.thread_count() <= 4);
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (blocking.thread_count() > 0 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        CHECK(blocking.thread_count() == 0);
+
+        // Grows again when needed.
+        CHECK(sync_wait(blocking.run([] { return 42; })) == 42);
+    }
+
+    //
+    // Compute throughput while half of the coroutines make blocking calls,
+    // made inline on the workers versus offloaded, run with --no-skip.
+    //
+    TEST_CASE("blocking offload throughput" * doctest::skip()) {
+        constexpr int blocking_calls = 64;
+        constexpr int compute_tasks  = 64;
+        constexpr auto call_time     = std::chrono::milliseconds(5);
+        constexpr auto slice         = std::chrono::microseconds(500);
+
+        auto spin = [](std::chrono::microseconds time) {
+            auto until = std::chrono::steady_clock::now() + time;
+            while (std::chrono::steady_clock::now() < until) {
+            }
+        };
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        static_thread_pool pool;
+
+        auto run = [&](bool offload) {
+            auto blocking_call = [&]() -> task<> {
+                co_await pool.schedule();
+                auto call = [&] { std::this_thread::sleep_for(call_time); };
+                if (offload) {
+                    co_await run_blocking(call);
+                } else {
+                    call();
+                }
+            };
+
+            auto compute = [&]() -> task<> {
+                co_await pool.schedule();
+                for (int i = 0; i < 10; ++i) {
+                    spin(slice);
+                    co_await pool.schedule();
+                }
+            };
+
+            std::vector< double > times;
+            for (int i = 0; i < 5; ++i) {
+                times.push_back(measure_us([&] {
+                    std::vector< task<> > tasks;
+                    for (int j = 0; j < blocking_calls; ++j) {
+                        tasks.push_back(blocking_call());
+                    }
+                    for (int j = 0; j < compute_tasks; ++j) {
+                        tasks.push_back(compute());
+                    }
+                    sync_wait(when_all_ready_vec(std::move(tasks)));
+                }));
+            }
+            return times;
+        };
+
+        MESSAGE("threads: " << pool.thread_count());
+        MESSAGE("blocking on the workers: " << bench::mean(run(false)) << " us");
+        MESSAGE("run_blocking: " << bench::mean(run(true)) << " us");
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
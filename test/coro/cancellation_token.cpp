@@ -0,0 +1,334 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/test/cancellation_token_tests.cpp
+// from the cppcoro project. The original file is licenced under the MIT
+// license and the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/cancellation_registration.hpp>
+    #include <gap/coro/cancellation_source.hpp>
+    #include <gap/coro/cancellation_token.hpp>
+    #include <gap/coro/operation_cancelled.hpp>
+    #include <gap/coro/single_consumer_event.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <memory>
+    #include <optional>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("cancellation_token");
+
+    TEST_CASE("default cancellation_token is not cancellable") {
+        cancellation_token token;
+        CHECK(!token.is_cancellation_requested());
+        CHECK(!token.can_be_cancelled());
+    }
+
+    TEST_CASE("calling request_cancellation on cancellation_source updates cancellation_token") {
+        cancellation_source source;
+        auto token = source.token();
+        CHECK(token.can_be_cancelled());
+        CHECK(!token.is_cancellation_requested());
+        source.request_cancellation();
+        CHECK(token.is_cancellation_requested());
+        CHECK(token.can_be_cancelled());
+    }
+
+    TEST_CASE("token can't be cancelled once the source is destroyed") {
+        cancellation_token token;
+        {
+            cancellation_source source;
+            token = source.token();
+            CHECK(token.can_be_cancelled());
+        }
+        CHECK(!token.can_be_cancelled());
+        CHECK(!token.is_cancellation_requested());
+    }
+
+    TEST_CASE("throw_if_cancellation_requested") {
+        cancellation_source source;
+        auto token = source.token();
+
+        CHECK_NOTHROW(token.throw_if_cancellation_requested());
+        source.request_cancellation();
+        CHECK_THROWS_AS(token.throw_if_cancellation_requested(), const operation_cancelled&);
+    }
+
+    TEST_CASE("cancellation_registration callbacks are called on request_cancellation") {
+        cancellation_source source;
+
+        bool callback1_executed = false;
+        bool callback2_executed = false;
+
+        cancellation_registration registration1{ source.token(), [&] {
+            callback1_executed = true;
+        } };
+
+        {
+            // Deregistered before cancellation.
+            cancellation_registration registration2{ source.token(), [&] {
+                callback2_executed = true;
+            } };
+        }
+
+        CHECK(!callback1_executed);
+        source.request_cancellation();
+        CHECK(callback1_executed);
+        CHECK(!callback2_executed);
+    }
+
+    TEST_CASE("registering a callback after cancellation runs it immediately") {
+        cancellation_source source;
+        source.request_cancellation();
+
+        bool executed = false;
+        cancellation_registration registration{ source.token(), [&] { executed = true; } };
+        CHECK(executed);
+    }
+
+    TEST_CASE("many registrations grow the registration table") {
+        cancellation_source source;
+
+        int count = 0;
+        std::vector< std::unique_ptr< cancellation_registration > > registrations;
+        for (int i = 0; i < 100; ++i) {
+            registrations.push_back(std::make_unique< cancellation_registration >(
+                source.token(), [&] { ++count; }
+            ));
+        }
+
+        // Free some slots, and reuse them.
+        for (int i = 0; i < 100; i += 2) {
+            registrations[static_cast< std::size_t >(i)].reset();
+        }
+        for (int i = 0; i < 25; ++i) {
+            registrations.push_back(std::make_unique< cancellation_registration >(
+                source.token(), [&] { ++count; }
+            ));
+        }
+
+        source.request_cancellation();
+        CHECK(count == 75);
+    }
+
+    TEST_CASE("callback can deregister itself") {
+        cancellation_source source;
+
+        std::optional< cancellation_registration > registration;
+        registration.emplace(source.token(), [&] { registration.reset(); });
+
+        source.request_cancellation();
+        CHECK(!registration.has_value());
+    }
+
+    TEST_CASE("callback can destroy its own registration") {
+        cancellation_source source;
+
+        int calls = 0;
+        auto registration = std::make_unique< std::optional< cancellation_registration > >();
+        registration->emplace(source.token(), [&] {
+            ++calls;
+            registration.reset();
+        });
+
+        source.request_cancellation();
+        CHECK(calls == 1);
+        CHECK(!registration);
+    }
+
+    TEST_CASE("concurrent registration and cancellation") {
+        for (int round = 0; round < 100; ++round) {
+            cancellation_source source;
+            std::atomic< int > count = 0;
+
+            std::thread registrar([&] {
+                for (int i = 0; i < 100; ++i) {
+                    cancellation_registration registration{ source.token(), [&] {
+                        count.fetch_add(1);
+                    } };
+                }
+            });
+
+            source.request_cancellation();
+            registrar.join();
+
+            // Each registration either ran its callback, or was deregistered
+            // before the request came in.
+            CHECK(count.load() <= 100);
+        }
+    }
+
+    TEST_CASE("concurrent registrations growing the table are all called") {
+        constexpr int registrars = 4;
+        constexpr int per_registrar = 64;
+
+        for (int round = 0; round < 200; ++round) {
+            cancellation_source source;
+            std::atomic< int > count = 0;
+            std::atomic< int > registered = 0;
+
+            std::vector< std::thread > threads;
+            std::vector< std::vector< std::unique_ptr< cancellation_registration > > > registrations(
+                registrars
+            );
+            for (std::size_t t = 0; t < registrars; ++t) {
+                threads.emplace_back([&, t] {
+                    for (int i = 0; i < per_registrar; ++i) {
+                        registrations[t].push_back(std::make_unique< cancellation_registration >(
+                            source.token(), [&] { count.fetch_add(1); }
+                        ));
+                        registered.fetch_add(1);
+                    }
+                });
+            }
+
+            // Cancel while the table is growing past its first chunk.
+            while (registered.load() < registrars * per_registrar / 2) {
+                std::this_thread::yield();
+            }
+            source.request_cancellation();
+            for (auto &thread : threads) {
+                thread.join();
+            }
+
+            // Every registration outlives the request, so each callback ran
+            // exactly once, either when registering or when cancelling.
+            CHECK(count.load() == registrars * per_registrar);
+        }
+    }
+
+    TEST_CASE("single_consumer_event wait is cancelled") {
+        single_consumer_event event;
+        cancellation_source source;
+
+        bool cancelled = false;
+        auto waiter = [&]() -> task<> {
+            try {
+                co_await event.wait(source.token());
+            } catch (const operation_cancelled&) {
+                cancelled = true;
+            }
+        };
+
+        auto canceller = [&]() -> task<> {
+            CHECK(!cancelled);
+            source.request_cancellation();
+            CHECK(cancelled);
+            co_return;
+        };
+
+        sync_wait(when_all_ready(waiter(), canceller()));
+        CHECK(cancelled);
+        CHECK(!event.is_set());
+    }
+
+    TEST_CASE("single_consumer_event wait completes when set first") {
+        single_consumer_event event;
+        cancellation_source source;
+
+        bool completed = false;
+        auto waiter = [&]() -> task<> {
+            co_await event.wait(source.token());
+            completed = true;
+        };
+
+        auto setter = [&]() -> task<> {
+            event.set();
+            source.request_cancellation();
+            co_return;
+        };
+
+        sync_wait(when_all_ready(waiter(), setter()));
+        CHECK(completed);
+    }
+
+    TEST_CASE("single_consumer_event wait with an already cancelled token") {
+        single_consumer_event event;
+        cancellation_source source;
+        source.request_cancellation();
+
+        CHECK_THROWS_AS(
+            sync_wait([&]() -> task<> { co_await event.wait(source.token()); }()),
+            const operation_cancelled&
+        );
+    }
+
+    TEST_CASE("single_consumer_event wait races with set and cancel") {
+        static_thread_pool pool{ 2 };
+
+        for (int round = 0; round < 200; ++round) {
+            single_consumer_event event;
+            cancellation_source source;
+
+            auto waiter = [&]() -> task< bool > {
+                try {
+                    co_await event.wait(source.token());
+                    co_return true;
+                } catch (const operation_cancelled&) {
+                    co_return false;
+                }
+            };
+
+            auto setter = [&]() -> task<> {
+                co_await pool.schedule();
+                event.set();
+            };
+
+            auto canceller = [&]() -> task<> {
+                co_await pool.schedule();
+                source.request_cancellation();
+            };
+
+            auto [result, set, cancel] = sync_wait(when_all_ready(waiter(), setter(), canceller()));
+            CHECK_NOTHROW(result.result());
+        }
+    }
+
+    TEST_CASE("static_thread_pool schedule with a cancelled token") {
+        static_thread_pool pool{ 2 };
+        cancellation_source source;
+        source.request_cancellation();
+
+        bool ran = false;
+        auto work = [&]() -> task<> {
+            co_await pool.schedule(source.token());
+            ran = true;
+        };
+
+        CHECK_THROWS_AS(sync_wait(work()), const operation_cancelled&);
+        CHECK(!ran);
+    }
+
+    TEST_CASE("static_thread_pool schedule with a live token") {
+        static_thread_pool pool{ 2 };
+        cancellation_source source;
+
+        auto id = sync_wait([&]() -> task< std::thread::id > {
+            co_await pool.schedule(source.token());
+            co_return std::this_thread::get_id();
+        }());
+
+        CHECK(id != std::this_thread::get_id());
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
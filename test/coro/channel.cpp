@@ -0,0 +1,303 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/channel.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <memory>
+    #include <stdexcept>
+    #include <string>
+    #include <thread>
+    #include <utility>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("channel");
+
+    TEST_CASE("zero capacity is rejected") {
+        CHECK_THROWS_AS(channel< int >{ 0 }, const std::invalid_argument&);
+    }
+
+    TEST_CASE("try_send and try_receive") {
+        channel< int > ch{ 2 };
+        CHECK(ch.capacity() == 2);
+
+        CHECK(ch.try_send(1));
+        CHECK(ch.try_send(2));
+        CHECK_FALSE(ch.try_send(3));
+
+        CHECK(ch.try_receive() == 1);
+        CHECK(ch.try_send(3));
+        CHECK(ch.try_receive() == 2);
+        CHECK(ch.try_receive() == 3);
+        CHECK_FALSE(ch.try_receive().has_value());
+    }
+
+    TEST_CASE("failed try_send leaves the value untouched") {
+        channel< std::unique_ptr< int > > ch{ 1 };
+        auto first  = std::make_unique< int >(1);
+        auto second = std::make_unique< int >(2);
+
+        CHECK(ch.try_send(std::move(first)));
+        CHECK_FALSE(ch.try_send(std::move(second)));
+        CHECK(second != nullptr);
+
+        auto received = ch.try_receive();
+        REQUIRE(received.has_value());
+        CHECK(**received == 1);
+    }
+
+    TEST_CASE("send and receive without suspending") {
+        channel< std::string > ch{ 4 };
+
+        auto values = sync_wait([&]() -> task< std::vector< std::string > > {
+            co_await ch.send("a");
+            co_await ch.send("b");
+
+            std::vector< std::string > received;
+            received.push_back(*co_await ch.receive());
+            received.push_back(*co_await ch.receive());
+            co_return received;
+        }());
+
+        CHECK(values == std::vector< std::string >{ "a", "b" });
+    }
+
+    TEST_CASE("receiver suspends until a value is sent") {
+        channel< int > ch{ 1 };
+        std::optional< int > received;
+
+        auto consumer = [&]() -> task<> { received = co_await ch.receive(); };
+
+        auto producer = [&]() -> task<> {
+            CHECK(!received.has_value());
+            co_await ch.send(42);
+            CHECK(received == 42);
+        };
+
+        sync_wait(when_all_ready(consumer(), producer()));
+    }
+
+    TEST_CASE("sender suspends while the channel is full") {
+        channel< int > ch{ 2 };
+        int sent = 0;
+
+        auto producer = [&]() -> task<> {
+            for (int i = 0; i < 5; ++i) {
+                co_await ch.send(i);
+                ++sent;
+            }
+        };
+
+        auto consumer = [&]() -> task<> {
+            // The producer is blocked on its third value.
+            CHECK(sent == 2);
+
+            std::vector< int > values;
+            for (int i = 0; i < 5; ++i) {
+                values.push_back(*co_await ch.receive());
+            }
+
+            CHECK(sent == 5);
+            CHECK(values == std::vector< int >{ 0, 1, 2, 3, 4 });
+        };
+
+        sync_wait(when_all_ready(producer(), consumer()));
+    }
+
+    TEST_CASE("close wakes receivers after buffered values are drained") {
+        channel< int > ch{ 4 };
+
+        auto consumer = [&]() -> task< std::vector< int > > {
+            std::vector< int > values;
+            while (auto value = co_await ch.receive()) {
+                values.push_back(*value);
+            }
+            co_return values;
+        };
+
+        auto producer = [&]() -> task<> {
+            co_await ch.send(1);
+            co_await ch.send(2);
+            ch.close();
+            co_return;
+        };
+
+        auto [values, done] = sync_wait(when_all_ready(consumer(), producer()));
+        CHECK(values.result() == std::vector< int >{ 1, 2 });
+        CHECK(ch.is_closed());
+    }
+
+    TEST_CASE("close fails suspended and later senders") {
+        channel< int > ch{ 1 };
+
+        auto blocked_sender = [&]() -> task<> {
+            co_await ch.send(1);
+            co_await ch.send(2);
+        };
+
+        auto closer = [&]() -> task<> {
+            ch.close();
+            co_return;
+        };
+
+        auto [sender, closed] = sync_wait(when_all_ready(blocked_sender(), closer()));
+        CHECK_THROWS_AS(sender.result(), const channel_closed&);
+
+        CHECK_THROWS_AS(sync_wait(ch.send(3)), const channel_closed&);
+        CHECK_FALSE(ch.try_send(3));
+
+        // The value that made it in before closing can still be received.
+        CHECK(sync_wait(ch.receive()) == 1);
+        CHECK_FALSE(sync_wait(ch.receive()).has_value());
+    }
+
+    TEST_CASE("multiple producers and consumers on a thread pool") {
+        static_thread_pool pool{ 4 };
+        channel< int > ch{ 8 };
+
+        constexpr int producers          = 4;
+        constexpr int consumers          = 4;
+        constexpr int values_per_producer = 2000;
+
+        auto producer = [&](int id) -> task<> {
+            co_await pool.schedule();
+            for (int i = 0; i < values_per_producer; ++i) {
+                co_await ch.send(id * values_per_producer + i);
+            }
+        };
+
+        auto consumer = [&]() -> task< long long > {
+            co_await pool.schedule();
+            long long sum = 0;
+            while (auto value = co_await ch.receive()) {
+                sum += *value;
+            }
+            co_return sum;
+        };
+
+        auto produce_all = [&]() -> task<> {
+            std::vector< task<> > tasks;
+            for (int id = 0; id < producers; ++id) {
+                tasks.push_back(producer(id));
+            }
+            co_await when_all_ready_vec(std::move(tasks));
+            ch.close();
+        };
+
+        auto consume_all = [&]() -> task< long long > {
+            std::vector< task< long long > > tasks;
+            for (int i = 0; i < consumers; ++i) {
+                tasks.push_back(consumer());
+            }
+
+            auto results = co_await when_all_ready_vec(std::move(tasks));
+            long long sum = 0;
+            for (auto &result : results) {
+                sum += result.result();
+            }
+            co_return sum;
+        };
+
+        auto [produced, consumed] = sync_wait(when_all_ready(produce_all(), consume_all()));
+        produced.result();
+
+        constexpr long long total = producers * values_per_producer;
+        CHECK(consumed.result() == total * (total - 1) / 2);
+    }
+
+    TEST_CASE("send racing with close does not strand values") {
+        // The move of a held value into its cell waits until close() has
+        // started and then lets the closing thread and the receiver run,
+        // so that close() happens between a sender claiming a cell and
+        // storing its value.
+        struct held_value
+        {
+            held_value(std::atomic< bool > *moving, std::atomic< bool > *closing) noexcept
+                : m_moving(moving), m_closing(closing)
+            {}
+
+            held_value(held_value &&other) noexcept {
+                if (other.m_moving != nullptr) {
+                    other.m_moving->store(true);
+                    while (!other.m_closing->load()) {
+                        std::this_thread::yield();
+                    }
+                    for (int i = 0; i < 100; ++i) {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+            held_value& operator=(held_value&&) = delete;
+
+            std::atomic< bool > *m_moving  = nullptr;
+            std::atomic< bool > *m_closing = nullptr;
+        };
+
+        static_thread_pool pool{ 4 };
+
+        for (int round = 0; round < 100; ++round) {
+            channel< held_value > ch{ 8 };
+            std::atomic< int > sent     = 0;
+            std::atomic< bool > moving  = false;
+            std::atomic< bool > closing = false;
+
+            auto sender = [&]() -> task<> {
+                co_await pool.schedule();
+                for (int i = 0; i < round % 4; ++i) {
+                    co_await ch.send(held_value{ nullptr, nullptr });
+                    ++sent;
+                }
+
+                held_value value{ &moving, &closing };
+                if (ch.try_send(std::move(value))) {
+                    ++sent;
+                }
+            };
+
+            auto receiver = [&]() -> task< int > {
+                co_await pool.schedule();
+                int received = 0;
+                while (co_await ch.receive()) {
+                    ++received;
+                }
+                co_return received;
+            };
+
+            auto closer = [&]() -> task<> {
+                co_await pool.schedule();
+                while (!moving.load()) {
+                    std::this_thread::yield();
+                }
+                closing.store(true);
+                ch.close();
+            };
+
+            auto [produced, received, closed] = sync_wait(
+                when_all_ready(sender(), receiver(), closer())
+            );
+            produced.result();
+            closed.result();
+
+            // A value stored after the receiver saw the channel drained
+            // would be left in the buffer.
+            REQUIRE(received.result() == sent.load());
+            REQUIRE_FALSE(ch.try_receive().has_value());
+        }
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
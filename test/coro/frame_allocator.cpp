@@ -0,0 +1,285 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/frame_allocator.hpp>
+    #include <gap/coro/generator.hpp>
+    #include <gap/coro/recursive_generator.hpp>
+    #include <gap/coro/shared_task.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <chrono>
+    #include <cmath>
+    #include <cstddef>
+    #include <memory>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    namespace
+    {
+        struct allocation_counters
+        {
+            std::size_t allocations   = 0;
+            std::size_t deallocations = 0;
+            std::size_t live_bytes    = 0;
+        };
+
+        template< typename T >
+        struct counting_allocator
+        {
+            using value_type = T;
+
+            explicit counting_allocator(allocation_counters &counters) noexcept
+                : m_counters(&counters)
+            {}
+
+            template< typename U >
+            counting_allocator(const counting_allocator< U > &other) noexcept
+                : m_counters(other.m_counters)
+            {}
+
+            T *allocate(std::size_t n) {
+                ++m_counters->allocations;
+                m_counters->live_bytes += n * sizeof(T);
+                return std::allocator< T >().allocate(n);
+            }
+
+            void deallocate(T *ptr, std::size_t n) noexcept {
+                ++m_counters->deallocations;
+                m_counters->live_bytes -= n * sizeof(T);
+                std::allocator< T >().deallocate(ptr, n);
+            }
+
+            template< typename U >
+            bool operator==(const counting_allocator< U > &other) const noexcept {
+                return m_counters == other.m_counters;
+            }
+
+            allocation_counters *m_counters;
+        };
+
+        template< typename allocator_t >
+        task< int > add_one(std::allocator_arg_t, const allocator_t&, int value) {
+            co_return value + 1;
+        }
+
+        template< typename allocator_t >
+        shared_task< int > shared_double(std::allocator_arg_t, const allocator_t&, int value) {
+            co_return value * 2;
+        }
+
+        template< typename allocator_t >
+        generator< int > iota(std::allocator_arg_t, const allocator_t&, int count) {
+            for (int i = 0; i < count; ++i) {
+                co_yield i;
+            }
+        }
+
+        template< typename allocator_t >
+        recursive_generator< int > countdown(
+            std::allocator_arg_t, const allocator_t &alloc, int from
+        ) {
+            if (from > 0) {
+                co_yield from;
+                co_yield countdown(std::allocator_arg, alloc, from - 1);
+            }
+        }
+
+        struct accumulator
+        {
+            template< typename allocator_t >
+            task< int > add(std::allocator_arg_t, const allocator_t&, int value) {
+                m_total += value;
+                co_return m_total;
+            }
+
+            int m_total = 0;
+        };
+
+    } // namespace
+
+    TEST_SUITE_BEGIN("frame_allocator");
+
+    #if GAP_CORO_FRAME_RECYCLING
+    TEST_CASE("recycler reuses freed blocks of the same size class") {
+        auto *first = coro::detail::frame_recycler::allocate(100);
+        coro::detail::frame_recycler::deallocate(first, 100);
+
+        // 100 and 120 bytes share the 128 byte class.
+        auto *second = coro::detail::frame_recycler::allocate(120);
+        CHECK(second == first);
+        coro::detail::frame_recycler::deallocate(second, 120);
+    }
+    #endif
+
+    TEST_CASE("recycler passes large frames through to the global heap") {
+        constexpr auto size = coro::detail::frame_recycler::max_cached_size + 1;
+        auto *block = coro::detail::frame_recycler::allocate(size);
+        REQUIRE(block != nullptr);
+        coro::detail::frame_recycler::deallocate(block, size);
+    }
+
+    TEST_CASE("default frames are recycled across many tasks") {
+        auto make_task = [](int value) -> task< int > { co_return value; };
+
+        int sum = 0;
+        for (int i = 0; i < 1000; ++i) {
+            sum += sync_wait(make_task(i));
+        }
+
+        CHECK(sum == 999 * 1000 / 2);
+    }
+
+    TEST_CASE("task frame uses the passed allocator") {
+        allocation_counters counters;
+        counting_allocator< std::byte > alloc{ counters };
+
+        {
+            auto t = add_one(std::allocator_arg, alloc, 41);
+            CHECK(counters.allocations == 1);
+            CHECK(counters.live_bytes > 0);
+            CHECK(sync_wait(std::move(t)) == 42);
+        }
+
+        CHECK(counters.deallocations == 1);
+        CHECK(counters.live_bytes == 0);
+    }
+
+    TEST_CASE("member coroutine frame uses the passed allocator") {
+        allocation_counters counters;
+        counting_allocator< std::byte > alloc{ counters };
+
+        accumulator acc;
+        CHECK(sync_wait(acc.add(std::allocator_arg, alloc, 2)) == 2);
+        CHECK(sync_wait(acc.add(std::allocator_arg, alloc, 3)) == 5);
+
+        CHECK(counters.allocations == 2);
+        CHECK(counters.deallocations == 2);
+        CHECK(counters.live_bytes == 0);
+    }
+
+    TEST_CASE("shared_task frame uses the passed allocator") {
+        allocation_counters counters;
+        counting_allocator< std::byte > alloc{ counters };
+
+        {
+            auto t    = shared_double(std::allocator_arg, alloc, 21);
+            auto copy = t;
+            CHECK(sync_wait(t) == 42);
+            CHECK(sync_wait(copy) == 42);
+            CHECK(counters.allocations == 1);
+        }
+
+        CHECK(counters.deallocations == 1);
+        CHECK(counters.live_bytes == 0);
+    }
+
+    TEST_CASE("generator frames use the passed allocator") {
+        allocation_counters counters;
+        counting_allocator< std::byte > alloc{ counters };
+
+        int sum = 0;
+        for (int value : iota(std::allocator_arg, alloc, 10)) {
+            sum += value;
+        }
+        CHECK(sum == 45);
+
+        sum = 0;
+        for (int value : countdown(std::allocator_arg, alloc, 4)) {
+            sum += value;
+        }
+        CHECK(sum == 10);
+
+        // One frame for the generator and one per recursion level (4..0).
+        CHECK(counters.allocations == 6);
+        CHECK(counters.deallocations == 6);
+        CHECK(counters.live_bytes == 0);
+    }
+
+    TEST_CASE("frames destroyed on a different thread") {
+        static_thread_pool pool{ 2 };
+
+        auto make_task = [&](int value) -> task< int > {
+            co_await pool.schedule();
+            co_return value;
+        };
+
+        auto run = [&]() -> task< int > {
+            std::vector< task< int > > tasks;
+            for (int i = 0; i < 1000; ++i) {
+                tasks.push_back(make_task(i));
+            }
+
+            auto ready = co_await when_all_ready_vec(std::move(tasks));
+
+            int sum = 0;
+            for (auto &t : ready) {
+                sum += t.result();
+            }
+            co_return sum;
+        };
+
+        CHECK(sync_wait(run()) == 999 * 1000 / 2);
+    }
+
+    //
+    // Allocation benchmark, run with --no-skip.
+    //
+    TEST_CASE("recycled vs global heap task frames" * doctest::skip()) {
+        constexpr int iterations = 1 << 18;
+        constexpr int samples    = 5;
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        std::vector< double > recycled_us, heap_us;
+        long sink = 0;
+
+        auto plain = [](int value) -> task< int > { co_return value + 1; };
+        std::allocator< std::byte > heap;
+
+        for (int s = 0; s < samples; ++s) {
+            recycled_us.push_back(measure_us([&] {
+                for (int i = 0; i < iterations; ++i) {
+                    sink += sync_wait(plain(i));
+                }
+            }));
+
+            // std::allocator goes straight to the global operator new.
+            heap_us.push_back(measure_us([&] {
+                for (int i = 0; i < iterations; ++i) {
+                    sink += sync_wait(add_one(std::allocator_arg, heap, i));
+                }
+            }));
+        }
+
+        auto report = [&](const char *name, const std::vector< double > &us) {
+            auto avg       = bench::mean(us);
+            auto deviation = std::sqrt(bench::standard_deviation(us));
+            MESSAGE(name << ": " << avg << " us (+-" << deviation << "), "
+                         << (avg * 1000.0 / iterations) << " ns/task");
+        };
+
+        report("recycled frames", recycled_us);
+        report("global heap frames", heap_us);
+
+        CHECK(sink != 0);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,245 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/generator.hpp>
+    #include <gap/coro/generator_adaptors.hpp>
+
+    #include <chrono>
+    #include <cmath>
+    #include <cstdint>
+    #include <memory>
+    #include <stdexcept>
+    #include <string>
+    #include <utility>
+    #include <vector>
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("generator_adaptors");
+
+    static generator< int > count_to(int count, int *resumes = nullptr) {
+        for (int i = 0; i < count; ++i) {
+            if (resumes) {
+                ++*resumes;
+            }
+            co_yield i;
+        }
+    }
+
+    static auto is_even = [](int v) { return v % 2 == 0; };
+
+    TEST_CASE("transform") {
+        std::vector< std::string > values;
+        for (auto v : count_to(4) | coro::transform([](int v) { return std::to_string(v * 10); })) {
+            values.push_back(v);
+        }
+        CHECK(values == std::vector< std::string >{ "0", "10", "20", "30" });
+    }
+
+    TEST_CASE("filter") {
+        std::vector< int > values;
+        for (int v : count_to(10) | coro::filter(is_even)) {
+            values.push_back(v);
+        }
+        CHECK(values == std::vector< int >{ 0, 2, 4, 6, 8 });
+
+        auto none = count_to(10) | coro::filter([](int) { return false; });
+        CHECK(none.begin() == none.end());
+    }
+
+    TEST_CASE("take_while stops at the first failing element") {
+        int resumes = 0;
+        std::vector< int > values;
+        for (int v : count_to(100, &resumes) | coro::take_while([](int v) { return v < 3; })) {
+            values.push_back(v);
+        }
+        CHECK(values == std::vector< int >{ 0, 1, 2 });
+        CHECK(resumes == 4);
+    }
+
+    TEST_CASE("enumerate") {
+        std::vector< std::pair< std::size_t, int > > values;
+        for (auto [index, v] : count_to(10) | coro::filter(is_even) | coro::enumerate) {
+            values.emplace_back(index, v);
+        }
+        CHECK(values == std::vector< std::pair< std::size_t, int > >{
+            { 0, 0 }, { 1, 2 }, { 2, 4 }, { 3, 6 }, { 4, 8 }
+        });
+    }
+
+    TEST_CASE("chunk") {
+        for (int count : { 0, 1, 3, 4, 7 }) {
+            std::vector< std::vector< int > > chunks;
+            for (const auto &chunk : count_to(count) | coro::chunk(3)) {
+                chunks.push_back(chunk);
+            }
+
+            std::vector< std::vector< int > > expected;
+            for (int i = 0; i < count; ++i) {
+                if (i % 3 == 0) {
+                    expected.emplace_back();
+                }
+                expected.back().push_back(i);
+            }
+            CHECK(chunks == expected);
+        }
+    }
+
+    TEST_CASE("five stages resume the source once per element") {
+        int resumes = 0;
+        auto source = count_to(1000, &resumes);
+
+        auto pipeline = source
+            | coro::filter(is_even)
+            | coro::transform([](int v) { return v * 3; })
+            | coro::take_while([](int v) { return v < 600; })
+            | coro::enumerate
+            | coro::chunk(16);
+
+        std::size_t elements = 0, chunks = 0;
+        for (const auto &chunk : pipeline) {
+            for (auto [index, v] : chunk) {
+                CHECK(v == int(index) * 6);
+                ++elements;
+            }
+            ++chunks;
+        }
+
+        // Values 0, 2, ..., 198 pass, 200 is the first to be rejected.
+        CHECK(elements == 100);
+        CHECK(chunks == 7);
+        CHECK(resumes == 201);
+    }
+
+    TEST_CASE("refers to lvalue generators and owns rvalue ones") {
+        auto alive = std::make_shared< int >(0);
+        std::weak_ptr< int > watch = alive;
+
+        auto source = [](std::shared_ptr< int > keep) -> generator< int > {
+            for (int i = 0;; ++i) {
+                co_yield i + *keep;
+            }
+        };
+
+        {
+            auto gen = source(alive);
+            {
+                auto view = gen | coro::filter(is_even);
+                CHECK(*view.begin() == 0);
+            }
+            // The view consumed 0 from the generator, which picks up after it.
+            CHECK(*gen.begin() == 1);
+        }
+
+        {
+            auto view = source(std::move(alive)) | coro::take_while([](int v) { return v < 5; });
+            int sum = 0;
+            for (int v : view) {
+                sum += v;
+            }
+            CHECK(sum == 10);
+            CHECK(!watch.expired());
+        }
+        CHECK(watch.expired());
+    }
+
+    TEST_CASE("propagates exceptions from the source") {
+        auto gen = []() -> generator< int > {
+            co_yield 1;
+            throw std::runtime_error("failed");
+        };
+
+        std::vector< int > values;
+        auto consume = [&] {
+            for (auto v : gen() | coro::transform([](int v) { return v + 1; }) | coro::enumerate) {
+                values.push_back(v.second);
+            }
+        };
+
+        CHECK_THROWS_AS(consume(), std::runtime_error);
+        CHECK(values == std::vector< int >{ 2 });
+    }
+
+    //
+    // Fused adaptors against a coroutine per stage, run with --no-skip.
+    //
+    static generator< int > nested_filter(generator< int > gen) {
+        for (int v : gen) {
+            if (v % 2 == 0) {
+                co_yield v;
+            }
+        }
+    }
+
+    static generator< int > nested_transform(generator< int > gen) {
+        for (int v : gen) {
+            co_yield v * 3;
+        }
+    }
+
+    static generator< int > nested_take_while(generator< int > gen) {
+        for (int v : gen) {
+            if (v < 0) {
+                co_return;
+            }
+            co_yield v;
+        }
+    }
+
+    TEST_CASE("fused adaptors throughput" * doctest::skip()) {
+        constexpr int count   = 1 << 22;
+        constexpr int samples = 5;
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        std::vector< double > fused, nested;
+        std::int64_t expected = 0;
+        for (std::int64_t i = 0; i < count; i += 2) {
+            expected += i * 3;
+        }
+
+        for (int s = 0; s < samples; ++s) {
+            std::int64_t sum = 0;
+            fused.push_back(measure_us([&] {
+                auto pipeline = count_to(count)
+                    | coro::filter(is_even)
+                    | coro::transform([](int v) { return v * 3; })
+                    | coro::take_while([](int v) { return v >= 0; });
+                for (int v : pipeline) {
+                    sum += v;
+                }
+            }));
+            CHECK(sum == expected);
+
+            sum = 0;
+            nested.push_back(measure_us([&] {
+                for (int v : nested_take_while(nested_transform(nested_filter(count_to(count))))) {
+                    sum += v;
+                }
+            }));
+            CHECK(sum == expected);
+        }
+
+        auto report = [&](const char *name, const std::vector< double > &us) {
+            auto deviation = std::sqrt(bench::standard_deviation(us));
+            MESSAGE(name << ": " << bench::mean(us) << " us (+-" << deviation << ")");
+        };
+
+        MESSAGE("elements: " << count);
+        report("fused adaptors", fused);
+        report("coroutine per stage", nested);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,263 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/coroutine_trace.hpp>
+    #include <gap/coro/lifecycle_hooks.hpp>
+    #include <gap/coro/shared_task.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+
+    #include <algorithm>
+    #include <atomic>
+    #include <cstdint>
+    #include <map>
+    #include <set>
+    #include <sstream>
+    #include <thread>
+    #include <type_traits>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("lifecycle_hooks");
+
+    namespace
+    {
+        // Made up coroutine identities, far from any real promise.
+        const void *fake_coroutine(std::uintptr_t n) {
+            return reinterpret_cast< const void* >((std::uintptr_t(1) << 40) + n);
+        }
+
+        std::vector< trace_record > records_of(
+            const std::vector< trace_record > &records, const void *coroutine
+        ) {
+            std::vector< trace_record > result;
+            std::copy_if(records.begin(), records.end(), std::back_inserter(result), [&](auto &r) {
+                return r.coroutine == coroutine;
+            });
+            return result;
+        }
+
+        std::vector< coroutine_event > events_of(const std::vector< trace_record > &records) {
+            std::vector< coroutine_event > events;
+            for (const auto &record : records) {
+                events.push_back(record.event);
+            }
+            return events;
+        }
+
+    } // namespace
+
+    TEST_CASE("trace_hooks record and dump Chrome trace events") {
+        clear_coroutine_trace();
+        auto *coroutine = fake_coroutine(1);
+
+        trace_hooks::on_create(coroutine, coroutine_kind::shared_task);
+        std::thread([&] {
+            trace_hooks::on_resume(coroutine, coroutine_kind::shared_task);
+            trace_hooks::on_suspend(coroutine, coroutine_kind::shared_task);
+        }).join();
+        trace_hooks::on_destroy(coroutine, coroutine_kind::shared_task);
+
+        auto records = records_of(collect_coroutine_trace(), coroutine);
+        REQUIRE(records.size() == 4);
+        CHECK(events_of(records) == std::vector{
+            coroutine_event::create, coroutine_event::resume,
+            coroutine_event::suspend, coroutine_event::destroy
+        });
+        CHECK(records[0].thread == records[3].thread);
+        CHECK(records[1].thread == records[2].thread);
+        CHECK(records[0].thread != records[1].thread);
+        CHECK(std::is_sorted(records.begin(), records.end(), [](auto &a, auto &b) {
+            return a.time < b.time;
+        }));
+
+        std::ostringstream dump;
+        dump_chrome_trace(dump);
+        auto json = dump.str();
+        CHECK(json.starts_with("{\"traceEvents\":["));
+        CHECK(json.find("\"ph\":\"b\",\"id\":\"0x10000000001\"") != std::string::npos);
+        CHECK(json.find("\"ph\":\"e\",\"id\":\"0x10000000001\"") != std::string::npos);
+        CHECK(json.find("\"name\":\"shared_task\",\"cat\":\"coroutine\",\"ph\":\"X\"")
+              != std::string::npos);
+        CHECK(json.find("\"thread_name\"") != std::string::npos);
+
+        clear_coroutine_trace();
+        CHECK(records_of(collect_coroutine_trace(), coroutine).empty());
+    }
+
+    TEST_CASE("trace keeps the most recent events of each thread") {
+        clear_coroutine_trace();
+        auto *coroutine = fake_coroutine(2);
+
+        std::thread([&] {
+            for (std::size_t i = 0; i < 3 * trace_ring_capacity; ++i) {
+                trace_hooks::on_resume(coroutine, coroutine_kind::task);
+            }
+        }).join();
+
+        CHECK(records_of(collect_coroutine_trace(), coroutine).size() == trace_ring_capacity);
+        clear_coroutine_trace();
+    }
+
+    TEST_CASE("trace is read while threads record") {
+        constexpr int threads = 4;
+        clear_coroutine_trace();
+
+        std::atomic< bool > stop = false;
+        std::vector< std::thread > recorders;
+        for (int t = 0; t < threads; ++t) {
+            recorders.emplace_back([&, t] {
+                // Each thread records an increasing sequence, in order.
+                for (std::uintptr_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+                    auto id = fake_coroutine((std::uintptr_t(t + 1) << 32) + i);
+                    trace_hooks::on_resume(id, coroutine_kind::task);
+                }
+            });
+        }
+
+        bool ordered = true;
+        for (int round = 0; round < 50; ++round) {
+            std::map< std::uint32_t, std::uintptr_t > last;
+            for (const auto &record : collect_coroutine_trace()) {
+                auto value = reinterpret_cast< std::uintptr_t >(record.coroutine);
+                auto [it, inserted] = last.try_emplace(record.thread, value);
+                if (!inserted) {
+                    ordered &= value > it->second;
+                    it->second = value;
+                }
+            }
+        }
+
+        stop = true;
+        for (auto &recorder : recorders) {
+            recorder.join();
+        }
+        CHECK(ordered);
+        clear_coroutine_trace();
+    }
+
+#if GAP_CORO_LIFECYCLE_HOOKS
+
+    static_assert(std::is_base_of_v< detail::task_lifecycle_frame, detail::task_promise< void > >);
+
+    namespace
+    {
+        // The recorded events grouped by coroutine, in the order they were
+        // created. Frames are reused, a destroy ends the group.
+        std::vector< std::vector< trace_record > > by_coroutine(coroutine_kind kind) {
+            std::vector< std::vector< trace_record > > result;
+            std::map< const void*, std::size_t > index;
+            for (const auto &record : collect_coroutine_trace()) {
+                if (record.kind != kind) {
+                    continue;
+                }
+                auto [it, inserted] = index.try_emplace(record.coroutine, result.size());
+                if (inserted) {
+                    result.emplace_back();
+                }
+                result[it->second].push_back(record);
+                if (record.event == coroutine_event::destroy) {
+                    index.erase(it);
+                }
+            }
+            return result;
+        }
+
+        // Create, then resume and suspend in turn, then destroy.
+        bool well_formed(const std::vector< trace_record > &records) {
+            auto events = events_of(records);
+            if (events.size() < 4 || events.front() != coroutine_event::create
+                || events.back() != coroutine_event::destroy)
+            {
+                return false;
+            }
+            for (std::size_t i = 1; i + 1 < events.size(); ++i) {
+                auto expected = i % 2 ? coroutine_event::resume : coroutine_event::suspend;
+                if (events[i] != expected) {
+                    return false;
+                }
+            }
+            return events.size() % 2 == 0;
+        }
+
+        task< int > inner() { co_return 1; }
+
+        task< int > outer() {
+            auto first = co_await inner();
+            co_return first + co_await inner();
+        }
+
+    } // namespace
+
+    TEST_CASE("tasks report their lifecycle") {
+        clear_coroutine_trace();
+        CHECK(sync_wait(outer()) == 2);
+
+        auto tasks = by_coroutine(coroutine_kind::task);
+        REQUIRE(tasks.size() >= 3);
+        for (const auto &records : tasks) {
+            CHECK(well_formed(records));
+        }
+        clear_coroutine_trace();
+    }
+
+    TEST_CASE("shared tasks report their lifecycle") {
+        clear_coroutine_trace();
+        sync_wait([]() -> task<> {
+            auto shared = []() -> shared_task< int > { co_return 7; }();
+            CHECK(co_await shared == 7);
+            CHECK(co_await shared == 7);
+        }());
+
+        auto shared_tasks = by_coroutine(coroutine_kind::shared_task);
+        REQUIRE(shared_tasks.size() == 1);
+        CHECK(well_formed(shared_tasks.front()));
+        clear_coroutine_trace();
+    }
+
+    TEST_CASE("hooks see the thread each stretch runs on") {
+        static_thread_pool pool{ 1 };
+        clear_coroutine_trace();
+
+        auto hop = [&]() -> task<> {
+            co_await pool.schedule();
+        };
+        sync_wait(hop());
+
+        auto tasks = by_coroutine(coroutine_kind::task);
+        auto hopped = std::any_of(tasks.begin(), tasks.end(), [](const auto &records) {
+            std::set< std::uint32_t > threads;
+            for (const auto &record : records) {
+                if (record.event == coroutine_event::resume) {
+                    threads.insert(record.thread);
+                }
+            }
+            return well_formed(records) && threads.size() == 2;
+        });
+        CHECK(hopped);
+        clear_coroutine_trace();
+    }
+
+#else
+
+    static_assert(!lifecycle_hooks_enabled);
+
+    TEST_CASE("hooks compile away when disabled") {
+        clear_coroutine_trace();
+        sync_wait([]() -> task<> { co_return; }());
+        CHECK(collect_coroutine_trace().empty());
+    }
+
+#endif
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
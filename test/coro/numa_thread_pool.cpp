@@ -0,0 +1,286 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/numa_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <chrono>
+    #include <filesystem>
+    #include <fstream>
+    #include <memory>
+    #include <memory_resource>
+    #include <numeric>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("numa_thread_pool");
+
+    namespace
+    {
+        template< typename allocator_t >
+        task< int > add_one(std::allocator_arg_t, const allocator_t&, int value) {
+            co_return value + 1;
+        }
+
+    } // namespace
+
+    TEST_CASE("parse cpulist") {
+        using list = std::vector< std::uint32_t >;
+        CHECK(numa_topology::parse_cpulist("0-3,8,10-11\n") == list{ 0, 1, 2, 3, 8, 10, 11 });
+        CHECK(numa_topology::parse_cpulist("5") == list{ 5 });
+        CHECK(numa_topology::parse_cpulist("2,0-1,1") == list{ 0, 1, 2 });
+        CHECK(numa_topology::parse_cpulist("").empty());
+        CHECK(numa_topology::parse_cpulist("\n").empty());
+        CHECK(numa_topology::parse_cpulist("3-1").empty());
+        CHECK(numa_topology::parse_cpulist("x").empty());
+    }
+
+    TEST_CASE("topology from sysfs") {
+        namespace fs = std::filesystem;
+        auto root    = fs::temp_directory_path() / "gap-test-numa-sysfs";
+        fs::remove_all(root);
+
+        auto write_node = [&](const char *name, const char *cpulist) {
+            fs::create_directories(root / name);
+            std::ofstream(root / name / "cpulist") << cpulist << '\n';
+        };
+
+        write_node("node1", "2-3");
+        write_node("node0", "0-1");
+        write_node("node2", ""); // memory only
+        write_node("possible", "0-3");
+
+        auto topology = numa_topology::from_sysfs(root);
+        REQUIRE(topology.nodes.size() == 2);
+        CHECK(topology.nodes[0].id == 0);
+        CHECK(topology.nodes[0].cpus == std::vector< std::uint32_t >{ 0, 1 });
+        CHECK(topology.nodes[1].id == 1);
+        CHECK(topology.nodes[1].cpus == std::vector< std::uint32_t >{ 2, 3 });
+        CHECK(topology.cpu_count() == 4);
+
+        CHECK(numa_topology::from_sysfs(root / "missing").nodes.empty());
+        fs::remove_all(root);
+    }
+
+    TEST_CASE("detect finds at least one node") {
+        auto topology = numa_topology::detect();
+        REQUIRE(!topology.nodes.empty());
+        CHECK(topology.cpu_count() > 0);
+    }
+
+    TEST_CASE("schedule_on resumes on the node") {
+        numa_thread_pool pool{
+            numa_topology::uniform(2, 1),
+            { .threads_per_node = 2, .pin_threads = false, .steal_across_nodes = false }
+        };
+        CHECK(pool.node_count() == 2);
+        CHECK(pool.thread_count() == 4);
+        CHECK(!pool.current_node());
+
+        std::atomic< int > misplaced = 0;
+        auto on_node = [&](std::uint32_t node) -> task<> {
+            co_await pool.schedule_on(node);
+            for (int i = 0; i < 10; ++i) {
+                if (pool.current_node() != node) {
+                    ++misplaced;
+                }
+
+                // Scheduling from a worker keeps to the worker's node.
+                co_await pool.schedule();
+            }
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < 20; ++i) {
+            tasks.push_back(on_node(std::uint32_t(i % 2)));
+        }
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+        CHECK(misplaced == 0);
+    }
+
+    TEST_CASE("many tasks with stealing across nodes") {
+        numa_thread_pool pool{
+            numa_topology::uniform(2, 2), { .pin_threads = false }
+        };
+
+        std::atomic< int > counter = 0;
+        auto work = [&](std::uint32_t node) -> task<> {
+            co_await pool.schedule_on(node);
+            for (int i = 0; i < 100; ++i) {
+                counter.fetch_add(1, std::memory_order_relaxed);
+                co_await pool.schedule();
+            }
+        };
+
+        std::vector< task<> > tasks;
+        for (int i = 0; i < 64; ++i) {
+            // Everything goes to one node, the other has to steal to help.
+            tasks.push_back(work(0));
+        }
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+        CHECK(counter == 6'400);
+    }
+
+    TEST_CASE("arena serves aligned memory") {
+        numa_arena arena{ 0, 4096 };
+        auto *a = arena.allocate(10, 1);
+        auto *b = arena.allocate(64, 64);
+        CHECK(reinterpret_cast< std::uintptr_t >(b) % 64 == 0);
+        CHECK(a != b);
+
+        // Larger than a chunk.
+        auto *big = static_cast< std::byte* >(arena.allocate(1 << 16, 16));
+        big[0] = big[(1 << 16) - 1] = std::byte{ 1 };
+
+        std::pmr::vector< int > values(&arena);
+        for (int i = 0; i < 10'000; ++i) {
+            values.push_back(i);
+        }
+        CHECK(std::accumulate(values.begin(), values.end(), 0ll) == 49'995'000ll);
+        arena.release();
+    }
+
+    TEST_CASE("frame allocator places and reuses frames") {
+        numa_thread_pool pool{ numa_topology::uniform(1, 1), { .pin_threads = false } };
+        auto alloc = pool.frame_allocator(0);
+
+        CHECK(sync_wait(add_one(std::allocator_arg, alloc, 41)) == 42);
+        auto reserved = alloc.m_pool->reserved();
+        CHECK(reserved > 0);
+
+        for (int i = 0; i < 1'000; ++i) {
+            CHECK(sync_wait(add_one(std::allocator_arg, alloc, i)) == i + 1);
+        }
+        CHECK(alloc.m_pool->reserved() == reserved);
+    }
+
+    TEST_CASE("frame pool recycles blocks freed on other threads") {
+        constexpr std::size_t size   = numa_frame_pool::max_pooled_size;
+        constexpr std::size_t blocks = 2 * numa_frame_pool::max_cached_per_class;
+        constexpr std::size_t rounds = 10;
+
+        numa_frame_pool pool{ 0 };
+        for (std::size_t round = 0; round < rounds; ++round) {
+            std::vector< void* > allocated;
+            std::thread([&] {
+                for (std::size_t i = 0; i < blocks; ++i) {
+                    allocated.push_back(pool.allocate(size));
+                }
+            }).join();
+
+            // More than this thread keeps, the rest goes to the shared lists.
+            for (auto *block : allocated) {
+                pool.deallocate(block, size);
+            }
+        }
+
+        // Most rounds are served from the blocks freed in the ones before.
+        CHECK(pool.reserved() < rounds * blocks * size / 2);
+    }
+
+    TEST_CASE("frame pool caches do not outlive their pool") {
+        // A new pool may well be placed where the previous one was, it must
+        // not hand out blocks cached for that one.
+        for (int round = 0; round < 10; ++round) {
+            auto pool  = std::make_unique< numa_frame_pool >(0);
+            auto *block = static_cast< std::byte* >(pool->allocate(64));
+            block[0]    = std::byte{ 1 };
+            pool->deallocate(block, 64);
+            CHECK(pool->allocate(64) == block);
+        }
+    }
+
+    //
+    // Memory-bound work over data owned by each node, sent to the node that
+    // owns it versus to whichever node comes next, run with --no-skip. On a
+    // machine with a single node the nodes are a uniform split of the CPUs
+    // and only the fraction of remote visits is meaningful.
+    //
+    TEST_CASE("numa local scheduling" * doctest::skip()) {
+        constexpr std::size_t block_size = std::size_t(4) << 20; // longs per block
+        constexpr int blocks_per_node    = 4;
+        constexpr int passes             = 8;
+
+        auto topology = numa_topology::detect();
+        if (topology.nodes.size() == 1) {
+            auto cpus = std::max< std::uint32_t >(std::thread::hardware_concurrency() / 2, 1);
+            topology  = numa_topology::uniform(2, cpus);
+        }
+
+        numa_thread_pool pool{ topology, { .steal_across_nodes = false } };
+
+        struct block
+        {
+            std::uint32_t node;
+            std::pmr::vector< long > data;
+        };
+
+        std::vector< block > blocks;
+        for (std::uint32_t node = 0; node < pool.node_count(); ++node) {
+            for (int i = 0; i < blocks_per_node; ++i) {
+                auto &b = blocks.emplace_back(block{ node, std::pmr::vector< long >(&pool.arena(node)) });
+                b.data.resize(block_size, 1);
+            }
+        }
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        auto run = [&](bool local) {
+            std::atomic< long > sum    = 0;
+            std::atomic< int > remote  = 0;
+            std::atomic< int > visits  = 0;
+
+            auto visit = [&](const block &b, std::uint32_t pass) -> task<> {
+                if (local) {
+                    co_await pool.schedule_on(b.node);
+                } else {
+                    co_await pool.schedule_on((b.node + pass) % pool.node_count());
+                }
+
+                remote += pool.current_node() != b.node;
+                ++visits;
+                sum += std::accumulate(b.data.begin(), b.data.end(), 0l);
+            };
+
+            std::vector< double > times;
+            for (std::uint32_t pass = 0; pass < passes; ++pass) {
+                times.push_back(measure_us([&] {
+                    std::vector< task<> > tasks;
+                    for (const auto &b : blocks) {
+                        tasks.push_back(visit(b, pass));
+                    }
+                    sync_wait(when_all_ready_vec(std::move(tasks)));
+                }));
+            }
+
+            MESSAGE(
+                (local ? "owner node" : "rotating node") << ": mean " << bench::mean(times)
+                << " us per pass, remote visits " << remote << " / " << visits
+            );
+        };
+
+        MESSAGE("nodes: " << pool.node_count() << ", threads: " << pool.thread_count());
+        run(true);
+        run(false);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
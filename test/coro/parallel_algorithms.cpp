@@ -0,0 +1,269 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/parallel_algorithms.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+
+    #include <algorithm>
+    #include <atomic>
+    #include <chrono>
+    #include <cmath>
+    #include <cstdint>
+    #include <functional>
+    #include <memory>
+    #include <numeric>
+    #include <random>
+    #include <stdexcept>
+    #include <string>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("parallel_algorithms");
+
+    static std::vector< std::uint64_t > random_values(std::size_t count, std::uint64_t seed = 42) {
+        std::mt19937_64 rng{ seed };
+        std::vector< std::uint64_t > values(count);
+        for (auto &v : values) {
+            v = rng() % (count * 4 + 1);
+        }
+        return values;
+    }
+
+    TEST_CASE("parallel_for visits every element once") {
+        static_thread_pool pool{ 4 };
+
+        std::vector< int > values(100'000, 1);
+        sync_wait(parallel_for(pool, values, [](int &v) { v *= 3; }));
+        CHECK(std::all_of(values.begin(), values.end(), [](int v) { return v == 3; }));
+    }
+
+    TEST_CASE("parallel_for over an empty range") {
+        static_thread_pool pool{ 2 };
+
+        std::vector< int > values;
+        bool called = false;
+        sync_wait(parallel_for(pool, values, [&](int &) { called = true; }));
+        CHECK(!called);
+    }
+
+    TEST_CASE("parallel_for with a coarse grain") {
+        static_thread_pool pool{ 4 };
+
+        std::vector< int > values(1000);
+        std::iota(values.begin(), values.end(), 0);
+
+        std::atomic< std::int64_t > sum = 0;
+        sync_wait(parallel_for(pool, values.begin(), values.end(), [&](int v) { sum += v; }, 256));
+        CHECK(sum == 999 * 1000 / 2);
+    }
+
+    TEST_CASE("parallel_for rethrows the first failure") {
+        static_thread_pool pool{ 4 };
+
+        std::vector< int > values(10'000);
+        std::iota(values.begin(), values.end(), 0);
+
+        std::atomic< int > visited = 0;
+        CHECK_THROWS_AS(sync_wait(parallel_for(pool, values, [&](int v) {
+            ++visited;
+            if (v == 5000) {
+                throw std::runtime_error("failed");
+            }
+        })), std::runtime_error);
+        CHECK(visited <= 10'000);
+    }
+
+    TEST_CASE("parallel_transform_reduce") {
+        static_thread_pool pool{ 4 };
+
+        auto values = random_values(200'000);
+        auto square = [](std::uint64_t v) { return v * v; };
+
+        auto expected = std::transform_reduce(
+            values.begin(), values.end(), std::uint64_t(7), std::plus<>{}, square
+        );
+        auto result = sync_wait(
+            parallel_transform_reduce(pool, values, std::uint64_t(7), std::plus<>{}, square)
+        );
+        CHECK(result == expected);
+    }
+
+    TEST_CASE("parallel_transform_reduce of an empty range returns init") {
+        static_thread_pool pool{ 2 };
+
+        std::vector< int > values;
+        auto result = sync_wait(parallel_transform_reduce(
+            pool, values, std::string("init"),
+            [](std::string a, std::string b) { return a + b; },
+            [](int v) { return std::to_string(v); }
+        ));
+        CHECK(result == "init");
+    }
+
+    TEST_CASE("parallel_transform_reduce with a non-trivial value type") {
+        static_thread_pool pool{ 4 };
+
+        std::vector< int > values(5000, 1);
+        auto result = sync_wait(parallel_transform_reduce(
+            pool, values, std::string(),
+            [](std::string a, std::string b) { return a + b; },
+            [](int v) { return std::string(static_cast< std::size_t >(v), 'x'); }
+        ));
+        CHECK(result == std::string(5000, 'x'));
+    }
+
+    TEST_CASE("parallel_sort matches std::sort") {
+        static_thread_pool pool{ 4 };
+
+        for (std::size_t size : { 0u, 1u, 2u, 17u, 5000u, 100'000u, 250'001u }) {
+            auto values   = random_values(size, size);
+            auto expected = values;
+            std::sort(expected.begin(), expected.end());
+
+            sync_wait(parallel_sort(pool, values));
+            CHECK(values == expected);
+        }
+    }
+
+    TEST_CASE("parallel_sort with a custom comparator") {
+        static_thread_pool pool{ 4 };
+
+        auto values   = random_values(100'000);
+        auto expected = values;
+        std::sort(expected.begin(), expected.end(), std::greater<>{});
+
+        sync_wait(parallel_sort(pool, values.begin(), values.end(), std::greater<>{}));
+        CHECK(values == expected);
+    }
+
+    TEST_CASE("parallel_sort of move-only elements") {
+        static_thread_pool pool{ 4 };
+
+        auto keys = random_values(50'000);
+        std::vector< std::unique_ptr< std::uint64_t > > values;
+        for (auto key : keys) {
+            values.push_back(std::make_unique< std::uint64_t >(key));
+        }
+        std::sort(keys.begin(), keys.end());
+
+        sync_wait(parallel_sort(pool, values, [](const auto &a, const auto &b) { return *a < *b; }));
+
+        REQUIRE(values.size() == keys.size());
+        bool sorted = true;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            sorted = sorted && values[i] && *values[i] == keys[i];
+        }
+        CHECK(sorted);
+    }
+
+    struct no_default
+    {
+        explicit no_default(std::uint64_t v) : value(v) {}
+        std::uint64_t value;
+        auto operator<=>(const no_default &) const = default;
+    };
+
+    TEST_CASE("parallel_sort of elements without a default constructor") {
+        static_thread_pool pool{ 4 };
+
+        auto keys = random_values(60'000);
+        std::vector< no_default > values;
+        for (auto key : keys) {
+            values.emplace_back(key);
+        }
+        std::sort(keys.begin(), keys.end());
+
+        sync_wait(parallel_sort(pool, values));
+
+        bool sorted = true;
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            sorted = sorted && values[i].value == keys[i];
+        }
+        CHECK(sorted);
+    }
+
+    //
+    // Throughput against the sequential algorithms, run with --no-skip.
+    //
+    TEST_CASE("parallel algorithms throughput" * doctest::skip()) {
+        static_thread_pool pool;
+
+        constexpr std::size_t size = 1 << 24;
+        constexpr int samples      = 5;
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        auto source = random_values(size);
+        auto work   = [](std::uint64_t v) {
+            for (int i = 0; i < 16; ++i) {
+                v = v * 6364136223846793005ull + 1442695040888963407ull;
+            }
+            return v;
+        };
+
+        std::vector< double > for_seq, for_par, reduce_seq, reduce_par, sort_seq, sort_par;
+        std::uint64_t sink = 0;
+
+        for (int s = 0; s < samples; ++s) {
+            auto values = source;
+            for_seq.push_back(measure_us([&] {
+                std::for_each(values.begin(), values.end(), [&](auto &v) { v = work(v); });
+            }));
+
+            values = source;
+            for_par.push_back(measure_us([&] {
+                sync_wait(parallel_for(pool, values, [&](auto &v) { v = work(v); }));
+            }));
+
+            reduce_seq.push_back(measure_us([&] {
+                sink += std::transform_reduce(
+                    source.begin(), source.end(), std::uint64_t(0), std::plus<>{}, work
+                );
+            }));
+
+            reduce_par.push_back(measure_us([&] {
+                sink += sync_wait(
+                    parallel_transform_reduce(pool, source, std::uint64_t(0), std::plus<>{}, work)
+                );
+            }));
+
+            values = source;
+            sort_seq.push_back(measure_us([&] { std::sort(values.begin(), values.end()); }));
+
+            values = source;
+            sort_par.push_back(measure_us([&] { sync_wait(parallel_sort(pool, values)); }));
+        }
+
+        auto report = [&](const char *name, const std::vector< double > &us) {
+            auto deviation = std::sqrt(bench::standard_deviation(us));
+            MESSAGE(name << ": " << bench::mean(us) << " us (+-" << deviation << ")");
+        };
+
+        MESSAGE("threads: " << pool.thread_count() << ", elements: " << size);
+        report("std::for_each", for_seq);
+        report("parallel_for", for_par);
+        report("std::transform_reduce", reduce_seq);
+        report("parallel_transform_reduce", reduce_par);
+        report("std::sort", sort_seq);
+        report("parallel_sort", sort_par);
+
+        CHECK(sink != 0);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
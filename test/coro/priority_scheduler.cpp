@@ -0,0 +1,247 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/async_scope.hpp>
+    #include <gap/coro/priority_scheduler.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <algorithm>
+    #include <atomic>
+    #include <chrono>
+    #include <mutex>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("priority_scheduler");
+
+    TEST_CASE("schedule resumes on a worker") {
+        priority_scheduler sched{ 2 };
+        CHECK(sched.thread_count() == 2u);
+
+        auto initiating_thread_id = std::this_thread::get_id();
+        sync_wait([&]() -> task<> {
+            co_await sched.schedule(priority::low);
+            CHECK(std::this_thread::get_id() != initiating_thread_id);
+        }());
+    }
+
+    TEST_CASE("queued high priority work runs first") {
+        priority_scheduler sched{ 1 };
+        std::atomic< bool > released = false;
+
+        std::mutex mutex;
+        std::vector< priority > order;
+
+        // Keeps the only worker busy until everything else is queued.
+        auto blocker = [&]() -> task<> {
+            co_await sched.schedule();
+            while (!released.load()) {
+                std::this_thread::yield();
+            }
+        };
+
+        auto work = [&](priority level) -> task<> {
+            co_await sched.schedule(level);
+            std::lock_guard lock(mutex);
+            order.push_back(level);
+        };
+
+        auto release = [&]() -> task<> {
+            released = true;
+            co_return;
+        };
+
+        sync_wait(when_all_ready(
+            blocker(), work(priority::low), work(priority::normal), work(priority::low),
+            work(priority::high), work(priority::normal), work(priority::high), release()
+        ));
+
+        CHECK(order == std::vector< priority >{
+            priority::high, priority::high, priority::normal, priority::normal,
+            priority::low, priority::low
+        });
+    }
+
+    TEST_CASE("high priority work preempts at the next yield") {
+        priority_scheduler sched{ 1 };
+        async_scope scope;
+
+        std::atomic< int > iteration = 0;
+        int ran_at = -1;
+
+        auto urgent = [&]() -> task<> {
+            co_await sched.schedule(priority::high);
+            ran_at = iteration;
+        };
+
+        sync_wait([&]() -> task<> {
+            co_await sched.schedule(priority::low);
+            for (int i = 0; i < 100; ++i) {
+                iteration = i;
+                if (i == 10) {
+                    scope.spawn(urgent());
+                    CHECK(sched.queued(priority::high) == 1);
+                }
+                co_await sched.yield();
+            }
+            co_await scope.join();
+        }());
+
+        CHECK(ran_at == 10);
+    }
+
+    TEST_CASE("yield lets queued work of the same priority run") {
+        priority_scheduler sched{ 1 };
+        async_scope scope;
+        std::vector< int > order;
+
+        auto other = [&]() -> task<> {
+            co_await sched.schedule(priority::low);
+            order.push_back(1);
+        };
+
+        sync_wait([&]() -> task<> {
+            co_await sched.schedule(priority::low);
+            scope.spawn(other());
+
+            // Nothing more urgent than the low priority coroutine is queued.
+            co_await sched.yield();
+            order.push_back(0);
+            co_await scope.join();
+        }());
+
+        CHECK(order == std::vector< int >{ 1, 0 });
+    }
+
+    TEST_CASE("yield from outside of the scheduler moves onto it") {
+        priority_scheduler sched{ 1 };
+        auto initiating_thread_id = std::this_thread::get_id();
+
+        sync_wait([&]() -> task<> {
+            co_await sched.yield();
+            CHECK(std::this_thread::get_id() != initiating_thread_id);
+        }());
+    }
+
+    TEST_CASE("mixed priorities on many threads") {
+        priority_scheduler sched{ 4 };
+        std::atomic< int > counter = 0;
+
+        auto worker = [&](priority level) -> task<> {
+            co_await sched.schedule(level);
+            for (int i = 0; i < 100; ++i) {
+                counter.fetch_add(1, std::memory_order_relaxed);
+                co_await sched.yield();
+            }
+        };
+
+        std::vector< task<> > tasks;
+        for (std::size_t i = 0; i < 48; ++i) {
+            tasks.push_back(worker(priority(i % priority_scheduler::priority_levels)));
+        }
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+
+        CHECK(counter == 4'800);
+        for (auto level : { priority::high, priority::normal, priority::low }) {
+            CHECK(sched.queued(level) == 0);
+        }
+    }
+
+    //
+    // Latency of short interactive queries next to bulk work, run with
+    // --no-skip.
+    //
+    TEST_CASE("priority scheduler query latency" * doctest::skip()) {
+        constexpr int bulk_tasks = 16;
+        constexpr int queries    = 200;
+        constexpr auto slice     = std::chrono::microseconds(200);
+        constexpr auto interval  = std::chrono::milliseconds(2);
+
+        using clock = std::chrono::steady_clock;
+
+        auto spin = [](std::chrono::microseconds time) {
+            auto until = clock::now() + time;
+            while (clock::now() < until) {
+            }
+        };
+
+        // Bulk work runs in slices separated by 'next_slice', queries are
+        // timed from being scheduled until they run.
+        auto run = [&](auto &&next_slice, auto &&schedule_bulk, auto &&schedule_query) {
+            std::atomic< bool > stop = false;
+            auto bulk = [&]() -> task<> {
+                co_await schedule_bulk();
+                while (!stop.load(std::memory_order_relaxed)) {
+                    spin(slice);
+                    co_await next_slice();
+                }
+            };
+
+            async_scope scope;
+            for (int i = 0; i < bulk_tasks; ++i) {
+                scope.spawn(bulk());
+            }
+
+            std::vector< double > latencies;
+            for (int i = 0; i < queries; ++i) {
+                std::this_thread::sleep_for(interval);
+                sync_wait([&]() -> task<> {
+                    auto start = clock::now();
+                    co_await schedule_query();
+                    latencies.push_back(
+                        std::chrono::duration< double, std::micro >(clock::now() - start).count()
+                    );
+                }());
+            }
+
+            stop = true;
+            sync_wait([&]() -> task<> { co_await scope.join(); }());
+            return latencies;
+        };
+
+        auto threads = std::max(std::thread::hardware_concurrency() / 2, 1u);
+
+        // Without priorities queries wait in line with the bulk work.
+        std::vector< double > prioritized, shared;
+        {
+            priority_scheduler sched{ threads };
+            prioritized = run(
+                [&] { return sched.yield(); },
+                [&] { return sched.schedule(priority::low); },
+                [&] { return sched.schedule(priority::high); }
+            );
+        }
+        {
+            priority_scheduler sched{ threads };
+            shared = run(
+                [&] { return sched.yield(); },
+                [&] { return sched.schedule(priority::normal); },
+                [&] { return sched.schedule(priority::normal); }
+            );
+        }
+
+        auto report = [&](const char *name, std::vector< double > us) {
+            std::sort(us.begin(), us.end());
+            auto p99 = us[us.size() * 99 / 100];
+            MESSAGE(name << ": mean " << bench::mean(us) << " us, p99 " << p99 << " us");
+        };
+
+        MESSAGE("threads: " << threads << ", bulk tasks: " << bulk_tasks << ", queries: " << queries);
+        report("high priority queries", prioritized);
+        report("queries at the priority of the bulk work", shared);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,245 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#if defined(GAP_ENABLE_COROUTINES) && defined(__linux__)
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/async_generator.hpp>
+    #include <gap/coro/process.hpp>
+    #include <gap/coro/reactor.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <chrono>
+    #include <string>
+    #include <string_view>
+    #include <system_error>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("reactor");
+
+    namespace
+    {
+        std::span< const std::byte > bytes(std::string_view text) {
+            return std::as_bytes(std::span(text.data(), text.size()));
+        }
+
+        task< std::string > read_all(async_pipe &pipe) {
+            std::string result;
+            std::vector< std::byte > buffer(4096);
+            while (auto read = co_await pipe.read_some(buffer)) {
+                result.append(reinterpret_cast< const char* >(buffer.data()), read);
+            }
+            co_return result;
+        }
+
+        task< std::string > collect(async_generator< std::string > output) {
+            std::string result;
+            for (auto it = co_await output.begin(); it != output.end(); co_await ++it) {
+                result += *it;
+            }
+            co_return result;
+        }
+
+    } // namespace
+
+    TEST_CASE("pipe round trip") {
+        reactor r;
+        auto [in, out] = async_pipe::create(r);
+
+        sync_wait(out.write_all(bytes("hello")));
+        out.close();
+        CHECK(sync_wait(read_all(in)) == "hello");
+    }
+
+    TEST_CASE("read waits for the writer") {
+        reactor r;
+        static_thread_pool pool{ 1 };
+        auto [in, out] = async_pipe::create(r);
+
+        auto writer = [&]() -> task<> {
+            co_await pool.schedule();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            co_await out.write_all(bytes("late"));
+            out.close();
+        };
+
+        auto [written, read] = sync_wait(when_all_ready(writer(), read_all(in)));
+        written.result();
+        CHECK(read.result() == "late");
+    }
+
+    TEST_CASE("write waits for the reader") {
+        // Several times what a pipe buffers.
+        const std::string data(1 << 20, 'x');
+
+        reactor r;
+        static_thread_pool pool{ 1 };
+        auto [in, out] = async_pipe::create(r);
+
+        auto writer = [&]() -> task<> {
+            co_await out.write_all(bytes(data));
+            out.close();
+        };
+
+        auto reader = [&]() -> task< std::string > {
+            co_await pool.schedule();
+            co_return co_await read_all(in);
+        };
+
+        auto [written, read] = sync_wait(when_all_ready(writer(), reader()));
+        written.result();
+        CHECK(read.result() == data);
+    }
+
+    TEST_CASE("writing to a closed pipe throws") {
+        reactor r;
+        auto [in, out] = async_pipe::create(r);
+        in.close();
+
+        // EPIPE rather than SIGPIPE killing the test.
+        CHECK_THROWS_AS(sync_wait(out.write_some(bytes("lost"))), std::system_error);
+    }
+
+    TEST_CASE("run_process streams stdout") {
+        reactor r;
+        auto output = sync_wait(collect(run_process({ "sh", "-c", "echo hello; echo world" }, {}, r)));
+        CHECK(output == "hello\nworld\n");
+
+        auto merged = sync_wait(collect(
+            run_process({ "sh", "-c", "echo out; echo err >&2" }, { .merge_stderr = true }, r)
+        ));
+        CHECK(merged == "out\nerr\n");
+    }
+
+    TEST_CASE("run_process failures throw") {
+        reactor r;
+        try {
+            sync_wait(collect(run_process({ "sh", "-c", "echo partial; exit 3" }, {}, r)));
+            FAIL("expected process_error");
+        } catch (const process_error &error) {
+            CHECK(error.exit_code() == 3);
+        }
+
+        CHECK_THROWS_AS(
+            sync_wait(collect(run_process({ "gap-test-no-such-program" }, {}, r))),
+            std::system_error
+        );
+    }
+
+    TEST_CASE("child_process stdin and exit code") {
+        reactor r;
+        auto child = child_process::spawn({ "cat" }, { .pipe_stdin = true }, r);
+
+        sync_wait(child.stdin_pipe().write_all(bytes("echoed")));
+        child.stdin_pipe().close();
+        CHECK(sync_wait(read_all(child.stdout_pipe())) == "echoed");
+        CHECK(sync_wait(child.wait()) == 0);
+        CHECK(sync_wait(child.wait()) == 0);
+
+        auto killed = child_process::spawn({ "sh", "-c", "kill -9 $$" }, {}, r);
+        CHECK(sync_wait(killed.wait()) == 128 + 9);
+    }
+
+    TEST_CASE("few threads supervise many children") {
+        constexpr int children = 100;
+
+        reactor r{ 1 };
+        static_thread_pool pool{ 2 };
+
+        auto run = [&](int i) -> task< bool > {
+            co_await pool.schedule();
+            std::vector< std::string > argv{ "echo", std::to_string(i) };
+            auto output = co_await collect(run_process(std::move(argv), {}, r));
+            co_return output == std::to_string(i) + "\n";
+        };
+
+        std::vector< task< bool > > tasks;
+        for (int i = 0; i < children; ++i) {
+            tasks.push_back(run(i));
+        }
+
+        auto results = sync_wait(when_all_ready_vec(std::move(tasks)));
+        int correct  = 0;
+        for (auto &result : results) {
+            correct += result.result();
+        }
+        CHECK(correct == children);
+    }
+
+    TEST_CASE("resumes on the original scheduler") {
+        reactor r;
+        static_thread_pool pool{ 1 };
+        auto [in, out] = async_pipe::create(r);
+
+        auto reader = [&]() -> task< bool > {
+            co_await pool.schedule();
+            auto worker = std::this_thread::get_id();
+            std::vector< std::byte > buffer(8);
+            co_await in.read_some(buffer);
+            co_return std::this_thread::get_id() == worker;
+        };
+
+        auto writer = [&]() -> task<> {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            co_await out.write_all(bytes("x"));
+        };
+
+        auto [read, written] = sync_wait(when_all_ready(reader(), writer()));
+        written.result();
+        CHECK(read.result());
+    }
+
+    //
+    // Hundreds of children at once, supervised by one reactor thread and a
+    // two thread pool, run with --no-skip.
+    //
+    TEST_CASE("supervising children" * doctest::skip()) {
+        constexpr int children = 500;
+
+        reactor r{ 1 };
+        static_thread_pool pool{ 2 };
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        auto run = [&]() -> task< std::size_t > {
+            co_await pool.schedule();
+            std::vector< std::string > argv{ "sh", "-c", "sleep 0.1; echo done" };
+            auto output = co_await collect(run_process(std::move(argv), {}, r));
+            co_return output.size();
+        };
+
+        std::vector< double > times;
+        for (int round = 0; round < 3; ++round) {
+            times.push_back(measure_us([&] {
+                std::vector< task< std::size_t > > tasks;
+                for (int i = 0; i < children; ++i) {
+                    tasks.push_back(run());
+                }
+                sync_wait(when_all_ready_vec(std::move(tasks)));
+            }));
+        }
+
+        MESSAGE(
+            children << " children sleeping 100 ms each: mean " << bench::mean(times) << " us on "
+                     << r.thread_count() << " reactor thread and 2 pool threads"
+        );
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES && __linux__
@@ -0,0 +1,180 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of cppcoro/test/sequence_barrier_tests.cpp
+// from the cppcoro project. The original file is licenced under the MIT
+// license and the original license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/sequence_barrier.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <cstdint>
+    #include <thread>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("sequence_barrier");
+
+    TEST_CASE("default constructed sequence_barrier") {
+        sequence_barrier< std::uint32_t > barrier;
+        CHECK(barrier.last_published() == sequence_traits< std::uint32_t >::initial_sequence);
+    }
+
+    TEST_CASE("constructing with an initial sequence number") {
+        sequence_barrier< std::uint64_t > barrier{ 100 };
+        CHECK(barrier.last_published() == 100);
+    }
+
+    TEST_CASE("waiting for an already published sequence number doesn't suspend") {
+        sequence_barrier< std::uint32_t > barrier;
+        barrier.publish(3);
+
+        auto result = sync_wait([&]() -> task< std::uint32_t > {
+            co_return co_await barrier.wait_until_published(2);
+        }());
+
+        CHECK(result == 3);
+    }
+
+    TEST_CASE("publish resumes the waiters it satisfies") {
+        sequence_barrier< std::uint32_t > barrier;
+
+        bool reached_a = false;
+        bool reached_b = false;
+        bool reached_c = false;
+        bool reached_d = false;
+
+        auto waiter = [&](std::uint32_t target, bool &reached) -> task<> {
+            auto published = co_await barrier.wait_until_published(target);
+            CHECK(published >= target);
+            reached = true;
+        };
+
+        auto publisher = [&]() -> task<> {
+            CHECK(!reached_a);
+            barrier.publish(0);
+            CHECK(reached_a);
+            CHECK(!reached_b);
+
+            barrier.publish(5);
+            CHECK(reached_b);
+            CHECK(reached_c);
+            CHECK(!reached_d);
+
+            barrier.publish(9);
+            CHECK(!reached_d);
+
+            barrier.publish(10);
+            CHECK(reached_d);
+            co_return;
+        };
+
+        sync_wait(when_all_ready(
+            waiter(0, reached_a),
+            waiter(3, reached_b),
+            waiter(5, reached_c),
+            waiter(10, reached_d),
+            publisher()
+        ));
+    }
+
+    TEST_CASE("sequence numbers wrap around") {
+        sequence_barrier< std::uint8_t > barrier{ 250 };
+
+        bool reached = false;
+        auto waiter = [&]() -> task<> {
+            // 3 follows 250 once the 8-bit sequence number wraps.
+            auto published = co_await barrier.wait_until_published(3);
+            CHECK(published == 3);
+            reached = true;
+        };
+
+        auto publisher = [&]() -> task<> {
+            barrier.publish(255);
+            CHECK(!reached);
+            barrier.publish(2);
+            CHECK(!reached);
+            barrier.publish(3);
+            CHECK(reached);
+            co_return;
+        };
+
+        sync_wait(when_all_ready(waiter(), publisher()));
+    }
+
+    TEST_CASE("consumer resumed on a scheduler") {
+        static_thread_pool pool{ 2 };
+        sequence_barrier< std::uint32_t > barrier;
+
+        auto consumer = [&]() -> task< std::thread::id > {
+            co_await barrier.wait_until_published(7, pool);
+            co_return std::this_thread::get_id();
+        };
+
+        auto producer = [&]() -> task<> {
+            barrier.publish(7);
+            co_return;
+        };
+
+        auto [id, done] = sync_wait(when_all_ready(consumer(), producer()));
+        CHECK(id.result() != std::this_thread::get_id());
+    }
+
+    TEST_CASE("producer and consumer on different threads") {
+        static_thread_pool pool{ 2 };
+
+        constexpr std::uint64_t iterations = 10'000;
+
+        sequence_barrier< std::uint64_t > written;
+        sequence_barrier< std::uint64_t > read;
+
+        constexpr std::uint64_t buffer_size = 16;
+        std::uint64_t buffer[buffer_size];
+
+        auto producer = [&]() -> task<> {
+            co_await pool.schedule();
+            for (std::uint64_t seq = 0; seq < iterations; ++seq) {
+                if (seq >= buffer_size) {
+                    co_await read.wait_until_published(seq - buffer_size, pool);
+                }
+                buffer[seq % buffer_size] = seq;
+                written.publish(seq);
+            }
+        };
+
+        auto consumer = [&]() -> task< std::uint64_t > {
+            co_await pool.schedule();
+            std::uint64_t sum = 0;
+            std::uint64_t next = 0;
+            while (next < iterations) {
+                auto available = co_await written.wait_until_published(next, pool);
+                for (; next <= available; ++next) {
+                    sum += buffer[next % buffer_size];
+                }
+                read.publish(available);
+            }
+            co_return sum;
+        };
+
+        auto [produced, consumed] = sync_wait(when_all_ready(producer(), consumer()));
+        produced.result();
+        CHECK(consumed.result() == iterations * (iterations - 1) / 2);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
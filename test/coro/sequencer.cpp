@@ -0,0 +1,301 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+///////////////////////////////////////////////////////////////////////////////
+// Copyright (c) Lewis Baker
+// Licenced under MIT license. See LICENSE.txt for details.
+///////////////////////////////////////////////////////////////////////////////
+// This file is a modified version of
+// cppcoro/test/single_producer_sequencer_tests.cpp and
+// cppcoro/test/multi_producer_sequencer_tests.cpp from the cppcoro project.
+// The original files are licenced under the MIT license and the original
+// license is included above.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/channel.hpp>
+    #include <gap/coro/multi_producer_sequencer.hpp>
+    #include <gap/coro/sequence_barrier.hpp>
+    #include <gap/coro/single_producer_sequencer.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <chrono>
+    #include <cmath>
+    #include <cstddef>
+    #include <cstdint>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("sequencer");
+
+    TEST_CASE("sequence_range") {
+        sequence_range< std::uint8_t > range{ 254, 2 };
+        CHECK(range.size() == 4);
+        CHECK(range.front() == 254);
+        CHECK(range.back() == 1);
+
+        std::vector< std::uint8_t > values(range.begin(), range.end());
+        CHECK(values == std::vector< std::uint8_t >{ 254, 255, 0, 1 });
+
+        CHECK(range.first(2).size() == 2);
+        CHECK(range.skip(3).front() == 1);
+        CHECK(range.skip(10).empty());
+    }
+
+    TEST_CASE("single_producer_sequencer claims are bounded by the consumer") {
+        sequence_barrier< std::size_t > read_barrier;
+        single_producer_sequencer< std::size_t > sequencer{ read_barrier, 4 };
+
+        sync_wait([&]() -> task<> {
+            auto first = co_await sequencer.claim_up_to(3);
+            CHECK(first.front() == 0);
+            CHECK(first.size() == 3);
+
+            // Only one slot is left until the consumer releases some.
+            auto second = co_await sequencer.claim_up_to(3);
+            CHECK(second.front() == 3);
+            CHECK(second.size() == 1);
+
+            sequencer.publish(second.back());
+            read_barrier.publish(1);
+
+            auto third = co_await sequencer.claim_one();
+            CHECK(third == 4);
+        }());
+
+        CHECK(sequencer.last_published() == 3);
+    }
+
+    TEST_CASE("single_producer_sequencer producer and consumer on a thread pool") {
+        static_thread_pool pool{ 2 };
+
+        constexpr std::size_t buffer_size = 256;
+        constexpr std::size_t iterations  = 100'000;
+
+        sequence_barrier< std::size_t > read_barrier;
+        single_producer_sequencer< std::size_t > sequencer{ read_barrier, buffer_size };
+        std::vector< std::uint64_t > buffer(buffer_size);
+
+        auto producer = [&]() -> task<> {
+            co_await pool.schedule();
+            std::size_t produced = 0;
+            while (produced < iterations) {
+                auto range = co_await sequencer.claim_up_to(iterations - produced, pool);
+                for (auto seq : range) {
+                    buffer[seq % buffer_size] = seq;
+                }
+                produced += range.size();
+                sequencer.publish(range.back());
+            }
+        };
+
+        auto consumer = [&]() -> task< std::uint64_t > {
+            co_await pool.schedule();
+            std::uint64_t sum = 0;
+            std::size_t next  = 0;
+            while (next < iterations) {
+                auto available = co_await sequencer.wait_until_published(next, pool);
+                for (; next <= available; ++next) {
+                    sum += buffer[next % buffer_size];
+                }
+                read_barrier.publish(available);
+            }
+            co_return sum;
+        };
+
+        auto [produced, consumed] = sync_wait(when_all_ready(producer(), consumer()));
+        produced.result();
+        CHECK(consumed.result() == std::uint64_t(iterations) * (iterations - 1) / 2);
+    }
+
+    TEST_CASE("multi_producer_sequencer publishes out of order") {
+        sequence_barrier< std::uint32_t > read_barrier;
+        multi_producer_sequencer< std::uint32_t > sequencer{ read_barrier, 8 };
+        CHECK(sequencer.buffer_size() == 8);
+
+        std::uint32_t last_known = sequence_traits< std::uint32_t >::initial_sequence;
+        std::uint32_t available  = 0;
+        bool resumed             = false;
+
+        auto consumer = [&]() -> task<> {
+            available = co_await sequencer.wait_until_published(1, last_known);
+            resumed   = true;
+        };
+
+        auto producers = [&]() -> task<> {
+            auto a = co_await sequencer.claim_one();
+            auto b = co_await sequencer.claim_up_to(2);
+            CHECK(a == 0);
+            CHECK(b.front() == 1);
+
+            // Slot 0 is missing, so nothing is visible yet.
+            sequencer.publish(b);
+            CHECK(!resumed);
+            CHECK(sequencer.last_published_after(last_known) == last_known);
+
+            sequencer.publish(a);
+            CHECK(resumed);
+            CHECK(available == 2);
+        };
+
+        sync_wait(when_all_ready(consumer(), producers()));
+    }
+
+    TEST_CASE("multi_producer_sequencer many producers on a thread pool") {
+        static_thread_pool pool{ 4 };
+
+        constexpr std::size_t buffer_size         = 64;
+        constexpr std::uint64_t producer_count    = 3;
+        constexpr std::uint64_t values_per_producer = 10'000;
+        constexpr std::uint64_t total             = producer_count * values_per_producer;
+
+        sequence_barrier< std::size_t > read_barrier;
+        multi_producer_sequencer< std::size_t > sequencer{ read_barrier, buffer_size };
+        std::vector< std::uint64_t > buffer(buffer_size);
+
+        auto producer = [&]() -> task<> {
+            co_await pool.schedule();
+            std::uint64_t produced = 0;
+            while (produced < values_per_producer) {
+                auto range = co_await sequencer.claim_up_to(
+                    std::min< std::uint64_t >(8, values_per_producer - produced), pool
+                );
+                for (auto seq : range) {
+                    buffer[seq & (buffer_size - 1)] = 1;
+                }
+                produced += range.size();
+                sequencer.publish(range);
+            }
+        };
+
+        auto consumer = [&]() -> task< std::uint64_t > {
+            co_await pool.schedule();
+            std::uint64_t sum = 0;
+            std::size_t next  = 0;
+            std::size_t last_known = sequence_traits< std::size_t >::initial_sequence;
+            while (next < total) {
+                auto available = co_await sequencer.wait_until_published(next, last_known, pool);
+                for (; next <= available; ++next) {
+                    sum += buffer[next & (buffer_size - 1)];
+                }
+                last_known = available;
+                read_barrier.publish(available);
+            }
+            co_return sum;
+        };
+
+        auto produce_all = [&]() -> task<> {
+            std::vector< task<> > tasks;
+            for (std::uint64_t i = 0; i < producer_count; ++i) {
+                tasks.push_back(producer());
+            }
+            co_await when_all_ready_vec(std::move(tasks));
+        };
+
+        auto [produced, consumed] = sync_wait(when_all_ready(produce_all(), consumer()));
+        produced.result();
+        CHECK(consumed.result() == total);
+    }
+
+    //
+    // Throughput benchmark against channel<T>, run with --no-skip.
+    //
+    TEST_CASE("single_producer_sequencer vs channel throughput" * doctest::skip()) {
+        static_thread_pool pool{ 2 };
+
+        constexpr std::size_t buffer_size = 1024;
+        constexpr std::size_t iterations  = 1 << 20;
+        constexpr int samples             = 5;
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        std::vector< double > sequencer_us, channel_us;
+        std::uint64_t sink = 0;
+
+        for (int s = 0; s < samples; ++s) {
+            sequencer_us.push_back(measure_us([&] {
+                sequence_barrier< std::size_t > read_barrier;
+                single_producer_sequencer< std::size_t > sequencer{ read_barrier, buffer_size };
+                std::vector< std::uint64_t > buffer(buffer_size);
+
+                auto producer = [&]() -> task<> {
+                    co_await pool.schedule();
+                    std::size_t produced = 0;
+                    while (produced < iterations) {
+                        auto range = co_await sequencer.claim_up_to(iterations - produced, pool);
+                        for (auto seq : range) {
+                            buffer[seq % buffer_size] = seq;
+                        }
+                        produced += range.size();
+                        sequencer.publish(range.back());
+                    }
+                };
+
+                auto consumer = [&]() -> task<> {
+                    co_await pool.schedule();
+                    std::size_t next = 0;
+                    while (next < iterations) {
+                        auto available = co_await sequencer.wait_until_published(next, pool);
+                        for (; next <= available; ++next) {
+                            sink += buffer[next % buffer_size];
+                        }
+                        read_barrier.publish(available);
+                    }
+                };
+
+                sync_wait(when_all_ready(producer(), consumer()));
+            }));
+
+            channel_us.push_back(measure_us([&] {
+                channel< std::uint64_t > ch{ buffer_size };
+
+                auto producer = [&]() -> task<> {
+                    co_await pool.schedule();
+                    for (std::size_t i = 0; i < iterations; ++i) {
+                        co_await ch.send(i);
+                    }
+                    ch.close();
+                };
+
+                auto consumer = [&]() -> task<> {
+                    co_await pool.schedule();
+                    while (auto value = co_await ch.receive()) {
+                        sink += *value;
+                    }
+                };
+
+                sync_wait(when_all_ready(producer(), consumer()));
+            }));
+        }
+
+        auto report = [&](const char *name, const std::vector< double > &us) {
+            auto avg       = bench::mean(us);
+            auto deviation = std::sqrt(bench::standard_deviation(us));
+            MESSAGE(name << ": " << avg << " us (+-" << deviation << "), "
+                         << (avg * 1000.0 / iterations) << " ns/item");
+        };
+
+        report("single_producer_sequencer", sequencer_us);
+        report("channel", channel_us);
+
+        CHECK(sink != 0);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,197 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+
+    #include <atomic>
+    #include <chrono>
+    #include <cmath>
+    #include <cstdint>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("static_thread_pool");
+
+    TEST_CASE("construct/destruct") {
+        static_thread_pool pool;
+        CHECK(pool.thread_count() == std::max(std::thread::hardware_concurrency(), 1u));
+    }
+
+    TEST_CASE("construct/destruct to specific thread count") {
+        static_thread_pool pool{ 5 };
+        CHECK(pool.thread_count() == 5u);
+    }
+
+    TEST_CASE("run one task") {
+        static_thread_pool pool{ 2 };
+
+        auto initiating_thread_id = std::this_thread::get_id();
+
+        sync_wait([&]() -> task<> {
+            co_await pool.schedule();
+            CHECK(std::this_thread::get_id() != initiating_thread_id);
+        }());
+    }
+
+    TEST_CASE("schedule from inside the pool") {
+        static_thread_pool pool{ 2 };
+
+        auto result = sync_wait([&]() -> task< int > {
+            co_await pool.schedule();
+            co_await pool.schedule();
+            co_return 42;
+        }());
+
+        CHECK(result == 42);
+    }
+
+    TEST_CASE("launch many tasks remotely") {
+        static_thread_pool pool;
+
+        std::atomic< std::uint32_t > counter = 0;
+
+        auto make_task = [&]() -> task<> {
+            co_await pool.schedule();
+            counter.fetch_add(1, std::memory_order_relaxed);
+        };
+
+        std::vector< task<> > tasks;
+        for (std::uint32_t i = 0; i < 100; ++i) {
+            tasks.push_back(make_task());
+        }
+
+        sync_wait(when_all_ready_vec(std::move(tasks)));
+
+        CHECK(counter.load() == 100u);
+    }
+
+    TEST_CASE("fan out from a worker thread") {
+        static_thread_pool pool{ 4 };
+
+        std::atomic< std::uint64_t > sum = 0;
+
+        auto leaf = [&](std::uint64_t value) -> task<> {
+            co_await pool.schedule();
+            sum.fetch_add(value, std::memory_order_relaxed);
+        };
+
+        auto root = [&]() -> task<> {
+            co_await pool.schedule();
+
+            // Spawned from a worker, so these land in its local deque and
+            // the remaining workers have to steal them.
+            std::vector< task<> > tasks;
+            for (std::uint64_t i = 1; i <= 10'000; ++i) {
+                tasks.push_back(leaf(i));
+            }
+
+            co_await when_all_ready_vec(std::move(tasks));
+        };
+
+        sync_wait(root());
+
+        CHECK(sum.load() == 10'000u * 10'001u / 2u);
+    }
+
+    //
+    // Throughput benchmark, run with --no-skip.
+    //
+    namespace
+    {
+        std::uint64_t spin_work(std::uint64_t seed) noexcept {
+            // A few hundred nanoseconds of dependent integer work.
+            for (int i = 0; i < 256; ++i) {
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+            }
+            return seed;
+        }
+
+        template< typename function_t >
+        double measure_us(function_t &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        }
+
+    } // namespace
+
+    TEST_CASE("static_thread_pool vs std::thread fan-out" * doctest::skip()) {
+        constexpr std::uint32_t jobs    = 1 << 14;
+        constexpr std::uint32_t samples = 5;
+
+        static_thread_pool pool;
+        const auto threads = pool.thread_count();
+
+        std::vector< double > pool_us, thread_us;
+        std::atomic< std::uint64_t > sink = 0;
+
+        for (std::uint32_t s = 0; s < samples; ++s) {
+            pool_us.push_back(measure_us([&] {
+                auto job = [&](std::uint64_t i) -> task<> {
+                    co_await pool.schedule();
+                    sink.fetch_add(spin_work(i), std::memory_order_relaxed);
+                };
+
+                std::vector< task<> > tasks;
+                tasks.reserve(jobs);
+                for (std::uint64_t i = 0; i < jobs; ++i) {
+                    tasks.push_back(job(i));
+                }
+
+                sync_wait(when_all_ready_vec(std::move(tasks)));
+            }));
+
+            // One std::thread per job, capped at 'threads' in flight.
+            thread_us.push_back(measure_us([&] {
+                std::vector< std::thread > workers;
+                workers.reserve(threads);
+                for (std::uint64_t i = 0; i < jobs; ++i) {
+                    workers.emplace_back([&, i] {
+                        sink.fetch_add(spin_work(i), std::memory_order_relaxed);
+                    });
+
+                    if (workers.size() == threads) {
+                        for (auto &w : workers) {
+                            w.join();
+                        }
+                        workers.clear();
+                    }
+                }
+
+                for (auto &w : workers) {
+                    w.join();
+                }
+            }));
+        }
+
+        auto report = [&](const char *name, const std::vector< double > &us) {
+            auto avg       = bench::mean(us);
+            auto deviation = std::sqrt(bench::standard_deviation(us));
+            MESSAGE(name << ": " << avg << " us (+-" << deviation << "), "
+                         << (jobs / avg) << " jobs/us");
+        };
+
+        report("static_thread_pool", pool_us);
+        report("std::thread", thread_us);
+
+        CHECK(sink.load() != 0u);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
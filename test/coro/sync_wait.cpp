@@ -12,16 +12,26 @@
 #ifdef GAP_ENABLE_COROUTINES
 
     #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
     #include <gap/coro/sync_wait.hpp>
 
     #include <gap/core/config.hpp>
     #include <gap/core/on_scope_exit.hpp>
 
+    #include <gap/coro/manual_reset_event.hpp>
     #include <gap/coro/task.hpp>
     #include <gap/coro/shared_task.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
 
+    #include <atomic>
+    #include <chrono>
+    #include <cmath>
+    #include <cstdint>
+    #include <memory>
     #include <string>
+    #include <thread>
     #include <type_traits>
+    #include <vector>
 
 using namespace gap::coro;
 
@@ -62,6 +72,139 @@ namespace gap::test
         CHECK(gap::coro::sync_wait(makeTask()) == "foo");
     }
 
+    TEST_CASE("manual_reset_event set before wait") {
+        manual_reset_event event;
+        CHECK(!event.is_set());
+        event.set();
+        CHECK(event.is_set());
+        event.wait();
+
+        event.reset();
+        CHECK(!event.is_set());
+
+        manual_reset_event initially_set{ true };
+        initially_set.wait();
+    }
+
+    TEST_CASE("manual_reset_event wakes a parked waiter") {
+        manual_reset_event event;
+        std::atomic< bool > woken = false;
+
+        std::thread waiter([&] {
+            event.wait();
+            woken = true;
+        });
+
+        // Long enough for the waiter to exhaust its spin budget and park.
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CHECK(!woken);
+        event.set();
+        waiter.join();
+        CHECK(woken);
+    }
+
+    TEST_CASE("manual_reset_event is destroyed as soon as wait returns") {
+        // As in sync_wait(), set() must be done with the event by then.
+        for (int i = 0; i < 200; ++i) {
+            auto event = std::make_unique< manual_reset_event >();
+            std::thread setter([&to_set = *event] { to_set.set(); });
+            event->wait();
+            event.reset();
+            setter.join();
+        }
+    }
+
+    TEST_CASE("sync_wait(task<T>) completing on another thread") {
+        static_thread_pool pool{ 2 };
+
+        auto on_pool = [&](int value) -> task< int > {
+            co_await pool.schedule();
+            co_return value;
+        };
+
+        for (int i = 0; i < 1000; ++i) {
+            CHECK(sync_wait(on_pool(i)) == i);
+        }
+    }
+
+    //
+    // Latency benchmark, run with --no-skip.
+    //
+    TEST_CASE("sync_wait latency" * doctest::skip()) {
+        static_thread_pool pool;
+
+        constexpr int iterations = 100'000;
+        constexpr int samples    = 5;
+
+        auto measure_us = [](auto &&fn) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            auto stop = std::chrono::steady_clock::now();
+            return std::chrono::duration< double, std::micro >(stop - start).count();
+        };
+
+        auto completed = []() -> task< std::uint64_t > { co_return 1; };
+
+        auto on_pool = [&]() -> task< std::uint64_t > {
+            co_await pool.schedule();
+            co_return 1;
+        };
+
+        const auto thread_count = std::max(2u, std::thread::hardware_concurrency());
+
+        std::vector< double > completed_us, on_pool_us, contended_us;
+        std::atomic< std::uint64_t > sink = 0;
+
+        for (int s = 0; s < samples; ++s) {
+            completed_us.push_back(measure_us([&] {
+                std::uint64_t sum = 0;
+                for (int i = 0; i < iterations; ++i) {
+                    sum += sync_wait(completed());
+                }
+                sink += sum;
+            }));
+
+            on_pool_us.push_back(measure_us([&] {
+                std::uint64_t sum = 0;
+                for (int i = 0; i < iterations; ++i) {
+                    sum += sync_wait(on_pool());
+                }
+                sink += sum;
+            }));
+
+            // Every thread blocks in sync_wait() on its own tiny tasks at
+            // the same time.
+            contended_us.push_back(measure_us([&] {
+                std::vector< std::thread > threads;
+                for (unsigned t = 0; t < thread_count; ++t) {
+                    threads.emplace_back([&] {
+                        std::uint64_t sum = 0;
+                        for (unsigned i = 0; i < iterations / thread_count; ++i) {
+                            sum += sync_wait(completed());
+                        }
+                        sink += sum;
+                    });
+                }
+                for (auto &thread : threads) {
+                    thread.join();
+                }
+            }));
+        }
+
+        auto report = [&](const char *name, const std::vector< double > &us) {
+            auto avg       = bench::mean(us);
+            auto deviation = std::sqrt(bench::standard_deviation(us));
+            MESSAGE(name << ": " << avg << " us (+-" << deviation << "), "
+                         << (avg * 1000.0 / iterations) << " ns/sync_wait");
+        };
+
+        report("already completed", completed_us);
+        report("completing on static_thread_pool", on_pool_us);
+        report("already completed, one caller per core", contended_us);
+
+        CHECK(sink != 0);
+    }
+
     TEST_SUITE_END();
 
 } // namespace gap::test
@@ -0,0 +1,294 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/core/benchmark.hpp>
+    #include <gap/coro/cancellation_source.hpp>
+    #include <gap/coro/operation_cancelled.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/timer_service.hpp>
+    #include <gap/coro/when_all_ready.hpp>
+    #include <gap/coro/with_timeout.hpp>
+
+    #include <chrono>
+    #include <cmath>
+    #include <cstddef>
+    #include <optional>
+    #include <stdexcept>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+using namespace std::chrono_literals;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("timer_service");
+
+    using clock = std::chrono::steady_clock;
+
+    TEST_CASE("schedule_after waits at least the delay") {
+        timer_service timers;
+
+        auto start = clock::now();
+        auto id    = sync_wait([&]() -> task< std::thread::id > {
+            co_await timers.schedule_after(20ms);
+            co_return std::this_thread::get_id();
+        }());
+
+        CHECK(clock::now() - start >= 20ms);
+        CHECK(id != std::this_thread::get_id());
+        CHECK(timers.pending_timers() == 0);
+    }
+
+    TEST_CASE("elapsed delays do not suspend") {
+        timer_service timers;
+
+        auto id = sync_wait([&]() -> task< std::thread::id > {
+            co_await timers.schedule_after(0ms);
+            co_await timers.schedule_after(-5ms);
+            co_return std::this_thread::get_id();
+        }());
+
+        CHECK(id == std::this_thread::get_id());
+    }
+
+    TEST_CASE("timers fire in deadline order") {
+        timer_service timers;
+
+        std::vector< int > order;
+        auto sleeper = [&](int delay_ms) -> task<> {
+            co_await timers.schedule_after(std::chrono::milliseconds(delay_ms));
+            order.push_back(delay_ms);
+        };
+
+        sync_wait(when_all_ready(sleeper(30), sleeper(10), sleeper(50), sleeper(20)));
+        CHECK(order == std::vector< int >{ 10, 20, 30, 50 });
+    }
+
+    TEST_CASE("timers cascade down from the upper levels") {
+        // At 10us per tick, 300ms is far beyond the lowest two levels.
+        timer_service timers{ 10us };
+
+        std::vector< clock::duration > late;
+        auto sleeper = [&](clock::duration delay) -> task<> {
+            auto start = clock::now();
+            co_await timers.schedule_after(delay);
+            late.push_back(clock::now() - start - delay);
+        };
+
+        sync_wait(when_all_ready(sleeper(300ms), sleeper(1ms), sleeper(3ms), sleeper(120ms)));
+        REQUIRE(late.size() == 4);
+        for (auto l : late) {
+            CHECK(l >= clock::duration::zero());
+        }
+    }
+
+    TEST_CASE("timers after an idle period") {
+        // At 1ns per tick the service idles through a hundred million ticks,
+        // far too many to step through one by one.
+        timer_service timers{ 1ns };
+        std::this_thread::sleep_for(100ms);
+
+        auto start = clock::now();
+        sync_wait([&]() -> task<> { co_await timers.schedule_after(1ms); }());
+        auto elapsed = clock::now() - start;
+
+        CHECK(elapsed >= 1ms);
+        CHECK(elapsed < 50ms);
+        CHECK(timers.pending_timers() == 0);
+    }
+
+    TEST_CASE("cancelling a pending timer") {
+        timer_service timers;
+        cancellation_source source;
+
+        bool cancelled = false;
+        auto sleeper = [&]() -> task<> {
+            try {
+                co_await timers.schedule_after(1h, source.token());
+            } catch (const operation_cancelled &) {
+                cancelled = true;
+            }
+        };
+
+        auto canceller = [&]() -> task<> {
+            CHECK(timers.pending_timers() == 1);
+            source.request_cancellation();
+            CHECK(timers.pending_timers() == 0);
+            co_return;
+        };
+
+        sync_wait(when_all_ready(sleeper(), canceller()));
+        CHECK(cancelled);
+    }
+
+    TEST_CASE("cancelled before starting") {
+        timer_service timers;
+        cancellation_source source;
+        source.request_cancellation();
+
+        CHECK_THROWS_AS(sync_wait([&]() -> task<> {
+            co_await timers.schedule_after(1h, source.token());
+        }()), operation_cancelled);
+        CHECK(timers.pending_timers() == 0);
+    }
+
+    TEST_CASE("cancelled from another thread") {
+        timer_service timers;
+        cancellation_source source;
+
+        std::thread canceller([&] {
+            while (timers.pending_timers() == 0) {
+                std::this_thread::yield();
+            }
+            source.request_cancellation();
+        });
+
+        CHECK_THROWS_AS(sync_wait([&]() -> task<> {
+            co_await timers.schedule_after(1h, source.token());
+        }()), operation_cancelled);
+        canceller.join();
+    }
+
+    TEST_CASE("schedule_after resumes on the given scheduler") {
+        static_thread_pool pool{ 2 };
+        timer_service timers;
+
+        auto on_pool = [&](clock::duration delay) -> task< std::thread::id > {
+            co_await timers.schedule_after(delay, pool);
+            co_return std::this_thread::get_id();
+        };
+
+        auto [delayed, elapsed] = sync_wait(when_all_ready(on_pool(5ms), on_pool(0ms)));
+        CHECK(delayed.result() != std::this_thread::get_id());
+        CHECK(elapsed.result() != std::this_thread::get_id());
+    }
+
+    TEST_CASE("destroying the service cancels pending timers") {
+        std::optional< timer_service > timers{ std::in_place };
+
+        bool cancelled = false;
+        auto sleeper = [&]() -> task<> {
+            try {
+                co_await timers->schedule_after(1h);
+            } catch (const operation_cancelled &) {
+                cancelled = true;
+            }
+        };
+
+        auto destroyer = [&]() -> task<> {
+            timers.reset();
+            co_return;
+        };
+
+        sync_wait(when_all_ready(sleeper(), destroyer()));
+        CHECK(cancelled);
+    }
+
+    TEST_CASE("with_timeout completing in time") {
+        timer_service timers;
+
+        auto quick = [&]() -> task< int > {
+            co_await timers.schedule_after(1ms);
+            co_return 42;
+        };
+
+        CHECK(sync_wait(with_timeout(timers, quick(), 1h)) == 42);
+        CHECK(timers.pending_timers() == 0);
+    }
+
+    TEST_CASE("with_timeout timing out") {
+        timer_service timers;
+        cancellation_source source;
+
+        auto slow = [&]() -> task<> {
+            try {
+                co_await timers.schedule_after(1h, source.token());
+            } catch (const operation_cancelled &) {}
+        };
+
+        auto start = clock::now();
+        CHECK_THROWS_AS(sync_wait(with_timeout(timers, slow(), 10ms)), operation_timed_out);
+        CHECK(clock::now() - start >= 10ms);
+
+        // The slow task is still pending in the background.
+        CHECK(timers.pending_timers() == 1);
+        source.request_cancellation();
+        CHECK(timers.pending_timers() == 0);
+    }
+
+    TEST_CASE("with_timeout propagates exceptions") {
+        timer_service timers;
+
+        auto failing = []() -> task< int > {
+            throw std::runtime_error("failed");
+            co_return 0;
+        };
+
+        CHECK_THROWS_AS(sync_wait(with_timeout(timers, failing(), 1h)), std::runtime_error);
+        CHECK(timers.pending_timers() == 0);
+    }
+
+    //
+    // Insert and cancel cost with many pending timers, run with --no-skip.
+    //
+    TEST_CASE("timer_service insert and cancel" * doctest::skip()) {
+        constexpr std::size_t timer_count = 1'000'000;
+        constexpr int samples             = 3;
+
+        std::vector< double > insert_ns, cancel_ns;
+
+        for (int s = 0; s < samples; ++s) {
+            timer_service timers;
+
+            // One source per timer, so that cancelling removes one timer at
+            // a time from a full wheel.
+            std::vector< cancellation_source > sources(timer_count);
+
+            auto sleeper = [&](std::size_t i) -> task<> {
+                try {
+                    // Spread the deadlines over every level of the wheel.
+                    co_await timers.schedule_after(1s + std::chrono::milliseconds(i * 37), sources[i].token());
+                } catch (const operation_cancelled &) {}
+            };
+
+            std::vector< task<> > sleepers;
+            sleepers.reserve(timer_count);
+            for (std::size_t i = 0; i < timer_count; ++i) {
+                sleepers.push_back(sleeper(i));
+            }
+
+            auto start = clock::now();
+            auto controller = [&]() -> task<> {
+                auto inserted = clock::now();
+                CHECK(timers.pending_timers() == timer_count);
+                for (auto &source : sources) {
+                    source.request_cancellation();
+                }
+                auto cancelled = clock::now();
+                CHECK(timers.pending_timers() == 0);
+
+                using ns = std::chrono::duration< double, std::nano >;
+                insert_ns.push_back(ns(inserted - start).count() / timer_count);
+                cancel_ns.push_back(ns(cancelled - inserted).count() / timer_count);
+                co_return;
+            };
+
+            sync_wait(when_all_ready(when_all_ready_vec(std::move(sleepers)), controller()));
+        }
+
+        MESSAGE("start timer: " << bench::mean(insert_ns) << " ns (+-"
+                << std::sqrt(bench::standard_deviation(insert_ns)) << ")");
+        MESSAGE("cancel timer: " << bench::mean(cancel_ns) << " ns (+-"
+                << std::sqrt(bench::standard_deviation(cancel_ns)) << ")");
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
@@ -0,0 +1,225 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/async_manual_reset_event.hpp>
+    #include <gap/coro/shared_task.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/coro/when_all.hpp>
+    #include <gap/coro/when_any.hpp>
+
+    #include <atomic>
+    #include <chrono>
+    #include <stdexcept>
+    #include <string>
+    #include <thread>
+    #include <vector>
+
+using namespace gap::coro;
+
+namespace gap::test
+{
+    TEST_SUITE_BEGIN("when_all");
+
+    TEST_CASE("when_all() with heterogeneous results") {
+        auto make_int = []() -> task< int > { co_return 1; };
+        auto make_string = []() -> task< std::string > { co_return "two"; };
+        auto make_void = []() -> task<> { co_return; };
+
+        auto [a, b, c] = sync_wait(when_all(make_int(), make_string(), make_void()));
+
+        CHECK(a == 1);
+        CHECK(b == "two");
+        static_assert(std::is_same_v< decltype(c), gap::coro::detail::void_type >);
+    }
+
+    TEST_CASE("when_all() waits for all tasks") {
+        async_manual_reset_event event;
+        int finished = 0;
+
+        auto make_task = [&](int value) -> task< int > {
+            co_await event;
+            ++finished;
+            co_return value;
+        };
+
+        auto check = [&]() -> task<> {
+            CHECK(finished == 0);
+            event.set();
+            CHECK(finished == 2);
+            co_return;
+        };
+
+        auto [result, unused] = sync_wait(when_all(when_all(make_task(1), make_task(2)), check()));
+        auto [x, y] = result;
+        CHECK(x == 1);
+        CHECK(y == 2);
+    }
+
+    TEST_CASE("when_all() rethrows the first exception") {
+        auto ok = []() -> task< int > { co_return 1; };
+        auto fail = [](const char *what) -> task< int > {
+            throw std::runtime_error(what);
+            co_return 0;
+        };
+
+        try {
+            sync_wait(when_all(ok(), fail("first"), fail("second")));
+            FAIL("expected an exception");
+        } catch (const std::runtime_error &err) {
+            CHECK(std::string(err.what()) == "first");
+        }
+    }
+
+    TEST_CASE("when_all_vec() returns results in order") {
+        static_thread_pool pool{ 4 };
+
+        auto make_task = [&](int value) -> task< int > {
+            co_await pool.schedule();
+            co_return value * value;
+        };
+
+        std::vector< task< int > > tasks;
+        for (int i = 0; i < 100; ++i) {
+            tasks.push_back(make_task(i));
+        }
+
+        auto results = sync_wait(when_all_vec(std::move(tasks)));
+
+        REQUIRE(results.size() == 100u);
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            CHECK(results[i] == static_cast< int >(i * i));
+        }
+    }
+
+    TEST_CASE("when_all_vec() of void tasks") {
+        int count = 0;
+        auto make_task = [&]() -> task<> {
+            ++count;
+            co_return;
+        };
+
+        std::vector< task<> > tasks;
+        tasks.push_back(make_task());
+        tasks.push_back(make_task());
+
+        sync_wait(when_all_vec(std::move(tasks)));
+        CHECK(count == 2);
+    }
+
+    TEST_CASE("when_all_vec() of shared tasks returning references") {
+        int value = 7;
+        auto make_task = [&]() -> shared_task< int& > { co_return value; };
+
+        std::vector< shared_task< int& > > tasks;
+        tasks.push_back(make_task());
+        tasks.push_back(make_task());
+
+        auto results = sync_wait(when_all_vec(std::move(tasks)));
+        REQUIRE(results.size() == 2u);
+        CHECK(&results[0].get() == &value);
+        CHECK(&results[1].get() == &value);
+    }
+
+    TEST_CASE("when_any() resumes on the first completion") {
+        async_manual_reset_event slow_event;
+        async_manual_reset_event fast_event;
+        bool slow_finished = false;
+
+        auto slow = [&]() -> task< int > {
+            co_await slow_event;
+            slow_finished = true;
+            co_return 1;
+        };
+
+        auto fast = [&]() -> task< std::string > {
+            co_await fast_event;
+            co_return "fast";
+        };
+
+        auto check = [&]() -> task<> {
+            fast_event.set();
+            co_return;
+        };
+
+        auto [winner, unused] = sync_wait(when_all(when_any(slow(), fast()), check()));
+
+        CHECK(winner.index() == 1u);
+        CHECK(std::get< 1 >(winner) == "fast");
+        CHECK_FALSE(slow_finished);
+
+        // The loser still completes in the background.
+        slow_event.set();
+        CHECK(slow_finished);
+    }
+
+    TEST_CASE("when_any() with a synchronously completing task") {
+        async_manual_reset_event never;
+
+        auto blocked = [&]() -> task<> { co_await never; };
+        auto ready = []() -> task< int > { co_return 42; };
+
+        auto winner = sync_wait(when_any(blocked(), ready()));
+        CHECK(winner.index() == 1u);
+        CHECK(std::get< 1 >(winner) == 42);
+
+        never.set();
+    }
+
+    TEST_CASE("when_any() rethrows when the first completion failed") {
+        async_manual_reset_event never;
+
+        auto blocked = [&]() -> task< int > {
+            co_await never;
+            co_return 1;
+        };
+
+        auto fail = []() -> task< int > {
+            throw std::runtime_error("boom");
+            co_return 0;
+        };
+
+        CHECK_THROWS_AS(sync_wait(when_any(blocked(), fail())), const std::runtime_error&);
+
+        never.set();
+    }
+
+    TEST_CASE("when_any_vec() on a thread pool") {
+        static_thread_pool pool{ 4 };
+        std::atomic< int > completed = 0;
+
+        auto make_task = [&](int index) -> task< int > {
+            co_await pool.schedule();
+            if (index != 3) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+            completed.fetch_add(1);
+            co_return index * 10;
+        };
+
+        std::vector< task< int > > tasks;
+        for (int i = 0; i < 6; ++i) {
+            tasks.push_back(make_task(i));
+        }
+
+        auto [index, value] = sync_wait(when_any_vec(std::move(tasks)));
+        CHECK(value == static_cast< int >(index) * 10);
+
+        // Let the stragglers drain before the pool goes away.
+        while (completed.load() != 6) {
+            std::this_thread::yield();
+        }
+    }
+
+    TEST_CASE("when_any_vec() of no awaitables throws") {
+        CHECK_THROWS_AS(when_any_vec(std::vector< task< int > >{}), const std::invalid_argument&);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test
+
+#endif // GAP_ENABLE_COROUTINES
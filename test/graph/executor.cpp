@@ -0,0 +1,264 @@
+// Copyright (c) 2024-present, Trail of Bits, Inc.
+
+#ifdef GAP_ENABLE_COROUTINES
+
+    #include <doctest/doctest.h>
+    #include <gap/coro/generator.hpp>
+    #include <gap/coro/static_thread_pool.hpp>
+    #include <gap/coro/sync_wait.hpp>
+    #include <gap/coro/task.hpp>
+    #include <gap/graph/executor.hpp>
+
+    #include <atomic>
+    #include <chrono>
+    #include <memory>
+    #include <mutex>
+    #include <random>
+    #include <stdexcept>
+    #include <thread>
+    #include <vector>
+
+namespace gap::test::executor
+{
+    using namespace std::chrono_literals;
+
+    using coro::static_thread_pool;
+    using coro::sync_wait;
+    using coro::task;
+
+    struct node_t {
+        using node_pointer = std::shared_ptr< node_t >;
+        using child_type   = node_pointer;
+
+        explicit node_t(int val)
+            : value(val) {}
+
+        generator< child_type > children() const {
+            for (auto ch : _children)
+                co_yield ch;
+        }
+
+        int value;
+        std::atomic< bool > done = false;
+
+        std::vector< child_type > _children;
+    };
+
+    struct edge_t {
+        using node_type    = node_t;
+        using node_pointer = node_type::node_pointer;
+
+        using source_type  = node_pointer;
+        using target_type  = node_pointer;
+
+        source_type source() const { return _src; }
+        target_type target() const { return _dst; }
+
+        node_pointer _src, _dst;
+    };
+
+    struct graph_t {
+        using node_type    = node_t;
+        using edge_type    = edge_t;
+        using node_pointer = node_type::node_pointer;
+
+        explicit graph_t(int count) {
+            for (int i = 0; i < count; ++i) {
+                _nodes.push_back(std::make_shared< node_t >(i));
+            }
+        }
+
+        generator< node_pointer > nodes() const {
+            for (auto ch : _nodes)
+                co_yield ch;
+        }
+
+        generator< edge_type > edges() const {
+            for (auto node : _nodes) {
+                for (auto child : node->children()) {
+                    // A named edge, GCC 12 destroys braced temporaries in
+                    // co_yield twice.
+                    edge_type edge{ node, child };
+                    co_yield edge;
+                }
+            }
+        }
+
+        std::vector< node_pointer > _nodes;
+    };
+
+    static_assert(graph::graph_like< graph_t >);
+
+    using node_ptr = node_t::node_pointer;
+
+    // Checks that every child of a node has finished before the node starts.
+    static bool children_done(const node_ptr &node) {
+        for (auto &child : node->_children) {
+            if (!child->done.load()) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    TEST_SUITE_BEGIN("graph executor");
+
+    TEST_CASE("empty graph") {
+        static_thread_pool pool{ 2 };
+        graph_t g{ 0 };
+
+        auto report = sync_wait(graph::execute(g, pool, [](node_ptr) -> task<> { co_return; }));
+        CHECK(report.nodes == 0);
+        CHECK(report.critical_path_nodes == 0);
+    }
+
+    TEST_CASE("children run before their parents") {
+        static_thread_pool pool{ 4 };
+        graph_t g{ 4 };
+
+        auto &nodes = g._nodes;
+        nodes[0]->_children = { nodes[1], nodes[2] };
+        nodes[1]->_children = { nodes[3] };
+        nodes[2]->_children = { nodes[3] };
+
+        std::mutex mutex;
+        std::vector< int > order;
+        std::atomic< bool > in_order = true;
+
+        auto report = sync_wait(graph::execute(g, pool, [&](node_ptr node) -> task<> {
+            if (!children_done(node)) {
+                in_order = false;
+            }
+            {
+                std::lock_guard lock(mutex);
+                order.push_back(node->value);
+            }
+            node->done = true;
+            co_return;
+        }));
+
+        CHECK(in_order);
+        REQUIRE(order.size() == 4);
+        CHECK(order.front() == 3);
+        CHECK(order.back() == 0);
+        CHECK(report.nodes == 4);
+        CHECK(report.critical_path_nodes == 3);
+    }
+
+    TEST_CASE("independent nodes run in parallel") {
+        static_thread_pool pool{ 4 };
+        graph_t g{ 4 };
+
+        auto report = sync_wait(graph::execute(g, pool, [](node_ptr) -> task<> {
+            std::this_thread::sleep_for(20ms);
+            co_return;
+        }));
+
+        CHECK(report.critical_path_nodes == 1);
+        CHECK(report.busy_time >= 80ms);
+        CHECK(report.parallelism() > 1.5);
+        CHECK(report.available_parallelism() > 3.0);
+    }
+
+    TEST_CASE("critical path follows the slowest chain") {
+        static_thread_pool pool{ 4 };
+        graph_t g{ 5 };
+
+        // 0 <- 1 <- 2 is slow, 3 <- 4 is fast.
+        auto &nodes = g._nodes;
+        nodes[0]->_children = { nodes[1] };
+        nodes[1]->_children = { nodes[2] };
+        nodes[3]->_children = { nodes[4] };
+
+        auto report = sync_wait(graph::execute(g, pool, [](node_ptr node) -> task<> {
+            std::this_thread::sleep_for(node->value < 3 ? 10ms : 1ms);
+            co_return;
+        }));
+
+        CHECK(report.critical_path_nodes == 3);
+        CHECK(report.critical_path >= 30ms);
+        CHECK(report.wall_time >= report.critical_path);
+    }
+
+    TEST_CASE("cycles are rejected before running anything") {
+        static_thread_pool pool{ 2 };
+        graph_t g{ 3 };
+
+        auto &nodes = g._nodes;
+        nodes[0]->_children = { nodes[1] };
+        nodes[1]->_children = { nodes[2] };
+        nodes[2]->_children = { nodes[0] };
+
+        std::atomic< int > calls = 0;
+        CHECK_THROWS_AS(sync_wait(graph::execute(g, pool, [&](node_ptr) -> task<> {
+            ++calls;
+            co_return;
+        })), graph::cyclic_graph);
+        CHECK(calls == 0);
+
+        for (auto &node : nodes) {
+            node->_children.clear();
+        }
+    }
+
+    TEST_CASE("dependents of a failed node are skipped") {
+        static_thread_pool pool{ 4 };
+        graph_t g{ 5 };
+
+        // 0 depends on 1, which fails. 2 <- 3 and 4 are unaffected.
+        auto &nodes = g._nodes;
+        nodes[0]->_children = { nodes[1] };
+        nodes[2]->_children = { nodes[3] };
+
+        CHECK_THROWS_AS(sync_wait(graph::execute(g, pool, [](node_ptr node) -> task<> {
+            if (node->value == 1) {
+                throw std::runtime_error("failed");
+            }
+            node->done = true;
+            co_return;
+        })), std::runtime_error);
+
+        CHECK(!nodes[0]->done);
+        CHECK(nodes[2]->done);
+        CHECK(nodes[3]->done);
+        CHECK(nodes[4]->done);
+    }
+
+    TEST_CASE("random DAG") {
+        static_thread_pool pool{ 4 };
+
+        constexpr int count = 2000;
+        graph_t g{ count };
+
+        std::mt19937 rng{ 7 };
+        for (int i = 1; i < count; ++i) {
+            std::uniform_int_distribution< int > pick{ 0, i - 1 };
+            for (int e = 0; e < 3; ++e) {
+                g._nodes[std::size_t(i)]->_children.push_back(g._nodes[std::size_t(pick(rng))]);
+            }
+        }
+
+        std::atomic< int > executed = 0;
+        std::atomic< bool > in_order = true;
+
+        auto report = sync_wait(graph::execute(g, pool, [&](node_ptr node) -> task<> {
+            if (!children_done(node)) {
+                in_order = false;
+            }
+            ++executed;
+            node->done = true;
+            co_return;
+        }));
+
+        CHECK(in_order);
+        CHECK(executed == count);
+        CHECK(report.nodes == count);
+        CHECK(report.critical_path_nodes > 1);
+        CHECK(report.critical_path_nodes <= count);
+    }
+
+    TEST_SUITE_END();
+
+} // namespace gap::test::executor
+
+#endif // GAP_ENABLE_COROUTINES